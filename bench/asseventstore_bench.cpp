@@ -0,0 +1,210 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// ASS 事件窗口的内存对比：与 azplayer-mediagen 的 ass_100k 相同的 10 万条事件(24 分钟，同一随机种子)
+// - 之前：全部事件提交给 libass
+// - 之后：事件保存在 ASSEventStore 中，libass 里只有 [pts - 5s, pts + 60s) 窗口内的事件
+// 单独构建时没有 libass，libass 一侧按其事件的分配方式建模：每条事件一个 ASS_Event(80 字节，数组按倍数增长)，
+// Name/Effect/Text 各 strdup 一次；两侧都测量进程常驻内存的增量，不含渲染时的字形/位图缓存
+
+#include "benchcommon.h"
+#include "renderer/asseventstore.h"
+#include "subtitlegen.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+    constexpr size_t kEvents = 100'000;
+    constexpr int64_t kDurationMs = 1'440'000;
+    // 与 ASSRender 的窗口相同
+    constexpr int64_t kWindowBehindMs = 5'000;
+    constexpr int64_t kWindowAheadMs = 60'000;
+
+    // 与 azplayer-mediagen 的 nameSeed 相同，得到与 ass_100k 相同的事件
+    uint32_t nameSeed(const std::string &name) {
+        uint32_t h = 2166136261u;
+        for (unsigned char ch : name) {
+            h = (h ^ ch) * 16777619u;
+        }
+        return h;
+    }
+
+    struct Packet {
+        int64_t start;
+        int64_t duration;
+        std::string data; // ReadOrder,Layer,Style,Name,MarginL,MarginR,MarginV,Effect,Text
+    };
+
+    // libass 中 ASS_Event 的布局(x86-64 上 80 字节)
+    struct LibassEvent {
+        long long start;
+        long long duration;
+        int readOrder;
+        int layer;
+        int style;
+        char *name;
+        int marginL, marginR, marginV;
+        char *effect;
+        char *text;
+        void *renderPriv;
+    };
+
+    // ass_process_chunk 的分配方式：Name/Effect/Text 各复制一份，事件数组按倍数增长
+    class LibassTrackModel {
+    public:
+        ~LibassTrackModel() { clear(); }
+
+        void add(const Packet &p) {
+            if (m_size == m_capacity) {
+                m_capacity = m_capacity * 2 + 1;
+                m_events = static_cast<LibassEvent *>(std::realloc(m_events, m_capacity * sizeof(LibassEvent)));
+            }
+            // 跳过 ReadOrder,Layer,Style 三个字段
+            const char *field = p.data.c_str();
+            for (int i = 0; i < 3; ++i) {
+                field = std::strchr(field, ',') + 1;
+            }
+            const char *nameEnd = std::strchr(field, ',');
+            const char *effect = nameEnd;
+            for (int i = 0; i < 4; ++i) {
+                effect = std::strchr(effect, ',') + 1;
+            }
+            const char *text = std::strchr(effect, ',') + 1;
+
+            LibassEvent &e = m_events[m_size++];
+            e = {};
+            e.start = p.start;
+            e.duration = p.duration;
+            e.name = copy(field, nameEnd);
+            e.effect = copy(effect, text - 1);
+            e.text = copy(text, p.data.c_str() + p.data.size());
+        }
+
+        void clear() {
+            for (size_t i = 0; i < m_size; ++i) {
+                std::free(m_events[i].name);
+                std::free(m_events[i].effect);
+                std::free(m_events[i].text);
+            }
+            std::free(m_events);
+            m_events = nullptr;
+            m_size = m_capacity = 0;
+        }
+
+        [[nodiscard]] size_t size() const { return m_size; }
+
+    private:
+        static char *copy(const char *begin, const char *end) {
+            const size_t len = static_cast<size_t>(end - begin);
+            char *s = static_cast<char *>(std::malloc(len + 1));
+            std::memcpy(s, begin, len);
+            s[len] = '\0';
+            return s;
+        }
+
+        LibassEvent *m_events = nullptr;
+        size_t m_size = 0;
+        size_t m_capacity = 0;
+    };
+
+    // 把已释放的内存还给系统，下一项的常驻内存增量才准确
+    void trimHeap() {
+#if defined(__GLIBC__)
+        malloc_trim(0);
+#endif
+    }
+
+    double mib(int64_t bytes) {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+}
+
+int main() {
+    static_assert(sizeof(void *) != 8 || sizeof(LibassEvent) == 80, "ASS_Event layout");
+
+    std::vector<Packet> packets;
+    packets.reserve(kEvents);
+    {
+        const std::vector<subtitlegen::Event> events = subtitlegen::makeEvents(kEvents, kDurationMs, nameSeed("ass_100k"));
+        int readOrder = 0;
+        for (const subtitlegen::Event &e : events) {
+            packets.push_back({e.startMs, e.endMs - e.startMs, subtitlegen::assPacket(e, readOrder++)});
+        }
+    }
+    trimHeap();
+    if (bench::residentBytes() < 0) {
+        std::printf("resident memory is not available on this platform\n");
+        return 0;
+    }
+
+    // 之前：所有事件都在 libass 中
+    int64_t base = bench::residentBytes();
+    int64_t fullTrack = 0;
+    {
+        LibassTrackModel track;
+        for (const Packet &p : packets) {
+            track.add(p);
+        }
+        trimHeap(); // 数组增长时释放的旧内存不计入
+        fullTrack = bench::residentBytes() - base;
+        bench::doNotOptimize(track.size());
+    }
+    trimHeap();
+
+    // 之后：事件存储 + 事件最多的那个窗口
+    base = bench::residentBytes();
+    ASSEventStore store;
+    for (const Packet &p : packets) {
+        if (!store.add(p.data.data(), p.data.size(), p.start, p.duration)) {
+            std::printf("ASSEventStore::add failed\n");
+            return 1;
+        }
+    }
+    store.finalize();
+    store.shrinkToFit();
+    trimHeap();
+    const int64_t storeBytes = bench::residentBytes() - base;
+
+    int64_t busiest = 0;
+    size_t busiestEvents = 0;
+    for (int64_t now = 0; now < kDurationMs; now += 1000) {
+        const size_t n = store.countOverlapping(now - kWindowBehindMs, now + kWindowAheadMs);
+        if (n > busiestEvents) {
+            busiestEvents = n;
+            busiest = now;
+        }
+    }
+
+    base = bench::residentBytes();
+    int64_t windowTrack = 0;
+    double refillUs = 0;
+    {
+        LibassTrackModel track;
+        const auto begin = std::chrono::steady_clock::now();
+        store.forEachOverlapping(busiest - kWindowBehindMs, busiest + kWindowAheadMs, [&](const ASSEventStore::Event &e, const char *text) {
+            track.add({e.start, e.duration, std::string(text, e.size)});
+        });
+        refillUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+        trimHeap();
+        windowTrack = bench::residentBytes() - base;
+        bench::doNotOptimize(track.size());
+    }
+
+    std::printf("%zu events, %.1f MiB of event text\n\n", store.size(), mib(static_cast<int64_t>(store.textBytes())));
+    std::printf("%-36s %10s\n", "", "RSS (MiB)");
+    std::printf("%-36s %10.2f\n", "before: all events in libass", mib(fullTrack));
+    std::printf("%-36s %10.2f   (memoryUsage %.2f)\n", "after: ASSEventStore", mib(storeBytes), mib(static_cast<int64_t>(store.memoryUsage())));
+    std::printf("%-36s %10.2f   (%zu events at %lld s, refill %.0f us)\n", "after: busiest window in libass", mib(windowTrack),
+                busiestEvents, static_cast<long long>(busiest / 1000), refillUs);
+    std::printf("%-36s %10.2f\n", "after: total", mib(storeBytes + windowTrack));
+    return 0;
+}
@@ -0,0 +1,56 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// 多音轨混音(AudioMixer)微基准，单位：每秒输出音频耗费的 CPU 时间(us)
+// 叠加音轨按输入声道 -> 输出声道列出，相同声道数走单位阵快速路径，其余经过下混矩阵
+
+#include "audio/audiomixer.h"
+#include "benchcommon.h"
+#include <cstdio>
+#include <vector>
+
+namespace {
+    constexpr int kFramesPerChunk = 1024; // 与 AudioPlayer 每次写入环形缓冲区的量级相当
+
+    struct Case {
+        int tracks;
+        int inChannels;
+        int outChannels;
+    };
+}
+
+int main() {
+    const Case cases[] = {{1, 2, 2}, {1, 6, 2}, {1, 8, 2}, {1, 2, 6}, {2, 2, 2}, {2, 6, 2}, {4, 2, 2}, {4, 6, 2}};
+
+    bench::printAudioHeader("us/second");
+    for (const Case &cs : cases) {
+        AudioMixer mixer;
+        if (!mixer.init(cs.outChannels, bench::kSampleRate)) {
+            std::printf("init failed\n");
+            return 1;
+        }
+        std::vector<int> ids;
+        for (int i = 0; i < cs.tracks; ++i) {
+            ids.push_back(mixer.addTrack(cs.inChannels));
+            mixer.setGain(ids.back(), 0.5f);
+        }
+
+        const std::vector<float> input = bench::makeSignal(cs.inChannels, kFramesPerChunk);
+        std::vector<float> dst(static_cast<size_t>(kFramesPerChunk) * cs.outChannels, 0.1f);
+
+        const double us = bench::audioUsPerSecond(kFramesPerChunk, [&](int n) {
+            const double pts = static_cast<double>(n) * kFramesPerChunk / bench::kSampleRate;
+            for (int id : ids) {
+                mixer.push(id, input.data(), kFramesPerChunk, pts);
+            }
+            mixer.mix(dst.data(), kFramesPerChunk, pts);
+        });
+
+        char name[32], sample[32];
+        std::snprintf(name, sizeof(name), "%dx %dch->%dch", cs.tracks, cs.inChannels, cs.outChannels);
+        // 输出 dst 中的一个值，防止混音被优化掉
+        std::snprintf(sample, sizeof(sample), "(%g)", dst[cs.outChannels]);
+        bench::printAudioRow(name, us, sample);
+    }
+    return 0;
+}
@@ -0,0 +1,191 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef BENCHCOMMON_H
+#define BENCHCOMMON_H
+
+// 基准测试与压力测试共用：生产者/消费者线程的绑核方式，防止结果被优化掉的 doNotOptimize，进程常驻内存，
+// 以及音频处理基准的测试信号、计时与结果表
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+namespace bench {
+    // 生产者/消费者线程的配对方式
+    enum class Pairing {
+        Unpinned,  // 由系统调度
+        SameCore,  // 绑在同一个核上，交接全靠线程切换
+        CrossCore, // 绑在两个不同的核上，交接经过 cache line 传递
+    };
+
+    inline const char *pairingName(Pairing p) {
+        switch (p) {
+        case Pairing::Unpinned:
+            return "unpinned";
+        case Pairing::SameCore:
+            return "same-core";
+        case Pairing::CrossCore:
+            return "cross-core";
+        }
+        return "?";
+    }
+
+    inline int cpuCount() {
+        const unsigned n = std::thread::hardware_concurrency();
+        return n == 0 ? 1 : static_cast<int>(n);
+    }
+
+    // 把当前线程绑定到 cpu，cpu < 0 时解除绑定；不支持的平台返回 false
+    inline bool pinCurrentThread(int cpu) {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (cpu < 0) {
+            for (int i = 0; i < cpuCount() && i < CPU_SETSIZE; ++i) {
+                CPU_SET(i, &set);
+            }
+        } else {
+            CPU_SET(cpu, &set);
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+        DWORD_PTR processMask = 0, systemMask = 0;
+        if (cpu < 0 && !GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+            return false;
+        return SetThreadAffinityMask(GetCurrentThread(), cpu < 0 ? processMask : DWORD_PTR{1} << cpu) != 0;
+#else
+        return cpu < 0;
+#endif
+    }
+
+    // 当前机器上能测的配对方式(单核机器没有 CrossCore，不支持绑核的平台只有 Unpinned)
+    inline std::vector<Pairing> availablePairings() {
+        std::vector<Pairing> pairings{Pairing::Unpinned};
+#if defined(__linux__) || defined(_WIN32)
+        pairings.push_back(Pairing::SameCore);
+        if (cpuCount() >= 2)
+            pairings.push_back(Pairing::CrossCore);
+#endif
+        return pairings;
+    }
+
+    // {生产者 CPU, 消费者 CPU}，-1 为不绑定
+    inline std::pair<int, int> pairingCpus(Pairing p) {
+        switch (p) {
+        case Pairing::SameCore:
+            return {0, 0};
+        case Pairing::CrossCore:
+            return {0, 1};
+        default:
+            return {-1, -1};
+        }
+    }
+
+    // 让编译器认为 value 被读取，被测代码的结果不会被当作死代码删掉
+    template <typename T>
+    inline void doNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        (void)*reinterpret_cast<const volatile char *>(&value);
+#endif
+    }
+
+    // 当前进程的常驻内存(字节)，不支持的平台返回 -1
+    inline int64_t residentBytes() {
+#if defined(__linux__)
+        std::FILE *file = std::fopen("/proc/self/statm", "r");
+        if (!file)
+            return -1;
+        long long size = 0, resident = 0;
+        const int n = std::fscanf(file, "%lld %lld", &size, &resident);
+        std::fclose(file);
+        return n == 2 ? static_cast<int64_t>(resident) * sysconf(_SC_PAGESIZE) : -1;
+#elif defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return -1;
+        return static_cast<int64_t>(counters.WorkingSetSize);
+#else
+        return -1;
+#endif
+    }
+
+    // 音频处理基准的采样率与每项测试处理的音频时长
+    constexpr int kSampleRate = 48000;
+    constexpr int kAudioSeconds = 20;
+
+    // 测试信号：几个不相关的正弦叠加，每个声道频率不同
+    inline float signalSample(int channel, int frame) {
+        constexpr double kTwoPi = 6.283185307179586;
+        const double t = static_cast<double>(frame) / kSampleRate;
+        const double f = 110.0 * (channel + 2);
+        return static_cast<float>(0.4 * std::sin(kTwoPi * f * t) + 0.2 * std::sin(kTwoPi * f * 2.7 * t) + 0.1 * std::sin(kTwoPi * 3.1 * t));
+    }
+
+    // 交错存放的测试信号
+    inline std::vector<float> makeSignal(int channels, int frames) {
+        std::vector<float> data(static_cast<size_t>(channels) * frames);
+        for (int i = 0; i < frames; ++i) {
+            for (int c = 0; c < channels; ++c) {
+                data[static_cast<size_t>(i) * channels + c] = signalSample(c, i);
+            }
+        }
+        return data;
+    }
+
+    // 每次处理 framesPerChunk 帧，共 kAudioSeconds 秒，返回每秒音频耗费的 CPU 时间(us)
+    // processChunk(n) 处理第 n 块
+    template <typename F>
+    inline double audioUsPerSecond(int framesPerChunk, F &&processChunk) {
+        const int chunks = kSampleRate * kAudioSeconds / framesPerChunk;
+        const auto begin = std::chrono::steady_clock::now();
+        for (int n = 0; n < chunks; ++n) {
+            processChunk(n);
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::micro>(end - begin).count() / kAudioSeconds;
+    }
+
+    // 音频处理基准的结果表：名称、每秒音频耗费的 CPU 时间、单核实时倍数，以及每项自己的附加列
+    inline void printAudioHeader(const char *unit, const char *extra = "") {
+        std::printf("%-16s %14s %10s", "case", unit, "realtime");
+        std::printf(*extra ? "   %s\n" : "%s\n", extra);
+    }
+
+    inline void printAudioRow(const char *name, double us, const char *extra = "") {
+        std::printf("%-16s %14.1f %9.0fx", name, us, 1e6 / us);
+        std::printf(*extra ? "   %s\n" : "%s\n", extra);
+    }
+
+    // 等待对方时先自旋一小段再让出 CPU，单核/同核配对下对方才有机会运行
+    class Backoff {
+    public:
+        void pause() {
+            if (++m_spins > kSpinLimit)
+                std::this_thread::yield();
+        }
+        void reset() { m_spins = 0; }
+
+    private:
+        static constexpr int kSpinLimit = 64;
+        int m_spins = 0;
+    };
+}
+
+#endif // BENCHCOMMON_H
@@ -0,0 +1,117 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// AtomicDoubleBuffer 在不同线程配对与数据大小下的吞吐和发布延迟
+// 写线程不停写入(每次填满整个数据块，模拟准备一帧渲染数据)，读线程不停读取(模拟渲染线程)
+// 发布延迟 = 读线程第一次读到某次写入的时刻 - 该次写入完成的时刻
+// 同一份源码编译两次：bench_doublebuffer 与定义了 REUSABLE_ATOMIC_DOUBLE_BUFFER 的 bench_doublebuffer_reusable
+
+#include "benchcommon.h"
+#include "stats/latencyhistogram.h"
+#include "utils/AtomicDoubleBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr uint64_t kWrites = 200'000;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Payload {
+        std::vector<uint8_t> data;
+        uint64_t seq = 0;
+        int64_t stampNs = 0; // 写入完成的时刻
+    };
+
+    int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    struct Result {
+        double seconds = 0.0;
+        uint64_t reads = 0;      // 成功的 read
+        uint64_t freshReads = 0; // 读到新数据的 read
+        uint64_t torn = 0;       // 数据块内容与序号不一致(不应出现)
+    };
+
+    Result run(bench::Pairing pairing, size_t payloadSize, LatencyHistogram &hist) {
+        AtomicDoubleBuffer<Payload> buf;
+        (void)buf.reset([&](Payload &b0, Payload &b1) -> bool {
+            b0.data.assign(payloadSize, 0);
+            b1.data.assign(payloadSize, 0);
+            return true;
+        });
+
+        const auto [writerCpu, readerCpu] = bench::pairingCpus(pairing);
+        std::atomic<bool> done{false};
+        Result result;
+
+        std::thread reader([&]() {
+            (void)bench::pinCurrentThread(readerCpu);
+            uint64_t lastSeq = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                const bool ok = buf.read([&](Payload &p, int) -> bool {
+                    if (p.seq == lastSeq)
+                        return true;
+                    hist.record(static_cast<uint64_t>(nowNs() - p.stampNs));
+                    const uint8_t expect = static_cast<uint8_t>(p.seq);
+                    if (p.data.front() != expect || p.data.back() != expect)
+                        ++result.torn;
+                    lastSeq = p.seq;
+                    ++result.freshReads;
+                    return true;
+                });
+                if (ok)
+                    ++result.reads;
+                else
+                    std::this_thread::yield();
+            }
+        });
+
+        (void)bench::pinCurrentThread(writerCpu);
+        const Clock::time_point begin = Clock::now();
+        for (uint64_t seq = 1; seq <= kWrites; ++seq) {
+            (void)buf.write([&](Payload &p, int) -> bool {
+                std::memset(p.data.data(), static_cast<uint8_t>(seq), p.data.size());
+                p.seq = seq;
+                p.stampNs = nowNs();
+                return true;
+            });
+            if ((seq & 63) == 0)
+                std::this_thread::yield(); // 单核/同核时给读线程运行的机会
+        }
+        result.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        done.store(true, std::memory_order_release);
+        reader.join();
+        (void)bench::pinCurrentThread(-1);
+        return result;
+    }
+}
+
+int main() {
+#ifdef REUSABLE_ATOMIC_DOUBLE_BUFFER
+    std::printf("AtomicDoubleBuffer (REUSABLE_ATOMIC_DOUBLE_BUFFER), %llu writes, cpus: %d\n",
+                static_cast<unsigned long long>(kWrites), bench::cpuCount());
+#else
+    std::printf("AtomicDoubleBuffer, %llu writes, cpus: %d\n", static_cast<unsigned long long>(kWrites), bench::cpuCount());
+#endif
+    std::printf("%-12s %10s %12s %12s %8s %10s %10s %10s %6s\n",
+                "pairing", "payload", "writes/s", "reads/s", "fresh%", "p50 ns", "p99 ns", "max ns", "torn");
+    for (bench::Pairing pairing : bench::availablePairings()) {
+        for (size_t payload : {size_t{64}, size_t{4} << 10, size_t{256} << 10}) {
+            static LatencyHistogram hist;
+            hist.reset();
+            const Result r = run(pairing, payload, hist);
+            const LatencyHistogram::Snapshot snap = hist.snapshot();
+            std::printf("%-12s %10zu %12.0f %12.0f %8.1f %10.0f %10.0f %10llu %6llu\n",
+                        bench::pairingName(pairing), payload, kWrites / r.seconds, r.reads / r.seconds,
+                        100.0 * r.freshReads / kWrites, snap.p50, snap.p99,
+                        static_cast<unsigned long long>(snap.max), static_cast<unsigned long long>(r.torn));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// AtomicDoubleBuffer 压力测试：写线程不停写入，读线程不停读取并校验
+// - 每次写入把整个数据块填满同一个序号，读到的数据块内必须全部一致(没有读到写了一半的数据)
+// - 序号必须递增：默认实现每次读到的都是新数据(严格递增)，REUSABLE_ATOMIC_DOUBLE_BUFFER 允许重复读同一份(不减)
+// - 交替使用 autoRelease 与手动 release，覆盖两种发布路径
+// 配合 ThreadSanitizer 使用(-DAZPLAYER_BENCH_TSAN=ON)
+// 用法: stress_doublebuffer [百万次写入，默认 1]
+// 任一项校验失败时返回 1
+
+#include "benchcommon.h"
+#include "utils/AtomicDoubleBuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct Failure {
+        std::atomic<bool> failed{false};
+        void report(const char *what, uint64_t seq) {
+            if (!failed.exchange(true))
+                std::fprintf(stderr, "%s at seq %llu\n", what, static_cast<unsigned long long>(seq));
+        }
+    };
+
+    bool run(bench::Pairing pairing, size_t elements, uint64_t writes) {
+        AtomicDoubleBuffer<std::vector<uint64_t>> buf;
+        (void)buf.reset([&](std::vector<uint64_t> &b0, std::vector<uint64_t> &b1) -> bool {
+            b0.assign(elements, 0);
+            b1.assign(elements, 0);
+            return true;
+        });
+
+        const auto [writerCpu, readerCpu] = bench::pairingCpus(pairing);
+        std::atomic<bool> done{false};
+        Failure failure;
+
+        std::thread reader([&]() {
+            (void)bench::pinCurrentThread(readerCpu);
+            uint64_t lastSeq = 0;
+            // 写线程结束后再读一次，确认能读到最后一次写入
+            for (bool last = false; !last && !failure.failed.load(std::memory_order_relaxed);) {
+                last = done.load(std::memory_order_acquire);
+                const bool ok = buf.read([&](std::vector<uint64_t> &data, int) -> bool {
+                    const uint64_t seq = data.front();
+                    for (uint64_t v : data) {
+                        if (v != seq) {
+                            failure.report("torn read", seq);
+                            return false;
+                        }
+                    }
+#ifdef REUSABLE_ATOMIC_DOUBLE_BUFFER
+                    if (seq < lastSeq)
+#else
+                    if (seq <= lastSeq)
+#endif
+                        failure.report("sequence went backwards", seq);
+                    lastSeq = seq;
+                    return true;
+                });
+                if (!ok)
+                    std::this_thread::yield();
+            }
+            if (!failure.failed.load() && lastSeq != writes)
+                failure.report("last write never observed", lastSeq);
+        });
+
+        (void)bench::pinCurrentThread(writerCpu);
+        for (uint64_t seq = 1; seq <= writes && !failure.failed.load(std::memory_order_relaxed); ++seq) {
+            const bool autoRelease = (seq & 1) != 0;
+            (void)buf.write(
+                [&](std::vector<uint64_t> &data, int) -> bool {
+                    std::fill(data.begin(), data.end(), seq);
+                    return true;
+                },
+                autoRelease);
+            if (!autoRelease)
+                buf.release();
+            if ((seq & 63) == 0)
+                std::this_thread::yield(); // 单核/同核时给读线程运行的机会
+        }
+        done.store(true, std::memory_order_release);
+        reader.join();
+        (void)bench::pinCurrentThread(-1);
+        return !failure.failed.load();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const double millions = argc > 1 ? std::atof(argv[1]) : 1.0;
+    if (!(millions > 0.0)) {
+        std::fprintf(stderr, "usage: stress_doublebuffer [millions of writes]\n");
+        return 2;
+    }
+    const uint64_t writes = static_cast<uint64_t>(millions * 1e6);
+
+#ifdef REUSABLE_ATOMIC_DOUBLE_BUFFER
+    const char *variant = "reusable";
+#else
+    const char *variant = "default";
+#endif
+    bool allOk = true;
+    for (bench::Pairing pairing : bench::availablePairings()) {
+        for (size_t elements : {size_t{8}, size_t{512}}) {
+            const bool ok = run(pairing, elements, writes);
+            std::printf("doublebuffer %-9s %-12s %5zu x u64 %s\n", variant, bench::pairingName(pairing), elements, ok ? "ok" : "FAILED");
+            std::fflush(stdout);
+            allOk &= ok;
+        }
+    }
+    return allOk ? 0 : 1;
+}
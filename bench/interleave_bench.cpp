@@ -0,0 +1,182 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// planar -> packed 交织微基准，单位：每秒音频耗费的 CPU 时间(us)
+// scalar: 逐采样拷贝/转换; simd: interleaveSamples、interleaveToFloat; swr: swr_convert(需要 FFmpeg，定义 AZ_BENCH_HAVE_SWR)
+
+#include "audio/interleave.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef AZ_BENCH_HAVE_SWR
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libswresample/swresample.h>
+}
+#endif
+
+namespace {
+    constexpr int kSampleRate = 48000;
+    constexpr int kFramesPerPacket = 1024;
+    constexpr int kSeconds = 60; // 每项测试处理的音频时长
+
+    struct Case {
+        int channels;
+        int bytesPerSample;
+    };
+
+    void interleaveNaive(const uint8_t *const *src, uint8_t *dst, int channels, int frames, int bytesPerSample) {
+        for (int i = 0; i < frames; ++i) {
+            for (int c = 0; c < channels; ++c) {
+                std::memcpy(dst, src[c] + static_cast<size_t>(i) * bytesPerSample, bytesPerSample);
+                dst += bytesPerSample;
+            }
+        }
+    }
+
+    // s16p/s32p -> f32，缩放与 swresample 相同
+    template <typename T>
+    void toFloatNaive(const uint8_t *const *src, float *dst, int channels, int frames, float scale) {
+        for (int i = 0; i < frames; ++i) {
+            for (int c = 0; c < channels; ++c) {
+                *dst++ = static_cast<float>(reinterpret_cast<const T *>(src[c])[i]) * scale;
+            }
+        }
+    }
+
+    void toFloatNaive(const uint8_t *const *src, float *dst, int channels, int frames, int bytesPerSample) {
+        if (bytesPerSample == 2) {
+            toFloatNaive<int16_t>(src, dst, channels, frames, 1.0f / (1 << 15));
+        } else {
+            toFloatNaive<int32_t>(src, dst, channels, frames, 1.0f / (1U << 31));
+        }
+    }
+
+    void fillPlanes(std::vector<std::vector<uint8_t>> &planes, std::vector<const uint8_t *> &src) {
+        for (size_t c = 0; c < planes.size(); ++c) {
+            for (size_t i = 0; i < planes[c].size(); ++i) {
+                planes[c][i] = static_cast<uint8_t>(i * 7 + c * 13);
+            }
+            src[c] = planes[c].data();
+        }
+    }
+
+    // 返回每秒音频的耗时(us)
+    template <typename Func>
+    double measure(Func &&func) {
+        const int packets = kSampleRate * kSeconds / kFramesPerPacket;
+        const auto begin = std::chrono::steady_clock::now();
+        for (int p = 0; p < packets; ++p) {
+            func();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::micro>(end - begin).count() / kSeconds;
+    }
+}
+
+int main() {
+    const Case cases[] = {{1, 2}, {2, 2}, {6, 2}, {8, 2}, {1, 4}, {2, 4}, {6, 4}, {8, 4}};
+
+    std::printf("%-10s %12s %12s %12s\n", "format", "scalar(us)", "simd(us)", "swr(us)");
+    for (const Case &cs : cases) {
+        std::vector<std::vector<uint8_t>> planes(cs.channels, std::vector<uint8_t>(kFramesPerPacket * cs.bytesPerSample));
+        std::vector<const uint8_t *> src(cs.channels);
+        fillPlanes(planes, src);
+        std::vector<uint8_t> ref(kFramesPerPacket * cs.channels * cs.bytesPerSample);
+        std::vector<uint8_t> out(ref.size());
+
+        interleaveNaive(src.data(), ref.data(), cs.channels, kFramesPerPacket, cs.bytesPerSample);
+        interleaveSamples(src.data(), 0, out.data(), cs.channels, kFramesPerPacket, cs.bytesPerSample);
+        if (ref != out) {
+            std::printf("mismatch: %dch %dbit\n", cs.channels, cs.bytesPerSample * 8);
+            return 1;
+        }
+
+        const double scalarUs = measure([&] {
+            interleaveNaive(src.data(), out.data(), cs.channels, kFramesPerPacket, cs.bytesPerSample);
+        });
+        const double simdUs = measure([&] {
+            interleaveSamples(src.data(), 0, out.data(), cs.channels, kFramesPerPacket, cs.bytesPerSample);
+        });
+
+        double swrUs = -1.0;
+#ifdef AZ_BENCH_HAVE_SWR
+        {
+            AVChannelLayout layout;
+            av_channel_layout_default(&layout, cs.channels);
+            const AVSampleFormat inFmt = cs.bytesPerSample == 2 ? AV_SAMPLE_FMT_S16P : AV_SAMPLE_FMT_FLTP;
+            const AVSampleFormat outFmt = av_get_packed_sample_fmt(inFmt);
+            SwrContext *swr = nullptr;
+            if (swr_alloc_set_opts2(&swr, &layout, outFmt, kSampleRate, &layout, inFmt, kSampleRate, 0, nullptr) >= 0 && swr_init(swr) >= 0) {
+                uint8_t *dst = out.data();
+                swrUs = measure([&] {
+                    (void)swr_convert(swr, &dst, kFramesPerPacket, src.data(), kFramesPerPacket);
+                });
+            }
+            swr_free(&swr);
+            av_channel_layout_uninit(&layout);
+        }
+#endif
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "%dch %s", cs.channels, cs.bytesPerSample == 2 ? "s16" : "f32");
+        if (swrUs < 0) {
+            std::printf("%-10s %12.1f %12.1f %12s\n", name, scalarUs, simdUs, "-");
+        } else {
+            std::printf("%-10s %12.1f %12.1f %12.1f\n", name, scalarUs, simdUs, swrUs);
+        }
+    }
+
+    // 整数 planar -> f32 packed(设备格式)
+    std::printf("\n%-14s %12s %12s %12s\n", "format", "scalar(us)", "simd(us)", "swr(us)");
+    for (const Case &cs : cases) {
+        std::vector<std::vector<uint8_t>> planes(cs.channels, std::vector<uint8_t>(kFramesPerPacket * cs.bytesPerSample));
+        std::vector<const uint8_t *> src(cs.channels);
+        fillPlanes(planes, src);
+        std::vector<float> ref(static_cast<size_t>(kFramesPerPacket) * cs.channels);
+        std::vector<float> out(ref.size());
+
+        toFloatNaive(src.data(), ref.data(), cs.channels, kFramesPerPacket, cs.bytesPerSample);
+        interleaveToFloat(src.data(), 0, out.data(), cs.channels, kFramesPerPacket, cs.bytesPerSample);
+        if (std::memcmp(ref.data(), out.data(), ref.size() * sizeof(float)) != 0) {
+            std::printf("mismatch: %dch s%dp -> f32\n", cs.channels, cs.bytesPerSample * 8);
+            return 1;
+        }
+
+        const double scalarUs = measure([&] {
+            toFloatNaive(src.data(), out.data(), cs.channels, kFramesPerPacket, cs.bytesPerSample);
+        });
+        const double simdUs = measure([&] {
+            interleaveToFloat(src.data(), 0, out.data(), cs.channels, kFramesPerPacket, cs.bytesPerSample);
+        });
+
+        double swrUs = -1.0;
+#ifdef AZ_BENCH_HAVE_SWR
+        {
+            AVChannelLayout layout;
+            av_channel_layout_default(&layout, cs.channels);
+            const AVSampleFormat inFmt = cs.bytesPerSample == 2 ? AV_SAMPLE_FMT_S16P : AV_SAMPLE_FMT_S32P;
+            SwrContext *swr = nullptr;
+            if (swr_alloc_set_opts2(&swr, &layout, AV_SAMPLE_FMT_FLT, kSampleRate, &layout, inFmt, kSampleRate, 0, nullptr) >= 0 && swr_init(swr) >= 0) {
+                uint8_t *dst = reinterpret_cast<uint8_t *>(out.data());
+                swrUs = measure([&] {
+                    (void)swr_convert(swr, &dst, kFramesPerPacket, src.data(), kFramesPerPacket);
+                });
+            }
+            swr_free(&swr);
+            av_channel_layout_uninit(&layout);
+        }
+#endif
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "%dch s%dp>f32", cs.channels, cs.bytesPerSample * 8);
+        if (swrUs < 0) {
+            std::printf("%-14s %12.1f %12.1f %12s\n", name, scalarUs, simdUs, "-");
+        } else {
+            std::printf("%-14s %12.1f %12.1f %12.1f\n", name, scalarUs, simdUs, swrUs);
+        }
+    }
+    return 0;
+}
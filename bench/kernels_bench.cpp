@@ -0,0 +1,246 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// 渲染与媒体库扫描中的热点函数，单线程
+// - DirtyRectManager::init + addRect：字幕行的字形矩形(密集、相邻)与特效字幕的散布矩形
+// - ASSRender::blendSingleOnly / unpremultiplyAlpha：把合成的 ASS_Image 链混合到脏矩形缓冲区再反预乘
+// - VideoRenderData::splitComponentToPlane：1080p 的 NV12 / P010LE / YUYV422 逐分量拆到独立平面
+// - EpisodeAssetManager::extractEpisodes：不同规模的番剧文件名列表
+// 依赖 Qt、FFmpeg 与 libass，只随主工程构建(-DAZPLAYER_BUILD_BENCH=ON)
+
+#include "renderer/assrender.h"
+#include "renderer/renderdata.h"
+#include "utils/dirtyrectmanager.h"
+#include "utils/episodeassetmanager.h"
+#include <QRect>
+#include <QString>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+AZ_EXTERN_C_BEGIN
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+AZ_EXTERN_C_END
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    volatile uint64_t g_sink = 0; // 防止结果被优化掉
+
+    // 重复执行 func 至少 minSeconds 秒(且至少 3 次)，返回每次的平均耗时(ns)
+    template <typename Func>
+    double measure(Func &&func, double minSeconds = 0.3) {
+        func(); // 预热
+        uint64_t iterations = 0;
+        const Clock::time_point begin = Clock::now();
+        double sec = 0.0;
+        do {
+            func();
+            ++iterations;
+            sec = std::chrono::duration<double>(Clock::now() - begin).count();
+        } while (sec < minSeconds || iterations < 3);
+        return sec * 1e9 / iterations;
+    }
+
+    // 底部两行字幕，每个字形一个矩形，与相邻字形有少量重叠(描边/阴影)
+    std::vector<QRect> glyphRects() {
+        std::vector<QRect> rects;
+        for (int line = 0; line < 2; ++line) {
+            const int y = 930 + line * 56;
+            for (int i = 0; i < 40; ++i) {
+                rects.emplace_back(400 + i * 28, y, 32, 48);
+            }
+        }
+        return rects;
+    }
+
+    // 特效字幕：全屏散布的小矩形
+    std::vector<QRect> scatteredRects(size_t count) {
+        std::mt19937 rng(7);
+        std::vector<QRect> rects;
+        for (size_t i = 0; i < count; ++i) {
+            const int w = 16 + static_cast<int>(rng() % 48);
+            const int h = 16 + static_cast<int>(rng() % 48);
+            rects.emplace_back(static_cast<int>(rng() % (1920 - w)), static_cast<int>(rng() % (1080 - h)), w, h);
+        }
+        return rects;
+    }
+
+    void benchDirtyRects() {
+        std::printf("DirtyRectManager init + addRect\n");
+        std::printf("  %-16s %8s %8s %12s %12s\n", "layout", "rects", "merged", "us/frame", "ns/rect");
+        struct Case {
+            const char *name;
+            std::vector<QRect> rects;
+        };
+        const Case cases[] = {
+            {"glyphs 2x40", glyphRects()},
+            {"scattered 50", scatteredRects(50)},
+            {"scattered 200", scatteredRects(200)},
+        };
+        for (const Case &c : cases) {
+            DirtyRectManager manager;
+            const double ns = measure([&]() {
+                manager.init();
+                for (const QRect &rect : c.rects) {
+                    manager.addRect(rect);
+                }
+                g_sink = g_sink + manager.size();
+            });
+            std::printf("  %-16s %8zu %8zu %12.2f %12.1f\n", c.name, c.rects.size(), manager.size(), ns / 1e3, ns / c.rects.size());
+        }
+    }
+
+    void benchBlend() {
+        std::printf("\nASSRender blendSingleOnly / unpremultiplyAlpha\n");
+        std::printf("  %-16s %8s %12s %12s %12s %12s\n", "layout", "images", "blend us", "Mpix/s", "unpremul us", "Mpix/s");
+        struct Case {
+            const char *name;
+            std::vector<QRect> rects;
+        };
+        const Case cases[] = {
+            {"glyphs 2x40", glyphRects()},
+            {"scattered 200", scatteredRects(200)},
+        };
+        for (const Case &c : cases) {
+            // 每个矩形三张图：阴影、描边、字形本体，与 libass 的输出一致
+            const size_t imageCount = c.rects.size() * 3;
+            std::vector<ASS_Image> images(imageCount);
+            std::vector<std::vector<unsigned char>> bitmaps(imageCount);
+            std::mt19937 rng(11);
+            uint64_t pixels = 0;
+            for (size_t i = 0; i < imageCount; ++i) {
+                const QRect &rect = c.rects[i / 3];
+                ASS_Image &img = images[i];
+                img.w = rect.width();
+                img.h = rect.height();
+                img.stride = (img.w + 15) & ~15;
+                img.dst_x = rect.x();
+                img.dst_y = rect.y();
+                img.color = (i % 3 == 2) ? 0xFFFFFF00u : 0x00000040u;
+                bitmaps[i].resize(static_cast<size_t>(img.stride) * img.h);
+                for (unsigned char &v : bitmaps[i]) {
+                    v = static_cast<unsigned char>(rng() % 3 == 0 ? 0 : rng() % 256); // 约三分之一透明
+                }
+                img.bitmap = bitmaps[i].data();
+                img.next = i + 1 < imageCount ? &images[i + 1] : nullptr;
+                pixels += static_cast<uint64_t>(img.w) * img.h;
+            }
+
+            DirtyRectManager manager;
+            manager.init();
+            for (const QRect &rect : c.rects) {
+                manager.addRect(rect);
+            }
+            std::vector<std::vector<uint8_t>> dataArr(manager.size());
+            uint64_t bufferPixels = 0;
+            for (size_t i = 0; i < manager.size(); ++i) {
+                dataArr[i].assign(static_cast<size_t>(manager[i].width()) * manager[i].height() * 4, 0);
+                bufferPixels += dataArr[i].size() / 4;
+            }
+
+            const double blendNs = measure([&]() {
+                for (const ASS_Image *img = images.data(); img; img = img->next) {
+                    ASSRender::blendSingleOnly(manager, dataArr, img);
+                }
+                g_sink = g_sink + dataArr[0][3];
+            });
+            // 反预乘会就地修改缓冲区，每次从混合结果的副本开始
+            const std::vector<std::vector<uint8_t>> blended = dataArr;
+            const double unpremulNs = measure([&]() {
+                for (size_t i = 0; i < dataArr.size(); ++i) {
+                    std::memcpy(dataArr[i].data(), blended[i].data(), blended[i].size());
+                    ASSRender::unpremultiplyAlpha(dataArr[i]);
+                }
+                g_sink = g_sink + dataArr[0][3];
+            });
+            const double copyNs = measure([&]() {
+                for (size_t i = 0; i < dataArr.size(); ++i) {
+                    std::memcpy(dataArr[i].data(), blended[i].data(), blended[i].size());
+                }
+                g_sink = g_sink + dataArr[0][3];
+            });
+            const double netUnpremulNs = std::max(unpremulNs - copyNs, 1.0);
+            std::printf("  %-16s %8zu %12.1f %12.1f %12.1f %12.1f\n", c.name, imageCount,
+                        blendNs / 1e3, pixels / blendNs * 1e3, netUnpremulNs / 1e3, bufferPixels / netUnpremulNs * 1e3);
+        }
+    }
+
+    void benchSplitComponent() {
+        std::printf("\nVideoRenderData::splitComponentToPlane (1920x1080)\n");
+        std::printf("  %-12s %10s %12s\n", "format", "component", "ms/frame");
+        for (AVPixelFormat fmt : {AV_PIX_FMT_NV12, AV_PIX_FMT_P010LE, AV_PIX_FMT_YUYV422}) {
+            const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(fmt);
+            VideoRenderData data; // 析构时释放 frm
+            AVFrame *frm = av_frame_alloc();
+            if (frm) {
+                frm->format = fmt;
+                frm->width = 1920;
+                frm->height = 1080;
+            }
+            if (!frm || av_frame_get_buffer(frm, 0) < 0) {
+                std::printf("  %-12s allocation failed\n", desc->name);
+                av_frame_free(&frm);
+                continue;
+            }
+            for (int p = 0; p < 4 && frm->buf[p]; ++p) {
+                std::memset(frm->buf[p]->data, 0x5a + p, frm->buf[p]->size);
+            }
+            data.frmItem.frm = frm;
+
+            double totalNs = 0.0;
+            for (int c = 0; c < desc->nb_components; ++c) {
+                const double ns = measure([&]() {
+                    data.splitComponentToPlane(c, desc);
+                    g_sink = g_sink + data.dst16[c][0];
+                });
+                totalNs += ns;
+                std::printf("  %-12s %10d %12.3f\n", desc->name, c, ns / 1e6);
+            }
+            std::printf("  %-12s %10s %12.3f\n", desc->name, "all", totalNs / 1e6);
+        }
+    }
+
+    // 若干部番剧的视频与字幕文件名，共 count 个
+    std::vector<QString> episodeNames(size_t count) {
+        static const char *const kShows[] = {"Sousou no Frieren", "Kusuriya no Hitorigoto", "Dungeon Meshi", "Bocchi the Rock!"};
+        static const char *const kGroups[] = {"[LoliHouse]", "[Nekomoe kissaten]", "[SweetSub&LoliHouse]"};
+        std::vector<QString> names;
+        names.reserve(count);
+        for (size_t i = 0; names.size() < count; ++i) {
+            const size_t show = (i / 48) % 4;
+            const int episode = static_cast<int>(i / 2 % 24) + 1;
+            const QString base = QString("%1 %2 - %3 [WebRip 1080p HEVC-10bit AAC]")
+                                     .arg(kGroups[show % 3])
+                                     .arg(kShows[show])
+                                     .arg(episode, 2, 10, QChar('0'));
+            names.push_back(base + (i % 2 == 0 ? ".mkv" : ".SC.ass"));
+        }
+        return names;
+    }
+
+    void benchExtractEpisodes() {
+        std::printf("\nEpisodeAssetManager::extractEpisodes\n");
+        std::printf("  %-8s %12s %12s\n", "files", "us/call", "ns/file");
+        for (size_t count : {size_t{24}, size_t{100}, size_t{1000}}) {
+            const std::vector<QString> names = episodeNames(count);
+            const double ns = measure([&]() {
+                const std::vector<int> episodes = EpisodeAssetManager::extractEpisodes(names);
+                g_sink = g_sink + static_cast<uint64_t>(episodes.back());
+            });
+            std::printf("  %-8zu %12.2f %12.1f\n", count, ns / 1e3, ns / count);
+        }
+    }
+}
+
+int main() {
+    benchDirtyRects();
+    benchBlend();
+    benchSplitComponent();
+    benchExtractEpisodes();
+    return 0;
+}
@@ -0,0 +1,83 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// 播放统计记录开销微基准：原先每个样本 deque push/pop + 求和的 10 样本均值 vs LatencyHistogram::record
+// 同时用排序得到的精确百分位检查直方图的误差
+
+#include "stats/latencyhistogram.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr int kSamples = 2'000'000;
+
+    // 原 PlaybackStats::calculateAverage
+    double legacyAverage(std::deque<double> &deq, double value) {
+        deq.push_back(value);
+        if (deq.size() > 10) {
+            deq.pop_front();
+        }
+        return std::accumulate(deq.begin(), deq.end(), 0.0) / deq.size();
+    }
+
+    template <typename Func>
+    double nsPerSample(Func &&func) {
+        const auto begin = std::chrono::steady_clock::now();
+        func();
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - begin).count() / kSamples;
+    }
+}
+
+int main() {
+    // 对数正态的耗时(us)，中位数约 4ms，带长尾
+    std::mt19937_64 rng(42);
+    std::lognormal_distribution<double> dist(std::log(4000.0), 0.6);
+    std::vector<uint64_t> samples(kSamples);
+    for (uint64_t &s : samples) {
+        s = static_cast<uint64_t>(dist(rng));
+    }
+
+    std::deque<double> deq;
+    double avg = 0.0;
+    const double legacyNs = nsPerSample([&] {
+        for (uint64_t s : samples) {
+            avg = legacyAverage(deq, s * 0.001);
+        }
+    });
+
+    static LatencyHistogram hist;
+    const double histNs = nsPerSample([&] {
+        for (uint64_t s : samples) {
+            hist.record(s);
+        }
+    });
+
+    const auto begin = std::chrono::steady_clock::now();
+    const LatencyHistogram::Snapshot snap = hist.snapshot();
+    const double snapshotUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+
+    std::printf("%-24s %10.2f ns/sample   (avg %.3f)\n", "deque 10-sample mean", legacyNs, avg);
+    std::printf("%-24s %10.2f ns/sample\n", "LatencyHistogram", histNs);
+    std::printf("%-24s %10.2f us\n", "snapshot", snapshotUs);
+
+    std::sort(samples.begin(), samples.end());
+    auto exact = [&](double p) {
+        return static_cast<double>(samples[static_cast<size_t>(std::ceil(p * kSamples)) - 1]);
+    };
+    const double ps[] = {0.50, 0.95, 0.99};
+    const double got[] = {snap.p50, snap.p95, snap.p99};
+    std::printf("\n%-6s %12s %12s %8s\n", "pct", "exact(us)", "hist(us)", "err%");
+    for (int i = 0; i < 3; ++i) {
+        const double e = exact(ps[i]);
+        std::printf("p%-5.0f %12.0f %12.1f %8.2f\n", ps[i] * 100, e, got[i], 100.0 * (got[i] - e) / e);
+    }
+    std::printf("%-6s %12llu %12llu\n", "max", static_cast<unsigned long long>(samples.back()), static_cast<unsigned long long>(snap.max));
+    return 0;
+}
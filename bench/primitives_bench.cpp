@@ -0,0 +1,202 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// 无锁队列在不同线程配对与容量下的吞吐和延迟
+// - SPSCRing：帧队列的元素(与 AVFrmItem 大小相当)，容量取播放器实际使用的 3/16/50 和一个大容量
+// - SPSCRing 往返延迟：两个容量为 1 的队列做 ping-pong，记录每次往返的耗时分布
+// - SPSCBuffer：PCM 字节流，按不同块大小写入/读出
+// 单核机器上没有 cross-core 配对，same-core/unpinned 的结果主要反映线程切换开销
+
+#include "benchcommon.h"
+#include "stats/latencyhistogram.h"
+#include "utils/spscbuffer.h"
+#include "utils/spscring.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr size_t kRingItems = 1'000'000;
+    constexpr size_t kRoundTrips = 100'000;
+    constexpr uint64_t kBufferBytes = uint64_t{256} << 20;
+    constexpr uint64_t kBufferCapacity = uint64_t{1} << 16;
+
+    // 与 AVFrmItem 大小相当
+    struct Item {
+        void *frm = nullptr;
+        unsigned char sub[48]{};
+        int width = 0, height = 0;
+        int serial = 0;
+        double pts = 0.0;
+        double duration = 0.0;
+        uint64_t seq = 0;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double secondsSince(Clock::time_point begin) {
+        return std::chrono::duration<double>(Clock::now() - begin).count();
+    }
+
+    // 在配对指定的核上分别运行生产者和消费者，返回总耗时(秒)
+    template <typename Producer, typename Consumer>
+    double runPair(bench::Pairing pairing, Producer &&producer, Consumer &&consumer) {
+        const auto [producerCpu, consumerCpu] = bench::pairingCpus(pairing);
+        std::atomic<int> ready{0};
+        auto waitReady = [&]() {
+            ready.fetch_add(1);
+            while (ready.load() < 2) {
+                std::this_thread::yield();
+            }
+        };
+        Clock::time_point begin;
+        std::thread consumerThread([&]() {
+            (void)bench::pinCurrentThread(consumerCpu);
+            waitReady();
+            consumer();
+        });
+        (void)bench::pinCurrentThread(producerCpu);
+        waitReady();
+        begin = Clock::now();
+        producer();
+        consumerThread.join();
+        const double sec = secondsSince(begin);
+        (void)bench::pinCurrentThread(-1);
+        return sec;
+    }
+
+    void benchRingThroughput() {
+        std::printf("SPSCRing throughput (%zu items of %zu bytes)\n", kRingItems, sizeof(Item));
+        std::printf("  %-12s %8s %12s %12s\n", "pairing", "capacity", "ns/item", "Mitems/s");
+        for (bench::Pairing pairing : bench::availablePairings()) {
+            for (size_t capacity : {size_t{3}, size_t{16}, size_t{50}, size_t{1024}}) {
+                SPSCRing<Item> ring(capacity);
+                uint64_t checksum = 0;
+                const double sec = runPair(
+                    pairing,
+                    [&]() {
+                        bench::Backoff backoff;
+                        for (uint64_t i = 0; i < kRingItems; ++i) {
+                            Item item;
+                            item.seq = i;
+                            while (!ring.push(std::move(item))) {
+                                backoff.pause();
+                            }
+                            backoff.reset();
+                        }
+                    },
+                    [&]() {
+                        bench::Backoff backoff;
+                        Item item;
+                        for (uint64_t i = 0; i < kRingItems; ++i) {
+                            while (!ring.pop(item)) {
+                                backoff.pause();
+                            }
+                            backoff.reset();
+                            checksum += item.seq;
+                        }
+                    });
+                const uint64_t expected = kRingItems * (kRingItems - 1) / 2;
+                std::printf("  %-12s %8zu %12.1f %12.2f%s\n", bench::pairingName(pairing), capacity,
+                            sec * 1e9 / kRingItems, kRingItems / sec / 1e6, checksum == expected ? "" : "  CHECKSUM MISMATCH");
+            }
+        }
+    }
+
+    void benchRingLatency() {
+        std::printf("\nSPSCRing round-trip latency (%zu ping-pongs, capacity 1)\n", kRoundTrips);
+        std::printf("  %-12s %10s %10s %10s %10s\n", "pairing", "p50 ns", "p95 ns", "p99 ns", "max ns");
+        for (bench::Pairing pairing : bench::availablePairings()) {
+            SPSCRing<uint64_t> ping(1), pong(1);
+            static LatencyHistogram hist;
+            hist.reset();
+            (void)runPair(
+                pairing,
+                [&]() {
+                    bench::Backoff backoff;
+                    uint64_t reply = 0;
+                    for (uint64_t i = 0; i < kRoundTrips; ++i) {
+                        const Clock::time_point begin = Clock::now();
+                        while (!ping.push(uint64_t{i})) {
+                            backoff.pause();
+                        }
+                        backoff.reset();
+                        while (!pong.pop(reply)) {
+                            backoff.pause();
+                        }
+                        backoff.reset();
+                        hist.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count()));
+                    }
+                },
+                [&]() {
+                    bench::Backoff backoff;
+                    uint64_t value = 0;
+                    for (uint64_t i = 0; i < kRoundTrips; ++i) {
+                        while (!ping.pop(value)) {
+                            backoff.pause();
+                        }
+                        backoff.reset();
+                        while (!pong.push(uint64_t{value})) {
+                            backoff.pause();
+                        }
+                        backoff.reset();
+                    }
+                });
+            const LatencyHistogram::Snapshot snap = hist.snapshot();
+            std::printf("  %-12s %10.0f %10.0f %10.0f %10llu\n", bench::pairingName(pairing),
+                        snap.p50, snap.p95, snap.p99, static_cast<unsigned long long>(snap.max));
+        }
+    }
+
+    void benchBufferThroughput() {
+        std::printf("\nSPSCBuffer throughput (%llu MiB through a %llu KiB ring)\n",
+                    static_cast<unsigned long long>(kBufferBytes >> 20), static_cast<unsigned long long>(kBufferCapacity >> 10));
+        std::printf("  %-12s %8s %12s\n", "pairing", "chunk", "GiB/s");
+        for (bench::Pairing pairing : bench::availablePairings()) {
+            for (uint64_t chunk : {uint64_t{64}, uint64_t{1024}, uint64_t{8192}}) {
+                SPSCBuffer buffer(kBufferCapacity);
+                std::vector<uint8_t> in(chunk, 0x5a), out(chunk);
+                uint64_t received = 0;
+                const double sec = runPair(
+                    pairing,
+                    [&]() {
+                        bench::Backoff backoff;
+                        for (uint64_t sent = 0; sent < kBufferBytes;) {
+                            const uint64_t n = buffer.write(in.data(), std::min(chunk, kBufferBytes - sent));
+                            if (n == 0) {
+                                backoff.pause();
+                                continue;
+                            }
+                            backoff.reset();
+                            sent += n;
+                        }
+                    },
+                    [&]() {
+                        bench::Backoff backoff;
+                        while (received < kBufferBytes) {
+                            const uint64_t n = buffer.read(out.data(), chunk);
+                            if (n == 0) {
+                                backoff.pause();
+                                continue;
+                            }
+                            backoff.reset();
+                            received += n;
+                        }
+                    });
+                std::printf("  %-12s %8llu %12.2f\n", bench::pairingName(pairing), static_cast<unsigned long long>(chunk),
+                            static_cast<double>(kBufferBytes) / sec / (1u << 30));
+            }
+        }
+    }
+}
+
+int main() {
+    std::printf("cpus: %d\n\n", bench::cpuCount());
+    benchRingThroughput();
+    benchRingLatency();
+    benchBufferThroughput();
+    return 0;
+}
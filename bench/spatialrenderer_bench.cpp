@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// 空间音频渲染(SpatialRenderer)微基准，单位：每秒输出音频耗费的 CPU 时间(us)，以及单核实时倍数
+// 覆盖 Ambisonics -> 双耳/扬声器、多声道 -> 双耳、22.2 -> 5.1 几种典型场景
+
+#include "audio/spatialrenderer.h"
+#include "benchcommon.h"
+#include <cstdio>
+#include <vector>
+
+namespace {
+    using Channel = SpatialRenderer::Channel;
+
+    constexpr int kFramesPerChunk = 1024; // 与 AudioPlayer 每次写入环形缓冲区的量级相当
+
+    Channel speaker(float azimuth, float elevation) {
+        return {Channel::Type::Speaker, azimuth, elevation, 0};
+    }
+
+    Channel lfe() {
+        return {Channel::Type::LFE, 0.0f, 0.0f, 0};
+    }
+
+    std::vector<Channel> ambisonics(int order) {
+        std::vector<Channel> layout;
+        for (int acn = 0; acn < (order + 1) * (order + 1); ++acn) {
+            layout.push_back({Channel::Type::Ambisonic, 0.0f, 0.0f, acn});
+        }
+        return layout;
+    }
+
+    std::vector<Channel> stereo() {
+        return {speaker(30, 0), speaker(-30, 0)};
+    }
+
+    std::vector<Channel> surround51() {
+        return {speaker(30, 0), speaker(-30, 0), speaker(0, 0), lfe(), speaker(110, 0), speaker(-110, 0)};
+    }
+
+    std::vector<Channel> surround71() {
+        return {speaker(30, 0), speaker(-30, 0), speaker(0, 0), lfe(), speaker(150, 0), speaker(-150, 0), speaker(90, 0), speaker(-90, 0)};
+    }
+
+    std::vector<Channel> surround714() {
+        std::vector<Channel> layout = surround71();
+        for (float az : {30.0f, -30.0f, 150.0f, -150.0f}) {
+            layout.push_back(speaker(az, 45));
+        }
+        return layout;
+    }
+
+    std::vector<Channel> surround222() {
+        return {speaker(30, 0), speaker(-30, 0), speaker(0, 0), lfe(), speaker(150, 0), speaker(-150, 0),
+                speaker(15, 0), speaker(-15, 0), speaker(180, 0), lfe(), speaker(90, 0), speaker(-90, 0),
+                speaker(30, 45), speaker(-30, 45), speaker(0, 45), speaker(0, 90), speaker(150, 45), speaker(-150, 45),
+                speaker(90, 45), speaker(-90, 45), speaker(180, 45), speaker(0, -30), speaker(30, -30), speaker(-30, -30)};
+    }
+
+    struct Case {
+        const char *name;
+        std::vector<Channel> in;
+        std::vector<Channel> out;
+        bool binaural;
+    };
+}
+
+int main() {
+    const Case cases[] = {
+        {"FOA->binaural", ambisonics(1), stereo(), true},
+        {"3OA->binaural", ambisonics(3), stereo(), true},
+        {"3OA->7.1", ambisonics(3), surround71(), false},
+        {"7.1.4->binaural", surround714(), stereo(), true},
+        {"22.2->5.1", surround222(), surround51(), false},
+    };
+
+    bench::printAudioHeader("us/second");
+    for (const Case &cs : cases) {
+        SpatialRenderer renderer;
+        if (!renderer.init(cs.in, cs.out, bench::kSampleRate, cs.binaural)) {
+            std::printf("%s: init failed\n", cs.name);
+            return 1;
+        }
+
+        const int inChannels = static_cast<int>(cs.in.size());
+        std::vector<std::vector<float>> input(inChannels, std::vector<float>(kFramesPerChunk));
+        std::vector<const float *> planes(inChannels);
+        for (int c = 0; c < inChannels; ++c) {
+            for (int i = 0; i < kFramesPerChunk; ++i) {
+                input[c][i] = bench::signalSample(c, i);
+            }
+            planes[c] = input[c].data();
+        }
+        std::vector<float> dst(static_cast<size_t>(kFramesPerChunk) * cs.out.size());
+
+        const double us = bench::audioUsPerSecond(kFramesPerChunk, [&](int) {
+            renderer.process(planes.data(), dst.data(), kFramesPerChunk);
+        });
+
+        char sample[32];
+        // 输出 dst 中的一个值，防止渲染被优化掉
+        std::snprintf(sample, sizeof(sample), "(%g)", dst[dst.size() / 2]);
+        bench::printAudioRow(cs.name, us, sample);
+    }
+    return 0;
+}
@@ -0,0 +1,256 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// SPSCRing / SPSCBuffer 压力测试：生产者/消费者各一个线程，传递数百万个元素并逐个校验
+// 配合 ThreadSanitizer 使用(-DAZPLAYER_BENCH_TSAN=ON)，用于验证对这些结构的改动没有引入数据竞争
+// 用法: stress_spsc [百万次操作数，默认 1]
+// 任一项校验失败时返回 1
+
+#include "benchcommon.h"
+#include "utils/spscbuffer.h"
+#include "utils/spscring.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr double kBytesPerSec = 48000.0 * 2 * 4; // 48kHz 立体声 f32
+    constexpr uint32_t kFrameSize = 12;               // 不整除容量，覆盖跨越首尾的整帧中转
+
+    // 流中第 offset 个字节的内容
+    uint8_t patternByte(uint64_t offset) {
+        return static_cast<uint8_t>((offset * 131) ^ (offset >> 8));
+    }
+
+    struct Failure {
+        std::atomic<bool> failed{false};
+        void report(const char *test, const char *what, uint64_t at) {
+            if (!failed.exchange(true))
+                std::fprintf(stderr, "[%s] %s at %llu\n", test, what, static_cast<unsigned long long>(at));
+        }
+    };
+
+    template <typename Producer, typename Consumer>
+    bool runPair(bench::Pairing pairing, Failure &failure, Producer &&producer, Consumer &&consumer) {
+        const auto [producerCpu, consumerCpu] = bench::pairingCpus(pairing);
+        std::thread consumerThread([&]() {
+            (void)bench::pinCurrentThread(consumerCpu);
+            consumer();
+        });
+        (void)bench::pinCurrentThread(producerCpu);
+        producer();
+        consumerThread.join();
+        (void)bench::pinCurrentThread(-1);
+        return !failure.failed.load();
+    }
+
+    // push/pop，元素持有堆内存，检查原地构造/析构与顺序
+    bool ringPushPop(bench::Pairing pairing, uint64_t ops) {
+        SPSCRing<std::unique_ptr<uint64_t>> ring(3);
+        Failure failure;
+        return runPair(
+            pairing, failure,
+            [&]() {
+                bench::Backoff backoff;
+                for (uint64_t i = 0; i < ops && !failure.failed.load(std::memory_order_relaxed); ++i) {
+                    auto value = std::make_unique<uint64_t>(i);
+                    while (!ring.push(std::move(value))) {
+                        backoff.pause();
+                    }
+                    backoff.reset();
+                }
+            },
+            [&]() {
+                bench::Backoff backoff;
+                std::unique_ptr<uint64_t> value;
+                for (uint64_t i = 0; i < ops; ++i) {
+                    while (!ring.pop(value)) {
+                        if (failure.failed.load(std::memory_order_relaxed))
+                            return;
+                        backoff.pause();
+                    }
+                    backoff.reset();
+                    if (!value || *value != i)
+                        return failure.report("ring push/pop", "out of order", i);
+                }
+            });
+    }
+
+    // pushBatch 写入、front/popFront 原地读取
+    bool ringBatchFront(bench::Pairing pairing, uint64_t ops) {
+        SPSCRing<std::unique_ptr<uint64_t>> ring(16);
+        Failure failure;
+        return runPair(
+            pairing, failure,
+            [&]() {
+                bench::Backoff backoff;
+                std::mt19937 rng(1);
+                std::unique_ptr<uint64_t> batch[7];
+                for (uint64_t next = 0; next < ops && !failure.failed.load(std::memory_order_relaxed);) {
+                    const size_t count = std::min<uint64_t>(rng() % 7 + 1, ops - next);
+                    for (size_t k = 0; k < count; ++k) {
+                        batch[k] = std::make_unique<uint64_t>(next + k);
+                    }
+                    size_t written = 0;
+                    while (written < count) {
+                        const size_t n = ring.pushBatch(batch + written, count - written);
+                        if (n == 0) {
+                            backoff.pause();
+                            continue;
+                        }
+                        backoff.reset();
+                        written += n;
+                    }
+                    next += count;
+                }
+            },
+            [&]() {
+                bench::Backoff backoff;
+                for (uint64_t i = 0; i < ops; ++i) {
+                    std::unique_ptr<uint64_t> *front = nullptr;
+                    while ((front = ring.front()) == nullptr) {
+                        if (failure.failed.load(std::memory_order_relaxed))
+                            return;
+                        backoff.pause();
+                    }
+                    backoff.reset();
+                    if (!*front || **front != i)
+                        return failure.report("ring batch/front", "out of order", i);
+                    ring.popFront();
+                }
+            });
+    }
+
+    // waitPush 写入、popBatch 读取，最后用 stop 让阻塞的生产者退出
+    bool ringWaitPushPopBatch(bench::Pairing pairing, uint64_t ops) {
+        SPSCRing<uint64_t> ring(50);
+        Failure failure;
+        std::atomic<bool> stop{false};
+        bool stoppedEarly = false;
+        const bool ok = runPair(
+            pairing, failure,
+            [&]() {
+                for (uint64_t i = 0; i < ops + ring.capacity() + 1; ++i) {
+                    if (!ring.waitPush(uint64_t{i}, stop)) {
+                        stoppedEarly = true;
+                        return;
+                    }
+                }
+            },
+            [&]() {
+                bench::Backoff backoff;
+                uint64_t batch[13];
+                for (uint64_t i = 0; i < ops;) {
+                    const size_t n = ring.popBatch(batch, std::min<uint64_t>(13, ops - i));
+                    if (n == 0) {
+                        backoff.pause();
+                        continue;
+                    }
+                    backoff.reset();
+                    for (size_t k = 0; k < n; ++k, ++i) {
+                        if (batch[k] != i) {
+                            failure.report("ring waitPush/popBatch", "out of order", i);
+                            stop.store(true);
+                            return;
+                        }
+                    }
+                }
+                // 不再消费，生产者多写的元素会填满队列并阻塞，直到 stop
+                stop.store(true);
+            });
+        if (ok && !stoppedEarly)
+            failure.report("ring waitPush/popBatch", "waitPush ignored stop", ops);
+        return ok && stoppedEarly;
+    }
+
+    // writeFrames 整帧写入(含跨越首尾的帧)与 pts 标记，随机长度读出，逐字节校验并核对 readPts
+    bool bufferFramesAndPts(bench::Pairing pairing, uint64_t ops) {
+        SPSCBuffer buffer(uint64_t{1} << 12);
+        Failure failure;
+        const uint64_t totalBytes = ops * kFrameSize;
+        return runPair(
+            pairing, failure,
+            [&]() {
+                bench::Backoff backoff;
+                std::mt19937 rng(2);
+                uint64_t written = 0;
+                while (written < totalBytes && !failure.failed.load(std::memory_order_relaxed)) {
+                    buffer.pushPtsMarker(written / kBytesPerSec, kBytesPerSec);
+                    const uint64_t maxFrames = std::min<uint64_t>(rng() % 64 + 1, (totalBytes - written) / kFrameSize);
+                    const int64_t frames = buffer.writeFrames(kFrameSize, maxFrames, [&](uint8_t *dst, uint64_t n) -> int64_t {
+                        const uint64_t offset = written;
+                        for (uint64_t k = 0; k < n * kFrameSize; ++k) {
+                            dst[k] = patternByte(offset + k);
+                        }
+                        written += n * kFrameSize;
+                        return static_cast<int64_t>(n);
+                    });
+                    if (frames == 0)
+                        backoff.pause();
+                    else
+                        backoff.reset();
+                }
+            },
+            [&]() {
+                bench::Backoff backoff;
+                std::mt19937 rng(3);
+                std::vector<uint8_t> out(1024);
+                uint64_t consumed = 0;
+                while (consumed < totalBytes) {
+                    const double pts = buffer.readPts(kBytesPerSec);
+                    if (std::isnan(pts) ? consumed != 0 : std::abs(pts - consumed / kBytesPerSec) > 1e-6)
+                        return failure.report("buffer frames/pts", "readPts mismatch", consumed);
+
+                    const uint64_t n = buffer.read(out.data(), rng() % out.size() + 1);
+                    if (n == 0) {
+                        if (failure.failed.load(std::memory_order_relaxed))
+                            return;
+                        backoff.pause();
+                        continue;
+                    }
+                    backoff.reset();
+                    for (uint64_t k = 0; k < n; ++k) {
+                        if (out[k] != patternByte(consumed + k))
+                            return failure.report("buffer frames/pts", "corrupted byte", consumed + k);
+                    }
+                    consumed += n;
+                }
+            });
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const double millions = argc > 1 ? std::atof(argv[1]) : 1.0;
+    if (!(millions > 0.0)) {
+        std::fprintf(stderr, "usage: stress_spsc [millions of operations]\n");
+        return 2;
+    }
+    const uint64_t ops = static_cast<uint64_t>(millions * 1e6);
+
+    struct Test {
+        const char *name;
+        bool (*run)(bench::Pairing, uint64_t);
+    };
+    const Test tests[] = {
+        {"ring push/pop", ringPushPop},
+        {"ring batch/front", ringBatchFront},
+        {"ring waitPush/popBatch", ringWaitPushPopBatch},
+        {"buffer frames/pts", bufferFramesAndPts},
+    };
+
+    bool allOk = true;
+    for (bench::Pairing pairing : bench::availablePairings()) {
+        for (const Test &test : tests) {
+            const bool ok = test.run(pairing, ops);
+            std::printf("%-24s %-12s %s\n", test.name, bench::pairingName(pairing), ok ? "ok" : "FAILED");
+            std::fflush(stdout);
+            allOk &= ok;
+        }
+    }
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// SPSCBuffer 微基准：模拟重采样输出写入 PCM 环形缓冲区
+// write: 先转换到中间缓冲再 memcpy 进环形缓冲区(旧路径)
+// writeFrames: 直接转换到环形缓冲区内存(reserve/commit)
+
+#include "utils/spscbuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr int kChannels = 6;                                 // 5.1
+    constexpr uint32_t kFrameSize = kChannels * sizeof(float);   // 24 字节，不是 2 的幂，会跨越环形缓冲区首尾
+    constexpr int kFramesPerPacket = 1024;                       // 一个音频帧的采样数
+    constexpr uint64_t kRingCapacity = 1u << 17;                 // 48kHz 5.1 f32 约 100ms
+    constexpr uint64_t kTotalFrames = 48000ull * 60 * 10;        // 10 分钟音频
+    constexpr uint64_t kCallbackBytes = 480 * kFrameSize;        // 一次回调读取 10ms
+
+    // 模拟 swr_convert：s16 planar -> f32 packed
+    void convert(const std::vector<std::vector<int16_t>> &src, int offset, uint8_t *dst, int frames) {
+        float *out = reinterpret_cast<float *>(dst);
+        for (int i = 0; i < frames; ++i) {
+            for (int c = 0; c < kChannels; ++c) {
+                *out++ = src[c][offset + i] * (1.0f / 32768.0f);
+            }
+        }
+    }
+
+    struct Result {
+        double seconds;
+        uint64_t checksum;
+    };
+
+    // 生产者写入 kTotalFrames 帧，消费者线程按回调大小读出
+    // verify 为 true 时消费者计算校验和(用于比较两条路径的输出是否一致，不计入耗时比较)
+    template <typename WriteFunc>
+    Result run(bool verify, WriteFunc &&writePacket) {
+        SPSCBuffer ring(kRingCapacity);
+        std::atomic<bool> done{false};
+        uint64_t checksum = 0;
+
+        std::thread consumer([&] {
+            std::vector<uint8_t> out(kCallbackBytes);
+            while (true) {
+                const uint64_t n = ring.read(out.data(), out.size());
+                for (uint64_t i = 0; verify && i + 4 <= n; i += 4) {
+                    uint32_t v;
+                    std::memcpy(&v, out.data() + i, 4);
+                    checksum = checksum * 31 + v;
+                }
+                if (n == 0) {
+                    if (done.load(std::memory_order_acquire) && ring.readAvailable() == 0)
+                        break;
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        const auto begin = std::chrono::steady_clock::now();
+        for (uint64_t written = 0; written < kTotalFrames; written += kFramesPerPacket) {
+            writePacket(ring);
+        }
+        done.store(true, std::memory_order_release);
+        consumer.join();
+        const auto end = std::chrono::steady_clock::now();
+        return {std::chrono::duration<double>(end - begin).count(), checksum};
+    }
+}
+
+int main() {
+    std::vector<std::vector<int16_t>> src(kChannels, std::vector<int16_t>(kFramesPerPacket));
+    for (int c = 0; c < kChannels; ++c) {
+        for (int i = 0; i < kFramesPerPacket; ++i) {
+            src[c][i] = static_cast<int16_t>((i * 37 + c * 1001) & 0x7fff);
+        }
+    }
+
+    // 旧路径：转换到中间缓冲，再拷贝进环形缓冲区
+    std::vector<uint8_t> staging(kFramesPerPacket * kFrameSize);
+    auto writeCopy = [&](SPSCBuffer &ring) {
+        convert(src, 0, staging.data(), kFramesPerPacket);
+        uint64_t offset = 0;
+        while (offset < staging.size()) {
+            const uint64_t n = ring.write(staging.data() + offset, staging.size() - offset);
+            offset += n;
+            if (n == 0)
+                std::this_thread::yield();
+        }
+    };
+
+    // 新路径：直接转换到环形缓冲区
+    auto writeSpan = [&](SPSCBuffer &ring) {
+        int offset = 0;
+        while (offset < kFramesPerPacket) {
+            const int64_t n = ring.writeFrames(kFrameSize, kFramesPerPacket - offset, [&](uint8_t *dst, uint64_t frames) -> int64_t {
+                const int count = static_cast<int>(frames);
+                convert(src, offset, dst, count);
+                offset += count;
+                return count;
+            });
+            if (n == 0)
+                std::this_thread::yield();
+        }
+    };
+
+    const uint64_t copyChecksum = run(true, writeCopy).checksum;
+    const uint64_t spanChecksum = run(true, writeSpan).checksum;
+    if (copyChecksum != spanChecksum) {
+        std::printf("checksum mismatch: %llu != %llu\n", static_cast<unsigned long long>(copyChecksum),
+                    static_cast<unsigned long long>(spanChecksum));
+        return 1;
+    }
+
+    const Result copyResult = run(false, writeCopy);
+    const Result spanResult = run(false, writeSpan);
+
+    const double mb = static_cast<double>(kTotalFrames) * kFrameSize / (1024.0 * 1024.0);
+    std::printf("%-12s %10s %12s\n", "path", "time(ms)", "MB/s");
+    std::printf("%-12s %10.1f %12.1f\n", "write", copyResult.seconds * 1000, mb / copyResult.seconds);
+    std::printf("%-12s %10.1f %12.1f\n", "writeFrames", spanResult.seconds * 1000, mb / spanResult.seconds);
+    return 0;
+}
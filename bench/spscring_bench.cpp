@@ -0,0 +1,250 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// SPSCRing 微基准：与原来的 SPSCQueue(取模索引、按值拷贝)对比，容量取播放器实际使用的 1/3/16/50
+// 单线程：生产者/消费者在同一线程交替，测单次操作本身的开销
+// 双线程：两个线程间传递元素，测缓存行争用(单核机器上主要是线程切换，参考意义不大)
+
+#include "benchcommon.h"
+#include "utils/spscring.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr size_t kItems = 4'000'000;
+    constexpr size_t kBatch = 8;
+
+    // 只有索引开销
+    struct SmallItem {
+        int serial = 0;
+        double pts = 0.0;
+    };
+
+    // 与 AVFrmItem 大小相当(内嵌 AVSubtitle)，拷贝开销明显
+    struct Item {
+        void *frm = nullptr;
+        unsigned char sub[48]{};
+        int width = 0, height = 0;
+        int serial = 0;
+        double pts = 0.0;
+        double duration = 0.0;
+    };
+
+    // 原 utils.h 中的 SPSCQueue，作为对比基线
+    template <typename T>
+    class LegacyQueue {
+    public:
+        explicit LegacyQueue(size_t capacity)
+            : m_capacity(capacity + 1), m_buffer(m_capacity) {}
+
+        bool push(const T &value) {
+            size_t tail = m_tail.load(std::memory_order_relaxed);
+            size_t next = (tail + 1) % m_capacity;
+            if (next == m_head.load(std::memory_order_acquire))
+                return false;
+            m_buffer[tail] = value;
+            m_tail.store(next, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(T &value) {
+            size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire))
+                return false;
+            value = m_buffer[head];
+            m_head.store((head + 1) % m_capacity, std::memory_order_release);
+            return true;
+        }
+
+        bool peekFirst(T &value) {
+            size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire))
+                return false;
+            value = m_buffer[head];
+            return true;
+        }
+
+    private:
+        const size_t m_capacity;
+        std::vector<T> m_buffer;
+        alignas(hardware_destructive_interference_size) std::atomic<size_t> m_head{0};
+        alignas(hardware_destructive_interference_size) std::atomic<size_t> m_tail{0};
+    };
+
+    template <typename Func>
+    double nsPerItem(Func &&func) {
+        const auto begin = std::chrono::steady_clock::now();
+        const uint64_t checksum = func();
+        const auto end = std::chrono::steady_clock::now();
+        bench::doNotOptimize(checksum);
+        return std::chrono::duration<double, std::nano>(end - begin).count() / kItems;
+    }
+
+    // ==== 单线程：填满后 peek + pop 一个、push 一个，模拟视频线程查看下一帧 ====
+    template <typename T>
+    uint64_t legacySingle(size_t capacity) {
+        LegacyQueue<T> q(capacity);
+        T item, peeked, out;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < capacity; ++i) {
+            (void)q.push(item);
+        }
+        for (size_t i = 0; i < kItems; ++i) {
+            (void)q.peekFirst(peeked);
+            (void)q.pop(out);
+            sum += static_cast<uint64_t>(out.serial) + static_cast<uint64_t>(peeked.pts);
+            item.serial = static_cast<int>(i);
+            (void)q.push(item);
+        }
+        return sum;
+    }
+
+    // 与旧接口一一对应的用法：pop 移出、push 移入
+    template <typename T>
+    uint64_t ringSingle(size_t capacity) {
+        SPSCRing<T> q(capacity);
+        uint64_t sum = 0;
+        for (size_t i = 0; i < capacity; ++i) {
+            (void)q.emplace();
+        }
+        T item, out;
+        for (size_t i = 0; i < kItems; ++i) {
+            const T *peeked = q.front();
+            sum += static_cast<uint64_t>(peeked->pts);
+            (void)q.pop(out);
+            sum += static_cast<uint64_t>(out.serial);
+            item.serial = static_cast<int>(i);
+            (void)q.push(std::move(item));
+        }
+        return sum;
+    }
+
+    // 原地访问：front 查看、consume 处理后移除、emplace 原地构造，不拷贝整个元素
+    template <typename T>
+    uint64_t ringInPlace(size_t capacity) {
+        SPSCRing<T> q(capacity);
+        uint64_t sum = 0;
+        for (size_t i = 0; i < capacity; ++i) {
+            (void)q.emplace();
+        }
+        T item;
+        for (size_t i = 0; i < kItems; ++i) {
+            sum += static_cast<uint64_t>(q.front()->pts);
+            (void)q.consume([&sum](T &front) { sum += static_cast<uint64_t>(front.serial); }, 1);
+            item.serial = static_cast<int>(i);
+            (void)q.emplace(item);
+        }
+        return sum;
+    }
+
+    // ==== 双线程 ====
+    uint64_t legacyThreads(size_t capacity) {
+        LegacyQueue<Item> q(capacity);
+        std::thread producer([&] {
+            Item item;
+            for (size_t i = 0; i < kItems; ++i) {
+                item.serial = static_cast<int>(i);
+                while (!q.push(item)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        uint64_t sum = 0;
+        Item out;
+        for (size_t i = 0; i < kItems; ++i) {
+            while (!q.pop(out)) {
+                std::this_thread::yield();
+            }
+            sum += static_cast<uint64_t>(out.serial);
+        }
+        producer.join();
+        return sum;
+    }
+
+    uint64_t ringThreads(size_t capacity) {
+        SPSCRing<Item> q(capacity);
+        std::thread producer([&] {
+            for (size_t i = 0; i < kItems; ++i) {
+                Item item;
+                item.serial = static_cast<int>(i);
+                while (!q.push(std::move(item))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        uint64_t sum = 0;
+        for (size_t i = 0; i < kItems; ++i) {
+            const Item *item;
+            while (!(item = q.front())) {
+                std::this_thread::yield();
+            }
+            sum += static_cast<uint64_t>(item->serial);
+            q.popFront();
+        }
+        producer.join();
+        return sum;
+    }
+
+    uint64_t ringBatchThreads(size_t capacity) {
+        SPSCRing<Item> q(capacity);
+        std::thread producer([&] {
+            Item items[kBatch];
+            size_t sent = 0;
+            while (sent < kItems) {
+                const size_t n = std::min(kBatch, kItems - sent);
+                for (size_t i = 0; i < n; ++i) {
+                    items[i].serial = static_cast<int>(sent + i);
+                }
+                size_t done = 0;
+                while (done < n) {
+                    const size_t pushed = q.pushBatch(items + done, n - done);
+                    if (pushed == 0)
+                        std::this_thread::yield();
+                    done += pushed;
+                }
+                sent += n;
+            }
+        });
+        uint64_t sum = 0;
+        size_t received = 0;
+        while (received < kItems) {
+            const size_t n = q.consume([&sum](Item &item) { sum += static_cast<uint64_t>(item.serial); }, kBatch);
+            if (n == 0)
+                std::this_thread::yield();
+            received += n;
+        }
+        producer.join();
+        return sum;
+    }
+}
+
+int main() {
+    const size_t capacities[] = {1, 3, 16, 50};
+
+    std::printf("single thread (ns/item)\n");
+    std::printf("%-16s %12s %12s %12s\n", "capacity", "SPSCQueue", "SPSCRing", "in place");
+    for (size_t capacity : capacities) {
+        std::printf("%-3zu %-12s %12.2f %12.2f %12.2f\n", capacity, "16B item",
+                    nsPerItem([&] { return legacySingle<SmallItem>(capacity); }),
+                    nsPerItem([&] { return ringSingle<SmallItem>(capacity); }),
+                    nsPerItem([&] { return ringInPlace<SmallItem>(capacity); }));
+        std::printf("%-3zu %-12s %12.2f %12.2f %12.2f\n", capacity, "AVFrmItem",
+                    nsPerItem([&] { return legacySingle<Item>(capacity); }),
+                    nsPerItem([&] { return ringSingle<Item>(capacity); }),
+                    nsPerItem([&] { return ringInPlace<Item>(capacity); }));
+    }
+
+    std::printf("\ntwo threads (ns/item), hardware threads: %u\n", std::thread::hardware_concurrency());
+    std::printf("%-16s %12s %12s %12s\n", "capacity", "SPSCQueue", "SPSCRing", "batch x8");
+    for (size_t capacity : capacities) {
+        std::printf("%-16zu %12.2f %12.2f %12.2f\n", capacity,
+                    nsPerItem([&] { return legacyThreads(capacity); }),
+                    nsPerItem([&] { return ringThreads(capacity); }),
+                    nsPerItem([&] { return ringBatchThreads(capacity); }));
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// 变速不变调(TimeStretcher)微基准，单位：每声道每秒输入音频耗费的 CPU 时间(us)
+// 同时检查输出时长与 输入时长/speed 的偏差
+
+#include "audio/timestretcher.h"
+#include "benchcommon.h"
+#include <cstdio>
+#include <vector>
+
+namespace {
+    constexpr int kFramesPerPacket = 1024;
+
+    struct Case {
+        int channels;
+        double speed;
+    };
+}
+
+int main() {
+    const Case cases[] = {{2, 0.5}, {2, 1.5}, {2, 2.0}, {2, 4.0}, {8, 0.5}, {8, 1.5}, {8, 2.0}, {8, 4.0}};
+
+    bench::printAudioHeader("us/ch-second", "length err");
+    for (const Case &cs : cases) {
+        const int totalFrames = bench::kSampleRate * bench::kAudioSeconds;
+        const std::vector<float> input = bench::makeSignal(cs.channels, totalFrames);
+        std::vector<float> out(static_cast<size_t>(kFramesPerPacket) * 8 * cs.channels);
+
+        TimeStretcher stretcher;
+        if (!stretcher.init(cs.channels, bench::kSampleRate)) {
+            std::printf("init failed\n");
+            return 1;
+        }
+        stretcher.setSpeed(cs.speed);
+
+        int64_t inFrames = 0;
+        int64_t outFrames = 0;
+        const double us = bench::audioUsPerSecond(kFramesPerPacket, [&](int n) {
+            stretcher.push(input.data() + static_cast<size_t>(n) * kFramesPerPacket * cs.channels, kFramesPerPacket);
+            inFrames += kFramesPerPacket;
+            int got;
+            while ((got = stretcher.pull(out.data(), kFramesPerPacket * 8)) > 0) {
+                outFrames += got;
+            }
+        });
+
+        const double expected = inFrames / cs.speed;
+        char name[32], lengthErr[32];
+        std::snprintf(name, sizeof(name), "%dch %.1fx", cs.channels, cs.speed);
+        std::snprintf(lengthErr, sizeof(lengthErr), "%.2f%%", (outFrames - expected) / expected * 100.0);
+        bench::printAudioRow(name, us / cs.channels, lengthErr);
+    }
+    return 0;
+}
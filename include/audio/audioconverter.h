@@ -0,0 +1,111 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef AUDIOCONVERTER_H
+#define AUDIOCONVERTER_H
+
+#include "audio/spatialrenderer.h"
+#include "compat/compat.h"
+#include "types/types.h"
+
+AZ_EXTERN_C_BEGIN
+#include <libswresample/swresample.h>
+AZ_EXTERN_C_END
+
+/**
+ * 解码帧 -> 设备 packed PCM 的转换器
+ * 采样率和声道布局不变时不经过 swresample：packed 直接拷贝，planar 用 SIMD 交织，s16/s32 -> f32 用 SIMD 交织并转换；
+ * 只有真正需要重采样、重新混音或转换采样格式时才使用 SwrContext
+ * Ambisonics、自定义顺序、超过 8 声道的布局以及双耳输出先由 SpatialRenderer 渲染到输出布局(输入采样率的 f32)，再走上面的流程
+ */
+class AudioConverter {
+    AudioConverter(const AudioConverter &) = delete;
+    AudioConverter &operator=(const AudioConverter &) = delete;
+
+public:
+    enum class Mode {
+        None,
+        Passthrough, // packed 且参数一致，直接拷贝
+        Interleave,  // 仅 planar -> packed
+        Convert,     // s16/s32(planar 或 packed) -> packed f32
+        Resample,    // swresample
+    };
+
+    AudioConverter() = default;
+    ~AudioConverter();
+
+    /**
+     * 输出必须是 packed 格式
+     * @param binaural 输出为 FL+FR 立体声时把多声道/Ambisonics 渲染为双耳(耳机)信号
+     */
+    [[nodiscard]] bool init(const AudioPar &in, const AudioPar &out, bool binaural = false);
+    void uninit();
+
+    // 丢弃内部缓存的数据(seek后调用)
+    void reset();
+
+    [[nodiscard]] Mode mode() const;
+
+    // in -> out 是否需要经过 SpatialRenderer(swresample 处理不了或要求双耳输出)
+    [[nodiscard]] static bool rendersSpatially(const AVChannelLayout &in, const AVChannelLayout &out, bool binaural);
+
+    // 已输入但尚未输出的数据时长(秒)，只有重采样和双耳渲染时不为0
+    [[nodiscard]] double delay() const;
+
+    /**
+     * 在接下来 distance 个输出采样内增加(正)/减少(负) sampleDelta 个采样，用于音频跟随其他主时钟
+     * 直通/交织/转换模式下会临时切换到 swresample，用最近的输入预热滤波器以免衔接处产生咔哒声；
+     * 补偿为0后在下一帧开头先排空 swresample 中缓存的采样再切换回来，这部分数据已计入 delay()
+     * 需在两帧之间(setInput 之前)调用
+     */
+    [[nodiscard]] bool setCompensation(int sampleDelta, int distance);
+
+    /**
+     * 设置待转换的帧，之后通过 produce 分批取出，帧需在取完之前保持有效
+     * @param skipSamples 丢弃帧开头的采样数(输入采样率)，用于与已缓冲的数据无缝拼接
+     */
+    void setInput(const AVFrame *frm, int skipSamples = 0);
+
+    /**
+     * 转换最多 frames 帧到 dst
+     * @return 实际输出的帧数，小于 frames 表示当前输入已经取完，< 0 表示出错
+     */
+    [[nodiscard]] int64_t produce(uint8_t *dst, uint64_t frames);
+
+private:
+    [[nodiscard]] bool initSwr();
+    void primeSwr();
+    [[nodiscard]] int produceFast(uint8_t *dst, int count);
+    void keepHistory(int offset, int frames);
+    [[nodiscard]] bool initRenderer(const AudioPar &in, const AudioPar &out, bool binaural);
+    [[nodiscard]] const AVFrame *render(const AVFrame *frm); // 渲染到 m_renderFrm，失败返回 nullptr
+
+    Mode m_mode = Mode::None;
+    Mode m_fastMode = Mode::None; // 参数一致时的直通/交织/转换模式，补偿结束后恢复
+    AudioPar m_inPar, m_outPar;
+    SwrContext *m_swrCtx = nullptr;
+    int m_channels = 0;
+    int m_bytesPerSample = 0; // 输出单个采样字节数
+    int m_inBytesPerSample = 0; // 快速路径下输入单个采样字节数
+    bool m_inPlanar = false;    // 快速路径下输入是否为 planar
+    int m_inSampleRate = 0;
+    int m_outSampleRate = 0;
+
+    const AVFrame *m_input = nullptr;
+    int m_inputOffset = 0; // 直通/交织/转换时已消费的输入采样数
+    bool m_inputFed = false; // 重采样时输入是否已送入 SwrContext
+    bool m_draining = false; // 补偿已结束，排空 SwrContext 后回到 m_fastMode
+
+    // 快速路径最近的输入采样(输入格式，planar 时按声道连续存放)，进入 swresample 时作为滤波器的历史
+    static constexpr int kHistoryFrames = 64;
+    std::vector<uint8_t> m_history;
+    int m_historyFrames = 0;
+
+    SpatialRenderer m_renderer;
+    AVFrame *m_renderFrm = nullptr;  // 渲染结果，packed f32、输出布局
+    int m_renderCapacity = 0;        // m_renderFrm 缓冲区可容纳的帧数
+    std::vector<float> m_renderIn;   // 非 f32 平面输入转换后的数据
+    std::vector<const float *> m_renderPlanes;
+};
+
+#endif // AUDIOCONVERTER_H
@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * 多音轨混音
+ * 主音轨的数据由调用方直接写在输出缓冲(通常就是环形缓冲区)里，mix 把各叠加音轨按 pts 对齐后
+ * 经过 增益 x 下混矩阵 累加上去，每个叠加音轨只额外读一遍自己的数据
+ * 叠加音轨的数据为交织 f32，采样率与输出一致，声道数不超过 kMaxChannels，由下混矩阵映射到输出声道
+ * @note 非线程安全
+ */
+class AudioMixer {
+public:
+    static constexpr int kMaxChannels = 8;
+
+    AudioMixer() = default;
+
+    [[nodiscard]] bool init(int outChannels, int sampleRate);
+    void uninit();
+
+    // 添加一个叠加音轨，返回音轨ID，失败返回 -1
+    [[nodiscard]] int addTrack(int channels);
+    void removeTrack(int track);
+
+    // 是否有需要处理的内容(叠加音轨或主音轨增益不为1)
+    [[nodiscard]] bool active() const;
+
+    // 主音轨增益
+    void setMainGain(float gain);
+    [[nodiscard]] float mainGain() const;
+
+    void setGain(int track, float gain);
+
+    /**
+     * 设置下混矩阵，matrix[o * channels + i] 为输入声道 i 到输出声道 o 的系数，不含音轨增益
+     * @note addTrack 时按声道数生成默认矩阵
+     */
+    void setMatrix(int track, const float *matrix);
+
+    /**
+     * 追加叠加音轨的数据
+     * @param pts 第一帧的pts(秒)，NaN 表示紧接在已有数据之后；与已有数据不连续时丢弃已有数据
+     */
+    void push(int track, const float *data, int frames, double pts);
+
+    // 丢弃叠加音轨已缓存的数据(seek后调用)
+    void clearTrack(int track);
+
+    // 叠加音轨已缓存数据的结束pts，没有数据时返回 NaN
+    [[nodiscard]] double bufferedEnd(int track) const;
+
+    /**
+     * 把各叠加音轨对齐到 pts 后累加到 dst
+     * @param dst 交织的主音轨数据，frames 帧
+     * @param pts dst 第一帧的pts，NaN 表示不对齐，直接从各音轨的当前位置取数据
+     */
+    void mix(float *dst, int frames, double pts);
+
+    // 按输入/输出声道数生成默认的下混矩阵(ITU-R BS.775 系数)
+    static void defaultMatrix(int inChannels, int outChannels, float *matrix);
+
+private:
+    struct Track {
+        bool used = false;
+        int channels = 0;
+        float gain = 1.0f;
+        bool identity = true; // 下混矩阵为单位阵，走逐采样的快速路径
+        std::vector<float> matrix;
+        std::vector<float> columns; // 按输入声道展开、补齐到 kMaxChannels 的矩阵列，gain 已乘入
+        std::vector<float> data;    // 交织数据
+        size_t read = 0;            // 已消费的帧数
+        double headPts = std::numeric_limits<double>::quiet_NaN(); // data[read] 的 pts，NaN 表示未知
+    };
+
+    [[nodiscard]] Track *track(int id);
+    [[nodiscard]] const Track *track(int id) const;
+    void updateColumns(Track &t);
+    void mixTrack(Track &t, float *dst, int frames, double pts);
+
+    int m_outChannels = 0;
+    int m_sampleRate = 0;
+    float m_mainGain = 1.0f;
+    std::vector<Track> m_tracks;
+};
+
+#endif // AUDIOMIXER_H
@@ -0,0 +1,29 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef INTERLEAVE_H
+#define INTERLEAVE_H
+
+#include <cstdint>
+
+/**
+ * 将 planar 采样交织为 packed，不做任何格式转换
+ * 1~8 声道的 16/32 位采样有 SSE2 实现，其余情况使用标量实现
+ * @param src 各声道的数据指针，共 channels 个
+ * @param srcOffset 从每个声道的第几个采样开始
+ * @param dst 输出，大小至少为 frames * channels * bytesPerSample
+ * @param bytesPerSample 单个采样的字节数：1、2、4、8
+ */
+void interleaveSamples(const uint8_t *const *src, int srcOffset, uint8_t *dst,
+                       int channels, int frames, int bytesPerSample);
+
+/**
+ * 将 planar 的 s16/s32 采样交织为 packed f32，缩放与 swresample 一致(1/2^15、1/2^31)
+ * 1~8 声道有 SSE2 实现，其余情况使用标量实现；channels 为 1 时也可用于 packed 整数采样的整体转换
+ * @param dst 输出，大小至少为 frames * channels
+ * @param bytesPerSample 输入单个采样的字节数：2(s16) 或 4(s32)
+ */
+void interleaveToFloat(const uint8_t *const *src, int srcOffset, float *dst,
+                       int channels, int frames, int bytesPerSample);
+
+#endif // INTERLEAVE_H
@@ -0,0 +1,39 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef REALFFT_H
+#define REALFFT_H
+
+#include <complex>
+#include <vector>
+
+/**
+ * 实数 FFT，长度为 2 的幂
+ * 通过一次 N/2 点复数 FFT 计算，频谱只保存 0..N/2 共 N/2+1 个点，实部/虚部分开存放(方便 SIMD 做频域乘加)
+ * @note 内部有临时缓冲，非线程安全
+ */
+class RealFFT {
+public:
+    RealFFT() = default;
+
+    [[nodiscard]] bool init(int size);
+
+    [[nodiscard]] int size() const;
+
+    // 输入 size 个实数，输出 size/2+1 个点的实部/虚部
+    void forward(const float *in, float *re, float *im);
+
+    // forward 的逆变换，结果已除以 size
+    void inverse(const float *re, const float *im, float *out);
+
+private:
+    void transform(std::complex<float> *data, bool inverse) const; // N/2 点原位复数 FFT
+
+    int m_size = 0;
+    std::vector<int> m_bitReverse;              // N/2 点的位反转序
+    std::vector<std::complex<float>> m_twiddle; // N/2 点 FFT 的旋转因子 e^{-2πik/(N/2)}
+    std::vector<std::complex<float>> m_split;   // 拆分奇偶项用的旋转因子 e^{-2πik/N}
+    std::vector<std::complex<float>> m_buffer;
+};
+
+#endif // REALFFT_H
@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SPATIALRENDERER_H
+#define SPATIALRENDERER_H
+
+#include "audio/realfft.h"
+#include <vector>
+
+/**
+ * 空间音频渲染：Ambisonics(最高三阶，ACN/SN3D) 与任意扬声器布局 -> 输出扬声器或双耳(耳机)
+ * - 扬声器输出：初始化时算好 输出 x 输入 的矩阵，之后逐块做 SIMD 乘加
+ *   Ambisonics 用带正则化的模式匹配解码 + max-rE 加权，普通声道按方位角在相邻扬声器间做恒功率声像
+ * - 双耳输出：每个输入声道对应一对 HRIR(球形头部模型)，Ambisonics 声道的 HRIR 在球面虚拟扬声器上预先合成，
+ *   用均匀分块的 FFT 卷积(overlap-save)，所有输入在频域累加后每只耳朵只做一次逆变换，固定延迟 kBlockFrames 帧
+ * @note 输入为各声道的 f32 平面，输出为交织 f32；非线程安全
+ */
+class SpatialRenderer {
+public:
+    // 一个声道在渲染器中的含义
+    struct Channel {
+        enum class Type {
+            Silent,    // 不参与渲染
+            Speaker,   // 位于 azimuth/elevation 的扬声器
+            LFE,       // 低频
+            Ambisonic, // Ambisonics 分量
+        };
+        Type type = Type::Silent;
+        float azimuth = 0.0f;   // 方位角(度)，正前方为0，向左为正
+        float elevation = 0.0f; // 仰角(度)，向上为正
+        int acn = 0;            // Ambisonics 分量的 ACN 序号
+    };
+
+    static constexpr int kMaxAmbisonicOrder = 3;
+    static constexpr int kBlockFrames = 128; // 双耳卷积的分块大小，同时也是双耳输出的延迟
+
+    SpatialRenderer() = default;
+
+    /**
+     * @param binaural 输出为左右耳，out 必须是两个声道
+     */
+    [[nodiscard]] bool init(const std::vector<Channel> &in, const std::vector<Channel> &out, int sampleRate, bool binaural);
+    void uninit();
+
+    // 清空卷积的历史数据(seek后调用)
+    void reset();
+
+    [[nodiscard]] bool initialized() const;
+    [[nodiscard]] bool binaural() const;
+    [[nodiscard]] int inChannels() const;
+    [[nodiscard]] int outChannels() const;
+
+    // 输出相对输入的延迟(帧)
+    [[nodiscard]] int latency() const;
+
+    // in 为 inChannels 个声道平面，输出 frames 帧到 out
+    void process(const float *const *in, float *out, int frames);
+
+private:
+    [[nodiscard]] bool buildMatrix(const std::vector<Channel> &in, const std::vector<Channel> &out);
+    [[nodiscard]] bool buildBinaural(const std::vector<Channel> &in, int sampleRate);
+    void processMatrix(const float *const *in, float *out, int frames);
+    void processBinaural(const float *const *in, float *out, int frames);
+    void convolveBlock();
+
+    int m_inChannels = 0;
+    int m_outChannels = 0;
+    bool m_binaural = false;
+
+    // ==== 扬声器输出 ====
+    std::vector<float> m_matrix; // m_matrix[o * m_inChannels + i]
+    std::vector<float> m_planes; // 每个输出声道一段，先按平面累加再交织
+
+    // ==== 双耳输出 ====
+    RealFFT m_fft;
+    int m_partitions = 0;       // HRIR 的分块数
+    int m_bins = 0;             // 频谱点数 kBlockFrames + 1，补齐到 8 的倍数
+    std::vector<int> m_sources; // 参与卷积的输入声道
+    std::vector<float> m_filters; // [source][ear][partition] 的频谱，实部 m_bins 个 + 虚部 m_bins 个
+    std::vector<float> m_history; // [source] 的 2 * kBlockFrames 个输入采样：上一块 + 当前块
+    std::vector<float> m_fdl;     // [source][partition] 的输入频谱，环形使用
+    int m_fdlHead = 0;            // 最新一块输入频谱在 m_fdl 中的位置
+    std::vector<float> m_acc;     // 频域累加结果，实部 + 虚部
+    std::vector<float> m_time;    // 逆变换结果
+    std::vector<float> m_outBlock; // 上一块的输出(交织，左右耳)，在下一块输入期间逐帧取出
+    int m_blockPos = 0;            // 当前块已输入的帧数
+};
+
+#endif // SPATIALRENDERER_H
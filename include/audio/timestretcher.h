@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef TIMESTRETCHER_H
+#define TIMESTRETCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * WSOLA 变速不变调
+ * 每次从输入中取一段(sequence)输出，相邻两段之间交叉淡化；下一段的起点在名义位置附近搜索，
+ * 取与上一段尾部(overlap)波形最相似的位置，避免相位不连续。名义位置每段前进 (sequence - overlap) * speed
+ * 相似度只在各声道的混合信号上计算，互相关使用 SIMD
+ * @note 输入输出均为交织的 f32；非线程安全
+ */
+class TimeStretcher {
+public:
+    TimeStretcher() = default;
+
+    [[nodiscard]] bool init(int channels, int sampleRate);
+    void uninit();
+
+    // 丢弃所有缓存的数据(seek/切换速度后调用)
+    void reset();
+
+    void setSpeed(double speed);
+    [[nodiscard]] double speed() const;
+
+    [[nodiscard]] int channels() const;
+
+    // 输入 frames 帧
+    void push(const float *in, int frames);
+
+    // 取出最多 maxFrames 帧，返回实际帧数
+    [[nodiscard]] int pull(float *out, int maxFrames);
+
+    // 可以取出的帧数
+    [[nodiscard]] int available() const;
+
+    // 已输入的总帧数
+    [[nodiscard]] int64_t inputFrames() const;
+
+    // 下一个输出帧在输入中对应的位置(帧)，用于换算时间戳
+    [[nodiscard]] double outputPosition() const;
+
+private:
+    // 处理所有已经足够的输入
+    void process();
+
+    // 在名义位置附近搜索与上一段尾部最相似的起点(绝对帧)
+    [[nodiscard]] int64_t seekBestOffset(int64_t nominal) const;
+
+    // 丢弃不再需要的输入/已经取出的输出
+    void compact();
+
+    [[nodiscard]] const float *inAt(int64_t pos) const;   // 绝对帧位置 -> 交织数据
+    [[nodiscard]] const float *monoAt(int64_t pos) const; // 绝对帧位置 -> 混合信号
+
+    int m_channels = 0;
+    int m_sequence = 0;   // 每段长度(帧)
+    int m_overlap = 0;    // 交叉淡化长度(帧)
+    int m_seekWindow = 0; // 起点搜索范围(帧)
+    double m_speed = 1.0;
+
+    std::vector<float> m_in;   // 输入(交织)
+    std::vector<float> m_mono; // 输入的混合信号
+    int64_t m_inBase = 0;      // m_in[0] 的绝对帧位置
+    int64_t m_inTotal = 0;     // 已输入的总帧数
+    double m_nominal = 0.0;    // 下一段的名义起点(绝对帧)
+
+    std::vector<float> m_mid;     // 上一段的尾部，与下一段的开头交叉淡化(交织)
+    std::vector<float> m_midMono; // 上一段尾部的混合信号
+    bool m_haveMid = false;
+
+    std::vector<float> m_fadeIn; // 交叉淡化系数
+
+    std::vector<float> m_out;  // 输出(交织)
+    size_t m_outRead = 0;      // 已取出的帧数
+    double m_outHeadPos = 0.0; // 下一个输出帧对应的输入位置
+};
+
+#endif // TIMESTRETCHER_H
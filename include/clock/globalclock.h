@@ -4,7 +4,7 @@
 #ifndef GLOBALCLOCK_H
 #define GLOBALCLOCK_H
 
-// 获取相对且单调的时间(秒)
+// 获取相对且单调的时间(秒)，来自 TimeSource，模拟时可以是虚拟时间
 [[nodiscard]] double getRelativeSeconds();
 
 enum class ClockType {
@@ -66,6 +66,10 @@ public:
 
     void togglePaused();
 
+    // 播放速度，同时作用于三个时钟，reset 后保持不变
+    void setSpeed(double newSpeed);
+    [[nodiscard]] double speed() const;
+
     [[nodiscard]] double audioPts() const;
     [[nodiscard]] double videoPts() const;
     [[nodiscard]] double externalPts() const;
@@ -92,6 +96,7 @@ private:
     ClockType m_mainClockType = ClockType::AUDIO;
     Clock m_audioClk, m_videoClk, m_externalClk;
     double m_maxFrameDuration;
+    double m_speed = 1.0;
 };
 
 #endif // GLOBALCLOCK_H
@@ -0,0 +1,86 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef TIMESOURCE_H
+#define TIMESOURCE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+enum class TimeSourceMode {
+    REAL,        // 现实时间(steady_clock)
+    VIRTUAL,     // 虚拟时间，只由 advance 推进
+    ACCELERATED, // 按倍率加速的现实时间
+};
+
+/**
+ * 播放器的时间源，getRelativeSeconds() 与解复用、解码、播放线程中的睡眠/轮询都经过它
+ * 例外是音频填充等待(AudioPlayer::m_fillWait)，它等的是按现实时间消耗数据的音频设备
+ * - REAL：默认模式，now 按 steady_clock 流逝(未切换过模式时就是 steady_clock)，sleepFor 即真实睡眠
+ * - VIRTUAL：now 只在 advance/advanceTo 时变化，sleepFor 阻塞到虚拟时间到达(或离开 VIRTUAL 模式)，
+ *   由模拟器单线程驱动时结果完全确定，且与现实时间无关
+ * - ACCELERATED：时间按 factor 倍流逝，sleepFor(t) 只睡 t / factor
+ * 切换到 REAL/ACCELERATED 时从切换前的读数继续；setVirtual 从指定时间重新开始，之后 now 可能比之前小
+ * @note 模式应在播放线程启动前切换；离开 VIRTUAL 模式会唤醒所有睡眠中的线程，
+ *       VIRTUAL 模式下停止播放前驱动方需继续推进时间或切回 REAL，否则轮询中的线程无法退出
+ */
+class TimeSource {
+    TimeSource(const TimeSource &) = delete;
+    TimeSource &operator=(const TimeSource &) = delete;
+    TimeSource(TimeSource &&) = delete;
+    TimeSource &operator=(TimeSource &&) = delete;
+
+public:
+    static TimeSource &instance();
+
+    // 当前时间(秒)，可在任意线程调用；两次 setVirtual 之间单调
+    [[nodiscard]] double now() const;
+
+    void sleepFor(double seconds);
+    void sleepUntil(double time);
+
+    void setReal();
+    // 切换为虚拟时间，从 start 秒开始
+    void setVirtual(double start);
+    // 切换为加速时间，从当前读数开始按 factor 倍流逝
+    void setAccelerated(double factor);
+
+    // 推进虚拟时间并唤醒到期的睡眠线程，只在 VIRTUAL 模式下有效，时间不会倒退
+    void advance(double seconds);
+    void advanceTo(double time);
+
+    [[nodiscard]] TimeSourceMode mode() const;
+
+private:
+    TimeSource() = default;
+    ~TimeSource() = default;
+
+    // 模式与 REAL/ACCELERATED 的换算参数：now = base + (steadySeconds() - origin) * factor
+    struct Snapshot {
+        TimeSourceMode mode;
+        double factor;
+        double origin; // 切换时的现实时间
+        double base;   // 切换时的读数
+    };
+
+    [[nodiscard]] static double steadySeconds();
+    [[nodiscard]] double now(const Snapshot &s) const;
+    // 顺序锁：写者持有 m_mutex，读者不加锁，读到写了一半的数据时重读
+    [[nodiscard]] Snapshot loadSnapshot() const;
+    void storeSnapshot(const Snapshot &s);
+    // 切换到 REAL/ACCELERATED
+    void setRate(TimeSourceMode mode, double factor);
+
+    std::atomic<TimeSourceMode> m_mode{TimeSourceMode::REAL};
+    std::atomic<uint32_t> m_seq{0}; // 奇数表示正在写
+    std::atomic<double> m_factor{1.0};
+    std::atomic<double> m_origin{0.0};
+    std::atomic<double> m_base{0.0};
+    std::atomic<double> m_virtualNow{0.0}; // VIRTUAL 模式的当前时间
+    std::mutex m_mutex;
+    std::condition_variable m_cond; // 虚拟时间推进或模式切换
+};
+
+#endif // TIMESOURCE_H
@@ -19,4 +19,12 @@ inline constexpr std::size_t hardware_destructive_interference_size = 64;
 using std::hardware_destructive_interference_size;
 #endif
 
+// SIMD 支持: x86-64 上 SSE2 总是可用，AVX2 需要编译选项开启(/arch:AVX2 或 -mavx2)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AZ_HAVE_SSE2 1
+#endif
+#if defined(__AVX2__)
+#define AZ_HAVE_AVX2 1
+#endif
+
 #endif /* COMPAT_H */
@@ -4,6 +4,7 @@
 #ifndef MEDIACONTROLLER_H
 #define MEDIACONTROLLER_H
 
+#include "clock/globalclock.h"
 #include "decode/decodeaudio.h"
 #include "decode/decodesubtitle.h"
 #include "decode/decodevideo.h"
@@ -42,6 +43,8 @@ public:
     Q_INVOKABLE [[nodiscard]] QVariantList getChaptersInfo() const; // 获取章节信息
     Q_INVOKABLE [[nodiscard]] int getSubtitleIdx() const;           // 获取当前使用的流在所有同类流中的索引，-1为未使用
     Q_INVOKABLE [[nodiscard]] int getAudioIdx() const;              // 获取当前使用的流在所有同类流中的索引，-1为未使用
+    Q_INVOKABLE [[nodiscard]] int getSecondarySubtitleIdx() const;  // 获取副字幕流在所有字幕流中的索引，-1为未使用
+    Q_INVOKABLE [[nodiscard]] int getOverlayAudioIdx() const;       // 获取叠加音轨在所有音频流中的索引，-1为未使用
 
     [[nodiscard]] bool loopOnEnd() const;
     Q_INVOKABLE void setLoopOnEnd(bool newLoopOnEnd);
@@ -50,6 +53,12 @@ public:
     void setProgress(int newProgress); // 仅用于修改数值产生信号
 
     [[nodiscard]] bool autoLoadExtSub() const;
+    [[nodiscard]] bool preloadAudioTracks() const;
+    [[nodiscard]] int clockMaster() const;
+    [[nodiscard]] double speed() const;
+    [[nodiscard]] int audioLatencyProfile() const;
+    [[nodiscard]] double overlayVolume() const;
+    [[nodiscard]] bool binauralRendering() const;
 
 public slots:
     [[nodiscard]] bool setVideoWindow(QObject *videoWindow); // 设置用于显示画面的QML元素
@@ -68,13 +77,23 @@ public slots:
     void addVolume();                 // 增加0.04音量
     void subVolume();                 // 减少0.04音量
     void setAutoLoadExtSub(bool newAutoLoadExtSub); // 设置是否自动加载外部字幕
+    void setPreloadAudioTracks(bool newPreload);     // 设置是否预读所有音轨(无缝切换音轨)
+    void setClockMaster(int newClockMaster);         // 设置主时钟 0音频 1视频 2外部，缺少对应的流时自动回退
+    void setSpeed(double newSpeed);                  // 设置播放速度 [0.5, 4]，音频变速不变调
+    void setAudioLatencyProfile(int newProfile);     // 设置音频延迟档位 0省电 1均衡 2低延迟，播放中立即重新打开设备
+    void setOverlayVolume(double newVolume);         // 设置叠加音轨相对主音轨的音量 [0, 1]
+    void setBinauralRendering(bool newBinaural);     // 设置是否把多声道渲染为双耳(耳机)信号，播放中立即生效
 
     void seekBySec(double ts, double rel); // seek到指定位置(秒)
     void fastForward();                    // 快进
     void fastRewind();                     // 快退
 
+    bool toggleTracing(); // 开始/停止帧级追踪，停止时导出 Chrome trace JSON，需要以 AZPLAYER_ENABLE_TRACING 编译
+
     [[nodiscard]] bool switchSubtitleStream(int demuxIdx, int streamIdx); // 切换字幕流
     [[nodiscard]] bool switchAudioStream(int demuxIdx, int streamIdx);    // 切换音频流
+    [[nodiscard]] bool setSecondarySubtitleStream(int demuxIdx, int streamIdx); // 设置副字幕流(双语字幕)，demuxIdx为-1时关闭
+    [[nodiscard]] bool setOverlayAudioStream(int demuxIdx, int streamIdx);      // 设置叠加音轨(与主音轨混音)，demuxIdx为-1时关闭
 
 signals:
     void pausedChanged();      // 开始/暂停
@@ -83,7 +102,13 @@ signals:
     void streamInfoUpdate();   // 流信息已更新
     void chaptersInfoUpdate(); // 章节信息已更新
 
-    void autoLoadExtSubChanged(); // 自动加载外部字幕状态更新
+    void autoLoadExtSubChanged();      // 自动加载外部字幕状态更新
+    void preloadAudioTracksChanged();  // 预读所有音轨状态更新
+    void clockMasterChanged();         // 主时钟设置更新
+    void speedChanged();               // 播放速度更新
+    void audioLatencyProfileChanged(); // 音频延迟档位更新
+    void overlayVolumeChanged();       // 叠加音轨音量更新
+    void binauralRenderingChanged();   // 双耳渲染设置更新
 
     void durationChanged(); // 播放时长改变
     void seeked();          // seek完成
@@ -103,14 +128,17 @@ private:
 
     // 音视频队列
     sharedPktQueue m_pktAudioBuf = std::make_shared<AVPktQueue>(2);               // max(2MB,16packets)
-    sharedFrmQueue m_frmAudioBuf = std::make_shared<SPSCQueue<AVFrmItem>>(50);    // max(50frames)
+    sharedFrmQueue m_frmAudioBuf = std::make_shared<SPSCRing<AVFrmItem>>(50);    // max(50frames)
     sharedPktQueue m_pktVideoBuf = std::make_shared<AVPktQueue>(10);              // max(10MB,16packets)
-    sharedFrmQueue m_frmVideoBuf = std::make_shared<SPSCQueue<AVFrmItem>>(3);     // max(3frames)
+    sharedFrmQueue m_frmVideoBuf = std::make_shared<SPSCRing<AVFrmItem>>(3);     // max(3frames)
     sharedPktQueue m_pktSubtitleBuf = std::make_shared<AVPktQueue>(2);            // max(2MB,16packets)
-    sharedFrmQueue m_frmSubtitleBuf = std::make_shared<SPSCQueue<AVFrmItem>>(16); // max(16frames)
+    sharedFrmQueue m_frmSubtitleBuf = std::make_shared<SPSCRing<AVFrmItem>>(16); // max(16frames)
+    sharedPktQueue m_pktOverlayBuf = std::make_shared<AVPktQueue>(2);             // max(2MB,16packets)
+    sharedFrmQueue m_frmOverlayBuf = std::make_shared<SPSCRing<AVFrmItem>>(50);  // max(50frames)
 
     // 解复用器
     std::array<Demux *, 3> m_demuxs{nullptr, nullptr, nullptr}; // 0文件 1字幕 2音轨
+    Demux *m_overlayDemux = nullptr; // 叠加音轨单独打开一份源文件，不计入 m_demuxs 以免流列表重复
     // 当前的视频流/字幕流/音频流所使用的{demuxIdx,streamIdx}
     struct StreamSlot {
         int demuxIdx = -1;
@@ -120,16 +148,19 @@ private:
         }
     };
     EnumIndexArray<StreamSlot, MediaType> m_streams;
+    StreamSlot m_secondarySubtitle; // 副字幕，只支持文本字幕
+    StreamSlot m_overlayAudio;      // 叠加音轨，demuxIdx 指向源文件所在的 m_demuxs
     // 音视频解码器
     DecodeAudio *m_decodeAudio = nullptr;
     DecodeVideo *m_decodeVideo = nullptr;
     DecodeSubtitle *m_decodeSubtitle = nullptr;
+    DecodeAudio *m_decodeOverlay = nullptr;
     // 音视频播放控制器
     AudioPlayer *m_audioPlayer = nullptr;
     VideoPlayer *m_videoPlayer = nullptr;
 
     QTimer m_checkPlayerFinishedTimer;      // 定时检查是否播完
-    QTimer m_updatePktAndFrmQueueSizeTimer; // 定时更新队列长度给 PlaybackStats
+    QTimer m_updatePktAndFrmQueueSizeTimer; // 定时更新队列长度与内存估算给 PlaybackStats
     QTimer m_progressFallbackTimer;         // 进度条保底策略，防止在某些情况下进度条不更新
 
     bool m_opened = false;   // 是否打开文件
@@ -140,7 +171,13 @@ private:
     int m_progress = 0;      // 播放进度（秒）
     bool m_loopOnEnd = true; // true播完重播 | false播完暂停
     bool m_played = false;   // 是否播完
-    bool m_autoLoadExtSub = true; // 是否自动加载外部字幕
+    bool m_autoLoadExtSub = true;               // 是否自动加载外部字幕
+    bool m_preloadAudioTracks = false;          // 是否预读所有音轨，切换音轨时不需要seek
+    ClockType m_clockMaster = ClockType::AUDIO; // 用户选择的主时钟
+    double m_speed = 1.0;                       // 播放速度
+    AudioLatencyProfile m_audioLatencyProfile = AudioLatencyProfile::Balanced; // 音频延迟档位
+    double m_overlayVolume = 1.0;               // 叠加音轨音量
+    bool m_binauralRendering = false;           // 是否双耳渲染
     Q_PROPERTY(bool paused READ paused WRITE setPaused NOTIFY pausedChanged FINAL)
     Q_PROPERTY(double volume READ volume WRITE setVolume NOTIFY volumeChanged FINAL)
     Q_PROPERTY(bool muted READ muted WRITE setMuted NOTIFY mutedChanged FINAL)
@@ -148,12 +185,22 @@ private:
     Q_PROPERTY(bool opened READ opened WRITE setOpened NOTIFY openedChanged FINAL)
     Q_PROPERTY(int progress READ progress WRITE setProgress NOTIFY progressChanged FINAL)
     Q_PROPERTY(bool autoLoadExtSub READ autoLoadExtSub WRITE setAutoLoadExtSub NOTIFY autoLoadExtSubChanged FINAL)
+    Q_PROPERTY(bool preloadAudioTracks READ preloadAudioTracks WRITE setPreloadAudioTracks NOTIFY preloadAudioTracksChanged FINAL)
+    Q_PROPERTY(int clockMaster READ clockMaster WRITE setClockMaster NOTIFY clockMasterChanged FINAL)
+    Q_PROPERTY(double speed READ speed WRITE setSpeed NOTIFY speedChanged FINAL)
+    Q_PROPERTY(int audioLatencyProfile READ audioLatencyProfile WRITE setAudioLatencyProfile NOTIFY audioLatencyProfileChanged FINAL)
+    Q_PROPERTY(double overlayVolume READ overlayVolume WRITE setOverlayVolume NOTIFY overlayVolumeChanged FINAL)
+    Q_PROPERTY(bool binauralRendering READ binauralRendering WRITE setBinauralRendering NOTIFY binauralRenderingChanged FINAL)
 
 private:
     [[nodiscard]] QVariantList getStreamInfo(MediaType type) const;
+    [[nodiscard]] int getFlatStreamIdx(MediaType type, const StreamSlot &slot) const; // 流在所有同类流中的索引
     [[nodiscard]] bool openStreamByFile(const QUrl &URL, MediaType type);
     [[nodiscard]] bool seekAudioAndSubtitleDemux(double pts);
     void checkPlayerFinished();
+    void applyClockMaster(); // 按用户选择和已有的流设置主时钟
+    void closeOverlayAudio(); // 关闭叠加音轨的解复用/解码，并从 AudioPlayer 中移除
+    bool exportTrace() const; // 写到 AZPLAYER_TRACE_JSON 指定的文件，未指定时写到临时目录
 
 signals:
     void clearVideoFBOSubtitleTex();
@@ -5,6 +5,7 @@
 #define DECODEBASE_H
 
 #include "types/ptrs.h"
+#include "utils/taskexecutor.h"
 #include <QObject>
 #include <atomic>
 #include <thread>
@@ -35,6 +36,9 @@ public:
 
     [[nodiscard]] bool initialized() const;
 
+    // 最近一帧解码输出的缓冲区大小(字节)，GUI 用它估算帧队列的内存
+    [[nodiscard]] int64_t lastFrameBytes() const;
+
 protected:
     sharedPktQueue m_pktBuf;
     sharedFrmQueue m_frmBuf;
@@ -46,13 +50,16 @@ protected:
     std::atomic<bool> m_stop{true};
     bool m_isEOF = false;
     int m_serial = 0;
-    std::thread m_thread;
+    TaskHandle m_thread;
     bool m_initialized = false;
     AVRational m_time_base;
+    std::atomic<int64_t> m_lastFrameBytes{0};
 
 protected:
     virtual void decodingLoop() = 0;
     [[nodiscard]] bool getPkt(AVPktItem &pktItem, bool &needFlushBuffers);
+    // 帧推入队列前调用，记录它引用的缓冲区大小
+    void recordFrameBytes(const AVFrame *frm);
 };
 
 #endif // DECODEBASE_H
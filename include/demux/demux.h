@@ -4,18 +4,26 @@
 #ifndef DEMUX_H
 #define DEMUX_H
 #include "compat/compat.h"
+#include "demux/subtitlepacketindex.h"
 #include "types/ptrs.h"
+#include "types/types.h"
 #include "utils/enumindexarray.h"
+#include "utils/taskexecutor.h"
 #include <QObject>
 #include <atomic>
+#include <deque>
+#include <map>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 AZ_EXTERN_C_BEGIN
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 #include <libavutil/avutil.h>
+#include <libavutil/time.h>
 AZ_EXTERN_C_END
 
 struct ChapterInfo {
@@ -51,8 +59,18 @@ public:
      * 可以通过 ASSRender::instance().initialized() 判断是否为有ASS字幕
      */
     [[nodiscard]] bool switchSubtitleStream(int streamIdx, weakPktQueue wpq, weakFrmQueue wfq, bool &isAssSub);
+    /**
+     * 设置副字幕流(双语字幕)，只支持文本字幕
+     * @param streamIdx -1表示关闭副字幕
+     */
+    [[nodiscard]] bool setSecondarySubtitleStream(int streamIdx);
     // 切换音频流
     [[nodiscard]] bool switchAudioStream(int streamIdx, weakPktQueue wpq, weakFrmQueue wfq);
+    /**
+     * 是否为所有音频流保留最近几秒的包
+     * 开启后切换音频流时直接从缓存的包开始解码，不需要seek，视频不受影响
+     */
+    void setPreloadAudioTracks(bool preload);
 
     // 关闭流
     void closeStream(MediaType type);
@@ -76,6 +94,9 @@ public:
     [[nodiscard]] bool isEOF() const;
 
     [[nodiscard]] bool isRunning() const;
+
+    // 打开的媒体URL，未初始化时为空
+    [[nodiscard]] const std::string &url() const { return m_URL; }
 public slots:
 signals:
     // 当前解复用器seek完成
@@ -98,7 +119,7 @@ private:
 
     char errBuf[512];
     std::atomic<bool> m_stop{true};
-    std::thread m_thread;
+    TaskHandle m_thread;
     bool m_initialized = false;
     std::mutex m_mutex; // 保护队列和流ID的更新
 
@@ -108,6 +129,27 @@ private:
     bool m_isMainDemux = false;
     bool m_isEOF = false;
 
+    // 字幕包索引，只在解复用线程中访问
+    std::map<int, SubtitlePacketIndex> m_subPktIndex; // 流ID -> 该字幕流的包索引
+    // 按索引取回字幕包用的独立上下文，选中图形字幕时在后台打开，m_subFetchReady 之后归解复用线程使用
+    AVFormatContext *m_subFetchCtx = nullptr;
+    std::atomic<bool> m_subFetchReady{false};
+    std::atomic<bool> m_subFetchOpening{false};        // 后台正在打开
+    std::atomic<bool> m_subFetchAbort{false};          // 中断后台的打开
+    TaskHandle m_subFetchOpen;                         // 只在调用 switchSubtitleStream/uninit 的线程访问
+    int64_t m_subFetchDeadline = 0;                    // 取回字幕包的截止时间 us，超时中断读取
+    int m_subRecoveredIdx = -1;                        // seek 后已取回的字幕流ID
+    int64_t m_subRecoveredPts = AV_NOPTS_VALUE;        // seek 后已取回的最后一个字幕包的pts，之后再读到不重复推送
+    // 字幕包已全部记入索引的时间段(秒)，升序且互不重叠；索引只含读到过的包，不在这些时间段内的 seek 目标要先扫描
+    std::vector<std::pair<double, double>> m_subIndexedSpans;
+    double m_readSpanBegin = INVALID_DOUBLE; // 主上下文自上次 seek 以来连续读过的时间段，seek 时并入 m_subIndexedSpans
+    double m_readSpanEnd = INVALID_DOUBLE;
+
+    // 音频流滚动缓存，开启后所有音频流的包都保留到主时钟之前几秒，由 m_mutex 保护
+    std::atomic<bool> m_preloadAudio{false};
+    std::map<int, std::deque<AVPacket *>> m_audioPktCache; // 流ID -> 最近的包
+    std::atomic<int> m_audioCacheFlushIdx{-1};             // 切换后需要把缓存推入音频队列的流ID
+
 private:
     void seekAllPktQueue(); // 为所有pkyQueue增加序号
 
@@ -118,6 +160,26 @@ private:
     void pushSubtitlePkt(AVPacket *pkt);
     void pushPkt(const weakPktQueue &wq, AVPacket *pkt);
 
+    void routeAudioPkt(AVPacket *pkt);                                      // 缓存并分发音频包，pkt 为空时只处理待推送的缓存
+    [[nodiscard]] bool cacheAudioPkt(const AVPacket *pkt);                  // 记录音频包到滚动缓存，需持有 m_mutex
+    void collectCachedAudioPkts(int streamIdx, std::vector<AVPacket *> &out); // 取出从主时钟开始的缓存包，需持有 m_mutex
+    [[nodiscard]] bool audioCacheCovers(int streamIdx, double pts);         // 缓存是否覆盖 pts
+    void clearAudioPktCache();
+
+    void indexSubtitlePkt(const AVPacket *pkt);          // 记录字幕包到索引，并延长连续读过的时间段
+    void closeReadSpan();                                // 把连续读过的时间段并入 m_subIndexedSpans
+    void addIndexedSpan(double begin, double end);
+    [[nodiscard]] double indexedSpanBegin(double ts) const; // 覆盖 ts 的已索引时间段的起点，没有时为 NaN
+    // seek 后取回 ts 时刻正在显示的图形字幕包：读过的位置按索引取回，未读过的位置(如向前 seek)在 m_subFetchCtx 上
+    // 从 ts 之前 15 秒开始扫描，限时 300ms；开始时间更早且仍在显示的字幕，以及扫描超时的情况不恢复
+    void recoverSubtitleState(double ts);
+    void openSubFetchCtxAsync();                // 在后台打开 m_subFetchCtx，已打开或正在打开时无效果
+    [[nodiscard]] AVFormatContext *openSubFetchCtx(const std::string &url, unsigned int nbStreams);
+    void selectSubFetchStream(int streamIdx); // m_subFetchCtx 只读取 streamIdx，其余流由demuxer直接丢弃
+    [[nodiscard]] AVPacket *fetchSubtitlePkt(int streamIdx, const SubtitlePacketIndex::Entry &e);
+    [[nodiscard]] std::vector<AVPacket *> scanSubtitlePkts(int streamIdx, double ts); // 从 ts 之前有限的一段开始扫描
+    static int subFetchInterrupt(void *opaque);
+
     void fillStreamInfo();   // 填充流消息
     void fillChaptersInfo(); // 填充章节消息
 
@@ -0,0 +1,49 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SUBTITLEPACKETINDEX_H
+#define SUBTITLEPACKETINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * 字幕包索引
+ * 记录播放过程中读到的字幕包的时间和文件位置，seek 后据此只取回目标时刻仍在显示的字幕包，
+ * 避免图形字幕(PGS/VobSub/DVB)在 seek 后一直空白到下一条字幕
+ * @note 非线程安全
+ */
+class SubtitlePacketIndex {
+public:
+    struct Entry {
+        int64_t pts;      // 流时间基
+        int64_t duration; // 流时间基，<= 0 表示未知(由下一个包结束显示)
+        int64_t pos;      // 包在文件中的字节偏移，< 0 表示未知
+    };
+
+    SubtitlePacketIndex() = default;
+
+    void clear();
+
+    // 添加一个包，以 (pts, pos) 区分，同一个包只记录一次；PGS 的一个显示集由多个相同 pts 的包组成
+    void add(int64_t pts, int64_t duration, int64_t pos);
+
+    /**
+     * 获取 ts 时刻可能正在显示的包，按 (pts, pos) 升序
+     * 包括 ts 之前最后一个 pts 的所有包，以及时长已知且覆盖 ts 的包
+     * @param maxCount 最多返回的个数
+     */
+    [[nodiscard]] std::vector<Entry> activeAt(int64_t ts, size_t maxCount = 8) const;
+
+    [[nodiscard]] size_t size() const;
+
+    [[nodiscard]] bool empty() const;
+
+private:
+    [[nodiscard]] static bool less(const Entry &a, const Entry &b) { return a.pts != b.pts ? a.pts < b.pts : a.pos < b.pos; }
+
+    std::vector<Entry> m_entries; // 按 (pts, pos) 升序
+};
+
+#endif // SUBTITLEPACKETINDEX_H
@@ -0,0 +1,92 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef ASSEVENTSTORE_H
+#define ASSEVENTSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * ASS 事件存储
+ * 所有事件文本紧凑地存放在一块连续内存(arena)中，索引按开始时间排序，
+ * 用于只把某个时间窗口内的事件提交给 libass
+ * @note 非线程安全
+ */
+class ASSEventStore {
+public:
+    struct Event {
+        int64_t start;    // 开始时间 ms
+        int64_t duration; // 持续时间 ms
+        uint32_t offset;  // 文本在 arena 中的偏移
+        uint32_t size;    // 文本长度，不含'\0'
+    };
+
+    ASSEventStore() = default;
+
+    void clear();
+
+    // 释放多余容量
+    void shrinkToFit();
+
+    /**
+     * 添加一条事件
+     * @note data的格式为：ReadOrder,Layer,Style,Name,MarginL,MarginR,MarginV,Effect,Text
+     * @param start 开始时间 ms
+     * @param duration 持续时间 ms
+     */
+    [[nodiscard]] bool add(const char *data, size_t size, int64_t start, int64_t duration);
+
+    // 按开始时间排序并建立区间索引，add 之后、查询之前必须调用
+    void finalize();
+
+    [[nodiscard]] bool finalized() const;
+
+    /**
+     * 遍历与 [begin, end) 有交集的事件
+     * @param func void(const Event &, const char *text)
+     */
+    template <typename Func>
+    void forEachOverlapping(int64_t begin, int64_t end, Func &&func) const;
+
+    // 与 [begin, end) 有交集的事件个数
+    [[nodiscard]] size_t countOverlapping(int64_t begin, int64_t end) const;
+
+    [[nodiscard]] const char *text(const Event &e) const;
+
+    [[nodiscard]] size_t size() const;
+
+    [[nodiscard]] bool empty() const;
+
+    // 事件文本总字节数
+    [[nodiscard]] size_t textBytes() const;
+
+    // 实际占用的内存字节数(按容量计)
+    [[nodiscard]] size_t memoryUsage() const;
+
+private:
+    // 第一个 maxEnd > begin 的事件下标，之前的事件均已结束
+    [[nodiscard]] size_t firstCandidate(int64_t begin) const;
+
+    std::vector<char> m_arena;
+    std::vector<Event> m_events;
+    std::vector<int64_t> m_maxEnd; // m_maxEnd[i] = max(events[0..i].end)，单调不减
+    bool m_finalized{true};
+};
+
+template <typename Func>
+void ASSEventStore::forEachOverlapping(int64_t begin, int64_t end, Func &&func) const {
+    if (!m_finalized || begin >= end)
+        return;
+    // 从第一个可能未结束的事件开始，到开始时间 >= end 为止
+    for (size_t i = firstCandidate(begin); i < m_events.size(); ++i) {
+        const Event &e = m_events[i];
+        if (e.start >= end)
+            break;
+        if (e.start + e.duration > begin)
+            func(e, m_arena.data() + e.offset);
+    }
+}
+
+#endif // ASSEVENTSTORE_H
@@ -5,12 +5,20 @@
 
 #include "ass/ass.h"
 #include "compat/compat.h"
+#include "renderer/asseventstore.h"
 #include "utils/dirtyrectmanager.h"
+#include "utils/taskexecutor.h"
 #include <QObject>
 #include <QRect>
 #include <QSize>
 #include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <utility>
 
 AZ_EXTERN_C_BEGIN
 #include <libavcodec/avcodec.h>
@@ -33,46 +41,123 @@ class ASSRender : public QObject {
 public:
     static ASSRender &instance();
 
+    /**
+     * 在后台线程中创建渲染器并初始化字体提供者
+     * @note 程序启动时调用一次，重复调用无效果
+     */
+    void warmUp();
+
+    // 字体是否已经扫描完成，完成前 getASSImage 不会渲染字幕
+    [[nodiscard]] bool fontsReady() const;
+
     [[deprecated("使用该方法加载字幕, MediaController 无法获取流信息")]]
     [[nodiscard]] bool init(const std::string &subFile); // 通过字幕文件加载
     /**
+     * 选中一条文本字幕流作为主字幕
+     * 文件第一次使用时会一次性解析其中所有的文本字幕流，之后在同一文件内切换不再读取文件
      * @param subStreamIdx 流ID，-1表示自动选中最佳字幕流
      * @note subStreamIdx 指 Demux全局的流ID
      */
     [[nodiscard]] bool init(const std::string &mediaFile, int subStreamIdx);
+    // 取消主字幕的选中，已解析的轨道保留，用于切换字幕
+    void deactivate();
+    // 释放所有已解析的轨道，用于关闭文件
     void uninit();
 
+    // 是否选中了主字幕
     [[nodiscard]] bool initialized() const;
 
     /**
-     * 添加一条事件
+     * 选中一条文本字幕流作为副字幕(双语字幕)，与主字幕同时显示在画面顶部
+     * @param subStreamIdx Demux全局的流ID，-1表示关闭副字幕
+     * @note 只有主字幕也是文本字幕时才会显示
+     */
+    [[nodiscard]] bool setSecondaryTrack(const std::string &mediaFile, int subStreamIdx);
+
+    /**
+     * 向主字幕添加一条事件
      * @note data的格式为：ReadOrder,Layer,Style,Name,MarginL,MarginR,MarginV,Effect,Text
      * @param startTime 开始时间 秒
      * @param duration 持续时间 秒
      */
     [[nodiscard]] bool addEvent(const char *data, int size, double startTime, double duration);
 
-    // 渲染一帧并获取矩形个数
-    [[nodiscard]] const ASS_Image *getASSImage(size_t &size, const QSize &videoSize, double pts);
+    // 一帧的渲染结果，图像在下一次 getASSImage 之前有效
+    struct Frame {
+        const ASS_Image *primary{nullptr};
+        const ASS_Image *secondary{nullptr}; // 副字幕
+        size_t size{0};                      // 矩形个数(包含副字幕)
+        // 其他线程正持有渲染器(切换轨道、添加字体)时跳过这一帧，此时应继续显示上一次的结果，不要调用 renderFrame
+        bool unchanged{false};
+    };
+
+    // 渲染一帧
+    [[nodiscard]] Frame getASSImage(const QSize &videoSize, double pts);
 
     /**
      * 渲染一帧到dataArr里
-     * @warning 请确保assImg是最后一次通过getASSImage()获取的
+     * @warning 请确保frame是最后一次通过getASSImage()获取的
      */
-    void renderFrame(std::vector<std::vector<uint8_t>> &dataArr, std::vector<QRect> &rects, const ASS_Image *assImg);
+    void renderFrame(std::vector<std::vector<uint8_t>> &dataArr, std::vector<QRect> &rects, const Frame &frame);
+
+    // 字幕相关的内存占用(字节)：所有轨道的事件存储 + 估算的 libass 轨道事件
+    [[nodiscard]] size_t memoryUsage() const;
+
+    // 合成用的像素内核，不依赖渲染器状态(可单独做基准测试)
+    // RGBA 反预乘
+    static void unpremultiplyAlpha(std::vector<uint8_t> &buffer);
+    // 把 img 混合到 dirtyRects 中包含它的那个矩形对应的 dataArr 缓冲区
+    static void blendSingleOnly(const DirtyRectManager &dirtyRects, std::vector<std::vector<uint8_t>> &dataArr, const ASS_Image *img);
+
 signals:
 
 private:
+    // 一条已解析的字幕轨道
+    struct Track {
+        ASS_Track *track{nullptr};
+        // 事件窗口：事件全部保存在 store 中，track 里只保留 [windowBegin, windowEnd) 内的事件
+        ASSEventStore store;
+        int64_t windowBegin{0}; // ms
+        int64_t windowEnd{0};   // ms, begin == end 表示窗口无效
+        size_t windowEvents{0}; // 当前窗口内的事件数
+        size_t trackBytes{0};   // 估算的 libass 事件内存
+
+        Track() = default;
+        Track(const Track &) = delete;
+        Track &operator=(const Track &) = delete;
+        ~Track() { ass_free_track(track); }
+    };
+    using TrackKey = std::pair<std::string, int>; // (文件, 流ID)
+
     ASS_Library *m_assLibrary{nullptr};
-    ASS_Renderer *m_assRenderer{nullptr};
-    ASS_Track *m_track{nullptr};
+    ASS_Renderer *m_assRenderer{nullptr};       // 主字幕
+    ASS_Renderer *m_secondaryRenderer{nullptr}; // 副字幕，两个轨道的图像需要同时有效，不能共用渲染器
+    std::map<TrackKey, std::unique_ptr<Track>> m_tracks;
+    std::map<std::string, int> m_parsedFiles;   // 已解析的文件 -> 最佳字幕流ID
+    Track *m_active{nullptr};
+    Track *m_secondary{nullptr};
     std::atomic<bool> m_initialized{false};
-    DirtyRectManager m_dirtyRectManager; // 用于脏矩阵合成
+    std::atomic<bool> m_warmUpStarted{false};
+    std::atomic<bool> m_fontsReady{false};
+    TaskHandle m_warmUpThread;
+    std::mutex m_mutex;                         // 保护库、渲染器与轨道，libass 本身不是线程安全的
+    // 已加入库中的字体附件，以 (内容哈希, 字节数) 区分；ass_add_font 加入的字体数据随库一直保留到进程退出，
+    // 所以这里记录的是整个进程内库中的字体，uninit 时不清空，再次打开同一字体时不重复加入
+    std::set<std::pair<uint64_t, size_t>> m_fontKeys;
+    QSize m_frameSize;                          // 当前渲染器设置的尺寸
+    DirtyRectManager m_dirtyRectManager;        // 用于脏矩阵合成
+    std::atomic<size_t> m_memoryBytes{0};
 
 private:
-    [[nodiscard]] bool initFromDemux(AVFormatContext *fmt, int subStreamIdx);
-    void unpremultiplyAlpha(std::vector<uint8_t> &buffer);
-    void blendSingleOnly(std::vector<std::vector<uint8_t>> &dataArr, const ASS_Image *img);
+    // 一次读取文件，解析其中所有的文本字幕流
+    [[nodiscard]] bool parseFile(const std::string &mediaFile);
+    [[nodiscard]] Track *findTrack(const std::string &mediaFile, int subStreamIdx);
+    void addFontAttachments(AVFormatContext *fmt);
+    [[nodiscard]] const ASS_Image *renderTrack(ASS_Renderer *renderer, Track &t, long long now);
+    void refillWindow(Track &t, int64_t now);
+    void updateCacheLimits(ASS_Renderer *renderer, const Track &t, const QSize &videoSize);
+    void updateMemoryUsage();
+    void addDirtyRects(const ASS_Image *img);
 };
 
 #endif // ASSRENDER_H
@@ -4,20 +4,32 @@
 #ifndef AUDIOPLAYER_H
 #define AUDIOPLAYER_H
 
+#include "audio/audioconverter.h"
+#include "audio/audiomixer.h"
+#include "audio/timestretcher.h"
 #include "compat/compat.h"
 #include "types/ptrs.h"
 #include "utils/spscbuffer.h"
+#include "utils/taskexecutor.h"
 #include <QObject>
+#include <chrono>
 #include <thread>
+#include <vector>
 
 AZ_EXTERN_C_BEGIN
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
-#include <libswresample/swresample.h>
 AZ_EXTERN_C_END
 
 struct ma_device;
 
+// 音频延迟档位，决定设备周期大小/个数和 PCM buffer 的水位
+enum class AudioLatencyProfile {
+    PowerSaving = 0, // 大周期，唤醒次数少
+    Balanced,        // 默认
+    LowLatency,      // 小周期，音量/暂停/seek 响应最快
+};
+
 class AudioPlayer : public QObject {
     Q_OBJECT
 private:
@@ -27,14 +39,18 @@ public:
     explicit AudioPlayer(QObject *parent = nullptr);
     ~AudioPlayer();
 
-    // 初始化
+    // 初始化，音频设备只在第一次调用时打开，之后的流都转换到设备格式
     [[nodiscard]] bool init(const AVCodecParameters *codecParams, sharedFrmQueue frmBuf);
-    // 回到未初始化状态
-    void uninit();
+    /**
+     * 回到未初始化状态，音频设备保持打开
+     * @param keepBuffered 切换音轨时为 true：已缓冲的数据继续播放，新流的数据从其末尾无缝接上；
+     *                     否则停止设备并丢弃缓冲(关闭文件)
+     */
+    void uninit(bool keepBuffered = false);
 
     // 启动
     void start();
-    // 退出
+    // 退出PCM线程
     void stop();
 
     void togglePaused();
@@ -42,6 +58,32 @@ public:
     [[nodiscard]] double volume() const;
     void setVolume(double newVolume);
 
+    // 延迟档位，设备在下一次 init 时按新档位重新打开
+    [[nodiscard]] AudioLatencyProfile latencyProfile() const;
+    void setLatencyProfile(AudioLatencyProfile profile);
+
+    // 双耳渲染：设备为立体声时把多声道/Ambisonics 渲染为耳机信号，主音轨在下一次 init 时生效
+    // 调用要求同 setOverlay
+    [[nodiscard]] bool binaural() const;
+    void setBinaural(bool enabled);
+
+    /**
+     * 设置叠加音轨，其数据与主音轨按pts对齐后混音(解说音轨、外部音频叠加在原声上)
+     * @param frmBuf 由另一个 DecodeAudio 解码的帧队列
+     * @note 只能在 PCM 线程未运行时调用(stop 之后、start 之前)，设备需已打开
+     */
+    [[nodiscard]] bool setOverlay(const AVCodecParameters *codecParams, sharedFrmQueue frmBuf);
+    // 移除叠加音轨，调用要求同 setOverlay
+    void clearOverlay();
+    [[nodiscard]] bool haveOverlay() const;
+
+    // 叠加音轨相对主音轨的增益，与设备音量相乘
+    void setOverlayGain(double gain);
+
+    // 播放速度，不等于1时经过 TimeStretcher 变速不变调
+    [[nodiscard]] double speed() const;
+    void setSpeed(double newSpeed);
+
 signals:
     void seeked();
     void playedOneFrame(); // 播放了一帧(仅没有视频流 或是 seek 时发射该信号)
@@ -50,40 +92,101 @@ private:
     sharedFrmQueue m_frmBuf;
 
     ma_device *m_audioDevice = nullptr; // 音频设备 NOTE: 生命周期与AudioPlayer一致，不要在init或者uninit里重新构造/析构
-    SwrContext *m_swrContext = nullptr; // 用于重采样的上下文
-    SPSCBuffer *m_pcmBuffer = nullptr;  // PCM buffer，用于在音频回调时使用
+    bool m_deviceOpened = false;        // 设备只打开一次，使用设备原生采样率和声道，f32格式
+    AudioConverter m_converter;         // 解码帧 -> 设备格式
+    bool m_binaural = false;            // 多声道转换到立体声设备时做双耳渲染
+    SPSCBuffer *m_pcmBuffer = nullptr;  // PCM buffer，用于在音频回调时使用，与设备一同创建
 
-    // 重采样缓冲区
-    uint8_t **m_swrBuffer = nullptr;
-    int m_swrBufferSize = 0;
-
-    // 一个完整AVFrame 的 PCM 数据
+    // 一个完整AVFrame，writePCM 将其直接转换/拷贝到 m_pcmBuffer 中
     AVFrmItem m_frmItem{};
-    int m_pcmDataSize = 0;
-    uint8_t *m_pcmDataPtr = nullptr;
-    int m_pcmDataIndex = 0;
-    int m_pcmFrameSize; // 一个PCM帧的字节大小
-    double m_bufferedEndPts; // 已经写入 m_pcmBuffer 的最新数据所表示的pts
+    int m_pcmFrameSize = 0;       // 一个PCM帧的字节大小
+    double m_deviceLatency = 0.0; // 回调写入的数据到真正播放出来的延迟(秒)，只在设备启动前写入
+
+    // ==== 延迟档位与欠载 ====
+    AudioLatencyProfile m_latencyProfile = AudioLatencyProfile::Balanced; // 用户选择的档位
+    AudioLatencyProfile m_deviceProfile = AudioLatencyProfile::Balanced;  // 设备打开时使用的档位
+    std::atomic<uint64_t> m_targetFill{0};      // PCM buffer 的目标水位(字节)，PCM线程只填充到该水位，欠载时由回调提高
+    uint64_t m_fillStep = 0;                    // 每次欠载提高的水位(字节)
+    std::chrono::microseconds m_fillWait{5000}; // 达到水位后PCM线程的等待时间，取设备周期的一半
+    std::atomic<bool> m_underrunArmed{false};   // PCM线程正在持续供给数据，此时读空才算欠载
+    std::atomic<int> m_underrunCount{0};        // 欠载次数
 
     // ==== FFmmpeg的音频参数 ====
-    AudioPar m_oldPar; // 原始音频参数
-    AudioPar m_swrPar; // 重采样音频参数，未进行重采样时与m_oldPar一致
+    AudioPar m_oldPar;    // 原始音频参数
+    AudioPar m_devicePar; // 输出(设备)音频参数，设备打开后不再改变
+
+    // ==== 切换音轨时的拼接 ====
+    double m_writtenEndPts = INVALID_DOUBLE; // 已写入 m_pcmBuffer 的数据的结束pts
+    bool m_splicing = false;      // 新流的数据需要接在已缓冲数据之后
+    bool m_switchPending = false; // 新流的第一帧尚未写入，用于统计切换耗时
+    std::chrono::steady_clock::time_point m_switchBegin;
+
+    // ==== 变速 ====
+    std::atomic<double> m_speed{1.0};           // 回调与PCM线程都会读取
+    TimeStretcher m_stretcher;                  // 设备格式数据 -> 变速后的数据，与设备一同初始化
+    std::vector<float> m_stretchChunk;          // 转换输出的中间缓冲
+    bool m_stretching = false;                  // 上一帧是否经过了 m_stretcher
+    int64_t m_stretchAnchorPos = 0;             // 最近一个有效pts对应的 m_stretcher 输入位置(帧)
+    double m_stretchAnchorPts = INVALID_DOUBLE; // 该位置的pts
+
+    // ==== 叠加音轨 ====
+    AudioMixer m_mixer;                     // 与设备一同初始化
+    sharedFrmQueue m_overlayFrmBuf;         // 为空表示没有叠加音轨
+    AudioPar m_overlayPar;                  // 叠加音轨的原始参数
+    AudioConverter m_overlayConverter;      // 叠加音轨 -> f32、设备采样率，声道不变，由 m_mixer 下混
+    AVFrmItem m_overlayItem{};              // 当前转换的叠加音轨帧
+    std::vector<float> m_overlayChunk;      // 叠加音轨转换输出的中间缓冲
+    int m_overlayTrack = -1;                // m_mixer 中的音轨ID
+    int m_overlaySerial = 0;                // 叠加音轨帧队列的序号，变化时丢弃已缓存的数据
+    std::atomic<float> m_overlayGain{1.0f}; // 控制线程写入，PCM线程每帧取用
+
+    // ==== 主时钟不是音频时的漂移校正 ====
+    double m_driftCum = 0.0;     // 音频时钟 - 主时钟 的指数加权累计
+    int m_driftAvgCount = 0;     // 已累计的次数，足够多之后才开始校正
+    bool m_compensating = false; // 是否正在补偿
 
     bool m_initialized = false; // 是否已经初始化
     int m_serial = 0;
-    std::thread m_thread;
+    TaskHandle m_thread;
     std::atomic<bool> m_stop{true};
     std::atomic<bool> m_paused{false};
     bool m_forceRefresh{false};
     double m_volume = 1.0;
 
 private:
+    // 以设备原生参数打开音频设备，并创建 PCM buffer
+    [[nodiscard]] bool openDevice();
+    // 关闭音频设备并释放 PCM buffer，用于切换延迟档位
+    void closeDevice();
+
+    // 当前水位下还能写入的帧数
+    [[nodiscard]] uint64_t writableFrames() const;
+
+    // 按 m_overlayPar 配置叠加音轨的转换器和混音音轨，设备重新打开后也要调用
+    [[nodiscard]] bool setupOverlayTrack();
+    // 解码叠加音轨直到其数据覆盖 endPts，再把各音轨混入 dst
+    void mixOverlay(float *dst, int64_t frames, double pts);
+    [[nodiscard]] bool getOverlayFrm(AVFrmItem &item);
+
     [[nodiscard]] bool getFrm(AVFrmItem &item);
 
     void playerLoop();
     void writePCM();
 
-    // 从队列获取一帧并更新 PCM 数据
+    // 在 m_pcmBuffer 的写指针处打上 pts 标记，标记环满时记录日志
+    void pushPtsMarker(double pts);
+    /**
+     * 把 m_converter 当前输入的数据写入 m_pcmBuffer
+     * @return 写入的帧数(变速时为变速前的帧数)，失败或停止时返回 -1
+     */
+    [[nodiscard]] int64_t writeConverted(double pts);
+    [[nodiscard]] int64_t writeStretched(double pts);
+
+    // 主时钟不是音频时，按音频与主时钟的差值微调本帧输出的采样数
+    void syncToMainClock(int nbSamples);
+    void resetDriftCorrection();
+
+    // 从队列获取一帧
     [[nodiscard]] bool updatePcmFromFrameQueue();
 
     static void miniaudio_data_callback(ma_device *pDevice, void *pOutput, const void *pInput, ma_uint32 frameCount);
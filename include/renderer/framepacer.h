@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <cstddef>
+#include <limits>
+
+/**
+ * 视频送显节奏：由相邻帧的 pts 差与视频/主时钟的差值算出每帧的计划送显时刻，再判断到点时是否该丢帧
+ * schedule/shouldPresent 只做计算，不读时钟也不睡眠；时间都是现实时间(秒)，由调用方传入
+ * 完整的单帧送显流程见 presentFrame，VideoPlayer 与 azplayer-syncsim 共用
+ */
+class FramePacer {
+public:
+    struct Frame {
+        double pts;
+        double duration;
+    };
+
+    enum class Sync {
+        ON_TIME,
+        LATE,  // 落后主时钟，缩短等待
+        EARLY, // 领先主时钟，延长等待
+    };
+
+    struct Plan {
+        double wait; // 距离计划送显时刻还要等待的时间(秒)，不大于 kMaxWait
+        Sync sync;
+    };
+
+    static constexpr double kMaxWait = 0.1; // 单次最多等待的时间，防止时钟跳变后长时间卡住
+    static constexpr double kInvalid = std::numeric_limits<double>::quiet_NaN();
+
+    // 清空上一帧与计划时刻，例如重新打开文件时
+    void reset();
+
+    /**
+     * 为下一帧安排送显时刻
+     * @param diff (视频时钟 - 主时钟) / 速度，NaN 表示无法比较
+     * @param restart 不参考之前的计划，以 now 作为这一帧的送显时刻(seek、切流后的第一帧)
+     */
+    Plan schedule(const Frame &frame, double diff, double speed, double maxFrameDuration, bool restart, double now);
+
+    /**
+     * 到了 now 时当前帧是否仍应送显：已经超过下一帧的计划时刻则丢弃
+     * @param next 下一帧，nullptr 表示队列中还没有
+     */
+    [[nodiscard]] bool shouldPresent(const Frame *next, double speed, double maxFrameDuration, double now) const;
+
+    // 暂停恢复后以 now 作为计划时刻的起点
+    void resume(double now);
+
+    // 当前帧的计划送显时刻(秒)
+    [[nodiscard]] double renderTime() const;
+
+    // 两帧之间的时长，pts 不连续时退回上一帧自带的 duration
+    [[nodiscard]] static double frameDuration(const Frame &last, const Frame &now, double maxFrameDuration);
+
+    // presentFrame 中与运行环境相关的部分：播放器用 TimeSource 与帧队列，模拟器用虚拟时间与解码模型
+    class Hooks {
+    public:
+        virtual ~Hooks() = default;
+        [[nodiscard]] virtual double now() = 0;
+        virtual void sleepFor(double seconds) = 0;
+        // 帧队列中的下一帧，队列为空时返回 false
+        [[nodiscard]] virtual bool peekNext(Frame &next) = 0;
+        [[nodiscard]] virtual size_t queueDepth() = 0;
+        // 送显当前帧
+        virtual void present() = 0;
+        // 丢弃当前帧
+        virtual void drop() = 0;
+    };
+
+    /**
+     * 视频播放线程处理一帧的送显流程：安排送显时刻 → 统计落后/领先 → 等待 → 判断是否丢帧 → 更新视频时钟与统计
+     * 速度、最大帧时长与主时钟取自 GlobalClock，计数写入 PlaybackStats，模拟器的计数即实际播放的计数
+     * @param restart seek、切流后的第一帧，见 schedule；该帧不计入送显抖动与音画误差分布
+     * @return 是否送显
+     */
+    bool presentFrame(const Frame &frame, bool restart, Hooks &hooks);
+
+private:
+    Frame m_last{kInvalid, kInvalid}; // 上一帧
+    double m_renderTime = kInvalid;   // 当前帧的计划送显时刻
+};
+
+#endif // FRAMEPACER_H
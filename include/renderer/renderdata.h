@@ -20,7 +20,6 @@ AZ_EXTERN_C_BEGIN
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 #include <libavutil/pixdesc.h>
-#include <libswscale/swscale.h>
 AZ_EXTERN_C_END
 
 struct VideoRenderData {
@@ -103,6 +102,9 @@ struct VideoRenderData {
 
     void updateGLParaArr(VideoRenderData::PixFormat fmt);
 
+    // 占用的内存(字节)：持有的解码帧 + 拆分平面的缓冲区
+    [[nodiscard]] int64_t memoryBytes() const;
+
     VideoRenderData() { reset(); }
     ~VideoRenderData() {
         if (frmItem.frm) {
@@ -114,7 +116,6 @@ struct VideoRenderData {
 struct SubRenderData {
     AVFrmItem frmItem;
     AVSubtitleType subtitleType = SUBTITLE_NONE; // 无字幕
-    SwsContext *subSwsCtx = nullptr;
 
     size_t size; // 矩形可用个数，避免频繁清空分配dataArr
     // *请不要直接使用 vector::size()
@@ -138,12 +139,15 @@ struct SubRenderData {
      */
     void updateBitmapImage(AVFrmItem *newItem, int videoWidth, int videoHeight);
 
-    // 更新ASS字幕
-    void updateASSImage(double pts, int videoWidth, int videoHeight);
+    // 更新ASS字幕，frame 为 ASSRender::getASSImage 的结果
+    void updateASSImage(const ASSRender::Frame &frame);
 
     // 准备缓冲区
     void prepareBuffers(size_t newSize);
 
+    // 占用的内存(字节)：各矩形的 RGBA 缓冲区(含暂未使用的)
+    [[nodiscard]] int64_t memoryBytes() const;
+
     SubRenderData() { reset(); }
     ~SubRenderData() { reset(); }
 };
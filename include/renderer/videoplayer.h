@@ -5,10 +5,12 @@
 #define VIDEOPLAYER_H
 
 #include "compat/compat.h"
+#include "renderer/framepacer.h"
 #include "renderer/renderdata.h"
 #include "types/ptrs.h"
+#include "utils/taskexecutor.h"
 #include <QObject>
-#include <QPair>
+#include <array>
 #include <atomic>
 #include <thread>
 
@@ -20,8 +22,6 @@ AZ_EXTERN_C_END
 class VideoPlayer : public QObject {
     Q_OBJECT
 public:
-    using FrameInterval = QPair<double, double>;
-
     explicit VideoPlayer(QObject *parent = nullptr);
     ~VideoPlayer();
 
@@ -48,23 +48,26 @@ signals:
 
 private:
     // 双缓冲
-    VideoDoubleBuf m_videoRenderData;       // 视频
-    SubtitleDoubleBuf m_subRenderData;      // 字幕
-    FrameInterval m_lastVideoFrameInterval; // 上一帧视频帧区间
-    double m_subtitleEndDisplayTime;        // 上一帧字幕结束时间
-    bool m_needClearSubtitle;               // 需要清空字幕
-    double m_renderTime;                    // 实际渲染指令被发出的时间(相对现实时间，秒)
+    VideoDoubleBuf m_videoRenderData;  // 视频
+    SubtitleDoubleBuf m_subRenderData; // 字幕
+    FramePacer m_pacer;                // 送显节奏
+    double m_subtitleEndDisplayTime;   // 上一帧字幕结束时间
+    bool m_needClearSubtitle;          // 需要清空字幕
 
     std::atomic<bool> m_stop{true};
     std::atomic<bool> m_paused{false};
     bool m_forceRefresh{false};
     int m_serial = 0;
-    std::thread m_thread;
+    TaskHandle m_thread;
     bool m_initialized = false; // 是否已经初始化
 
     int m_width{0};  // 视频宽
     int m_height{0}; // 视频高
 
+    // 双缓冲中每个缓冲区占用的内存(字节)，下标为缓冲区 idx
+    std::array<int64_t, 2> m_videoBufBytes{};
+    std::array<int64_t, 2> m_subBufBytes{};
+
 private:
     /**
      * 写入一帧数据
@@ -76,8 +79,6 @@ private:
 
     void playerLoop();
 
-    [[nodiscard]] static double getDuration(const FrameInterval &last, const FrameInterval &now);
-
     void handleASSSubtitle(double pts); // ASS 字幕
     void handleBitmapSubtitle();        // 位图字幕
     void handleEmptySubtitle();         // 写入空字幕
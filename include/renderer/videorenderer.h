@@ -6,10 +6,13 @@
 
 #include "compat/compat.h"
 #include "renderer/renderdata.h"
+#include <QOpenGLFramebufferObject>
 #include <QOpenGLFunctions_3_3_Core>
 #include <QOpenGLShaderProgram>
 #include <QQuickFramebufferObject>
 #include <QSize>
+#include <memory>
+#include <vector>
 
 AZ_EXTERN_C_BEGIN
 #include <libavutil/frame.h>
@@ -24,6 +27,9 @@ public:
     void render() override;
     void synchronize(QQuickFramebufferObject *item) override;
 
+    // 不经过 VideoWindow 直接指定渲染数据(无界面时使用)，需在渲染线程调用
+    void setRenderData(VideoDoubleBuf *vidData, SubtitleDoubleBuf *subData);
+
 private:
     QOpenGLShaderProgram m_program;
     GLuint m_vao = 0;
@@ -35,7 +41,6 @@ private:
     QSize m_subtitleSize{}; // 字幕的宽高
 
     AVPixelFormat m_AVPixelFormat = AV_PIX_FMT_NONE;
-    AVSubtitleType lastSubType = SUBTITLE_NONE;
     /**
      * Y | R | RGB | RGBA
      * U | G
@@ -70,6 +75,9 @@ private:
     VideoDoubleBuf *m_vidData = nullptr;    // 渲染需要的视频数据
     SubtitleDoubleBuf *m_subData = nullptr; // 渲染需要的字幕数据
 
+    std::unique_ptr<QOpenGLFramebufferObject> m_captureFBO; // 输出记录读回画面用的单采样 FBO
+    std::vector<uint8_t> m_capturePixels;
+
 private:
     // 初始化视频纹理
     void initVideoTex(VideoRenderData *renderData);
@@ -77,6 +85,10 @@ private:
     void initSubtitleTex(SubRenderData *subRenderData);
 
     [[nodiscard]] bool updateTex(VideoRenderData::PixFormat fmt);
+    // 读回刚绘制完的画面(含字幕)交给 OutputSink
+    void captureFrame(double pts, double duration);
+    // 重新计算纹理与 FBO 的显存估算并写入 PlaybackStats，纹理/FBO 重建后调用
+    void updateTextureStats();
     // 字幕纹理固定 RGBA_PACKED 格式
     [[nodiscard]] bool updateSubTex(SubRenderData &renData);
 
@@ -107,8 +119,14 @@ private:
     // 把纹理单元和纹理对象绑定
     void bindAllTexturesForDraw();
 
-    // 清空字幕纹理
+    // 清空字幕纹理(只清理上一次写入的区域)
     void clearSubtitleTex();
+
+    /**
+     * 清理上一次写入字幕纹理的矩形，调用前需绑定字幕纹理
+     * @param keepRects 即将写入的新矩形，被其完全覆盖的旧矩形不再清理
+     */
+    void clearSubTexRects(const QRect *keepRects, size_t keepCount);
 };
 
 // QML控件
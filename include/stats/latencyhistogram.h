@@ -0,0 +1,111 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include "compat/compat.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#pragma warning(push)
+#pragma warning(disable : 4324) // 因对齐说明符填充结构是预期的（cache line padding）
+#endif
+
+/**
+ * 固定分桶的对数-线性直方图(HDR 风格)，记录非负整数(如耗时 us、队列长度)
+ * - [0, 2^kSubBits) 每个值一个桶，之后每个 2 的幂区间均分为 2^(kSubBits-1) 个桶，相对误差不超过 1/2^(kSubBits-1)
+ * - 超过 kMaxValue 的值计入最后一个桶，max 仍然精确
+ * - record 只有几次 relaxed 读写，没有锁也没有 lock 前缀指令；任意线程可随时 snapshot
+ * @note 每个直方图只能有一个写线程，不同线程写的直方图各占独立的 cache line
+ */
+class alignas(hardware_destructive_interference_size) LatencyHistogram {
+public:
+    static constexpr int kSubBits = 5;
+    static constexpr int kMaxBits = 36; // 以 us 计约 19 小时
+    static constexpr uint64_t kMaxValue = (uint64_t{1} << kMaxBits) - 1;
+    static constexpr int kBucketCount = (kMaxBits - kSubBits + 2) << (kSubBits - 1);
+
+    // 某一时刻的统计结果，值的单位与 record 一致
+    struct Snapshot {
+        uint64_t count = 0;
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        uint64_t max = 0;
+    };
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    // 只能由写线程调用
+    void record(uint64_t value) {
+        const int idx = bucketIndex(value);
+        m_buckets[idx].store(m_buckets[idx].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_sum.store(m_sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        if (value > m_max.load(std::memory_order_relaxed))
+            m_max.store(value, std::memory_order_relaxed);
+    }
+
+    // 清零，调用时不能有线程在 record
+    void reset();
+
+    [[nodiscard]] Snapshot snapshot() const;
+
+    // p ∈ [0, 1]，没有样本时返回 0；需要多个百分位时用 snapshot，只读一遍桶
+    [[nodiscard]] double percentile(double p) const;
+
+    [[nodiscard]] static int bucketIndex(uint64_t value) {
+        if (value > kMaxValue)
+            value = kMaxValue;
+        if (value < (uint64_t{1} << kSubBits))
+            return static_cast<int>(value);
+        const int shift = highestBit(value) - kSubBits + 1;
+        return (shift << (kSubBits - 1)) + static_cast<int>(value >> shift);
+    }
+
+    // 桶 idx 覆盖的最小值与宽度
+    [[nodiscard]] static constexpr uint64_t bucketLower(int idx) {
+        if (idx < (1 << kSubBits))
+            return static_cast<uint64_t>(idx);
+        const int shift = (idx >> (kSubBits - 1)) - 1;
+        const uint64_t sub = static_cast<uint64_t>(idx & ((1 << (kSubBits - 1)) - 1)) + (uint64_t{1} << (kSubBits - 1));
+        return sub << shift;
+    }
+    [[nodiscard]] static constexpr uint64_t bucketWidth(int idx) {
+        return idx < (1 << kSubBits) ? 1 : uint64_t{1} << ((idx >> (kSubBits - 1)) - 1);
+    }
+
+private:
+    // value 最高位的序号，value 不为 0
+    [[nodiscard]] static int highestBit(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long idx = 0;
+        _BitScanReverse64(&idx, value);
+        return static_cast<int>(idx);
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    using Counts = std::array<uint64_t, kBucketCount>;
+
+    // 把桶计数读到 counts，返回总数
+    uint64_t loadCounts(Counts &counts) const;
+    [[nodiscard]] static double valueAtRank(const Counts &counts, uint64_t rank, uint64_t max);
+
+    std::array<std::atomic<uint64_t>, kBucketCount> m_buckets{};
+    std::atomic<uint64_t> m_sum{0};
+    std::atomic<uint64_t> m_max{0};
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,147 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef OUTPUTSINK_H
+#define OUTPUTSINK_H
+
+#include "utils/spscring.h"
+#include "utils/taskexecutor.h"
+#include "utils/xxhash64.h"
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QJsonObject>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct VideoRenderData;
+class SPSCBuffer;
+
+/**
+ * 输出回归记录：把播放器真正输出的内容逐帧做 XXH64，写成文本哈希列表，可选同时写出 y4m/wav
+ * - video.xxh64：送显的 VideoRenderData(即渲染器拿到的各平面数据)，每个送显帧一行
+ * - fbo.xxh64：合成后(含字幕)读回的 FBO 画面，只在开启 fbo 时记录，每个上传了新视频帧的 render 一行
+ * - audio.xxh64：设备回调写出的 PCM(交织 f32，含欠载时的静音)，每秒一行
+ * 列表每行为 "序号 ... 哈希"，格式变化时插入以 # 开头的说明行，compare 逐行比较两个目录
+ * @note 设备回调只把 PCM 写进无锁环形缓冲区，哈希和文件 IO 在单独的线程；视频与 FBO 在调用线程同步处理
+ */
+class OutputSink {
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator=(const OutputSink &) = delete;
+
+public:
+    struct Options {
+        bool dump = false; // 同时写出 video.y4m / fbo.y4m / audio.wav
+        bool fbo = false;  // 读回合成后的 FBO
+    };
+
+    static OutputSink &instance();
+
+    [[nodiscard]] static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    [[nodiscard]] static bool fboEnabled() { return s_fbo.load(std::memory_order_relaxed); }
+
+    // 开始记录到 dir(不存在时创建)，已在记录时先结束上一次
+    [[nodiscard]] bool begin(const QString &dir, const Options &opt);
+    // 结束记录，写出剩余数据并关闭所有文件
+    void end();
+
+    // 送显的视频渲染数据，在 release 之前由写线程调用
+    void writeVideo(const VideoRenderData &data);
+    // 读回的画面，rgba 为自上而下、紧密排列的 RGBA8；duration 只用于 y4m 的帧率
+    void writeFBO(const uint8_t *rgba, int width, int height, double pts, double duration);
+
+    // 设备输出格式(交织 f32)，不在记录时也会保存；请在设备回调停止时调用
+    void setAudioFormat(int channels, int sampleRate);
+    // 设备回调输出的 PCM，实时线程调用：不加锁、不做 IO，缓冲区放不下时整块丢弃并在列表的对应位置记录
+    void writeAudio(const float *pcm, uint32_t frames, int channels);
+    // 非实时线程直接写出 PCM(不经过环形缓冲区，不会丢弃)
+    void writeAudioSync(const float *pcm, uint32_t frames, int channels);
+
+    /**
+     * 逐行比较 goldenDir 与 dir 中的哈希列表，golden 中没有的列表跳过
+     * @return {"ok": bool, "video"/"fbo"/"audio": {"ok", "lines", "goldenLines", 第一处不同的 "line"/"frame"/"expected"/"actual"}}
+     */
+    [[nodiscard]] static QJsonObject compare(const QString &goldenDir, const QString &dir);
+
+private:
+    // 一个哈希列表文件
+    struct HashList {
+        QFile file;
+        int64_t count = 0; // 已写入的记录数
+    };
+
+    // 一个 y4m 文件，格式(key)变化时换一个新文件
+    struct Y4MFile {
+        QFile file;
+        QByteArray key;
+        int segment = 0;
+    };
+
+    OutputSink();
+    ~OutputSink();
+
+    void endLocked();
+    // 打开 <kind>.xxh64 并写入文件头
+    [[nodiscard]] bool openList(HashList &list, const char *kind);
+    void closeList(HashList &list);
+    // 需要时打开新的 y4m 分段并写入帧头，失败返回 false
+    [[nodiscard]] bool beginY4MFrame(Y4MFile &y4m, const char *baseName, const QByteArray &key, double duration);
+    static void closeY4M(Y4MFile &y4m);
+
+    // 以下由 m_audioMutex 保护
+    void drainAudioRing();
+    void writeDropMarker(uint64_t dropped);
+    void consumeAudio(const uint8_t *data, uint64_t len);
+    void finishAudioChunk();
+    void openAudioSegment();
+    void closeAudioSegment();
+
+    static inline std::atomic<bool> s_enabled{false};
+    static inline std::atomic<bool> s_fbo{false};
+
+    std::mutex m_mutex; // 保护 begin/end 与视频、FBO 的记录
+    QDir m_dir;
+    Options m_opt;
+    HashList m_videoList;
+    HashList m_fboList;
+    Y4MFile m_videoY4M;
+    Y4MFile m_fboY4M;
+    std::vector<uint8_t> m_fboPlanes; // FBO 转 YUV444 的临时数据
+
+    // 音频：回调 -> m_audioRing -> 写线程
+    std::unique_ptr<SPSCBuffer> m_audioRing;
+    std::atomic<int> m_audioInFlight{0};     // 正在写环形缓冲区的回调数，end 等它归零
+    // 一次(或连续几次)丢弃：位置与大小一起传给写线程
+    struct AudioDrop {
+        uint64_t offset = 0; // 丢弃发生时累计写入的字节数
+        uint64_t bytes = 0;
+    };
+    static constexpr size_t kAudioDropSlots = 256;
+    SPSCRing<AudioDrop> m_audioDrops{kAudioDropSlots}; // 回调 -> 写线程
+    // 以下只有回调线程使用(end 等回调全部退出后也会读写)
+    AudioDrop m_pendingDrop;   // 尚未放入 m_audioDrops 的丢弃，之后的丢弃位置相同时合并
+    uint64_t m_audioWritten = 0; // 累计写入环形缓冲区的字节数
+    std::atomic<bool> m_audioStop{true};
+    TaskHandle m_audioThread;
+
+    std::mutex m_audioMutex;
+    bool m_audioActive = false; // 正在记录
+    int m_channels = 0;
+    int m_sampleRate = 0;
+    HashList m_audioList;
+    QFile m_wav;
+    int m_wavSegment = 0;
+    uint64_t m_wavBytes = 0;
+    XXHash64 m_audioHash;
+    uint64_t m_chunkBytes = 0;  // 当前这一秒已经哈希的字节数
+    uint64_t m_audioFrames = 0; // 本段已输出的帧数
+    uint64_t m_audioRead = 0;   // 累计从环形缓冲区读出的字节数
+    uint64_t m_audioDroppedTotal = 0;
+    std::vector<uint8_t> m_audioScratch;
+};
+
+#endif // OUTPUTSINK_H
@@ -4,19 +4,90 @@
 #ifndef PLAYBACKSTATS_H
 #define PLAYBACKSTATS_H
 
+#include <QJsonObject>
 #include <QObject>
 #include <QSize>
 #include <QString>
+#include <atomic>
 #include <chrono>
-#include <deque>
+#include "stats/latencyhistogram.h"
 #include "types/types.h"
+#include "utils/enumindexarray.h"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4324) // 因对齐说明符填充结构是预期的（cache line padding）
+#endif
+
+/**
+ * 单写者的统计量：写线程用 relaxed 原子读写(读改写也不需要 lock 前缀)，其他线程随时读取
+ * 用法与普通变量一致，只是同一个值只能由一个线程写
+ */
+template <typename T>
+class StatValue {
+public:
+    StatValue(T value = T{}) : m_value(value) {}
+    StatValue(const StatValue &) = delete;
+    StatValue &operator=(const StatValue &) = delete;
+
+    StatValue &operator=(T value) {
+        m_value.store(value, std::memory_order_relaxed);
+        return *this;
+    }
+    operator T() const { return m_value.load(std::memory_order_relaxed); }
+
+    StatValue &operator+=(T delta) { return *this = static_cast<T>(*this + delta); }
+    StatValue &operator++() { return *this += T{1}; }
+    T operator++(int) {
+        const T old = *this;
+        *this += T{1};
+        return old;
+    }
+
+private:
+    std::atomic<T> m_value;
+};
+
+// QSize 打包在一个 64 位原子量里，宽高总是一起更新
+class StatSize {
+public:
+    StatSize &operator=(const QSize &size) {
+        m_packed.store(static_cast<uint64_t>(static_cast<uint32_t>(size.width())) << 32 | static_cast<uint32_t>(size.height()),
+                       std::memory_order_relaxed);
+        return *this;
+    }
+    [[nodiscard]] QSize load() const {
+        const uint64_t packed = m_packed.load(std::memory_order_relaxed);
+        return {static_cast<int32_t>(packed >> 32), static_cast<int32_t>(packed & 0xFFFFFFFFu)};
+    }
+
+private:
+    std::atomic<uint64_t> m_packed{0};
+};
 
+/**
+ * 播放统计，各线程写各自的一组字段(每组独占 cache line)，GUI 线程定时读取显示
+ * 耗时/误差/队列长度另有分桶直方图，可得到 p50/p95/p99/max，结束播放时可导出 JSON 对比不同构建
+ */
 class PlaybackStats : public QObject {
     Q_OBJECT
     Q_DISABLE_COPY_MOVE(PlaybackStats)
 public:
+    // 有分布统计的各阶段
+    enum class Stage {
+        VideoDecode,   // 一个视频包的解码耗时(ms)
+        VideoPrep,     // 视频渲染数据准备耗时(ms)
+        SubPrep,       // 字幕渲染数据准备耗时(ms)
+        Upload,        // 视频纹理上传耗时(ms)
+        PresentJitter, // 实际送显时刻与计划时刻之差的绝对值(ms)
+        AvError,       // |主时钟 - 视频时钟|(ms)
+        QueueDepth,    // 送显时视频帧队列的长度(帧)
+        Count
+    };
+
     static PlaybackStats &instance();
 
+    // 清空所有统计，调用时各播放线程不能在运行
     void reset();
 
     void frameRendered(); // 每渲染一帧调用一次，统计FPS用
@@ -24,70 +95,115 @@ public:
     void updateVideoDecodeTime(double ms); // 解码一次视频调用一次
     void updateVideoPrepTime(double ms);   // 准备一次视频调用一次
     void updateSubPrepTime(double ms);     // 准备一次字幕调用一次
+    void updateUploadTime(double ms);      // 上传一次视频纹理调用一次
+    void recordPresentJitter(double sec);  // 每送显一帧调用一次，sec = 实际时刻 - 计划时刻
+    void recordQueueDepth(size_t frames);  // 每送显一帧调用一次
+
+    // ==== 音画同步误差分布，用于回归对比 ====
+    void recordAvSyncError(double sec);                         // 每显示一帧视频调用一次，sec = 主时钟 - 视频时钟
+    [[nodiscard]] double avSyncErrorPercentile(double p) const; // |误差| 的百分位(ms)，p ∈ [0, 1]
+
+    // 某阶段当前的分布，单位见 Stage
+    [[nodiscard]] LatencyHistogram::Snapshot snapshot(Stage stage) const;
+
+    // 计数器与所有阶段的分布：{ "build", "counters": {...}, "stages": { "<name>": { "unit", "count", "mean", "p50", "p95", "p99", "max" } } }
+    [[nodiscard]] QJsonObject toJson() const;
+    Q_INVOKABLE bool dumpJson(const QString &path) const;
 
     // 获取拼接好的文本信息（HTML主要是为了带颜色）
     Q_INVOKABLE [[nodiscard]] QString getPlaybackStatsStringHTML() const;
 
+    // 开始/停止线程 CPU 与常驻内存的采样(见 ResourceMonitor)，只在显示统计时需要
+    Q_INVOKABLE void setResourceSampling(bool enabled);
+
 public:
-    // ==== 队列长度 ====
-    size_t audioPacketCount{};
-    size_t videoPacketCount{};
-    size_t subtitlePacketCount{};
-
-    size_t audioFrameCount{};
-    size_t videoFrameCount{};
-    size_t subtitleFrameCount{};
-
-    // ==== 视频/字幕尺寸 ====
-    QSize videoSize{};
-    QSize subtitleSize{};
-    QSize FBOSize{};
-
-    // ==== FPS ====
-    double videoFps{};
-    double outputFps{};
-
-    // ==== 视频解码耗时统计 ms ====
-    double videoDecodeTime{0.0};    // 当前视频帧解码耗时
-    double avgVideoDecodeTime{0.0}; // 视频解码平均耗时
-
-    // ==== 视频数据准备耗时 ms====
-    double videoPrepTime{0.0};
-    double avgVideoPrepTime{0.0};
-
-    // ==== 字幕数据准备耗时 ms====
-    double subPrepTime{0.0};
-    double avgSubPrepTime{0.0};
-
-    // ==== 帧状态 ====
-    int lateFrameCount{};
-    int earlyFrameCount{};
-    int droppedFrameCount{};
-
-    // ==== 时间戳 ====
-    double videoPTS{INVALID_DOUBLE};
-    double audioPTS{INVALID_DOUBLE};
-    double avPtsDiff{INVALID_DOUBLE};
-
-    // 视频信息
-    QString videoPixFormat;
-    int videoFormat; // AVFrame->format 这儿仅用于标记，避免重复更新videoPixFormat
+    // ==== 队列长度(GUI 定时器) ====
+    alignas(hardware_destructive_interference_size) StatValue<size_t> audioPacketCount;
+    StatValue<size_t> videoPacketCount;
+    StatValue<size_t> subtitlePacketCount;
+
+    StatValue<size_t> audioFrameCount;
+    StatValue<size_t> videoFrameCount;
+    StatValue<size_t> subtitleFrameCount;
+
+    // 内存占用估算(字节)
+    StatValue<int64_t> packetQueueBytes; // 所有包队列中的包数据
+    StatValue<int64_t> frameQueueBytes;  // 音视频帧队列，按各解码器最近一帧的大小估算
+    StatValue<int64_t> libassBytes;      // 字幕事件存储与 libass 轨道，不含 libass 内部有上限的缓存
+
+    // ==== 源FPS(解复用线程) ====
+    StatValue<double> videoFps;
+
+    // ==== 视频解码耗时统计 ms(视频解码线程) ====
+    alignas(hardware_destructive_interference_size) StatValue<double> videoDecodeTime; // 当前视频帧解码耗时
+    StatValue<double> avgVideoDecodeTime;                                               // 视频解码平均耗时
+
+    // ==== 视频播放线程 ====
+    alignas(hardware_destructive_interference_size) StatValue<double> videoPrepTime; // 视频数据准备耗时 ms
+    StatValue<double> avgVideoPrepTime;
+    StatValue<double> subPrepTime; // 字幕数据准备耗时 ms
+    StatValue<double> avgSubPrepTime;
+
+    // 帧状态
+    StatValue<int> lateFrameCount;
+    StatValue<int> earlyFrameCount;
+    StatValue<int> droppedFrameCount;
+
+    // 时间戳
+    StatValue<double> videoPTS{INVALID_DOUBLE};
+    StatValue<double> avPtsDiff{INVALID_DOUBLE};
+
+    StatValue<int64_t> renderBufferBytes; // 视频/字幕双缓冲占用的内存(字节)
+
+    // ==== 渲染线程 ====
+    alignas(hardware_destructive_interference_size) StatValue<double> outputFps;
+    StatValue<double> uploadTime; // 视频纹理上传耗时 ms
+    StatValue<double> avgUploadTime;
+
+    // 视频/字幕尺寸
+    StatSize videoSize;
+    StatSize subtitleSize;
+    StatSize FBOSize;
+
+    // 视频信息，AVFrame->format
+    StatValue<int> videoFormat{-1};
+
+    StatValue<int64_t> textureBytes; // 视频/字幕纹理与 FBO 的显存(字节)，按尺寸与格式估算
+
+    // ==== 音频 PCM 线程 ====
+    alignas(hardware_destructive_interference_size) StatValue<double> audioPTS{INVALID_DOUBLE};
+
+    // 音频跟随主时钟(主时钟不是音频时)
+    StatValue<double> audioDrift{INVALID_DOUBLE}; // 音频时钟 - 主时钟 的平滑值 ms
+    StatValue<int> audioCompensationCount;        // 施加补偿的次数
+    StatValue<int64_t> audioCompensatedSamples;   // 累计增加(正)/减少(负)的输出采样数
+
+    // 音频流切换
+    StatValue<double> audioSwitchLatency{INVALID_DOUBLE}; // 最近一次打开/切换音频流到新数据写入设备缓冲的耗时 ms
+
+    // 音频缓冲
+    StatValue<int> audioUnderrunCount;             // 设备回调读空的次数
+    StatValue<double> audioBufferMs{INVALID_DOUBLE}; // PCM buffer 当前水位 ms
 
 private:
     explicit PlaybackStats(QObject *parent = nullptr);
 
-    // 辅助函数：计算队列平均值
-    [[nodiscard]] double calculateAverage(std::deque<double> &deq, double newValue);
+    // 记录到某阶段的直方图，value 为该阶段单位下的值
+    void record(Stage stage, double value);
+
+    // 指数平滑，作用相当于最近十来个样本的均值
+    static void updateAverage(StatValue<double> &avg, double value);
 
 private:
+    // 仅渲染线程使用
     int m_frameCounter{};
     std::chrono::steady_clock::time_point m_lastFpsTime{std::chrono::steady_clock::now()};
 
-    // 最近10次的样本容器
-    std::deque<double> m_vDecSamples;
-    std::deque<double> m_vPrepSamples;
-    std::deque<double> m_sPrepSamples;
-    const size_t m_maxSamples = 10;
+    EnumIndexArray<LatencyHistogram, Stage> m_histograms;
 };
 
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
 #endif // PLAYBACKSTATS_H
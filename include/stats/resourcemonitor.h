@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef RESOURCEMONITOR_H
+#define RESOURCEMONITOR_H
+
+#include "utils/taskexecutor.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 进程资源采样：定时读取每个线程的 CPU 时间与进程的常驻内存，在单独的后台线程中进行
+ * - Linux：/proc/self/task/<tid>/stat 与 /proc/self/status
+ * - Windows：Toolhelp 线程快照 + GetThreadTimes/GetThreadDescription，GetProcessMemoryInfo
+ * 其他平台上 snapshot().supported 为 false
+ * 线程按名字分组(去掉结尾的编号)，FFmpeg 的帧/切片线程、同一等级的多个工作线程合并显示
+ */
+class ResourceMonitor {
+    ResourceMonitor(const ResourceMonitor &) = delete;
+    ResourceMonitor &operator=(const ResourceMonitor &) = delete;
+
+public:
+    struct ThreadGroup {
+        std::string name;
+        int threads = 0;  // 组内线程数
+        double cpu = 0;   // 组内 CPU 占用之和(%)，100 为占满一个核心
+        double peak = 0;  // 组内单个线程的最高占用(%)，接近 100 说明该线程占满了一个核心
+    };
+
+    struct Snapshot {
+        bool supported = false;          // 当前平台能否采样
+        bool valid = false;              // 至少完成两次采样，CPU 占用才有意义
+        double processCpu = 0;           // 所有线程之和(%)
+        int64_t rssBytes = -1;           // 常驻内存(字节)，未知为 -1
+        std::vector<ThreadGroup> groups; // 按 cpu 降序
+    };
+
+    static ResourceMonitor &instance();
+
+    // 开始定时采样，已在运行时无效果；start/stop 请在同一线程调用
+    void start(std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+    // 停止采样，保留最后一次的结果
+    void stop();
+
+    // 最近一次采样的结果，可在任意线程调用
+    [[nodiscard]] Snapshot snapshot() const;
+
+private:
+    struct ThreadSample {
+        std::string name;
+        double cpuSeconds = 0; // 累计的用户态 + 内核态时间
+    };
+    using Clock = std::chrono::steady_clock;
+
+    ResourceMonitor();
+    ~ResourceMonitor();
+
+    void samplingLoop(std::chrono::milliseconds interval);
+    void sample();
+
+    // 平台相关：读取所有线程(键为线程 ID)，失败返回 false；常驻内存(字节)，失败返回 -1
+    [[nodiscard]] static bool readThreads(std::unordered_map<uint64_t, ThreadSample> &threads);
+    [[nodiscard]] static int64_t readRss();
+
+    // 线程名去掉结尾的编号和分隔符作为分组名
+    [[nodiscard]] static std::string groupName(const std::string &threadName);
+
+    std::mutex m_stopMutex; // 保护 m_stop
+    std::condition_variable m_cv;
+    bool m_stop = true;
+    TaskHandle m_thread;
+
+    // 仅采样线程使用
+    std::unordered_map<uint64_t, ThreadSample> m_lastThreads;
+    Clock::time_point m_lastTime{};
+    bool m_hasLast = false;
+
+    mutable std::mutex m_mutex; // 保护 m_snapshot
+    Snapshot m_snapshot;
+};
+
+#endif // RESOURCEMONITOR_H
@@ -0,0 +1,148 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * 帧级流水线追踪，导出为 Chrome trace JSON(chrome://tracing、ui.perfetto.dev 可直接打开)
+ * - 每个线程一个固定大小的环形缓冲区，写满后覆盖最旧的事件；记录只有一次 relaxed 读和一次 release 写，不加锁
+ * - 事件带帧的 serial 与 pts(秒)，在 Perfetto 中按 pts 搜索即可跟踪一帧从读包到送显的全过程
+ * - 编译时定义 AZ_ENABLE_TRACING(CMake 选项 AZPLAYER_ENABLE_TRACING)才会生成 AZ_TRACE_* 埋点，否则宏为空
+ * - 运行时用 setEnabled 开关，关闭时埋点只有一次原子读
+ * @note 导出前最好先关闭追踪，否则正在被覆盖的最旧事件会被丢弃
+ */
+class Tracer {
+    Tracer(const Tracer &) = delete;
+    Tracer &operator=(const Tracer &) = delete;
+
+public:
+    static constexpr size_t kEventsPerThread = size_t{1} << 15; // 每个线程约 1MB
+
+    static Tracer &instance();
+
+    // 是否编译了埋点
+    [[nodiscard]] static constexpr bool compiledIn() {
+#ifdef AZ_ENABLE_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    [[nodiscard]] static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled);
+
+    // 丢弃已记录的事件
+    void clear();
+
+    // 当前线程在追踪中显示的名字(工作线程被不同任务复用时以最后一次为准)，name 必须是字符串常量
+    void setThreadName(const char *name);
+
+    // name 必须是字符串常量；没有 pts 时传 NaN，没有 serial 时传 -1
+    void begin(const char *name, int serial, double pts) { record('B', name, serial, pts); }
+    void end(const char *name, int serial, double pts) { record('E', name, serial, pts); }
+    void instant(const char *name, int serial, double pts) { record('i', name, serial, pts); }
+
+    // 写出 Chrome trace JSON(traceEvents 数组格式)
+    bool exportChromeTrace(std::ostream &out) const;
+    bool exportChromeTrace(const std::string &path) const;
+
+private:
+    struct Event {
+        int64_t ts;       // ns，相对 m_epoch
+        const char *name;
+        double pts;
+        int32_t serial;
+        char phase;       // 'B' 'E' 'i'
+    };
+
+    struct ThreadBuffer {
+        explicit ThreadBuffer(int tid) : tid(tid), events(kEventsPerThread) {}
+
+        const int tid;
+        std::atomic<const char *> name{nullptr};
+        std::atomic<uint64_t> head{0};       // 下一个写入位置，只由所属线程写
+        std::atomic<uint64_t> clearIndex{0}; // 早于该位置的事件已被 clear 丢弃
+        std::vector<Event> events;
+    };
+
+    Tracer();
+
+    void record(char phase, const char *name, int serial, double pts);
+    // 当前线程的缓冲区，第一次调用时创建并登记
+    ThreadBuffer *threadBuffer();
+
+    static inline std::atomic<bool> s_enabled{false};
+    static inline thread_local ThreadBuffer *t_buffer = nullptr; // 缓冲区由 m_buffers 持有，线程退出后仍可导出
+
+    const int64_t m_epoch;
+    mutable std::mutex m_mutex; // 保护 m_buffers 的增删与遍历
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+};
+
+/**
+ * 作用域追踪：构造时记录开始，析构时记录结束
+ * 开始时没有开启追踪则结束也不记录，保证 begin/end 成对
+ */
+class TraceScope {
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+public:
+    TraceScope(const char *name, int serial, double pts)
+        : m_name(name), m_serial(serial), m_pts(pts), m_active(Tracer::enabled()) {
+        if (m_active)
+            Tracer::instance().begin(name, serial, pts);
+    }
+    ~TraceScope() {
+        if (m_active)
+            Tracer::instance().end(m_name, m_serial, m_pts);
+    }
+
+    // 开始时还不知道的帧信息(如读包之后才有 pts)，记录在结束事件上
+    void setFrame(int serial, double pts) {
+        m_serial = serial;
+        m_pts = pts;
+    }
+
+private:
+    const char *m_name;
+    int m_serial;
+    double m_pts;
+    const bool m_active;
+};
+
+#define AZ_TRACE_CONCAT_IMPL(a, b) a##b
+#define AZ_TRACE_CONCAT(a, b) AZ_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef AZ_ENABLE_TRACING
+// 追踪当前作用域
+#define AZ_TRACE_SCOPE(name, serial, pts) const TraceScope AZ_TRACE_CONCAT(azTraceScope, __LINE__)(name, serial, pts)
+// 具名的作用域追踪，之后可以用 AZ_TRACE_SET_FRAME 补上帧信息
+#define AZ_TRACE_SCOPE_NAMED(var, name, serial, pts) TraceScope var(name, serial, pts)
+#define AZ_TRACE_SET_FRAME(var, serial, pts) var.setFrame(serial, pts)
+// 瞬时事件
+#define AZ_TRACE_INSTANT(name, serial, pts)                   \
+    do {                                                      \
+        if (Tracer::enabled())                                \
+            Tracer::instance().instant(name, serial, pts);    \
+    } while (0)
+#define AZ_TRACE_THREAD_NAME(name) Tracer::instance().setThreadName(name)
+#else
+#define AZ_TRACE_SCOPE(name, serial, pts) ((void)0)
+#define AZ_TRACE_SCOPE_NAMED(var, name, serial, pts) ((void)0)
+#define AZ_TRACE_SET_FRAME(var, serial, pts) ((void)0)
+#define AZ_TRACE_INSTANT(name, serial, pts) ((void)0)
+#define AZ_TRACE_THREAD_NAME(name) ((void)0)
+#endif
+
+#endif // TRACER_H
@@ -4,12 +4,13 @@
 #ifndef PTRS_H
 #define PTRS_H
 #include "types.h"
+#include "utils/spscring.h"
 #include "utils/utils.h"
 #include <memory>
 
 using sharedPktQueue = std::shared_ptr<AVPktQueue>;
 using weakPktQueue = std::weak_ptr<AVPktQueue>;
-using sharedFrmQueue = std::shared_ptr<SPSCQueue<AVFrmItem>>;
-using weakFrmQueue = std::weak_ptr<SPSCQueue<AVFrmItem>>;
+using sharedFrmQueue = std::shared_ptr<SPSCRing<AVFrmItem>>;
+using weakFrmQueue = std::weak_ptr<SPSCRing<AVFrmItem>>;
 
 #endif // PTRS_H
@@ -6,6 +6,7 @@
 
 #include <QObject>
 #include <QUrl>
+#include <vector>
 
 class EpisodeAssetManager : public QObject {
     Q_OBJECT
@@ -21,6 +22,13 @@ public:
      */
     [[nodiscard]] QUrl resolveSubtitleURL(const QUrl &videoFileURL);
 
+    /**
+     * 提取集数
+     * @param filenames 文件名数组
+     * @return 与各个文件名对应的集数, -1表示无法提取集数
+     */
+    [[nodiscard]] static std::vector<int> extractEpisodes(const std::vector<QString> &filenames);
+
 private:
 };
 
@@ -0,0 +1,28 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <array>
+#include <cstdint>
+
+// 调色板查找表，每一项为内存中按 R,G,B,A 顺序排列的一个像素
+using PaletteLUT = std::array<uint32_t, 256>;
+
+/**
+ * 由 FFmpeg 的 PAL8 调色板生成查找表
+ * @param palette FFmpeg 调色板，每一项为本机字节序的 0xAARRGGBB
+ * @param nbColors 有效颜色数，其余项填充为全透明
+ */
+void buildPaletteLUT(PaletteLUT &lut, const uint32_t *palette, int nbColors);
+
+/**
+ * 将 PAL8 索引图展开为 RGBA(非预乘)
+ * @param srcStride 源图每行字节数
+ * @param dstStride 目标图每行字节数
+ */
+void expandPal8ToRGBA(const uint8_t *src, int srcStride, const PaletteLUT &lut,
+                      uint8_t *dst, int dstStride, int width, int height);
+
+#endif // PALETTE_H
@@ -6,6 +6,8 @@
 
 #include "compat/compat.h"
 #include <atomic>
+#include <cassert>
+#include <cstring>
 #include <memory>
 
 #ifdef _MSC_VER
@@ -13,23 +15,75 @@
 #pragma warning(disable : 4324) // 因对齐说明符填充结构是预期的（cache line padding）
 #endif
 
+/**
+ * 单生产者单消费者字节环形缓冲区
+ * 附带一个 (字节偏移, pts) 标记的小环，生产者在写入每段数据前打上时间戳，
+ * 消费者读取时可以精确得到读指针处数据的 pts，即使缓冲区中存在不连续的时间戳
+ */
 class SPSCBuffer {
     SPSCBuffer(const SPSCBuffer &) = delete;
     SPSCBuffer &operator=(const SPSCBuffer &) = delete;
 
 public:
-    // capacity 必须是 2 的幂
-    explicit SPSCBuffer(uint64_t capacity);
+    // 可写区域，环形缓冲区尾部回绕时分为两段
+    struct WriteSpan {
+        uint8_t *first = nullptr;
+        uint64_t firstLen = 0;
+        uint8_t *second = nullptr;
+        uint64_t secondLen = 0;
+
+        [[nodiscard]] uint64_t size() const { return firstLen + secondLen; }
+    };
+
+    /**
+     * @param capacity 字节数，必须是 2 的幂
+     * @param markerCapacity pts 标记环的容量，向上取整到 2 的幂；
+     *        连续的标记会合并，只有时间戳不连续的位置才占用一个槽位，按缓冲区能容纳的最短帧数估算即可
+     */
+    explicit SPSCBuffer(uint64_t capacity, uint64_t markerCapacity = kDefaultMarkerCapacity);
     ~SPSCBuffer() = default;
 
     // 写入指定长度的数据，返回实际写入的数据
     [[nodiscard]] uint64_t write(const uint8_t *input, uint64_t len);
 
+    /**
+     * 预留最多 maxLen 字节的可写区域，数据直接写入环形缓冲区内存，之后用 commitWrite 提交，仅生产者调用
+     * @note 提交之前消费者不可见，两次 reserveWrite 之间必须 commitWrite(可以为0)
+     */
+    [[nodiscard]] WriteSpan reserveWrite(uint64_t maxLen);
+    // 提交 reserveWrite 预留区域中前 len 字节
+    void commitWrite(uint64_t len);
+
+    /**
+     * 以整帧为单位直接在环形缓冲区内生产数据，跨越首尾的那一帧通过栈上的小缓冲中转，仅生产者调用
+     * @param frameSize 一帧的字节数，不超过 kMaxFrameSize
+     * @param produce int64_t(uint8_t *dst, uint64_t frames)：向 dst 写入最多 frames 帧，返回实际写入的帧数，< 0 表示出错；
+     *                返回值小于 frames 时视为数据源暂时耗尽，本次不再继续调用
+     * @return 写入的帧数，produce 出错时返回其错误码(出错前生产的数据仍会提交)
+     */
+    template <typename Func>
+    [[nodiscard]] int64_t writeFrames(uint32_t frameSize, uint64_t maxFrames, Func &&produce);
+
     void requestClearOldData();
 
+    /**
+     * 标记接下来写入的第一个字节的 pts(秒)，仅生产者调用
+     * @param bytesPerSec 每秒字节数，pts 与上一个标记外推的结果相差不到 kMarkerMergeTolerance 时不新增标记
+     * @return 标记环满时丢弃该标记并返回 false，消费者会根据上一个标记外推
+     */
+    bool pushPtsMarker(double pts, double bytesPerSec);
+
+    /**
+     * 读指针处(下一个将被读出的字节)的 pts，仅消费者调用
+     * @param bytesPerSec 每秒字节数，用于从最近的标记外推
+     * @return 没有可用标记时返回 NaN
+     */
+    [[nodiscard]] double readPts(double bytesPerSec);
+
     // 读取指定长度的数据，返回实际读取的数据
     [[nodiscard]] uint64_t read(uint8_t *output, uint64_t len);
 
+    // 非线程安全，调用时需确保生产者和消费者都未运行
     void unsafeClear();
 
     // 获取长度函数
@@ -37,16 +91,86 @@ public:
     [[nodiscard]] uint64_t writeAvailable() const;
     [[nodiscard]] uint64_t capacity() const;
 
+    [[nodiscard]] uint64_t markerCapacity() const;
+
+    static constexpr uint32_t kMaxFrameSize = 1024;         // writeFrames 支持的最大帧字节数
+    static constexpr uint64_t kDefaultMarkerCapacity = 256; // 时间戳基本连续时足够
+    static constexpr double kMarkerMergeTolerance = 5e-6;   // 合并标记的误差上限(秒)，小于 96kHz 下半个采样
+
 private:
+    struct PtsMarker {
+        uint64_t offset; // 标记对应的写指针位置
+        double pts;
+    };
+
+    // 处理 requestClearOldData 的请求，返回处理后的读指针，仅消费者调用
+    [[nodiscard]] uint64_t applyPendingClear(uint64_t tail);
+
     alignas(hardware_destructive_interference_size) std::atomic<uint64_t> m_head{0}; // 读指针
     alignas(hardware_destructive_interference_size) std::atomic<uint64_t> m_tail{0}; // 写指针
     alignas(hardware_destructive_interference_size) std::atomic<uint8_t> m_needClear{0};
     alignas(hardware_destructive_interference_size) std::atomic<uint64_t> m_virtualTail{0};
+    alignas(hardware_destructive_interference_size) std::atomic<uint64_t> m_markerHead{0}; // 当前生效的标记
+    alignas(hardware_destructive_interference_size) std::atomic<uint64_t> m_markerTail{0};
     const uint64_t m_capacity;
     const uint64_t m_mask;
+    const uint64_t m_markerMask;
     std::unique_ptr<uint8_t[]> m_buffer;
+    std::unique_ptr<PtsMarker[]> m_markers;
 };
 
+template <typename Func>
+int64_t SPSCBuffer::writeFrames(uint32_t frameSize, uint64_t maxFrames, Func &&produce) {
+    assert(frameSize > 0 && frameSize <= kMaxFrameSize);
+    const uint64_t maxLen = maxFrames > UINT64_MAX / frameSize ? UINT64_MAX : maxFrames * frameSize;
+    const WriteSpan span = reserveWrite(maxLen);
+
+    int64_t total = 0;
+    uint64_t committed = 0;
+    // 生产到连续内存，返回是否可以继续
+    auto produceTo = [&](uint8_t *dst, uint64_t frames, int64_t &err) -> bool {
+        if (frames == 0)
+            return true;
+        const int64_t n = produce(dst, frames);
+        if (n < 0) {
+            err = n;
+            return false;
+        }
+        total += n;
+        committed += static_cast<uint64_t>(n) * frameSize;
+        return static_cast<uint64_t>(n) == frames;
+    };
+
+    int64_t err = 0;
+    // 第一段中的整帧
+    const uint64_t firstFrames = span.firstLen / frameSize;
+    bool goOn = produceTo(span.first, firstFrames, err);
+
+    // 跨越首尾的一帧
+    const uint64_t rem = span.firstLen - firstFrames * frameSize;
+    uint64_t secondOffset = 0;
+    if (goOn && rem > 0) {
+        goOn = false;
+        if (span.secondLen >= frameSize - rem) {
+            uint8_t bounce[kMaxFrameSize];
+            if (produceTo(bounce, 1, err)) {
+                std::memcpy(span.first + firstFrames * frameSize, bounce, rem);
+                std::memcpy(span.second, bounce + rem, frameSize - rem);
+                secondOffset = frameSize - rem;
+                goOn = true;
+            }
+        }
+    }
+
+    // 第二段
+    if (goOn && span.secondLen > secondOffset) {
+        (void)produceTo(span.second + secondOffset, (span.secondLen - secondOffset) / frameSize, err);
+    }
+
+    commitWrite(committed);
+    return err < 0 ? err : total;
+}
+
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
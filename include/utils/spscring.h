@@ -0,0 +1,202 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include "compat/compat.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4324) // 因对齐说明符填充结构是预期的（cache line padding）
+#endif
+
+/**
+ * 单生产者单消费者的有限无锁环形队列
+ * - 槽位数取不小于容量的 2 的幂，索引单调递增、用掩码取槽位，容量本身不必是 2 的幂
+ * - 生产者/消费者各自缓存对方的索引，只有缓存显示满/空时才去读对方的 cache line
+ * - 元素在槽位内原地构造/析构，只需可移动；消费者可以通过 front/consume 原地访问而不拷贝
+ * @note 除 size/capacity/serial 外，push 系列只能由生产者调用，front/pop 系列只能由消费者调用
+ */
+template <typename T>
+class SPSCRing {
+    SPSCRing(const SPSCRing &) = delete;
+    SPSCRing &operator=(const SPSCRing &) = delete;
+
+public:
+    explicit SPSCRing(size_t capacity)
+        : m_capacity(capacity),
+          m_mask(slotCount(capacity) - 1),
+          m_slots(std::make_unique<Storage[]>(m_mask + 1)) {
+        assert(capacity > 0);
+    }
+
+    ~SPSCRing() {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        for (size_t i = m_head.load(std::memory_order_relaxed); i != tail; ++i) {
+            slot(i)->~T();
+        }
+    }
+
+    // 在队尾原地构造一个元素，队列满时返回 false 且不使用参数
+    template <typename... Args>
+    [[nodiscard]] bool emplace(Args &&...args) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_headCache >= m_capacity) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if (tail - m_headCache >= m_capacity)
+                return false;
+        }
+        new (rawSlot(tail)) T(std::forward<Args>(args)...);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 失败时 value 保持不变，可以直接重试
+    [[nodiscard]] bool push(T &&value) {
+        return emplace(std::move(value));
+    }
+
+    /**
+     * 队列满时每隔 kWaitInterval 重试，直到成功或 stop 为 true
+     * @return 是否写入成功，false 表示因 stop 放弃(value 保持不变)
+     */
+    [[nodiscard]] bool waitPush(T &&value, const std::atomic<bool> &stop) {
+        while (!push(std::move(value))) {
+            if (stop.load(std::memory_order_relaxed))
+                return false;
+            std::this_thread::sleep_for(kWaitInterval);
+        }
+        return true;
+    }
+
+    /**
+     * 批量移动写入 [first, first + count)，只发布一次写索引
+     * @return 实际写入的个数，未写入的元素保持不变
+     */
+    template <typename It>
+    [[nodiscard]] size_t pushBatch(It first, size_t count) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (m_capacity - (tail - m_headCache) < count)
+            m_headCache = m_head.load(std::memory_order_acquire);
+        const size_t n = std::min(count, m_capacity - (tail - m_headCache));
+        for (size_t i = 0; i < n; ++i, ++first) {
+            new (rawSlot(tail + i)) T(std::move(*first));
+        }
+        if (n > 0)
+            m_tail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    // 队首元素，队列空时返回 nullptr；指针在 popFront 之前有效
+    [[nodiscard]] T *front() {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tailCache) {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (head == m_tailCache)
+                return nullptr;
+        }
+        return slot(head);
+    }
+
+    // 析构并移除队首元素，调用前 front 必须不为空
+    void popFront() {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        assert(head != m_tailCache);
+        slot(head)->~T();
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    [[nodiscard]] bool pop(T &value) {
+        T *item = front();
+        if (!item)
+            return false;
+        value = std::move(*item);
+        popFront();
+        return true;
+    }
+
+    /**
+     * 对队首最多 maxCount 个元素原地调用 func(T &)，之后析构并一次性移除
+     * @return 处理的元素个数
+     */
+    template <typename Func>
+    size_t consume(Func &&func, size_t maxCount = SIZE_MAX) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (m_tailCache - head < maxCount)
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+        const size_t n = std::min(maxCount, m_tailCache - head);
+        for (size_t i = 0; i < n; ++i) {
+            T *item = slot(head + i);
+            func(*item);
+            item->~T();
+        }
+        if (n > 0)
+            m_head.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // 批量移出最多 maxCount 个元素到 out
+    [[nodiscard]] size_t popBatch(T *out, size_t maxCount) {
+        return consume([&out](T &item) { *out++ = std::move(item); }, maxCount);
+    }
+
+    // 可以在任意线程调用，结果只是一个快照
+    [[nodiscard]] size_t size() const {
+        const size_t head = m_head.load(std::memory_order_acquire);
+        const size_t tail = m_tail.load(std::memory_order_acquire);
+        return std::min(tail - head, m_capacity); // 两次读取之间对方可能已前进
+    }
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    [[nodiscard]] size_t capacity() const { return m_capacity; }
+
+    [[nodiscard]] int serial() const { return m_serial.load(std::memory_order_relaxed); }
+    void addSerial() { m_serial.fetch_add(1); }
+
+    static constexpr std::chrono::milliseconds kWaitInterval{5};
+
+private:
+    struct alignas(T) Storage {
+        unsigned char bytes[sizeof(T)];
+    };
+
+    static size_t slotCount(size_t capacity) {
+        size_t n = 1;
+        while (n < capacity) {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    void *rawSlot(size_t index) { return &m_slots[index & m_mask]; }
+    T *slot(size_t index) { return std::launder(reinterpret_cast<T *>(rawSlot(index))); }
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<Storage[]> m_slots;
+    std::atomic<int> m_serial{0};
+
+    // 消费者：读索引 + 缓存的写索引
+    alignas(hardware_destructive_interference_size) std::atomic<size_t> m_head{0};
+    size_t m_tailCache = 0;
+    // 生产者：写索引 + 缓存的读索引
+    alignas(hardware_destructive_interference_size) std::atomic<size_t> m_tail{0};
+    size_t m_headCache = 0;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#endif // SPSCRING_H
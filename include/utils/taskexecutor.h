@@ -0,0 +1,110 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef TASKEXECUTOR_H
+#define TASKEXECUTOR_H
+
+#include "utils/enumindexarray.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 线程的服务等级，决定调度优先级/策略
+enum class TaskQoS {
+    RealtimeAudio, // 音频 PCM 线程，欠载直接可闻
+    Display,       // 视频呈现，掉帧可见
+    Decode,        // 音视频解码
+    Background,    // 解复用 I/O、字幕解码、字体扫描等
+    Count
+};
+
+/**
+ * 一个提交到 TaskExecutor 的任务，用法与 std::thread 的 joinable/join 一致
+ * @note 只能由持有者线程调用 join，任务本身需要自行检查退出标志
+ */
+class TaskHandle {
+public:
+    TaskHandle() = default;
+
+    [[nodiscard]] bool joinable() const;
+    // 等待任务执行完毕，之后不再 joinable
+    void join();
+
+private:
+    friend class TaskExecutor;
+
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+    };
+    std::shared_ptr<State> m_state;
+};
+
+/**
+ * 播放器全局的任务执行器
+ * 每个服务等级有各自常驻的工作线程，线程创建时按等级设置一次优先级(及可选的 CPU 亲和性)，
+ * 任务结束后线程留在池中等待下一个任务，打开/关闭文件时不再创建和销毁线程
+ * - Linux：RealtimeAudio 尝试 SCHED_FIFO，没有权限时退回 nice 值；Background 使用 SCHED_BATCH
+ * - Windows：SetThreadPriority；macOS：pthread QoS class
+ * 设置失败(没有权限)时保持默认优先级并打印日志
+ */
+class TaskExecutor {
+    TaskExecutor(const TaskExecutor &) = delete;
+    TaskExecutor &operator=(const TaskExecutor &) = delete;
+
+public:
+    static TaskExecutor &instance();
+
+    /**
+     * 在 qos 等级的空闲工作线程上运行 task，没有空闲线程时新建一个
+     * @param name 线程名(调试器/系统监视器中可见)，Linux 上最多显示 15 个字符
+     */
+    [[nodiscard]] TaskHandle submit(TaskQoS qos, const char *name, std::function<void()> task);
+
+    /**
+     * CPU 亲和性提示，bit i 表示允许运行在第 i 个逻辑核心上，0 表示不限制
+     * 对该等级之后开始的任务生效，不支持的平台上忽略
+     */
+    void setAffinityHint(TaskQoS qos, uint64_t cpuMask);
+
+    // 各等级当前的工作线程数(包括空闲的)
+    [[nodiscard]] int workerCount(TaskQoS qos) const;
+
+    /**
+     * 设置当前线程的名字，供不由执行器创建的线程(如音频设备回调线程)使用
+     * 工作线程在任务开始时按 submit 的 name 命名，任务结束后改名为 AZ-idle
+     */
+    static void setThreadName(const char *name);
+
+private:
+    struct Worker {
+        std::thread thread;
+        std::condition_variable cv; // 有新任务或退出
+        TaskQoS qos = TaskQoS::Background;
+        std::function<void()> task;
+        const char *name = nullptr;
+        std::shared_ptr<TaskHandle::State> state;
+        bool busy = false;
+        bool affinityDirty = false; // 亲和性改变，下一个任务开始前重新设置
+    };
+
+    TaskExecutor() = default;
+    ~TaskExecutor();
+
+    void workerLoop(Worker *worker);
+
+    static void applyQoS(TaskQoS qos);
+    static void applyAffinity(uint64_t cpuMask);
+
+    mutable std::mutex m_mutex; // 保护以下所有成员
+    bool m_exit = false;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    EnumIndexArray<uint64_t, TaskQoS> m_affinity{};
+};
+
+#endif // TASKEXECUTOR_H
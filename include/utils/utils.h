@@ -48,98 +48,6 @@ private:
     DeviceStatus() = default;
 };
 
-/**
- * 单生产者单消费者的有限无锁队列(缓冲区)
- */
-template <typename T>
-class SPSCQueue {
-public:
-    explicit SPSCQueue(size_t capacity)
-        : m_capacity(capacity + 1), // 多分配一个，用于处理满条件
-          m_buffer(m_capacity) {}
-
-    [[nodiscard]] bool push(const T &value) {
-        // 生产者本地快照
-        size_t current_tail = m_tail.load(std::memory_order_relaxed);
-        size_t next_tail = nextIndex(current_tail);
-
-        // 检查队列是否已满
-        if (next_tail == m_head.load(std::memory_order_acquire)) {
-            return false; // 队列满，推送失败
-        }
-
-        // 将数据存入当前tail指向的位置
-        m_buffer[current_tail] = value;
-
-        // 发布tail的更新，确保前面的数据存储对消费者可见
-        m_tail.store(next_tail, std::memory_order_release);
-        return true;
-    }
-
-    [[nodiscard]] bool pop(T &value) {
-        // 消费者本地快照
-        size_t current_head = m_head.load(std::memory_order_relaxed);
-
-        // 检查队列是否为空
-        if (current_head == m_tail.load(std::memory_order_acquire)) {
-            return false; // 队列空，弹出失败
-        }
-
-        // 从当前head指向的位置取出数据
-        value = m_buffer[current_head];
-
-        // 发布head的更新，告知生产者新的头部位置
-        m_head.store(nextIndex(current_head), std::memory_order_release);
-        return true;
-    }
-
-    /**
-     * 获取第一个有效的元素
-     * @note 请确保pop与peekSecond只在同一个线程下使用
-     */
-    [[nodiscard]] bool peekFirst(T &value) {
-        // 消费者本地快照
-        size_t current_head = m_head.load(std::memory_order_relaxed);
-
-        // 检查队列是否为空
-        if (current_head == m_tail.load(std::memory_order_acquire)) {
-            return false; // 队列空，弹出失败
-        }
-
-        // 从当前head指向的位置取出数据
-        value = m_buffer[current_head];
-        return true;
-    }
-
-    [[nodiscard]] size_t size() const {
-        size_t head = m_head.load(std::memory_order_acquire);
-        size_t tail = m_tail.load(std::memory_order_acquire);
-        if (tail >= head)
-            return tail - head;
-        else
-            return m_capacity - head + tail;
-    }
-
-    [[nodiscard]] size_t capacity() const {
-        return m_capacity - 1;
-    }
-
-    [[nodiscard]] int serial() const { return m_serial.load(std::memory_order_relaxed); }
-    void addSerial() { m_serial.fetch_add(1); }
-
-private:
-    size_t nextIndex(size_t index) const {
-        return (index + 1) % m_capacity;
-    }
-
-    const size_t m_capacity; // 环形缓冲区的总容量（包括浪费的一个位置）
-    std::vector<T> m_buffer; // 数据缓冲区
-
-    alignas(hardware_destructive_interference_size) std::atomic<size_t> m_head{0}; // 读索引（消费者使用）
-    alignas(hardware_destructive_interference_size) std::atomic<size_t> m_tail{0}; // 写索引（生产者使用）
-    std::atomic<int> m_serial{0};
-};
-
 class AVPktQueue {
 public:
     explicit AVPktQueue(size_t maxMB = 2)
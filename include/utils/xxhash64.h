@@ -0,0 +1,33 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef XXHASH64_H
+#define XXHASH64_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * XXH64 哈希(与 xxHash 参考实现的 XXH64 结果一致)，支持分段输入
+ * 用于输出帧/PCM 的逐帧校验，不要求抗碰撞
+ */
+class XXHash64 {
+public:
+    explicit XXHash64(uint64_t seed = 0) { reset(seed); }
+
+    void reset(uint64_t seed = 0);
+    void update(const void *data, size_t len);
+    [[nodiscard]] uint64_t digest() const;
+
+    // 一次性计算整段数据
+    [[nodiscard]] static uint64_t hash(const void *data, size_t len, uint64_t seed = 0);
+
+private:
+    uint64_t m_acc[4];
+    uint64_t m_seed;
+    uint64_t m_totalLen;
+    uint8_t m_buf[32]; // 不足一个 stripe 的尾部数据
+    uint32_t m_bufLen;
+};
+
+#endif // XXHASH64_H
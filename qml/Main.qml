@@ -26,6 +26,10 @@ AZWindow {
         MediaCtrl.setVolume(AZSettings.volume)
         MediaCtrl.setMuted(AZSettings.muted)
         MediaCtrl.setAutoLoadExtSub(AZSettings.autoLoadExtSub)
+        MediaCtrl.setPreloadAudioTracks(AZSettings.preloadAudioTracks)
+        MediaCtrl.setClockMaster(AZSettings.clockMaster)
+        MediaCtrl.setAudioLatencyProfile(AZSettings.audioLatencyProfile)
+        MediaCtrl.setBinauralRendering(AZSettings.binauralRendering)
         console.log("mainWin 初始化完成")
     }
 
@@ -35,6 +39,10 @@ AZWindow {
         function onMutedChanged() { AZSettings.muted = MediaCtrl.muted }
         function onVolumeChanged() { AZSettings.volume = MediaCtrl.volume }
         function onAutoLoadExtSubChanged() { AZSettings.autoLoadExtSub = MediaCtrl.autoLoadExtSub }
+        function onPreloadAudioTracksChanged() { AZSettings.preloadAudioTracks = MediaCtrl.preloadAudioTracks }
+        function onClockMasterChanged() { AZSettings.clockMaster = MediaCtrl.clockMaster }
+        function onAudioLatencyProfileChanged() { AZSettings.audioLatencyProfile = MediaCtrl.audioLatencyProfile }
+        function onBinauralRenderingChanged() { AZSettings.binauralRendering = MediaCtrl.binauralRendering }
     }
 
     // 启动参数
@@ -104,6 +112,13 @@ AZWindow {
                 playbackStatsArea.visible = !playbackStatsArea.visible
             }
         }
+
+        // 开始/停止帧级追踪（Ctrl+Shift+T），停止时导出 Chrome trace JSON
+        Shortcut {
+            sequence: "Ctrl+Shift+T"
+            autoRepeat: false
+            onActivated: MediaCtrl.toggleTracing()
+        }
     }
 
     // ====topBar、 bottomBar、sideBar区域是否包含鼠标====
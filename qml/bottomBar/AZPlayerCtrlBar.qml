@@ -190,6 +190,31 @@ Item{
                 MediaCtrl.seekBySec(chapterComboBox.model[index]["pts"],0.0);
             }
         }
+
+        AZComboBox{
+            id: speedComboBox
+            displayText: MediaCtrl.speed + "x"
+            width: 45
+            height: 20
+            anchors.left: chapterComboBox.right
+            anchors.leftMargin: 5
+            anchors.verticalCenter: parent.verticalCenter
+            popupWidth: 60
+            textRole:"text"
+            model: [
+                { text: "0.5x", value: 0.5 },
+                { text: "0.75x", value: 0.75 },
+                { text: "1x", value: 1.0 },
+                { text: "1.25x", value: 1.25 },
+                { text: "1.5x", value: 1.5 },
+                { text: "2x", value: 2.0 },
+                { text: "3x", value: 3.0 },
+                { text: "4x", value: 4.0 }
+            ]
+            onActivated: function(index){
+                MediaCtrl.setSpeed(speedComboBox.model[index]["value"]);
+            }
+        }
     }
 
     AZButton{
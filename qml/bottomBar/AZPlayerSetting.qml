@@ -200,5 +200,59 @@ Popup{
         }
     }
 
-    component MyAudioCtrl:Item{}
+    component MyAudioCtrl:Column{
+        spacing: 5
+        AZCheckBox {
+            id: preloadAudioTracksCheckBox
+            height: 20
+            width: 160
+            text:"预读所有音轨(无缝切换)"
+            checked: MediaCtrl.preloadAudioTracks
+            textColor: "#ebebeb"
+            onCheckedChanged: { MediaCtrl.setPreloadAudioTracks(checked) }
+        }
+        AZCheckBox {
+            id: binauralRenderingCheckBox
+            height: 20
+            width: 160
+            text:"耳机双耳渲染(多声道)"
+            checked: MediaCtrl.binauralRendering
+            textColor: "#ebebeb"
+            onCheckedChanged: { MediaCtrl.setBinauralRendering(checked) }
+        }
+        Row {
+            spacing: 5
+            Text {
+                text: "主时钟:"
+                color: "#ebebeb"
+                anchors.verticalCenter: parent.verticalCenter
+            }
+            AZComboBox {
+                id: clockMasterComboBox
+                width: 60
+                height: 20
+                popupWidth: 60
+                model: ["音频", "视频", "外部"]
+                currentIndex: MediaCtrl.clockMaster
+                onActivated: function(index) { MediaCtrl.setClockMaster(index) }
+            }
+        }
+        Row {
+            spacing: 5
+            Text {
+                text: "音频延迟:"
+                color: "#ebebeb"
+                anchors.verticalCenter: parent.verticalCenter
+            }
+            AZComboBox {
+                id: audioLatencyComboBox
+                width: 60
+                height: 20
+                popupWidth: 60
+                model: ["省电", "均衡", "低延迟"]
+                currentIndex: MediaCtrl.audioLatencyProfile
+                onActivated: function(index) { MediaCtrl.setAudioLatencyProfile(index) }
+            }
+        }
+    }
 }
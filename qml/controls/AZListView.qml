@@ -14,6 +14,7 @@ Rectangle {
     property int activeIndex: -1
     property ListModel listModel: null
     property bool readOnly: false
+    readonly property alias currentIndex: listView.currentIndex // 单击选中的项
 
     signal delActive()
     signal stopActive()
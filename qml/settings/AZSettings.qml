@@ -5,7 +5,11 @@ pragma Singleton
 import QtCore
 
 Settings {
-    property real volume: 1.0          // 音量
-    property bool muted: false         // 静音
-    property bool autoLoadExtSub: true // 自动加载外部字幕
+    property real volume: 1.0               // 音量
+    property bool muted: false              // 静音
+    property bool autoLoadExtSub: true      // 自动加载外部字幕
+    property bool preloadAudioTracks: false // 预读所有音轨
+    property int clockMaster: 0             // 主时钟 0音频 1视频 2外部
+    property int audioLatencyProfile: 1     // 音频延迟档位 0省电 1均衡 2低延迟
+    property bool binauralRendering: false  // 多声道渲染为双耳(耳机)信号
 }
@@ -28,5 +28,26 @@ ColumnLayout{
             text: "添加音轨"
             onClicked: AZPlayerState.mediafileDialog.openAudioStreamFile()
         }
+        AZTextButton{
+            id:overlayAudioBtn
+            width: 90
+            anchors.top: parent.top
+            anchors.bottom: parent.bottom
+            anchors.left: addAudioBtn.right
+            anchors.topMargin: 3
+            anchors.bottomMargin: 3
+            anchors.leftMargin: 3
+            // 将选中的音轨叠加到当前音轨上(解说音轨等)，再次点击关闭
+            text: audioTab.secondaryIdx === -1 ? "设为叠加音轨" : "关闭叠加音轨"
+            onClicked: {
+                if(audioTab.secondaryIdx !== -1){
+                    MediaCtrl.setOverlayAudioStream(-1, -1)
+                    return
+                }
+                let val = audioTab.selectedItem()
+                if(val && audioTab.selectedIndex() !== audioTab.currentIdx)
+                    MediaCtrl.setOverlayAudioStream(val.demuxIdx, val.streamIdx)
+            }
+        }
     }
 }
@@ -8,6 +8,18 @@ Item{
 
     property string streamType: "AUDIO" // 或 "SUBTITLE"
     property int currentIdx: -1
+    property int secondaryIdx: -1 // 副字幕 或 叠加音轨
+
+    // 单击选中的流，没有返回null
+    function selectedItem(){
+        if(view.currentIndex < 0 || view.currentIndex >= listModel.count)
+            return null
+        return listModel.get(view.currentIndex)
+    }
+
+    function selectedIndex(){
+        return view.currentIndex
+    }
 
     ListModel{
         id:listModel
@@ -18,9 +30,11 @@ Item{
         if(streamType === "AUDIO"){
             arr = MediaCtrl.getAudioInfo()
             currentIdx = MediaCtrl.getAudioIdx()
+            secondaryIdx = MediaCtrl.getOverlayAudioIdx()
         } else if(streamType === "SUBTITLE"){
             arr = MediaCtrl.getSubtitleInfo()
             currentIdx = MediaCtrl.getSubtitleIdx()
+            secondaryIdx = MediaCtrl.getSecondarySubtitleIdx()
         }
 
         listModel.clear()
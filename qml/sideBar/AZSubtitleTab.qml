@@ -29,5 +29,26 @@ ColumnLayout{
             text: "添加字幕"
             onClicked: AZPlayerState.mediafileDialog.openSubtitleStreamFile()
         }
+        AZTextButton{
+            id:secondarySubtitleBtn
+            width: 80
+            anchors.top: parent.top
+            anchors.bottom: parent.bottom
+            anchors.left: addSubtitleBtn.right
+            anchors.topMargin: 3
+            anchors.bottomMargin: 3
+            anchors.leftMargin: 3
+            // 将选中的字幕设为副字幕(双语字幕)，再次点击关闭
+            text: subtitleTab.secondaryIdx === -1 ? "设为副字幕" : "关闭副字幕"
+            onClicked: {
+                if(subtitleTab.secondaryIdx !== -1){
+                    MediaCtrl.setSecondarySubtitleStream(-1, -1)
+                    return
+                }
+                let val = subtitleTab.selectedItem()
+                if(val && subtitleTab.selectedIndex() !== subtitleTab.currentIdx)
+                    MediaCtrl.setSecondarySubtitleStream(val.demuxIdx, val.streamIdx)
+            }
+        }
     }
 }
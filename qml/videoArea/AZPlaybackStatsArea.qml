@@ -7,7 +7,7 @@ import QtQuick.Controls
 Text {
     id: statsText
     width: 400
-    height: 450
+    height: 560
     textFormat: Text.RichText
     text: ""
     wrapMode: Text.Wrap
@@ -28,8 +28,9 @@ Text {
         }
     }
 
-    // 显示
+    // 显示，同时开始采样线程 CPU 与内存(第二次刷新起才有 CPU 占用)
     function showStats() {
+        PlaybackStats.setResourceSampling(true)
         statsText.text = PlaybackStats.getPlaybackStatsStringHTML()
         refreshTimer.start()
     }
@@ -37,6 +38,7 @@ Text {
     // 隐藏
     function hideStats() {
         refreshTimer.stop()
+        PlaybackStats.setResourceSampling(false)
         statsText.text = ""
     }
 }
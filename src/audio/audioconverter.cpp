@@ -0,0 +1,444 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "audio/audioconverter.h"
+#include "audio/interleave.h"
+#include <QDebug>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iterator>
+
+AZ_EXTERN_C_BEGIN
+#include <libavutil/opt.h>
+AZ_EXTERN_C_END
+
+namespace {
+    [[nodiscard]] bool copyAudioPar(AudioPar &dst, const AudioPar &src) {
+        dst.reset();
+        dst.sampleRate = src.sampleRate;
+        dst.sampleFormat = src.sampleFormat;
+        return av_channel_layout_copy(&dst.ch_layout, &src.ch_layout) == 0;
+    }
+
+    using RenderChannel = SpatialRenderer::Channel;
+
+    constexpr int kMaxRematrixChannels = 8; // swresample 的下混矩阵只考虑了常见的 8 声道以内的布局
+
+    struct ChannelPosition {
+        AVChannel id;
+        float azimuth;
+        float elevation;
+    };
+
+    // 扬声器位置(度)，方位角向左为正，参考 ITU-R BS.2051
+    // clang-format off
+    constexpr ChannelPosition kChannelPositions[] = {
+        {AV_CHAN_FRONT_LEFT,              30,   0}, {AV_CHAN_FRONT_RIGHT,              -30,   0},
+        {AV_CHAN_FRONT_CENTER,             0,   0},
+        {AV_CHAN_FRONT_LEFT_OF_CENTER,    15,   0}, {AV_CHAN_FRONT_RIGHT_OF_CENTER,    -15,   0},
+        {AV_CHAN_BACK_LEFT,              150,   0}, {AV_CHAN_BACK_RIGHT,              -150,   0},
+        {AV_CHAN_BACK_CENTER,            180,   0},
+        {AV_CHAN_SIDE_LEFT,               90,   0}, {AV_CHAN_SIDE_RIGHT,               -90,   0},
+        {AV_CHAN_TOP_CENTER,               0,  90},
+        {AV_CHAN_TOP_FRONT_LEFT,          30,  45}, {AV_CHAN_TOP_FRONT_RIGHT,          -30,  45},
+        {AV_CHAN_TOP_FRONT_CENTER,         0,  45},
+        {AV_CHAN_TOP_BACK_LEFT,          150,  45}, {AV_CHAN_TOP_BACK_RIGHT,          -150,  45},
+        {AV_CHAN_TOP_BACK_CENTER,        180,  45},
+        {AV_CHAN_STEREO_LEFT,             30,   0}, {AV_CHAN_STEREO_RIGHT,             -30,   0},
+        {AV_CHAN_WIDE_LEFT,               60,   0}, {AV_CHAN_WIDE_RIGHT,               -60,   0},
+        {AV_CHAN_SURROUND_DIRECT_LEFT,    90,   0}, {AV_CHAN_SURROUND_DIRECT_RIGHT,    -90,   0},
+        {AV_CHAN_TOP_SIDE_LEFT,           90,  45}, {AV_CHAN_TOP_SIDE_RIGHT,           -90,  45},
+        {AV_CHAN_BOTTOM_FRONT_CENTER,      0, -30},
+        {AV_CHAN_BOTTOM_FRONT_LEFT,       30, -30}, {AV_CHAN_BOTTOM_FRONT_RIGHT,       -30, -30},
+    };
+    // clang-format on
+
+    /**
+     * FFmpeg 声道布局 -> 渲染器声道
+     * 未知声道作为输入时放在正前方，避免丢失声音；作为输出时不输出
+     */
+    std::vector<RenderChannel> renderChannels(const AVChannelLayout &layout, bool output) {
+        std::vector<RenderChannel> channels(layout.nb_channels);
+        for (int i = 0; i < layout.nb_channels; ++i) {
+            const AVChannel id = av_channel_layout_channel_from_index(&layout, i);
+            RenderChannel &c = channels[i];
+            if (id >= AV_CHAN_AMBISONIC_BASE && id <= AV_CHAN_AMBISONIC_END) {
+                c.type = RenderChannel::Type::Ambisonic;
+                c.acn = id - AV_CHAN_AMBISONIC_BASE;
+            } else if (id == AV_CHAN_LOW_FREQUENCY || id == AV_CHAN_LOW_FREQUENCY_2) {
+                c.type = RenderChannel::Type::LFE;
+            } else if (id == AV_CHAN_UNUSED) {
+                c.type = RenderChannel::Type::Silent;
+            } else {
+                auto it = std::find_if(std::begin(kChannelPositions), std::end(kChannelPositions), [id](const ChannelPosition &p) { return p.id == id; });
+                if (it != std::end(kChannelPositions)) {
+                    c.type = RenderChannel::Type::Speaker;
+                    c.azimuth = it->azimuth;
+                    c.elevation = it->elevation;
+                } else {
+                    c.type = output ? RenderChannel::Type::Silent : RenderChannel::Type::Speaker;
+                }
+            }
+        }
+        return channels;
+    }
+
+    [[nodiscard]] bool isStereo(const AVChannelLayout &layout) {
+        return layout.nb_channels == 2 && av_channel_layout_channel_from_index(&layout, 0) == AV_CHAN_FRONT_LEFT &&
+               av_channel_layout_channel_from_index(&layout, 1) == AV_CHAN_FRONT_RIGHT;
+    }
+
+    // 第 channel 个声道转换为 f32
+    template <typename T>
+    void toFloat(const uint8_t *src, int stride, int frames, float scale, float offset, float *dst) {
+        const T *p = reinterpret_cast<const T *>(src);
+        for (int i = 0; i < frames; ++i) {
+            dst[i] = (static_cast<float>(p[static_cast<size_t>(i) * stride]) + offset) * scale;
+        }
+    }
+
+    [[nodiscard]] bool channelToFloat(const AVFrame *frm, int channel, float *dst) {
+        const AVSampleFormat format = static_cast<AVSampleFormat>(frm->format);
+        const bool planar = av_sample_fmt_is_planar(format);
+        const int stride = planar ? 1 : frm->ch_layout.nb_channels;
+        const uint8_t *src = planar ? frm->extended_data[channel] : frm->extended_data[0] + static_cast<size_t>(channel) * av_get_bytes_per_sample(format);
+        switch (av_get_packed_sample_fmt(format)) {
+        case AV_SAMPLE_FMT_U8: toFloat<uint8_t>(src, stride, frm->nb_samples, 1.0f / 128.0f, -128.0f, dst); return true;
+        case AV_SAMPLE_FMT_S16: toFloat<int16_t>(src, stride, frm->nb_samples, 1.0f / 32768.0f, 0.0f, dst); return true;
+        case AV_SAMPLE_FMT_S32: toFloat<int32_t>(src, stride, frm->nb_samples, 1.0f / 2147483648.0f, 0.0f, dst); return true;
+        case AV_SAMPLE_FMT_S64: toFloat<int64_t>(src, stride, frm->nb_samples, 1.0f / 9223372036854775808.0f, 0.0f, dst); return true;
+        case AV_SAMPLE_FMT_FLT: toFloat<float>(src, stride, frm->nb_samples, 1.0f, 0.0f, dst); return true;
+        case AV_SAMPLE_FMT_DBL: toFloat<double>(src, stride, frm->nb_samples, 1.0f, 0.0f, dst); return true;
+        default: return false;
+        }
+    }
+}
+
+AudioConverter::~AudioConverter() {
+    uninit();
+}
+
+bool AudioConverter::init(const AudioPar &in, const AudioPar &out, bool binaural) {
+    uninit();
+
+    if (av_sample_fmt_is_planar(out.sampleFormat)) {
+        qDebug() << "AudioConverter: 输出必须是packed格式";
+        return false;
+    }
+
+    m_channels = out.ch_layout.nb_channels;
+    m_bytesPerSample = av_get_bytes_per_sample(out.sampleFormat);
+    m_inSampleRate = in.sampleRate;
+    m_outSampleRate = out.sampleRate;
+
+    if (!copyAudioPar(m_inPar, in) || !copyAudioPar(m_outPar, out)) {
+        uninit();
+        return false;
+    }
+
+    if (rendersSpatially(in.ch_layout, out.ch_layout, binaural)) {
+        if (!initRenderer(in, out, binaural)) {
+            uninit();
+            return false;
+        }
+        // 之后的步骤看到的输入是渲染结果
+        m_inPar.sampleFormat = AV_SAMPLE_FMT_FLT;
+        av_channel_layout_uninit(&m_inPar.ch_layout);
+        if (av_channel_layout_copy(&m_inPar.ch_layout, &out.ch_layout) != 0) {
+            uninit();
+            return false;
+        }
+    }
+
+    const bool sameLayout = av_channel_layout_compare(&m_inPar.ch_layout, &m_outPar.ch_layout) == 0;
+    const bool sameRate = m_inPar.sampleRate == m_outPar.sampleRate;
+    const AVSampleFormat inPacked = av_get_packed_sample_fmt(m_inPar.sampleFormat);
+    const bool sameFormat = inPacked == m_outPar.sampleFormat;
+    // 设备格式固定为 f32，FLAC 以及部分 AAC/MP3 解码器输出的 s16(p)/s32(p) 也不需要经过 swresample
+    const bool intToFloat = m_outPar.sampleFormat == AV_SAMPLE_FMT_FLT && (inPacked == AV_SAMPLE_FMT_S16 || inPacked == AV_SAMPLE_FMT_S32);
+
+    if (sameLayout && sameRate && (sameFormat || intToFloat)) {
+        m_inBytesPerSample = av_get_bytes_per_sample(inPacked);
+        m_inPlanar = av_sample_fmt_is_planar(m_inPar.sampleFormat);
+        if (!sameFormat) {
+            m_mode = m_fastMode = Mode::Convert;
+        } else {
+            m_mode = m_fastMode = m_inPlanar ? Mode::Interleave : Mode::Passthrough;
+        }
+        m_history.resize(static_cast<size_t>(kHistoryFrames) * m_channels * m_inBytesPerSample);
+        return true;
+    }
+
+    if (!initSwr()) {
+        uninit();
+        return false;
+    }
+    return true;
+}
+
+bool AudioConverter::initSwr() {
+    int ret = swr_alloc_set_opts2(&m_swrCtx,
+                                  &m_outPar.ch_layout, m_outPar.sampleFormat, m_outPar.sampleRate, // 输出
+                                  &m_inPar.ch_layout, m_inPar.sampleFormat, m_inPar.sampleRate,    // 输入
+                                  0, nullptr);
+    // 采样率相同时 swresample 默认不创建重采样器，第一次 swr_set_compensation 会重新 swr_init，
+    // 丢掉已有的滤波器历史，所以一开始就启用
+    if (ret >= 0 && m_swrCtx)
+        ret = av_opt_set_int(m_swrCtx, "flags", SWR_FLAG_RESAMPLE, 0);
+    if (ret < 0 || !m_swrCtx || swr_init(m_swrCtx) < 0) {
+        qDebug() << "采样上下文初始化失败";
+        swr_free(&m_swrCtx);
+        return false;
+    }
+    m_mode = Mode::Resample;
+    return true;
+}
+
+void AudioConverter::primeSwr() {
+    // 把快速路径最后输出的输入采样送入 SwrContext 作为滤波器历史，再丢弃对应的输出
+    // 同采样率下输入输出一一对应，丢弃的输出正好覆盖这些历史，新帧的第一个输出采样与快速路径无缝衔接
+    if (m_historyFrames <= 0)
+        return;
+    const int planes = m_inPlanar ? m_channels : 1;
+    const size_t planeSize = static_cast<size_t>(kHistoryFrames) * m_inBytesPerSample * (m_inPlanar ? 1 : m_channels);
+    std::vector<const uint8_t *> in(planes);
+    for (int p = 0; p < planes; ++p) {
+        in[p] = m_history.data() + p * planeSize;
+    }
+    if (swr_convert(m_swrCtx, nullptr, 0, in.data(), m_historyFrames) >= 0)
+        (void)swr_drop_output(m_swrCtx, m_historyFrames);
+    m_historyFrames = 0;
+}
+
+bool AudioConverter::rendersSpatially(const AVChannelLayout &in, const AVChannelLayout &out, bool binaural) {
+    if (binaural && isStereo(out) && in.nb_channels > 2)
+        return true;
+    if (av_channel_layout_compare(&in, &out) == 0)
+        return false;
+    // swresample 不支持 Ambisonics，自定义顺序和超过 8 声道的布局只能按声道序号对应或直接失败
+    return in.order == AV_CHANNEL_ORDER_AMBISONIC || in.order == AV_CHANNEL_ORDER_CUSTOM ||
+           out.order == AV_CHANNEL_ORDER_CUSTOM || in.nb_channels > kMaxRematrixChannels;
+}
+
+bool AudioConverter::initRenderer(const AudioPar &in, const AudioPar &out, bool binaural) {
+    const std::vector<RenderChannel> inChannels = renderChannels(in.ch_layout, false);
+    const std::vector<RenderChannel> outChannels = renderChannels(out.ch_layout, true);
+    if (!m_renderer.init(inChannels, outChannels, in.sampleRate, binaural && isStereo(out.ch_layout))) {
+        qDebug() << "AudioConverter: 空间音频渲染器初始化失败";
+        return false;
+    }
+    m_renderFrm = av_frame_alloc();
+    if (!m_renderFrm)
+        return false;
+    m_renderPlanes.resize(inChannels.size());
+    qDebug() << "AudioConverter: 空间音频渲染" << in.ch_layout.nb_channels << "->" << out.ch_layout.nb_channels
+             << (m_renderer.binaural() ? "(双耳)" : "");
+    return true;
+}
+
+const AVFrame *AudioConverter::render(const AVFrame *frm) {
+    const int channels = m_renderer.inChannels();
+    const int frames = frm->nb_samples;
+    if (frm->ch_layout.nb_channels != channels || frames <= 0)
+        return nullptr;
+
+    // 输入整理为 f32 平面
+    if (frm->format == AV_SAMPLE_FMT_FLTP) {
+        for (int c = 0; c < channels; ++c) {
+            m_renderPlanes[c] = reinterpret_cast<const float *>(frm->extended_data[c]);
+        }
+    } else {
+        m_renderIn.resize(static_cast<size_t>(channels) * frames);
+        for (int c = 0; c < channels; ++c) {
+            float *dst = &m_renderIn[static_cast<size_t>(c) * frames];
+            if (!channelToFloat(frm, c, dst)) {
+                qDebug() << "AudioConverter: 不支持的采样格式" << frm->format;
+                return nullptr;
+            }
+            m_renderPlanes[c] = dst;
+        }
+    }
+
+    if (frames > m_renderCapacity) {
+        av_frame_unref(m_renderFrm);
+        m_renderFrm->format = AV_SAMPLE_FMT_FLT;
+        m_renderFrm->sample_rate = m_inSampleRate;
+        m_renderFrm->nb_samples = frames;
+        if (av_channel_layout_copy(&m_renderFrm->ch_layout, &m_outPar.ch_layout) != 0 || av_frame_get_buffer(m_renderFrm, 0) < 0) {
+            m_renderCapacity = 0;
+            return nullptr;
+        }
+        m_renderCapacity = frames;
+    }
+    m_renderFrm->nb_samples = frames;
+    m_renderer.process(m_renderPlanes.data(), reinterpret_cast<float *>(m_renderFrm->data[0]), frames);
+    return m_renderFrm;
+}
+
+void AudioConverter::uninit() {
+    if (m_swrCtx) {
+        swr_free(&m_swrCtx);
+    }
+    m_mode = m_fastMode = Mode::None;
+    m_draining = false;
+    m_history.clear();
+    m_historyFrames = 0;
+    m_inPar.reset();
+    m_outPar.reset();
+    m_channels = 0;
+    m_bytesPerSample = 0;
+    m_inBytesPerSample = 0;
+    m_inPlanar = false;
+    m_inSampleRate = 0;
+    m_outSampleRate = 0;
+    m_input = nullptr;
+    m_inputOffset = 0;
+    m_inputFed = false;
+    m_renderer.uninit();
+    av_frame_free(&m_renderFrm);
+    m_renderCapacity = 0;
+    m_renderIn.clear();
+    m_renderPlanes.clear();
+}
+
+void AudioConverter::reset() {
+    if (m_swrCtx && m_fastMode != Mode::None) {
+        // 只是为了补偿临时使用的 swresample，直接回到快速路径
+        swr_free(&m_swrCtx);
+        m_mode = m_fastMode;
+    } else if (m_swrCtx) {
+        swr_init(m_swrCtx);
+    }
+    m_draining = false;
+    m_historyFrames = 0;
+    m_renderer.reset();
+    m_input = nullptr;
+    m_inputOffset = 0;
+    m_inputFed = false;
+}
+
+AudioConverter::Mode AudioConverter::mode() const {
+    return m_mode;
+}
+
+double AudioConverter::delay() const {
+    double delay = 0.0;
+    if (m_renderer.latency() > 0 && m_inSampleRate > 0)
+        delay += static_cast<double>(m_renderer.latency()) / m_inSampleRate;
+    if (m_swrCtx && m_outSampleRate > 0)
+        delay += static_cast<double>(swr_get_delay(m_swrCtx, m_outSampleRate)) / m_outSampleRate;
+    return delay;
+}
+
+bool AudioConverter::setCompensation(int sampleDelta, int distance) {
+    if (m_mode == Mode::None)
+        return false;
+
+    if (sampleDelta == 0) {
+        if (m_mode != Mode::Resample)
+            return true;
+        // 缓存中的采样属于上一帧，不能直接丢弃，留到下一帧开头排空
+        if (m_fastMode != Mode::None)
+            m_draining = true;
+        return swr_set_compensation(m_swrCtx, 0, 0) >= 0;
+    }
+
+    if (m_mode != Mode::Resample) {
+        if (!initSwr())
+            return false;
+        primeSwr();
+    }
+    m_draining = false;
+    return swr_set_compensation(m_swrCtx, sampleDelta, distance) >= 0;
+}
+
+void AudioConverter::setInput(const AVFrame *frm, int skipSamples) {
+    if (frm && m_renderer.initialized()) {
+        // 整帧渲染(跳过的部分也要进入卷积的历史)，渲染前后帧数不变
+        frm = render(frm);
+    }
+    m_input = frm;
+    m_inputOffset = 0;
+    m_inputFed = false;
+    if (!frm || skipSamples <= 0)
+        return;
+
+    if (m_mode == Mode::Resample && !m_draining) {
+        // 重采样时无法直接跳过输入，换算成输出采样数交给 SwrContext 丢弃
+        if (m_inSampleRate > 0)
+            (void)swr_drop_output(m_swrCtx, static_cast<int>(static_cast<int64_t>(skipSamples) * m_outSampleRate / m_inSampleRate));
+    } else {
+        m_inputOffset = std::min(skipSamples, frm->nb_samples);
+    }
+}
+
+int64_t AudioConverter::produce(uint8_t *dst, uint64_t frames) {
+    const int count = static_cast<int>(std::min<uint64_t>(frames, INT_MAX));
+
+    switch (m_mode) {
+    case Mode::Passthrough:
+    case Mode::Interleave:
+    case Mode::Convert:
+        return produceFast(dst, count);
+    case Mode::Resample: {
+        if (m_draining && !m_inputFed) {
+            // 新帧开始前排空 SwrContext，之后本帧及以后走快速路径
+            const int n = swr_convert(m_swrCtx, &dst, count, nullptr, 0);
+            if (n < 0)
+                return n;
+            if (n == count)
+                return n;
+            swr_free(&m_swrCtx);
+            m_mode = m_fastMode;
+            m_draining = false;
+            const size_t frameSize = static_cast<size_t>(m_channels) * m_bytesPerSample;
+            return n + produceFast(dst + n * frameSize, count - n);
+        }
+        // 第一次送入整帧，之后以 0 个输入采样取出 SwrContext 中缓存的输出(传入非空指针，不会触发 flush)
+        const uint8_t **in = m_input ? const_cast<const uint8_t **>(m_input->extended_data) : nullptr;
+        if (!in)
+            return 0;
+        const int n = swr_convert(m_swrCtx, &dst, count, in, m_inputFed ? 0 : m_input->nb_samples);
+        m_inputFed = true;
+        return n;
+    }
+    default:
+        return -1;
+    }
+}
+
+int AudioConverter::produceFast(uint8_t *dst, int count) {
+    if (!m_input)
+        return 0;
+    const int n = std::min(count, m_input->nb_samples - m_inputOffset);
+    if (n <= 0)
+        return 0;
+    if (m_mode == Mode::Passthrough) {
+        const size_t frameSize = static_cast<size_t>(m_channels) * m_bytesPerSample;
+        std::memcpy(dst, m_input->data[0] + m_inputOffset * frameSize, n * frameSize);
+    } else if (m_mode == Mode::Interleave) {
+        interleaveSamples(m_input->extended_data, m_inputOffset, dst, m_channels, n, m_bytesPerSample);
+    } else if (m_inPlanar) {
+        interleaveToFloat(m_input->extended_data, m_inputOffset, reinterpret_cast<float *>(dst), m_channels, n, m_inBytesPerSample);
+    } else {
+        // packed 输入已经是交织的，当作单声道整体转换
+        interleaveToFloat(m_input->extended_data, m_inputOffset * m_channels, reinterpret_cast<float *>(dst), 1, n * m_channels, m_inBytesPerSample);
+    }
+    keepHistory(m_inputOffset, n);
+    m_inputOffset += n;
+    return n;
+}
+
+void AudioConverter::keepHistory(int offset, int frames) {
+    const int keep = std::min(frames, kHistoryFrames);
+    const int old = std::min(m_historyFrames, kHistoryFrames - keep);
+    const int planes = m_inPlanar ? m_channels : 1;
+    const size_t sampleSize = static_cast<size_t>(m_inBytesPerSample) * (m_inPlanar ? 1 : m_channels);
+    for (int p = 0; p < planes; ++p) {
+        uint8_t *history = m_history.data() + p * kHistoryFrames * sampleSize;
+        std::memmove(history, history + (m_historyFrames - old) * sampleSize, old * sampleSize);
+        std::memcpy(history + old * sampleSize, m_input->extended_data[p] + (offset + frames - keep) * sampleSize, keep * sampleSize);
+    }
+    m_historyFrames = old + keep;
+}
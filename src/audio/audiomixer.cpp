@@ -0,0 +1,355 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "audio/audiomixer.h"
+#include "compat/compat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(AZ_HAVE_AVX2)
+#include <immintrin.h>
+#elif defined(AZ_HAVE_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr double kInvalidPts = std::numeric_limits<double>::quiet_NaN();
+    constexpr double kAlignToleranceSec = 0.002; // 与主音轨的偏差在该范围内不做对齐，避免逐帧 pts 抖动引起的爆音
+    constexpr double kDiscontinuitySec = 0.1;    // push 的 pts 与已有数据相差超过该值视为 seek
+    constexpr size_t kCompactFrames = 8192;      // 已消费的帧数超过该值时整体前移
+    constexpr float kCenterMix = 0.70710678f;    // -3dB
+
+    // dst[i] += src[i] * gain
+    void addScaled(float *dst, const float *src, float gain, size_t n) {
+        size_t i = 0;
+#if defined(AZ_HAVE_AVX2)
+        const __m256 g = _mm256_set1_ps(gain);
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), g)));
+        }
+#elif defined(AZ_HAVE_SSE2)
+        const __m128 g = _mm_set1_ps(gain);
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] += src[i] * gain;
+        }
+    }
+
+    // dst[i] *= gain
+    void scale(float *dst, float gain, size_t n) {
+        size_t i = 0;
+#if defined(AZ_HAVE_AVX2)
+        const __m256 g = _mm256_set1_ps(gain);
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(dst + i), g));
+        }
+#elif defined(AZ_HAVE_SSE2)
+        const __m128 g = _mm_set1_ps(gain);
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(dst + i), g));
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] *= gain;
+        }
+    }
+
+    /**
+     * dst[o] += Σ columns[i][o] * src[i]，逐帧
+     * columns 每列补齐到 AudioMixer::kMaxChannels 个输出，一帧的所有输出声道放在一个(<=4声道)或两个 SSE 寄存器里累加
+     */
+    void mixMatrix(float *dst, int outChannels, const float *src, int inChannels, const float *columns, int frames) {
+        constexpr int kStride = AudioMixer::kMaxChannels;
+#if defined(AZ_HAVE_SSE2)
+        if (outChannels <= 4) {
+            for (int f = 0; f < frames; ++f) {
+                const float *s = src + static_cast<size_t>(f) * inChannels;
+                float *d = dst + static_cast<size_t>(f) * outChannels;
+                __m128 acc = _mm_setzero_ps();
+                for (int i = 0; i < inChannels; ++i) {
+                    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(columns + static_cast<size_t>(i) * kStride), _mm_set1_ps(s[i])));
+                }
+                if (outChannels == 2) { // 立体声最常见，直接读写低 64 位
+                    const __m128 v = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double *>(d)));
+                    _mm_store_sd(reinterpret_cast<double *>(d), _mm_castps_pd(_mm_add_ps(v, acc)));
+                } else if (outChannels == 4) {
+                    _mm_storeu_ps(d, _mm_add_ps(_mm_loadu_ps(d), acc));
+                } else {
+                    alignas(16) float tmp[4];
+                    _mm_store_ps(tmp, acc);
+                    for (int o = 0; o < outChannels; ++o) {
+                        d[o] += tmp[o];
+                    }
+                }
+            }
+            return;
+        }
+#endif
+        for (int f = 0; f < frames; ++f) {
+            const float *s = src + static_cast<size_t>(f) * inChannels;
+            float *d = dst + static_cast<size_t>(f) * outChannels;
+#if defined(AZ_HAVE_SSE2)
+            __m128 acc0 = _mm_setzero_ps();
+            __m128 acc1 = _mm_setzero_ps();
+            for (int i = 0; i < inChannels; ++i) {
+                const __m128 v = _mm_set1_ps(s[i]);
+                const float *col = columns + static_cast<size_t>(i) * kStride;
+                acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(col), v));
+                acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(col + 4), v));
+            }
+            alignas(16) float acc[kStride];
+            _mm_store_ps(acc, acc0);
+            _mm_store_ps(acc + 4, acc1);
+#else
+            float acc[kStride] = {};
+            for (int i = 0; i < inChannels; ++i) {
+                const float *col = columns + static_cast<size_t>(i) * kStride;
+                for (int o = 0; o < kStride; ++o) {
+                    acc[o] += col[o] * s[i];
+                }
+            }
+#endif
+            for (int o = 0; o < outChannels; ++o) {
+                d[o] += acc[o];
+            }
+        }
+    }
+}
+
+bool AudioMixer::init(int outChannels, int sampleRate) {
+    uninit();
+    if (outChannels <= 0 || outChannels > kMaxChannels || sampleRate <= 0)
+        return false;
+    m_outChannels = outChannels;
+    m_sampleRate = sampleRate;
+    return true;
+}
+
+void AudioMixer::uninit() {
+    m_tracks.clear();
+    m_outChannels = 0;
+    m_sampleRate = 0;
+    m_mainGain = 1.0f;
+}
+
+int AudioMixer::addTrack(int channels) {
+    if (m_outChannels <= 0 || channels <= 0 || channels > kMaxChannels)
+        return -1;
+
+    // 复用已移除的位置
+    auto it = std::find_if(m_tracks.begin(), m_tracks.end(), [](const Track &t) { return !t.used; });
+    if (it == m_tracks.end()) {
+        m_tracks.emplace_back();
+        it = m_tracks.end() - 1;
+    }
+
+    Track &t = *it;
+    t = Track{};
+    t.used = true;
+    t.channels = channels;
+    t.matrix.resize(static_cast<size_t>(m_outChannels) * channels);
+    defaultMatrix(channels, m_outChannels, t.matrix.data());
+    updateColumns(t);
+    return static_cast<int>(it - m_tracks.begin());
+}
+
+void AudioMixer::removeTrack(int id) {
+    if (Track *t = track(id)) {
+        *t = Track{};
+    }
+}
+
+bool AudioMixer::active() const {
+    if (m_mainGain != 1.0f)
+        return true;
+    return std::any_of(m_tracks.begin(), m_tracks.end(), [](const Track &t) { return t.used; });
+}
+
+void AudioMixer::setMainGain(float gain) {
+    m_mainGain = gain;
+}
+
+float AudioMixer::mainGain() const {
+    return m_mainGain;
+}
+
+void AudioMixer::setGain(int id, float gain) {
+    Track *t = track(id);
+    if (!t || t->gain == gain)
+        return;
+    t->gain = gain;
+    updateColumns(*t);
+}
+
+void AudioMixer::setMatrix(int id, const float *matrix) {
+    Track *t = track(id);
+    if (!t || !matrix)
+        return;
+    std::copy(matrix, matrix + t->matrix.size(), t->matrix.begin());
+    updateColumns(*t);
+}
+
+void AudioMixer::push(int id, const float *data, int frames, double pts) {
+    Track *t = track(id);
+    if (!t || frames <= 0)
+        return;
+
+    if (!std::isnan(pts)) {
+        const double end = bufferedEnd(id);
+        if (std::isnan(end) || std::abs(pts - end) > kDiscontinuitySec) {
+            clearTrack(id);
+            t->headPts = pts;
+        }
+    }
+    t->data.insert(t->data.end(), data, data + static_cast<size_t>(frames) * t->channels);
+}
+
+void AudioMixer::clearTrack(int id) {
+    if (Track *t = track(id)) {
+        t->data.clear();
+        t->read = 0;
+        t->headPts = kInvalidPts;
+    }
+}
+
+double AudioMixer::bufferedEnd(int id) const {
+    const Track *t = track(id);
+    if (!t || std::isnan(t->headPts))
+        return kInvalidPts;
+    const size_t avail = t->data.size() / t->channels - t->read;
+    if (avail == 0)
+        return kInvalidPts;
+    return t->headPts + static_cast<double>(avail) / m_sampleRate;
+}
+
+void AudioMixer::mix(float *dst, int frames, double pts) {
+    if (frames <= 0)
+        return;
+    if (m_mainGain != 1.0f) {
+        scale(dst, m_mainGain, static_cast<size_t>(frames) * m_outChannels);
+    }
+    for (Track &t : m_tracks) {
+        if (t.used)
+            mixTrack(t, dst, frames, pts);
+    }
+}
+
+void AudioMixer::defaultMatrix(int inChannels, int outChannels, float *matrix) {
+    std::fill(matrix, matrix + static_cast<size_t>(inChannels) * outChannels, 0.0f);
+    auto at = [&](int o, int i) -> float & { return matrix[static_cast<size_t>(o) * inChannels + i]; };
+
+    // 以下按 FFmpeg 默认声道顺序(FL FR FC LFE BL BR SL SR)处理
+    if (inChannels == outChannels) {
+        for (int c = 0; c < inChannels; ++c) {
+            at(c, c) = 1.0f;
+        }
+    } else if (outChannels == 1) {
+        for (int i = 0; i < inChannels; ++i) {
+            at(0, i) = 1.0f / inChannels;
+        }
+    } else if (inChannels == 1) {
+        at(0, 0) = kCenterMix;
+        at(1, 0) = kCenterMix;
+    } else if (outChannels == 2) {
+        // L = FL + 0.707 FC + 0.707 (BL + SL)，LFE 丢弃，再整体归一化避免削波
+        at(0, 0) = 1.0f;
+        at(1, 1) = 1.0f;
+        if (inChannels >= 3) {
+            at(0, 2) = kCenterMix;
+            at(1, 2) = kCenterMix;
+        }
+        for (int i = 4; i < inChannels; ++i) {
+            at((i - 4) % 2, i) = kCenterMix;
+        }
+        float rowSum = 0.0f;
+        for (int i = 0; i < inChannels; ++i) {
+            rowSum += at(0, i);
+        }
+        for (int i = 0; i < inChannels; ++i) {
+            at(0, i) /= rowSum;
+            at(1, i) /= rowSum;
+        }
+    } else {
+        // 其余情况按声道序号对应，多出的输入声道折回
+        for (int i = 0; i < inChannels; ++i) {
+            at(i % outChannels, i) = 1.0f;
+        }
+    }
+}
+
+AudioMixer::Track *AudioMixer::track(int id) {
+    if (id < 0 || id >= static_cast<int>(m_tracks.size()) || !m_tracks[id].used)
+        return nullptr;
+    return &m_tracks[id];
+}
+
+const AudioMixer::Track *AudioMixer::track(int id) const {
+    if (id < 0 || id >= static_cast<int>(m_tracks.size()) || !m_tracks[id].used)
+        return nullptr;
+    return &m_tracks[id];
+}
+
+void AudioMixer::updateColumns(Track &t) {
+    t.identity = t.channels == m_outChannels;
+    t.columns.assign(static_cast<size_t>(t.channels) * kMaxChannels, 0.0f);
+    for (int i = 0; i < t.channels; ++i) {
+        for (int o = 0; o < m_outChannels; ++o) {
+            const float m = t.matrix[static_cast<size_t>(o) * t.channels + i];
+            t.identity &= m == (o == i ? 1.0f : 0.0f);
+            t.columns[static_cast<size_t>(i) * kMaxChannels + o] = m * t.gain;
+        }
+    }
+}
+
+void AudioMixer::mixTrack(Track &t, float *dst, int frames, double pts) {
+    const size_t ch = t.channels;
+    size_t avail = t.data.size() / ch - t.read;
+    if (avail == 0)
+        return;
+
+    // 按 pts 对齐：叠加音轨落后则丢弃多出的部分，超前则从本段中间开始混入
+    int dstOffset = 0;
+    if (!std::isnan(pts)) {
+        if (std::isnan(t.headPts))
+            t.headPts = pts;
+        const double diff = pts - t.headPts;
+        if (diff > kAlignToleranceSec) {
+            const size_t drop = std::min(avail, static_cast<size_t>(std::llround(diff * m_sampleRate)));
+            t.read += drop;
+            t.headPts += static_cast<double>(drop) / m_sampleRate;
+            avail -= drop;
+        } else if (diff < -kAlignToleranceSec) {
+            const int64_t offset = std::llround(-diff * m_sampleRate);
+            if (offset >= frames)
+                return;
+            dstOffset = static_cast<int>(offset);
+        }
+    }
+
+    const int n = static_cast<int>(std::min<size_t>(avail, frames - dstOffset));
+    if (n > 0) {
+        const float *src = t.data.data() + t.read * ch;
+        float *out = dst + static_cast<size_t>(dstOffset) * m_outChannels;
+        if (t.identity) {
+            addScaled(out, src, t.gain, static_cast<size_t>(n) * ch);
+        } else {
+            mixMatrix(out, m_outChannels, src, t.channels, t.columns.data(), n);
+        }
+        t.read += n;
+        if (!std::isnan(t.headPts))
+            t.headPts += static_cast<double>(n) / m_sampleRate;
+    }
+
+    if (t.read * ch == t.data.size()) {
+        t.data.clear();
+        t.read = 0;
+    } else if (t.read >= kCompactFrames) {
+        t.data.erase(t.data.begin(), t.data.begin() + t.read * ch);
+        t.read = 0;
+    }
+}
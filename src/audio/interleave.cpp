@@ -0,0 +1,281 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "audio/interleave.h"
+#include "compat/compat.h"
+#include <cstring>
+
+#ifdef AZ_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+    template <typename T>
+    void interleaveScalar(const uint8_t *const *src, int srcOffset, uint8_t *dst, int channels, int begin, int end) {
+        T *out = reinterpret_cast<T *>(dst) + static_cast<size_t>(begin) * channels;
+        for (int i = begin; i < end; ++i) {
+            for (int c = 0; c < channels; ++c) {
+                std::memcpy(out++, src[c] + (static_cast<size_t>(srcOffset) + i) * sizeof(T), sizeof(T));
+            }
+        }
+    }
+
+    template <typename T>
+    void interleaveToFloatScalar(const uint8_t *const *src, int srcOffset, float *dst, int channels, int begin, int end, float scale) {
+        float *out = dst + static_cast<size_t>(begin) * channels;
+        for (int i = begin; i < end; ++i) {
+            for (int c = 0; c < channels; ++c) {
+                *out++ = static_cast<float>(reinterpret_cast<const T *>(src[c])[static_cast<size_t>(srcOffset) + i]) * scale;
+            }
+        }
+    }
+
+#ifdef AZ_HAVE_SSE2
+    inline void store32(void *dst, __m128i v) {
+        const int x = _mm_cvtsi128_si32(v);
+        std::memcpy(dst, &x, 4);
+    }
+
+    // 32位采样(f32/s32)，只做数据搬移，按浮点寄存器处理不会改变位模式
+    // 每次处理4帧，4个声道一组做 4x4 转置
+    int interleave32(const uint8_t *const *src, int srcOffset, uint8_t *dst, int channels, int frames) {
+        const float *in[8];
+        for (int c = 0; c < channels; ++c) {
+            in[c] = reinterpret_cast<const float *>(src[c]) + srcOffset;
+        }
+        float *const out = reinterpret_cast<float *>(dst);
+
+        int i = 0;
+        if (channels == 2) {
+            for (; i + 4 <= frames; i += 4) {
+                const __m128 l = _mm_loadu_ps(in[0] + i);
+                const __m128 r = _mm_loadu_ps(in[1] + i);
+                _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(l, r));
+                _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(l, r));
+            }
+            return i;
+        }
+
+        for (; i + 4 <= frames; i += 4) {
+            float *const o = out + static_cast<size_t>(i) * channels;
+            int c = 0;
+            for (; c + 4 <= channels; c += 4) {
+                __m128 r0 = _mm_loadu_ps(in[c] + i);
+                __m128 r1 = _mm_loadu_ps(in[c + 1] + i);
+                __m128 r2 = _mm_loadu_ps(in[c + 2] + i);
+                __m128 r3 = _mm_loadu_ps(in[c + 3] + i);
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                _mm_storeu_ps(o + c, r0);
+                _mm_storeu_ps(o + channels + c, r1);
+                _mm_storeu_ps(o + 2 * channels + c, r2);
+                _mm_storeu_ps(o + 3 * channels + c, r3);
+            }
+            for (; c + 2 <= channels; c += 2) {
+                const __m128 a = _mm_loadu_ps(in[c] + i);
+                const __m128 b = _mm_loadu_ps(in[c + 1] + i);
+                const __m128 lo = _mm_unpacklo_ps(a, b); // a0 b0 a1 b1
+                const __m128 hi = _mm_unpackhi_ps(a, b); // a2 b2 a3 b3
+                _mm_storel_pi(reinterpret_cast<__m64 *>(o + c), lo);
+                _mm_storeh_pi(reinterpret_cast<__m64 *>(o + channels + c), lo);
+                _mm_storel_pi(reinterpret_cast<__m64 *>(o + 2 * channels + c), hi);
+                _mm_storeh_pi(reinterpret_cast<__m64 *>(o + 3 * channels + c), hi);
+            }
+            for (; c < channels; ++c) {
+                for (int k = 0; k < 4; ++k) {
+                    std::memcpy(o + k * channels + c, in[c] + i + k, 4);
+                }
+            }
+        }
+        return i;
+    }
+
+    // 16位采样，每次处理8帧
+    int interleave16(const uint8_t *const *src, int srcOffset, uint8_t *dst, int channels, int frames) {
+        const int16_t *in[8];
+        for (int c = 0; c < channels; ++c) {
+            in[c] = reinterpret_cast<const int16_t *>(src[c]) + srcOffset;
+        }
+        int16_t *const out = reinterpret_cast<int16_t *>(dst);
+
+        int i = 0;
+        if (channels == 2) {
+            for (; i + 8 <= frames; i += 8) {
+                const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in[0] + i));
+                const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in[1] + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i), _mm_unpacklo_epi16(l, r));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i + 8), _mm_unpackhi_epi16(l, r));
+            }
+            return i;
+        }
+
+        for (; i + 8 <= frames; i += 8) {
+            int16_t *const o = out + static_cast<size_t>(i) * channels;
+            int c = 0;
+            for (; c + 4 <= channels; c += 4) {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in[c] + i));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in[c + 1] + i));
+                const __m128i d0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in[c + 2] + i));
+                const __m128i d1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in[c + 3] + i));
+                const __m128i abLo = _mm_unpacklo_epi16(a, b);   // 帧0~3的(a,b)
+                const __m128i abHi = _mm_unpackhi_epi16(a, b);   // 帧4~7的(a,b)
+                const __m128i cdLo = _mm_unpacklo_epi16(d0, d1); // 帧0~3的(c,d)
+                const __m128i cdHi = _mm_unpackhi_epi16(d0, d1); // 帧4~7的(c,d)
+                const __m128i f[4] = {
+                    _mm_unpacklo_epi32(abLo, cdLo), // 帧0、1
+                    _mm_unpackhi_epi32(abLo, cdLo), // 帧2、3
+                    _mm_unpacklo_epi32(abHi, cdHi), // 帧4、5
+                    _mm_unpackhi_epi32(abHi, cdHi), // 帧6、7
+                };
+                for (int k = 0; k < 4; ++k) {
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(o + (2 * k) * channels + c), f[k]);
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(o + (2 * k + 1) * channels + c), _mm_srli_si128(f[k], 8));
+                }
+            }
+            for (; c + 2 <= channels; c += 2) {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in[c] + i));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in[c + 1] + i));
+                __m128i lo = _mm_unpacklo_epi16(a, b); // 每32位为一帧的(a,b)
+                __m128i hi = _mm_unpackhi_epi16(a, b);
+                for (int k = 0; k < 4; ++k) {
+                    store32(o + k * channels + c, lo);
+                    store32(o + (k + 4) * channels + c, hi);
+                    lo = _mm_srli_si128(lo, 4);
+                    hi = _mm_srli_si128(hi, 4);
+                }
+            }
+            for (; c < channels; ++c) {
+                for (int k = 0; k < 8; ++k) {
+                    o[k * channels + c] = in[c][i + k];
+                }
+            }
+        }
+        return i;
+    }
+
+    // 4 个整数采样 -> f32，s16 通过与自身交错后算术右移完成符号扩展(SSE2 没有 cvtepi16)
+    inline __m128 load4(const int16_t *p, __m128 scale) {
+        const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p));
+        return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), scale);
+    }
+    inline __m128 load4(const int32_t *p, __m128 scale) {
+        return _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))), scale);
+    }
+
+    // 整数采样交织为 f32，每次处理4帧，转换后与 interleave32 一样做 4x4 转置
+    template <typename T>
+    int interleaveToFloatSSE2(const uint8_t *const *src, int srcOffset, float *out, int channels, int frames, float scale) {
+        const T *in[8];
+        for (int c = 0; c < channels; ++c) {
+            in[c] = reinterpret_cast<const T *>(src[c]) + srcOffset;
+        }
+        const __m128 s = _mm_set1_ps(scale);
+
+        int i = 0;
+        if (channels == 1) {
+            for (; i + 4 <= frames; i += 4) {
+                _mm_storeu_ps(out + i, load4(in[0] + i, s));
+            }
+            return i;
+        }
+        if (channels == 2) {
+            for (; i + 4 <= frames; i += 4) {
+                const __m128 l = load4(in[0] + i, s);
+                const __m128 r = load4(in[1] + i, s);
+                _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(l, r));
+                _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(l, r));
+            }
+            return i;
+        }
+
+        for (; i + 4 <= frames; i += 4) {
+            float *const o = out + static_cast<size_t>(i) * channels;
+            int c = 0;
+            for (; c + 4 <= channels; c += 4) {
+                __m128 r0 = load4(in[c] + i, s);
+                __m128 r1 = load4(in[c + 1] + i, s);
+                __m128 r2 = load4(in[c + 2] + i, s);
+                __m128 r3 = load4(in[c + 3] + i, s);
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                _mm_storeu_ps(o + c, r0);
+                _mm_storeu_ps(o + channels + c, r1);
+                _mm_storeu_ps(o + 2 * channels + c, r2);
+                _mm_storeu_ps(o + 3 * channels + c, r3);
+            }
+            for (; c + 2 <= channels; c += 2) {
+                const __m128 a = load4(in[c] + i, s);
+                const __m128 b = load4(in[c + 1] + i, s);
+                const __m128 lo = _mm_unpacklo_ps(a, b); // a0 b0 a1 b1
+                const __m128 hi = _mm_unpackhi_ps(a, b); // a2 b2 a3 b3
+                _mm_storel_pi(reinterpret_cast<__m64 *>(o + c), lo);
+                _mm_storeh_pi(reinterpret_cast<__m64 *>(o + channels + c), lo);
+                _mm_storel_pi(reinterpret_cast<__m64 *>(o + 2 * channels + c), hi);
+                _mm_storeh_pi(reinterpret_cast<__m64 *>(o + 3 * channels + c), hi);
+            }
+            for (; c < channels; ++c) {
+                for (int k = 0; k < 4; ++k) {
+                    o[k * channels + c] = static_cast<float>(in[c][i + k]) * scale;
+                }
+            }
+        }
+        return i;
+    }
+#endif
+}
+
+void interleaveSamples(const uint8_t *const *src, int srcOffset, uint8_t *dst,
+                       int channels, int frames, int bytesPerSample) {
+    if (channels <= 0 || frames <= 0)
+        return;
+
+    // 单声道 planar 与 packed 的内存布局相同
+    if (channels == 1) {
+        std::memcpy(dst, src[0] + static_cast<size_t>(srcOffset) * bytesPerSample, static_cast<size_t>(frames) * bytesPerSample);
+        return;
+    }
+
+    int done = 0;
+#ifdef AZ_HAVE_SSE2
+    if (channels <= 8) {
+        if (bytesPerSample == 4) {
+            done = interleave32(src, srcOffset, dst, channels, frames);
+        } else if (bytesPerSample == 2) {
+            done = interleave16(src, srcOffset, dst, channels, frames);
+        }
+    }
+#endif
+
+    // 剩余不足一组的帧，以及没有SIMD实现的情况
+    switch (bytesPerSample) {
+    case 1: interleaveScalar<uint8_t>(src, srcOffset, dst, channels, done, frames); break;
+    case 2: interleaveScalar<uint16_t>(src, srcOffset, dst, channels, done, frames); break;
+    case 4: interleaveScalar<uint32_t>(src, srcOffset, dst, channels, done, frames); break;
+    case 8: interleaveScalar<uint64_t>(src, srcOffset, dst, channels, done, frames); break;
+    default: break;
+    }
+}
+
+void interleaveToFloat(const uint8_t *const *src, int srcOffset, float *dst,
+                       int channels, int frames, int bytesPerSample) {
+    if (channels <= 0 || frames <= 0)
+        return;
+
+    constexpr float kScale16 = 1.0f / (1 << 15);
+    constexpr float kScale32 = 1.0f / (1U << 31);
+
+    int done = 0;
+#ifdef AZ_HAVE_SSE2
+    if (channels <= 8) {
+        if (bytesPerSample == 2) {
+            done = interleaveToFloatSSE2<int16_t>(src, srcOffset, dst, channels, frames, kScale16);
+        } else if (bytesPerSample == 4) {
+            done = interleaveToFloatSSE2<int32_t>(src, srcOffset, dst, channels, frames, kScale32);
+        }
+    }
+#endif
+
+    switch (bytesPerSample) {
+    case 2: interleaveToFloatScalar<int16_t>(src, srcOffset, dst, channels, done, frames, kScale16); break;
+    case 4: interleaveToFloatScalar<int32_t>(src, srcOffset, dst, channels, done, frames, kScale32); break;
+    default: break;
+    }
+}
@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "audio/realfft.h"
+#include <cmath>
+
+namespace {
+    constexpr double kTwoPi = 6.283185307179586;
+
+    // std::complex 的乘法为了处理 inf/nan 会调用库函数，这里不需要
+    inline std::complex<float> mul(std::complex<float> a, std::complex<float> b) {
+        return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+    }
+}
+
+bool RealFFT::init(int size) {
+    m_size = 0;
+    if (size < 4 || (size & (size - 1)) != 0)
+        return false;
+
+    const int half = size / 2;
+    m_bitReverse.resize(half);
+    int bits = 0;
+    while ((1 << bits) < half) {
+        ++bits;
+    }
+    for (int i = 0; i < half; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        m_bitReverse[i] = r;
+    }
+
+    m_twiddle.resize(half / 2);
+    for (int k = 0; k < half / 2; ++k) {
+        m_twiddle[k] = std::polar(1.0f, static_cast<float>(-kTwoPi * k / half));
+    }
+    m_split.resize(half + 1);
+    for (int k = 0; k <= half; ++k) {
+        m_split[k] = std::polar(1.0f, static_cast<float>(-kTwoPi * k / size));
+    }
+    m_buffer.resize(half);
+    m_size = size;
+    return true;
+}
+
+int RealFFT::size() const {
+    return m_size;
+}
+
+void RealFFT::forward(const float *in, float *re, float *im) {
+    const int half = m_size / 2;
+    // 偶数项作实部、奇数项作虚部，做 N/2 点复数 FFT
+    for (int i = 0; i < half; ++i) {
+        m_buffer[m_bitReverse[i]] = {in[2 * i], in[2 * i + 1]};
+    }
+    transform(m_buffer.data(), false);
+
+    // X[k] = E[k] + W^k O[k]，E/O 由 Z[k] 与 conj(Z[N/2-k]) 拆出
+    for (int k = 0; k <= half; ++k) {
+        const std::complex<float> z = m_buffer[k == half ? 0 : k];
+        const std::complex<float> zc = std::conj(m_buffer[k == 0 ? 0 : half - k]);
+        const std::complex<float> even = 0.5f * (z + zc);
+        const std::complex<float> d = z - zc;
+        const std::complex<float> odd(0.5f * d.imag(), -0.5f * d.real()); // (z - zc) / 2j
+        const std::complex<float> x = even + mul(m_split[k], odd);
+        re[k] = x.real();
+        im[k] = x.imag();
+    }
+}
+
+void RealFFT::inverse(const float *re, const float *im, float *out) {
+    const int half = m_size / 2;
+    // forward 的逆过程：由 X[k] 与 conj(X[N/2-k]) 还原 Z[k]
+    for (int k = 0; k < half; ++k) {
+        const std::complex<float> x(re[k], im[k]);
+        const std::complex<float> xc = std::conj(std::complex<float>(re[half - k], im[half - k]));
+        const std::complex<float> even = 0.5f * (x + xc);
+        const std::complex<float> odd = mul(0.5f * (x - xc), std::conj(m_split[k]));
+        m_buffer[m_bitReverse[k]] = even + std::complex<float>(-odd.imag(), odd.real()); // even + j * odd
+    }
+    transform(m_buffer.data(), true);
+
+    const float scale = 1.0f / half;
+    for (int i = 0; i < half; ++i) {
+        out[2 * i] = m_buffer[i].real() * scale;
+        out[2 * i + 1] = m_buffer[i].imag() * scale;
+    }
+}
+
+void RealFFT::transform(std::complex<float> *data, bool inverse) const {
+    // 迭代基2，输入已按位反转序排列
+    const int n = m_size / 2;
+    for (int len = 2; len <= n; len <<= 1) {
+        const int halfLen = len / 2;
+        const int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int j = 0; j < halfLen; ++j) {
+                const std::complex<float> w = inverse ? std::conj(m_twiddle[j * step]) : m_twiddle[j * step];
+                const std::complex<float> t = mul(w, data[i + j + halfLen]);
+                data[i + j + halfLen] = data[i + j] - t;
+                data[i + j] += t;
+            }
+        }
+    }
+}
@@ -0,0 +1,694 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "audio/spatialrenderer.h"
+#include "audio/interleave.h"
+#include "compat/compat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(AZ_HAVE_AVX2)
+#include <immintrin.h>
+#elif defined(AZ_HAVE_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    using Channel = SpatialRenderer::Channel;
+
+    constexpr double kPi = 3.14159265358979323846;
+    constexpr double kDegToRad = kPi / 180.0;
+    constexpr int kMaxAmbisonicChannels = (SpatialRenderer::kMaxAmbisonicOrder + 1) * (SpatialRenderer::kMaxAmbisonicOrder + 1);
+    constexpr int kChunkFrames = 256;         // 扬声器输出每次按平面处理的帧数
+    constexpr float kHeightThreshold = 20.0f; // 仰角不低于该值的扬声器属于上层
+    constexpr double kRegularization = 1e-2;  // 模式匹配解码的正则化系数(相对于平均对角元)
+
+    // 球形头部模型(Brown & Duda 1998)
+    constexpr double kHeadRadius = 0.0875;   // 头部半径(m)
+    constexpr double kSpeedOfSound = 343.0;  // m/s
+    constexpr double kShadowAlphaMin = 0.1;  // 头部阴影最强处的高频增益
+    constexpr double kShadowThetaMin = 150.0; // 头部阴影最强处与耳轴的夹角(度)
+    constexpr double kHrirMs = 5.0;          // HRIR 的最短时长
+    constexpr int kHrirOnset = 8;            // HRIR 开头的固定延迟(帧)，给阴影滤波器的时域响应留出余量
+
+    struct Direction {
+        double azimuth;   // 度
+        double elevation; // 度
+    };
+
+    int ambisonicOrder(int acn) {
+        return static_cast<int>(std::sqrt(static_cast<double>(acn)));
+    }
+
+    double wrapDegrees(double deg) {
+        deg = std::fmod(deg, 360.0);
+        return deg < 0.0 ? deg + 360.0 : deg;
+    }
+
+    // SN3D 实球谐函数，ACN 排列，最高三阶
+    void sphericalHarmonics(int order, const Direction &dir, double *y) {
+        const double az = dir.azimuth * kDegToRad;
+        const double el = dir.elevation * kDegToRad;
+        const double px = std::cos(el) * std::cos(az);
+        const double py = std::cos(el) * std::sin(az);
+        const double pz = std::sin(el);
+
+        y[0] = 1.0;
+        if (order >= 1) {
+            y[1] = py;
+            y[2] = pz;
+            y[3] = px;
+        }
+        if (order >= 2) {
+            const double s3 = std::sqrt(3.0);
+            y[4] = s3 * px * py;
+            y[5] = s3 * py * pz;
+            y[6] = 0.5 * (3.0 * pz * pz - 1.0);
+            y[7] = s3 * px * pz;
+            y[8] = 0.5 * s3 * (px * px - py * py);
+        }
+        if (order >= 3) {
+            const double s58 = std::sqrt(5.0 / 8.0);
+            const double s15 = std::sqrt(15.0);
+            const double s38 = std::sqrt(3.0 / 8.0);
+            y[9] = s58 * py * (3.0 * px * px - py * py);
+            y[10] = s15 * px * py * pz;
+            y[11] = s38 * py * (5.0 * pz * pz - 1.0);
+            y[12] = 0.5 * pz * (5.0 * pz * pz - 3.0);
+            y[13] = s38 * px * (5.0 * pz * pz - 1.0);
+            y[14] = 0.5 * s15 * pz * (px * px - py * py);
+            y[15] = s58 * px * (px * px - 3.0 * py * py);
+        }
+    }
+
+    // 3D max-rE 加权 g_n = P_n(cos(137.9° / (N + 1.51)))
+    double maxReWeight(int n, int order) {
+        const double x = std::cos(137.9 * kDegToRad / (order + 1.51));
+        switch (n) {
+        case 0: return 1.0;
+        case 1: return x;
+        case 2: return 0.5 * (3.0 * x * x - 1.0);
+        default: return 0.5 * (5.0 * x * x * x - 3.0 * x);
+        }
+    }
+
+    // 部分主元高斯消元求解 a * x = b，a 为 n x n，b 为 n x m，结果写回 b
+    bool solve(std::vector<double> &a, std::vector<double> &b, int n, int m) {
+        for (int col = 0; col < n; ++col) {
+            int pivot = col;
+            for (int r = col + 1; r < n; ++r) {
+                if (std::abs(a[r * n + col]) > std::abs(a[pivot * n + col]))
+                    pivot = r;
+            }
+            if (std::abs(a[pivot * n + col]) < 1e-12)
+                return false;
+            if (pivot != col) {
+                std::swap_ranges(a.begin() + pivot * n, a.begin() + (pivot + 1) * n, a.begin() + col * n);
+                std::swap_ranges(b.begin() + pivot * m, b.begin() + (pivot + 1) * m, b.begin() + col * m);
+            }
+            const double inv = 1.0 / a[col * n + col];
+            for (int r = 0; r < n; ++r) {
+                if (r == col)
+                    continue;
+                const double f = a[r * n + col] * inv;
+                if (f == 0.0)
+                    continue;
+                for (int c = col; c < n; ++c) {
+                    a[r * n + c] -= f * a[col * n + c];
+                }
+                for (int c = 0; c < m; ++c) {
+                    b[r * m + c] -= f * b[col * m + c];
+                }
+            }
+        }
+        for (int r = 0; r < n; ++r) {
+            const double inv = 1.0 / a[r * n + r];
+            for (int c = 0; c < m; ++c) {
+                b[r * m + c] *= inv;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * order 阶 Ambisonics(SN3D) -> speakers 的解码矩阵，大小 speakers.size() x (order+1)^2
+     * 一两只扬声器时用虚拟心形指向，其余用带正则化的模式匹配(在 N3D 下求最小二乘)并做 max-rE 加权；
+     * 最后按水平面一圈平面波的平均能量归一化
+     */
+    std::vector<double> ambisonicDecoder(int order, const std::vector<Direction> &speakers) {
+        const int k = (order + 1) * (order + 1);
+        const int s = static_cast<int>(speakers.size());
+        std::vector<double> decoder(static_cast<size_t>(s) * k, 0.0);
+        if (s == 0)
+            return decoder;
+
+        if (s == 1) {
+            decoder[0] = 1.0;
+        } else if (s == 2) {
+            // 左右两只扬声器时取指向正左/正右的心形，否则指向扬声器本身
+            const bool leftRight = (speakers[0].azimuth > 0.0) != (speakers[1].azimuth > 0.0);
+            for (int i = 0; i < s; ++i) {
+                Direction dir = speakers[i];
+                if (leftRight)
+                    dir = {dir.azimuth > 0.0 ? 90.0 : -90.0, 0.0};
+                double y[kMaxAmbisonicChannels];
+                sphericalHarmonics(std::min(order, 1), dir, y);
+                decoder[i * k] = 0.5;
+                for (int c = 1; c < std::min(k, 4); ++c) {
+                    decoder[i * k + c] = 0.5 * y[c];
+                }
+            }
+        } else {
+            // D = (Yᵀ Y + λI)⁻¹ Yᵀ，Y 为 k x s 的 N3D 球谐矩阵
+            std::vector<double> yt(static_cast<size_t>(s) * k); // Yᵀ
+            for (int i = 0; i < s; ++i) {
+                double y[kMaxAmbisonicChannels];
+                sphericalHarmonics(order, speakers[i], y);
+                for (int c = 0; c < k; ++c) {
+                    yt[i * k + c] = y[c] * std::sqrt(2.0 * ambisonicOrder(c) + 1.0);
+                }
+            }
+            std::vector<double> gram(static_cast<size_t>(s) * s, 0.0);
+            double trace = 0.0;
+            for (int i = 0; i < s; ++i) {
+                for (int j = 0; j < s; ++j) {
+                    double sum = 0.0;
+                    for (int c = 0; c < k; ++c) {
+                        sum += yt[i * k + c] * yt[j * k + c];
+                    }
+                    gram[i * s + j] = sum;
+                }
+                trace += gram[i * s + i];
+            }
+            for (int i = 0; i < s; ++i) {
+                gram[i * s + i] += kRegularization * trace / s;
+            }
+            decoder = yt;
+            if (!solve(gram, decoder, s, k))
+                return std::vector<double>(static_cast<size_t>(s) * k, 0.0);
+            for (int i = 0; i < s; ++i) {
+                for (int c = 0; c < k; ++c) {
+                    const int n = ambisonicOrder(c);
+                    decoder[i * k + c] *= std::sqrt(2.0 * n + 1.0) * maxReWeight(n, order);
+                }
+            }
+        }
+
+        double energy = 0.0;
+        constexpr int kSteps = 72;
+        for (int step = 0; step < kSteps; ++step) {
+            double y[kMaxAmbisonicChannels];
+            sphericalHarmonics(order, {step * 360.0 / kSteps, 0.0}, y);
+            for (int i = 0; i < s; ++i) {
+                double p = 0.0;
+                for (int c = 0; c < k; ++c) {
+                    p += decoder[i * k + c] * y[c];
+                }
+                energy += p * p;
+            }
+        }
+        energy /= kSteps;
+        if (energy > 1e-12) {
+            const double scale = 1.0 / std::sqrt(energy);
+            for (double &d : decoder) {
+                d *= scale;
+            }
+        }
+        return decoder;
+    }
+
+    // 在一圈扬声器(out 中的序号)上对 azimuth 做恒功率声像，增益累加到 row[out序号]
+    void panOnRing(const std::vector<int> &ring, const std::vector<Channel> &out, double azimuth, float *row) {
+        if (ring.empty())
+            return;
+        if (ring.size() == 1) {
+            row[ring[0]] += 1.0f;
+            return;
+        }
+
+        std::vector<int> sorted = ring;
+        std::sort(sorted.begin(), sorted.end(), [&](int a, int b) { return wrapDegrees(out[a].azimuth) < wrapDegrees(out[b].azimuth); });
+        const double src = wrapDegrees(azimuth);
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            const int a = sorted[i];
+            const int b = sorted[(i + 1) % sorted.size()];
+            const double start = wrapDegrees(out[a].azimuth);
+            double gap = wrapDegrees(out[b].azimuth - start);
+            if (gap == 0.0)
+                gap = 360.0;
+            const double offset = wrapDegrees(src - start);
+            if (offset <= gap) {
+                const double t = offset / gap * kPi * 0.5;
+                row[a] += static_cast<float>(std::cos(t));
+                row[b] += static_cast<float>(std::sin(t));
+                return;
+            }
+        }
+    }
+
+    /**
+     * 普通声道(扬声器/LFE) -> out 的声像矩阵 matrix[o * in.size() + i]，Ambisonics 声道不处理
+     * 与 swresample 一样整体缩放，保证任何输出声道的系数和不超过 1，返回缩放系数
+     */
+    float positionalMatrix(const std::vector<Channel> &in, const std::vector<Channel> &out, std::vector<float> &matrix) {
+        const size_t inCount = in.size();
+        matrix.assign(out.size() * inCount, 0.0f);
+
+        std::vector<int> lower, upper;
+        int lfe = -1;
+        for (size_t o = 0; o < out.size(); ++o) {
+            if (out[o].type == Channel::Type::Speaker) {
+                (out[o].elevation >= kHeightThreshold ? upper : lower).push_back(static_cast<int>(o));
+            } else if (out[o].type == Channel::Type::LFE && lfe < 0) {
+                lfe = static_cast<int>(o);
+            }
+        }
+
+        std::vector<float> row(out.size());
+        for (size_t i = 0; i < inCount; ++i) {
+            std::fill(row.begin(), row.end(), 0.0f);
+            if (in[i].type == Channel::Type::LFE) {
+                if (lfe >= 0) // 没有低频声道时与 swresample 一样丢弃
+                    row[lfe] = 1.0f;
+            } else if (in[i].type == Channel::Type::Speaker) {
+                // 输出中有同一位置的扬声器时直接对应，否则在同一层相邻的两只扬声器间声像
+                auto same = std::find_if(out.begin(), out.end(), [&](const Channel &c) {
+                    return c.type == Channel::Type::Speaker && std::abs(c.azimuth - in[i].azimuth) < 0.5f && std::abs(c.elevation - in[i].elevation) < 0.5f;
+                });
+                if (same != out.end()) {
+                    row[same - out.begin()] = 1.0f;
+                } else {
+                    const bool high = in[i].elevation >= kHeightThreshold;
+                    const std::vector<int> &ring = high ? (upper.empty() ? lower : upper) : (lower.empty() ? upper : lower);
+                    panOnRing(ring, out, in[i].azimuth, row.data());
+                }
+            }
+            for (size_t o = 0; o < out.size(); ++o) {
+                matrix[o * inCount + i] = row[o];
+            }
+        }
+
+        float maxSum = 0.0f;
+        for (size_t o = 0; o < out.size(); ++o) {
+            float sum = 0.0f;
+            for (size_t i = 0; i < inCount; ++i) {
+                sum += std::abs(matrix[o * inCount + i]);
+            }
+            maxSum = std::max(maxSum, sum);
+        }
+        const float scale = maxSum > 1.0f ? 1.0f / maxSum : 1.0f;
+        for (float &m : matrix) {
+            m *= scale;
+        }
+        return scale;
+    }
+
+    // 双耳渲染 Ambisonics 用的虚拟扬声器：正二十面体 + 正十二面体的顶点，共 32 个，近似均匀分布
+    std::vector<Direction> virtualSpeakers() {
+        const double phi = (1.0 + std::sqrt(5.0)) / 2.0;
+        std::vector<Direction> dirs;
+        auto add = [&](double x, double y, double z) {
+            const double r = std::sqrt(x * x + y * y + z * z);
+            dirs.push_back({std::atan2(y, x) / kDegToRad, std::asin(z / r) / kDegToRad});
+        };
+        for (double a : {-1.0, 1.0}) {
+            for (double b : {-phi, phi}) {
+                add(0.0, a, b);
+                add(a, b, 0.0);
+                add(b, 0.0, a);
+            }
+        }
+        for (double a : {-1.0, 1.0}) {
+            for (double b : {-1.0, 1.0}) {
+                for (double c : {-1.0, 1.0}) {
+                    add(a, b, c);
+                }
+                add(0.0, a / phi, b * phi);
+                add(a / phi, b * phi, 0.0);
+                add(b * phi, 0.0, a / phi);
+            }
+        }
+        return dirs;
+    }
+
+    /**
+     * 球形头部模型的 HRIR：头部阴影为一阶高架滤波，耳间时间差按 Woodworth 公式
+     * @param ear 1为左耳，-1为右耳
+     */
+    void makeHrir(const Direction &dir, int ear, int sampleRate, RealFFT &fft, float *out) {
+        const int length = fft.size();
+        const double az = dir.azimuth * kDegToRad;
+        const double el = dir.elevation * kDegToRad;
+        const double cosTheta = std::clamp(ear * std::cos(el) * std::sin(az), -1.0, 1.0); // 与耳轴夹角的余弦
+        const double theta = std::acos(cosTheta);
+
+        const double alpha = (1.0 + kShadowAlphaMin / 2.0) + (1.0 - kShadowAlphaMin / 2.0) * std::cos(theta / (kShadowThetaMin * kDegToRad) * kPi);
+        const double headDelay = kHeadRadius / kSpeedOfSound;
+        const double tau = theta < kPi / 2.0 ? -headDelay * cosTheta : headDelay * (theta - kPi / 2.0);
+        const double delay = tau + headDelay + static_cast<double>(kHrirOnset) / sampleRate; // 秒，非负
+        const double w0 = kSpeedOfSound / kHeadRadius;
+
+        const int bins = length / 2 + 1;
+        std::vector<float> re(bins), im(bins);
+        for (int k = 0; k < bins; ++k) {
+            const double w = 2.0 * kPi * k * sampleRate / length;
+            // (1 + jαω/2ω0) / (1 + jω/2ω0) · e^{-jω·delay}
+            const double nr = 1.0, ni = alpha * w / (2.0 * w0);
+            const double dr = 1.0, di = w / (2.0 * w0);
+            const double den = dr * dr + di * di;
+            const double hr = (nr * dr + ni * di) / den;
+            const double hi = (ni * dr - nr * di) / den;
+            const double pr = std::cos(w * delay), pi = -std::sin(w * delay);
+            re[k] = static_cast<float>(hr * pr - hi * pi);
+            im[k] = static_cast<float>(hr * pi + hi * pr);
+        }
+        im[0] = 0.0f;
+        im[bins - 1] = 0.0f;
+        fft.inverse(re.data(), im.data(), out);
+
+        // 尾部淡出，去掉循环卷积绕回的部分
+        const int fade = length / 8;
+        for (int i = 0; i < fade; ++i) {
+            out[length - fade + i] *= static_cast<float>(0.5 * (1.0 + std::cos(kPi * (i + 1) / fade)));
+        }
+    }
+
+    // dst[i] += src[i] * gain
+    void addScaled(float *dst, const float *src, float gain, int n) {
+        int i = 0;
+#if defined(AZ_HAVE_AVX2)
+        const __m256 g = _mm256_set1_ps(gain);
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), g)));
+        }
+#elif defined(AZ_HAVE_SSE2)
+        const __m128 g = _mm_set1_ps(gain);
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] += src[i] * gain;
+        }
+    }
+
+    // 频域复数乘加 acc += x * h，实部/虚部分开存放，n 为 8 的倍数
+    void complexMulAdd(float *accRe, float *accIm, const float *xRe, const float *xIm, const float *hRe, const float *hIm, int n) {
+        int i = 0;
+#if defined(AZ_HAVE_AVX2)
+        for (; i + 8 <= n; i += 8) {
+            const __m256 xr = _mm256_loadu_ps(xRe + i), xi = _mm256_loadu_ps(xIm + i);
+            const __m256 hr = _mm256_loadu_ps(hRe + i), hi = _mm256_loadu_ps(hIm + i);
+            const __m256 re = _mm256_sub_ps(_mm256_mul_ps(xr, hr), _mm256_mul_ps(xi, hi));
+            const __m256 im = _mm256_add_ps(_mm256_mul_ps(xr, hi), _mm256_mul_ps(xi, hr));
+            _mm256_storeu_ps(accRe + i, _mm256_add_ps(_mm256_loadu_ps(accRe + i), re));
+            _mm256_storeu_ps(accIm + i, _mm256_add_ps(_mm256_loadu_ps(accIm + i), im));
+        }
+#elif defined(AZ_HAVE_SSE2)
+        for (; i + 4 <= n; i += 4) {
+            const __m128 xr = _mm_loadu_ps(xRe + i), xi = _mm_loadu_ps(xIm + i);
+            const __m128 hr = _mm_loadu_ps(hRe + i), hi = _mm_loadu_ps(hIm + i);
+            const __m128 re = _mm_sub_ps(_mm_mul_ps(xr, hr), _mm_mul_ps(xi, hi));
+            const __m128 im = _mm_add_ps(_mm_mul_ps(xr, hi), _mm_mul_ps(xi, hr));
+            _mm_storeu_ps(accRe + i, _mm_add_ps(_mm_loadu_ps(accRe + i), re));
+            _mm_storeu_ps(accIm + i, _mm_add_ps(_mm_loadu_ps(accIm + i), im));
+        }
+#endif
+        for (; i < n; ++i) {
+            accRe[i] += xRe[i] * hRe[i] - xIm[i] * hIm[i];
+            accIm[i] += xRe[i] * hIm[i] + xIm[i] * hRe[i];
+        }
+    }
+}
+
+bool SpatialRenderer::init(const std::vector<Channel> &in, const std::vector<Channel> &out, int sampleRate, bool binaural) {
+    uninit();
+    if (in.empty() || out.empty() || sampleRate <= 0)
+        return false;
+
+    m_inChannels = static_cast<int>(in.size());
+    m_outChannels = static_cast<int>(out.size());
+    m_binaural = binaural && out.size() == 2;
+    const bool ok = m_binaural ? buildBinaural(in, sampleRate) : buildMatrix(in, out);
+    if (!ok) {
+        uninit();
+        return false;
+    }
+    reset();
+    return true;
+}
+
+void SpatialRenderer::uninit() {
+    m_inChannels = m_outChannels = 0;
+    m_binaural = false;
+    m_matrix.clear();
+    m_planes.clear();
+    m_partitions = m_bins = 0;
+    m_sources.clear();
+    m_filters.clear();
+    m_history.clear();
+    m_fdl.clear();
+    m_acc.clear();
+    m_time.clear();
+    m_outBlock.clear();
+    reset();
+}
+
+void SpatialRenderer::reset() {
+    std::fill(m_history.begin(), m_history.end(), 0.0f);
+    std::fill(m_fdl.begin(), m_fdl.end(), 0.0f);
+    std::fill(m_outBlock.begin(), m_outBlock.end(), 0.0f);
+    m_fdlHead = 0;
+    m_blockPos = 0;
+}
+
+bool SpatialRenderer::initialized() const {
+    return m_inChannels > 0;
+}
+
+bool SpatialRenderer::binaural() const {
+    return m_binaural;
+}
+
+int SpatialRenderer::inChannels() const {
+    return m_inChannels;
+}
+
+int SpatialRenderer::outChannels() const {
+    return m_outChannels;
+}
+
+int SpatialRenderer::latency() const {
+    return m_binaural ? kBlockFrames : 0;
+}
+
+void SpatialRenderer::process(const float *const *in, float *out, int frames) {
+    if (m_inChannels <= 0 || frames <= 0)
+        return;
+    if (m_binaural) {
+        processBinaural(in, out, frames);
+    } else {
+        processMatrix(in, out, frames);
+    }
+}
+
+bool SpatialRenderer::buildMatrix(const std::vector<Channel> &in, const std::vector<Channel> &out) {
+    (void)positionalMatrix(in, out, m_matrix);
+
+    // Ambisonics 分量按输入中最高的阶数解码到所有扬声器
+    int order = -1;
+    for (const Channel &c : in) {
+        if (c.type == Channel::Type::Ambisonic && c.acn < kMaxAmbisonicChannels)
+            order = std::max(order, ambisonicOrder(c.acn));
+    }
+    if (order >= 0) {
+        std::vector<int> speakers;
+        std::vector<Direction> dirs;
+        for (size_t o = 0; o < out.size(); ++o) {
+            if (out[o].type == Channel::Type::Speaker) {
+                speakers.push_back(static_cast<int>(o));
+                dirs.push_back({out[o].azimuth, out[o].elevation});
+            }
+        }
+        const int k = (order + 1) * (order + 1);
+        const std::vector<double> decoder = ambisonicDecoder(order, dirs);
+        for (int i = 0; i < m_inChannels; ++i) {
+            if (in[i].type != Channel::Type::Ambisonic || in[i].acn >= k)
+                continue; // 超过三阶的分量丢弃
+            for (size_t s = 0; s < speakers.size(); ++s) {
+                m_matrix[static_cast<size_t>(speakers[s]) * m_inChannels + i] = static_cast<float>(decoder[s * k + in[i].acn]);
+            }
+        }
+    }
+
+    m_planes.resize(static_cast<size_t>(m_outChannels) * kChunkFrames);
+    return true;
+}
+
+bool SpatialRenderer::buildBinaural(const std::vector<Channel> &in, int sampleRate) {
+    // HRIR 至少 kHrirMs 毫秒，长度取 2 的幂并按 kBlockFrames 分块
+    int hrirLength = kBlockFrames;
+    while (hrirLength < sampleRate * kHrirMs / 1000.0 + kHrirOnset) {
+        hrirLength *= 2;
+    }
+    RealFFT hrirFft;
+    if (!hrirFft.init(hrirLength) || !m_fft.init(2 * kBlockFrames))
+        return false;
+    m_partitions = hrirLength / kBlockFrames;
+    m_bins = (kBlockFrames + 1 + 7) / 8 * 8;
+
+    // 普通声道的响度与下混到立体声时一致
+    std::vector<Channel> stereo(2);
+    stereo[0] = {Channel::Type::Speaker, 30.0f, 0.0f, 0};
+    stereo[1] = {Channel::Type::Speaker, -30.0f, 0.0f, 0};
+    std::vector<float> unused;
+    const float positionalScale = positionalMatrix(in, stereo, unused);
+
+    int order = -1;
+    for (const Channel &c : in) {
+        if (c.type == Channel::Type::Ambisonic && c.acn < kMaxAmbisonicChannels)
+            order = std::max(order, ambisonicOrder(c.acn));
+    }
+    const int k = (order + 1) * (order + 1);
+    const std::vector<Direction> virtuals = order >= 0 ? virtualSpeakers() : std::vector<Direction>{};
+    std::vector<double> decoder = ambisonicDecoder(std::max(order, 0), virtuals);
+    // 虚拟扬声器在耳边是相干叠加的：HRIR 的直流增益为 1，其余分量在均匀分布的球面上抵消，
+    // 所以按 W 的系数和归一化，使任意方向的平面波在低频的耳边增益为 1，与普通声道一致
+    double wSum = 0.0;
+    for (size_t v = 0; v < virtuals.size(); ++v) {
+        wSum += decoder[v * k];
+    }
+    if (wSum > 1e-9) {
+        for (double &d : decoder) {
+            d /= wSum;
+        }
+    }
+    std::vector<float> virtualHrirs(virtuals.size() * 2 * hrirLength);
+    for (size_t v = 0; v < virtuals.size(); ++v) {
+        makeHrir(virtuals[v], 1, sampleRate, hrirFft, &virtualHrirs[(v * 2) * hrirLength]);
+        makeHrir(virtuals[v], -1, sampleRate, hrirFft, &virtualHrirs[(v * 2 + 1) * hrirLength]);
+    }
+
+    // 每个输入声道左右耳各一个时域滤波器
+    std::vector<float> hrirs;
+    std::vector<float> hrir(2 * hrirLength);
+    for (int i = 0; i < m_inChannels; ++i) {
+        const Channel &c = in[i];
+        if (c.type == Channel::Type::Speaker) {
+            makeHrir({c.azimuth, c.elevation}, 1, sampleRate, hrirFft, hrir.data());
+            makeHrir({c.azimuth, c.elevation}, -1, sampleRate, hrirFft, hrir.data() + hrirLength);
+            for (float &h : hrir) {
+                h *= positionalScale;
+            }
+        } else if (c.type == Channel::Type::Ambisonic && c.acn < k) {
+            // Ambisonics 分量 = 各虚拟扬声器的解码系数 x 其 HRIR 之和
+            std::fill(hrir.begin(), hrir.end(), 0.0f);
+            for (size_t v = 0; v < virtuals.size(); ++v) {
+                addScaled(hrir.data(), &virtualHrirs[v * 2 * hrirLength], static_cast<float>(decoder[v * k + c.acn]), 2 * hrirLength);
+            }
+        } else {
+            continue; // LFE 与无效声道不参与双耳渲染
+        }
+        m_sources.push_back(i);
+        hrirs.insert(hrirs.end(), hrir.begin(), hrir.end());
+    }
+
+    // 分块变换到频域
+    const size_t spectrum = 2 * static_cast<size_t>(m_bins);
+    const int fftSize = 2 * kBlockFrames;
+    m_filters.assign(m_sources.size() * 2 * m_partitions * spectrum, 0.0f);
+    std::vector<float> block(fftSize);
+    for (size_t s = 0; s < m_sources.size(); ++s) {
+        for (int ear = 0; ear < 2; ++ear) {
+            const float *h = &hrirs[(s * 2 + ear) * hrirLength];
+            for (int p = 0; p < m_partitions; ++p) {
+                std::fill(block.begin(), block.end(), 0.0f);
+                std::copy(h + p * kBlockFrames, h + (p + 1) * kBlockFrames, block.begin());
+                float *dst = &m_filters[((s * 2 + ear) * m_partitions + p) * spectrum];
+                m_fft.forward(block.data(), dst, dst + m_bins);
+            }
+        }
+    }
+
+    m_history.resize(m_sources.size() * fftSize);
+    m_fdl.resize(m_sources.size() * m_partitions * spectrum);
+    m_acc.resize(spectrum);
+    m_time.resize(fftSize);
+    m_outBlock.resize(2 * kBlockFrames);
+    return true;
+}
+
+void SpatialRenderer::processMatrix(const float *const *in, float *out, int frames) {
+    const uint8_t *planes[64];
+    const int outChannels = std::min(m_outChannels, 64);
+    for (int o = 0; o < outChannels; ++o) {
+        planes[o] = reinterpret_cast<const uint8_t *>(&m_planes[static_cast<size_t>(o) * kChunkFrames]);
+    }
+
+    for (int done = 0; done < frames; done += kChunkFrames) {
+        const int n = std::min(kChunkFrames, frames - done);
+        for (int o = 0; o < outChannels; ++o) {
+            float *dst = &m_planes[static_cast<size_t>(o) * kChunkFrames];
+            std::fill(dst, dst + n, 0.0f);
+            const float *row = &m_matrix[static_cast<size_t>(o) * m_inChannels];
+            for (int i = 0; i < m_inChannels; ++i) {
+                if (row[i] != 0.0f)
+                    addScaled(dst, in[i] + done, row[i], n);
+            }
+        }
+        interleaveSamples(planes, 0, reinterpret_cast<uint8_t *>(out + static_cast<size_t>(done) * m_outChannels), outChannels, n, sizeof(float));
+    }
+}
+
+void SpatialRenderer::processBinaural(const float *const *in, float *out, int frames) {
+    const int fftSize = 2 * kBlockFrames;
+    int done = 0;
+    while (done < frames) {
+        const int n = std::min(frames - done, kBlockFrames - m_blockPos);
+        for (size_t s = 0; s < m_sources.size(); ++s) {
+            std::memcpy(&m_history[s * fftSize + kBlockFrames + m_blockPos], in[m_sources[s]] + done, n * sizeof(float));
+        }
+        // 输出的是上一块的卷积结果
+        std::memcpy(out + static_cast<size_t>(done) * 2, &m_outBlock[static_cast<size_t>(m_blockPos) * 2], n * 2 * sizeof(float));
+
+        m_blockPos += n;
+        done += n;
+        if (m_blockPos == kBlockFrames) {
+            convolveBlock();
+            m_blockPos = 0;
+        }
+    }
+}
+
+void SpatialRenderer::convolveBlock() {
+    const int fftSize = 2 * kBlockFrames;
+    const size_t spectrum = 2 * static_cast<size_t>(m_bins);
+
+    // 新的一块输入变换到频域，放进环形的频域延迟线
+    m_fdlHead = (m_fdlHead + 1) % m_partitions;
+    for (size_t s = 0; s < m_sources.size(); ++s) {
+        float *history = &m_history[s * fftSize];
+        float *x = &m_fdl[(s * m_partitions + m_fdlHead) * spectrum];
+        m_fft.forward(history, x, x + m_bins);
+        std::memcpy(history, history + kBlockFrames, kBlockFrames * sizeof(float));
+    }
+
+    // 所有输入声道、所有分块在频域累加，每只耳朵只做一次逆变换；overlap-save 取后半段
+    for (int ear = 0; ear < 2; ++ear) {
+        std::fill(m_acc.begin(), m_acc.end(), 0.0f);
+        for (size_t s = 0; s < m_sources.size(); ++s) {
+            for (int p = 0; p < m_partitions; ++p) {
+                const int slot = (m_fdlHead - p + m_partitions) % m_partitions;
+                const float *x = &m_fdl[(s * m_partitions + slot) * spectrum];
+                const float *h = &m_filters[((s * 2 + ear) * m_partitions + p) * spectrum];
+                complexMulAdd(m_acc.data(), m_acc.data() + m_bins, x, x + m_bins, h, h + m_bins, m_bins);
+            }
+        }
+        m_fft.inverse(m_acc.data(), m_acc.data() + m_bins, m_time.data());
+        for (int i = 0; i < kBlockFrames; ++i) {
+            m_outBlock[static_cast<size_t>(i) * 2 + ear] = m_time[kBlockFrames + i];
+        }
+    }
+}
@@ -0,0 +1,287 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "audio/timestretcher.h"
+#include "compat/compat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(AZ_HAVE_AVX2)
+#include <immintrin.h>
+#elif defined(AZ_HAVE_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr double kSequenceMs = 40.0;     // 每段长度
+    constexpr double kOverlapMs = 10.0;      // 交叉淡化长度
+    constexpr double kSeekWindowMs = 15.0;   // 起点搜索范围
+    constexpr int kCoarseStep = 4;           // 粗搜索步长，之后在最优点附近逐点细搜
+    constexpr int64_t kCompactFrames = 4096; // 积累到这么多帧再整体前移，避免频繁 erase
+
+    float dotProduct(const float *a, const float *b, int n) {
+        int i = 0;
+        float sum = 0.0f;
+#if defined(AZ_HAVE_AVX2)
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        for (; i + 16 <= n; i += 16) {
+            acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+            acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+        }
+        const __m256 acc = _mm256_add_ps(acc0, acc1);
+        __m128 v = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+        sum = _mm_cvtss_f32(v);
+#elif defined(AZ_HAVE_SSE2)
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        for (; i + 8 <= n; i += 8) {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        }
+        __m128 v = _mm_add_ps(acc0, acc1);
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+        sum = _mm_cvtss_f32(v);
+#endif
+        for (; i < n; ++i) {
+            sum += a[i] * b[i];
+        }
+        return sum;
+    }
+
+    // out = mid + (in - mid) * fade，逐采样线性交叉淡化
+    void crossFade(const float *mid, const float *in, const float *fadeIn, float *out, int frames, int channels) {
+        for (int i = 0; i < frames; ++i) {
+            const float w = fadeIn[i];
+            const float *m = mid + static_cast<size_t>(i) * channels;
+            const float *x = in + static_cast<size_t>(i) * channels;
+            float *o = out + static_cast<size_t>(i) * channels;
+            for (int c = 0; c < channels; ++c) {
+                o[c] = m[c] + (x[c] - m[c]) * w;
+            }
+        }
+    }
+}
+
+bool TimeStretcher::init(int channels, int sampleRate) {
+    uninit();
+    if (channels <= 0 || sampleRate <= 0)
+        return false;
+
+    m_channels = channels;
+    m_sequence = static_cast<int>(sampleRate * kSequenceMs / 1000.0);
+    m_overlap = static_cast<int>(sampleRate * kOverlapMs / 1000.0);
+    m_seekWindow = static_cast<int>(sampleRate * kSeekWindowMs / 1000.0);
+
+    m_fadeIn.resize(m_overlap);
+    for (int i = 0; i < m_overlap; ++i) {
+        m_fadeIn[i] = (i + 0.5f) / m_overlap;
+    }
+    m_mid.resize(static_cast<size_t>(m_overlap) * channels);
+    m_midMono.resize(m_overlap);
+    reset();
+    return true;
+}
+
+void TimeStretcher::uninit() {
+    m_channels = 0;
+    m_sequence = m_overlap = m_seekWindow = 0;
+    m_in.clear();
+    m_mono.clear();
+    m_mid.clear();
+    m_midMono.clear();
+    m_fadeIn.clear();
+    m_out.clear();
+    reset();
+}
+
+void TimeStretcher::reset() {
+    m_in.clear();
+    m_mono.clear();
+    m_out.clear();
+    m_outRead = 0;
+    m_inBase = 0;
+    m_inTotal = 0;
+    m_nominal = 0.0;
+    m_outHeadPos = 0.0;
+    m_haveMid = false;
+}
+
+void TimeStretcher::setSpeed(double speed) {
+    m_speed = speed > 0.0 ? speed : 1.0;
+}
+
+double TimeStretcher::speed() const {
+    return m_speed;
+}
+
+int TimeStretcher::channels() const {
+    return m_channels;
+}
+
+void TimeStretcher::push(const float *in, int frames) {
+    if (m_channels <= 0 || frames <= 0)
+        return;
+
+    const size_t ch = m_channels;
+    m_in.insert(m_in.end(), in, in + frames * ch);
+
+    // 混合信号只用于计算相似度，不需要精确的声道权重
+    const size_t monoBase = m_mono.size();
+    m_mono.resize(monoBase + frames);
+    const float scale = 1.0f / m_channels;
+    for (int i = 0; i < frames; ++i) {
+        const float *x = in + i * ch;
+        float sum = 0.0f;
+        for (size_t c = 0; c < ch; ++c) {
+            sum += x[c];
+        }
+        m_mono[monoBase + i] = sum * scale;
+    }
+    m_inTotal += frames;
+
+    process();
+}
+
+int TimeStretcher::pull(float *out, int maxFrames) {
+    const int n = std::min(available(), maxFrames);
+    if (n <= 0)
+        return 0;
+    const size_t ch = m_channels;
+    std::memcpy(out, m_out.data() + m_outRead * ch, n * ch * sizeof(float));
+    m_outRead += n;
+    m_outHeadPos += n * m_speed;
+    return n;
+}
+
+int TimeStretcher::available() const {
+    if (m_channels <= 0)
+        return 0;
+    return static_cast<int>(m_out.size() / m_channels - m_outRead);
+}
+
+int64_t TimeStretcher::inputFrames() const {
+    return m_inTotal;
+}
+
+double TimeStretcher::outputPosition() const {
+    // 没有剩余输出时，下一段从名义位置附近开始
+    return available() > 0 ? m_outHeadPos : m_nominal;
+}
+
+void TimeStretcher::process() {
+    const size_t ch = m_channels;
+    const int halfWindow = m_seekWindow / 2;
+    const int outFrames = m_sequence - m_overlap;
+
+    while (true) {
+        const int64_t nominal = static_cast<int64_t>(m_nominal);
+        if (nominal + halfWindow + m_sequence > m_inTotal)
+            break;
+        if (nominal < m_inBase) { // 名义位置之前的数据已经丢弃，只会在 reset 之后出现
+            m_nominal = static_cast<double>(m_inBase);
+            continue;
+        }
+
+        const int64_t start = m_haveMid ? seekBestOffset(nominal) : nominal;
+        const float *src = inAt(start);
+
+        if (available() == 0) {
+            m_out.clear();
+            m_outRead = 0;
+            m_outHeadPos = static_cast<double>(start);
+        }
+        const size_t base = m_out.size();
+        m_out.resize(base + static_cast<size_t>(outFrames) * ch);
+        float *dst = m_out.data() + base;
+
+        if (m_haveMid) {
+            crossFade(m_mid.data(), src, m_fadeIn.data(), dst, m_overlap, m_channels);
+            std::memcpy(dst + m_overlap * ch, src + m_overlap * ch, (outFrames - m_overlap) * ch * sizeof(float));
+        } else {
+            std::memcpy(dst, src, outFrames * ch * sizeof(float));
+        }
+
+        // 本段的尾部留给下一段交叉淡化
+        std::memcpy(m_mid.data(), inAt(start + outFrames), m_overlap * ch * sizeof(float));
+        std::memcpy(m_midMono.data(), monoAt(start + outFrames), m_overlap * sizeof(float));
+        m_haveMid = true;
+
+        m_nominal += outFrames * m_speed;
+    }
+
+    compact();
+}
+
+int64_t TimeStretcher::seekBestOffset(int64_t nominal) const {
+    const int halfWindow = m_seekWindow / 2;
+    const int64_t first = std::max(nominal - halfWindow, m_inBase);
+    const int64_t last = std::min(nominal + halfWindow, m_inTotal - m_sequence);
+    const int count = static_cast<int>(last - first);
+    if (count <= 0)
+        return nominal;
+
+    const float *ref = m_midMono.data();
+    const float *x = monoAt(first);
+    constexpr double kEps = 1e-9;
+
+    // 归一化互相关：<ref, x[k..k+overlap)> / |x[k..k+overlap)|，能量逐点滑动更新
+    double energy = dotProduct(x, x, m_overlap);
+    double bestScore = -1e30;
+    int best = 0;
+    for (int k = 0; k < count; ++k) {
+        if (k % kCoarseStep == 0) {
+            const double score = dotProduct(ref, x + k, m_overlap) / std::sqrt(std::max(energy, kEps));
+            if (score > bestScore) {
+                bestScore = score;
+                best = k;
+            }
+        }
+        energy += static_cast<double>(x[k + m_overlap]) * x[k + m_overlap] - static_cast<double>(x[k]) * x[k];
+    }
+
+    // 在粗搜索的最优点附近逐点细搜
+    const int lo = std::max(0, best - kCoarseStep + 1);
+    const int hi = std::min(count - 1, best + kCoarseStep - 1);
+    for (int k = lo; k <= hi; ++k) {
+        if (k == best)
+            continue;
+        const double e = dotProduct(x + k, x + k, m_overlap);
+        const double score = dotProduct(ref, x + k, m_overlap) / std::sqrt(std::max(e, kEps));
+        if (score > bestScore) {
+            bestScore = score;
+            best = k;
+        }
+    }
+    return first + best;
+}
+
+void TimeStretcher::compact() {
+    const size_t ch = m_channels;
+
+    // 下一次搜索最早从 名义位置 - 搜索半径 开始
+    const int64_t keepFrom = std::clamp(static_cast<int64_t>(m_nominal) - m_seekWindow / 2, m_inBase, m_inTotal);
+    const int64_t drop = keepFrom - m_inBase;
+    if (drop >= kCompactFrames || (drop > 0 && keepFrom == m_inTotal)) {
+        m_in.erase(m_in.begin(), m_in.begin() + drop * ch);
+        m_mono.erase(m_mono.begin(), m_mono.begin() + drop);
+        m_inBase = keepFrom;
+    }
+
+    if (m_outRead >= static_cast<size_t>(kCompactFrames)) {
+        m_out.erase(m_out.begin(), m_out.begin() + m_outRead * ch);
+        m_outRead = 0;
+    }
+}
+
+const float *TimeStretcher::inAt(int64_t pos) const {
+    return m_in.data() + (pos - m_inBase) * m_channels;
+}
+
+const float *TimeStretcher::monoAt(int64_t pos) const {
+    return m_mono.data() + (pos - m_inBase);
+}
@@ -2,7 +2,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "clock/globalclock.h"
-#include <chrono>
+#include "clock/timesource.h"
 #include <cmath>
 #include <limits>
 #include <QDebug>
@@ -12,8 +12,7 @@ namespace {
 }
 
 double getRelativeSeconds() {
-    const auto nowTime = std::chrono::steady_clock::now();
-    return std::chrono::duration<double>(nowTime.time_since_epoch()).count();
+    return TimeSource::instance().now();
 }
 
 Clock::Clock(ClockType type) : m_type(type) {
@@ -76,7 +75,7 @@ void GlobalClock::reset() {
     m_videoClk.setClock(INVALID_DOUBLE);
     m_audioClk.setClock(INVALID_DOUBLE);
     m_externalClk.setClock(INVALID_DOUBLE);
-    m_videoClk.m_speed = m_audioClk.m_speed = m_externalClk.m_speed = 1.0;
+    m_videoClk.m_speed = m_audioClk.m_speed = m_externalClk.m_speed = m_speed;
     m_videoClk.m_paused = m_audioClk.m_paused = m_externalClk.m_paused = false;
 }
 
@@ -108,6 +107,17 @@ void GlobalClock::togglePaused() {
     m_externalClk.togglePaused();
 }
 
+void GlobalClock::setSpeed(double newSpeed) {
+    m_videoClk.setSpeed(newSpeed);
+    m_audioClk.setSpeed(newSpeed);
+    m_externalClk.setSpeed(newSpeed);
+    m_speed = newSpeed;
+}
+
+double GlobalClock::speed() const {
+    return m_speed;
+}
+
 double GlobalClock::audioPts() const {
     return m_audioClk.getPts();
 }
@@ -0,0 +1,125 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "clock/timesource.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+TimeSource &TimeSource::instance() {
+    static TimeSource ins;
+    return ins;
+}
+
+double TimeSource::steadySeconds() {
+    const auto nowTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(nowTime.time_since_epoch()).count();
+}
+
+TimeSource::Snapshot TimeSource::loadSnapshot() const {
+    while (true) {
+        const uint32_t seq = m_seq.load(std::memory_order_acquire);
+        if (seq & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        // 读到写了一半的字段时，acquire 保证下面能看到写者已经改过的序号
+        const Snapshot s{m_mode.load(std::memory_order_acquire), m_factor.load(std::memory_order_acquire),
+                         m_origin.load(std::memory_order_acquire), m_base.load(std::memory_order_acquire)};
+        if (m_seq.load(std::memory_order_relaxed) == seq)
+            return s;
+    }
+}
+
+void TimeSource::storeSnapshot(const Snapshot &s) {
+    const uint32_t seq = m_seq.load(std::memory_order_relaxed);
+    m_seq.store(seq + 1, std::memory_order_relaxed);
+    m_factor.store(s.factor, std::memory_order_release);
+    m_origin.store(s.origin, std::memory_order_release);
+    m_base.store(s.base, std::memory_order_release);
+    m_mode.store(s.mode, std::memory_order_release);
+    m_seq.store(seq + 2, std::memory_order_release);
+}
+
+double TimeSource::now(const Snapshot &s) const {
+    if (s.mode == TimeSourceMode::VIRTUAL)
+        return m_virtualNow.load(std::memory_order_acquire);
+    return s.base + (steadySeconds() - s.origin) * s.factor;
+}
+
+double TimeSource::now() const {
+    return now(loadSnapshot());
+}
+
+void TimeSource::sleepFor(double seconds) {
+    if (seconds <= 0.0)
+        return;
+    const Snapshot s = loadSnapshot();
+    if (s.mode == TimeSourceMode::VIRTUAL) {
+        sleepUntil(now(s) + seconds);
+    } else {
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds / s.factor));
+    }
+}
+
+void TimeSource::sleepUntil(double time) {
+    if (m_mode.load(std::memory_order_acquire) != TimeSourceMode::VIRTUAL) {
+        sleepFor(time - now());
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait(lock, [&]() {
+        return m_mode.load(std::memory_order_relaxed) != TimeSourceMode::VIRTUAL || m_virtualNow.load(std::memory_order_relaxed) >= time;
+    });
+}
+
+void TimeSource::setReal() {
+    setRate(TimeSourceMode::REAL, 1.0);
+}
+
+void TimeSource::setVirtual(double start) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_virtualNow.store(start, std::memory_order_relaxed);
+        Snapshot s = loadSnapshot();
+        s.mode = TimeSourceMode::VIRTUAL;
+        storeSnapshot(s);
+    }
+    m_cond.notify_all();
+}
+
+void TimeSource::setAccelerated(double factor) {
+    setRate(TimeSourceMode::ACCELERATED, std::max(factor, 1e-3));
+}
+
+void TimeSource::setRate(TimeSourceMode mode, double factor) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // 从当前读数继续，切换前后 now 连续
+        const double steady = steadySeconds();
+        const Snapshot old = loadSnapshot();
+        const double base = old.mode == TimeSourceMode::VIRTUAL ? m_virtualNow.load(std::memory_order_relaxed)
+                                                                : old.base + (steady - old.origin) * old.factor;
+        storeSnapshot({mode, factor, steady, base});
+    }
+    m_cond.notify_all();
+}
+void TimeSource::advance(double seconds) {
+    advanceTo(m_virtualNow.load(std::memory_order_relaxed) + seconds);
+}
+
+void TimeSource::advanceTo(double time) {
+    if (m_mode.load(std::memory_order_acquire) != TimeSourceMode::VIRTUAL)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (time <= m_virtualNow.load(std::memory_order_relaxed))
+            return;
+        m_virtualNow.store(time, std::memory_order_release);
+    }
+    m_cond.notify_all();
+}
+
+TimeSourceMode TimeSource::mode() const {
+    return m_mode.load(std::memory_order_acquire);
+}
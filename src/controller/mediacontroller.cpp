@@ -2,13 +2,23 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "controller/mediacontroller.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
 #include <QFileInfo>
+#include <sstream>
 #include "clock/globalclock.h"
 #include "renderer/videorenderer.h"
+#include "stats/outputsink.h"
 #include "stats/playbackstats.h"
+#include "stats/tracer.h"
 #include "utils/episodeassetmanager.h"
+#include <algorithm>
 
 namespace {
+    constexpr double kMinSpeed = 0.5;
+    constexpr double kMaxSpeed = 4.0;
+
     void clearPktQ(sharedPktQueue pktq) {
         if (!pktq) {
             return;
@@ -37,10 +47,12 @@ MediaController::MediaController(QObject *parent)
     for (size_t i = 0; i < m_demuxs.size(); ++i) {
         m_demuxs[i] = new Demux(parent);
     }
+    m_overlayDemux = new Demux(parent);
 
     m_decodeAudio = new DecodeAudio(parent);
     m_decodeVideo = new DecodeVideo(parent);
     m_decodeSubtitle = new DecodeSubtitle(parent);
+    m_decodeOverlay = new DecodeAudio(parent);
 
     m_audioPlayer = new AudioPlayer(parent);
     m_videoPlayer = new VideoPlayer(parent);
@@ -79,6 +91,14 @@ MediaController::MediaController(QObject *parent)
         PlaybackStats::instance().audioFrameCount = m_frmAudioBuf->size();
         PlaybackStats::instance().videoFrameCount = m_frmVideoBuf->size();
         PlaybackStats::instance().subtitleFrameCount = m_frmSubtitleBuf->size();
+
+        // 内存估算：帧队列里没有逐帧的大小，按各解码器最近一帧计算(字幕帧很小，忽略)
+        PlaybackStats::instance().packetQueueBytes = static_cast<int64_t>(m_pktAudioBuf->currentBytes() + m_pktVideoBuf->currentBytes() +
+                                                                          m_pktSubtitleBuf->currentBytes() + m_pktOverlayBuf->currentBytes());
+        PlaybackStats::instance().frameQueueBytes = static_cast<int64_t>(m_frmAudioBuf->size()) * m_decodeAudio->lastFrameBytes() +
+                                                    static_cast<int64_t>(m_frmVideoBuf->size()) * m_decodeVideo->lastFrameBytes() +
+                                                    static_cast<int64_t>(m_frmOverlayBuf->size()) * m_decodeOverlay->lastFrameBytes();
+        PlaybackStats::instance().libassBytes = static_cast<int64_t>(ASSRender::instance().memoryUsage());
     });
     m_updatePktAndFrmQueueSizeTimer.start(1000); // 每1000ms触发一次
 
@@ -175,15 +195,13 @@ bool MediaController::open(const QUrl &URL) {
     setDuration(m_demuxs[kMainDemux]->getDuration()); // 总时长
     setProgress(0);
     GlobalClock::instance().reset();
-    GlobalClock::instance().setMainClockType(ClockType::AUDIO); // 默认
-    m_audioPlayer->setVolume(m_muted ? 0.0 : m_volume);         // start之前设置好
+    applyClockMaster();
+    m_audioPlayer->setVolume(m_muted ? 0.0 : m_volume); // start之前设置好
 
     if (!haveAudio && !haveVideo) {
         qDebug() << "文件不包含视频和音频";
         close();
         return false;
-    } else if (!haveAudio && haveVideo) {
-        GlobalClock::instance().setMainClockType(ClockType::VIDEO);
     }
 
     ok &= m_videoPlayer->init(m_frmVideoBuf, m_frmSubtitleBuf);
@@ -192,6 +210,17 @@ bool MediaController::open(const QUrl &URL) {
         return false;
     }
 
+    // 设置了 AZPLAYER_OUTPUT_SINK 时把送显的画面与设备输出的 PCM 逐帧哈希记录到 <目录>/<文件名>/ 下，用于与 golden 对比
+    // AZPLAYER_OUTPUT_SINK_FLAGS 可包含 dump(同时写出 y4m/wav)、fbo(读回合成后的画面)，用逗号分隔
+    const QString sinkDir = qEnvironmentVariable("AZPLAYER_OUTPUT_SINK");
+    if (!sinkDir.isEmpty()) {
+        const QStringList flags = qEnvironmentVariable("AZPLAYER_OUTPUT_SINK_FLAGS").split(',', Qt::SkipEmptyParts);
+        OutputSink::Options sinkOpt;
+        sinkOpt.dump = flags.contains("dump");
+        sinkOpt.fbo = flags.contains("fbo");
+        (void)OutputSink::instance().begin(QDir(sinkDir).filePath(QFileInfo(localFile).completeBaseName()), sinkOpt);
+    }
+
     m_demuxs[kMainDemux]->start();
     m_decodeAudio->start();
     m_decodeVideo->start();
@@ -238,6 +267,7 @@ bool MediaController::loadExternalAudio(const QUrl &URL) {
 void MediaController::close() {
     if (!m_opened) return;
 
+    closeOverlayAudio();
     for (size_t i = 0; i < m_demuxs.size(); ++i) {
         if (m_demuxs[i]) m_demuxs[i]->uninit();
     }
@@ -248,6 +278,19 @@ void MediaController::close() {
     m_audioPlayer->uninit();
     m_videoPlayer->uninit();
 
+    // 设置了 AZPLAYER_STATS_JSON 时把本次播放的统计写到该文件，便于对比不同构建
+    const QString statsPath = qEnvironmentVariable("AZPLAYER_STATS_JSON");
+    if (!statsPath.isEmpty()) {
+        (void)PlaybackStats::instance().dumpJson(statsPath);
+    }
+    // 同理，追踪从启动开始记录，每个文件关闭时写出并清空
+    if (Tracer::enabled() && qEnvironmentVariableIsSet("AZPLAYER_TRACE_JSON")) {
+        (void)exportTrace();
+        Tracer::instance().clear();
+    }
+    // 送显与解码线程都已停止，结束输出记录(音频回调此后写入的静音不再记录)
+    OutputSink::instance().end();
+
     clearPktQ(m_pktAudioBuf);
     clearPktQ(m_pktVideoBuf);
     clearPktQ(m_pktSubtitleBuf);
@@ -260,6 +303,7 @@ void MediaController::close() {
     ASSRender::instance().uninit();
     setOpened(false);
     m_streams.fill({-1, -1});
+    m_secondarySubtitle = {-1, -1};
     setPaused(true);
     setDuration(0);
     setProgress(0);
@@ -334,6 +378,38 @@ void MediaController::fastRewind() {
     seekBySec(std::max(0.0, getCurrentTime() - 5.0), -5.0);
 }
 
+bool MediaController::toggleTracing() {
+    if (!Tracer::compiledIn()) {
+        qDebug() << "未编译追踪，需要配置 -DAZPLAYER_ENABLE_TRACING=ON";
+        return false;
+    }
+    if (!Tracer::enabled()) {
+        Tracer::instance().clear();
+        Tracer::instance().setEnabled(true);
+        qDebug() << "开始追踪";
+        return true;
+    }
+    Tracer::instance().setEnabled(false);
+    return exportTrace();
+}
+
+bool MediaController::exportTrace() const {
+    QString path = qEnvironmentVariable("AZPLAYER_TRACE_JSON");
+    if (path.isEmpty()) {
+        path = QDir::temp().filePath("azplayer-trace-" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".json");
+    }
+    // 先写到内存，路径交给 QFile 处理(Windows 下的非 ASCII 路径)
+    std::ostringstream json;
+    QFile file(path);
+    if (!Tracer::instance().exportChromeTrace(json) || !file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "追踪写入失败:" << path;
+        return false;
+    }
+    file.write(QByteArray::fromStdString(json.str()));
+    qDebug() << "追踪已写入:" << path;
+    return true;
+}
+
 bool MediaController::switchSubtitleStream(int demuxIdx, int streamIdx) {
     if (m_streams[MediaType::Video].demuxIdx < 0 || m_streams[MediaType::Video].streamIdx < 0)
         return false;
@@ -345,7 +421,7 @@ bool MediaController::switchSubtitleStream(int demuxIdx, int streamIdx) {
     if (m_streams[MediaType::Subtitle].demuxIdx != -1)
         m_demuxs[m_streams[MediaType::Subtitle].demuxIdx]->closeStream(MediaType::Subtitle);
     m_decodeSubtitle->uninit();
-    ASSRender::instance().uninit();
+    ASSRender::instance().deactivate(); // 已解析的文本字幕轨道保留，切换回来时不需要重新读取文件
     m_videoPlayer->clearSubtitle(); // 切换后需要一定时间才会解码到新字幕，因此提前强制清掉旧字幕
 
     clearPktQ(m_pktSubtitleBuf);
@@ -362,20 +438,120 @@ bool MediaController::switchSubtitleStream(int demuxIdx, int streamIdx) {
     }
 
     m_streams[MediaType::Subtitle] = {demuxIdx, streamIdx}; // 更新
+    if (m_secondarySubtitle == m_streams[MediaType::Subtitle])
+        m_secondarySubtitle = {-1, -1}; // ASSRender 已经取消了副字幕
     emit streamInfoUpdate();
 
     return true;
 }
 
+bool MediaController::setSecondarySubtitleStream(int demuxIdx, int streamIdx) {
+    if (demuxIdx < 0 || streamIdx < 0) { // 关闭
+        (void)ASSRender::instance().setSecondaryTrack({}, -1);
+        m_secondarySubtitle = {-1, -1};
+        emit streamInfoUpdate();
+        return true;
+    }
+
+    if (demuxIdx >= static_cast<int>(m_demuxs.size()) || m_streams[MediaType::Subtitle] == StreamSlot{demuxIdx, streamIdx})
+        return false;
+    if (m_secondarySubtitle == StreamSlot{demuxIdx, streamIdx})
+        return true;
+
+    if (!m_demuxs[demuxIdx]->setSecondarySubtitleStream(streamIdx)) {
+        qDebug() << "副字幕只支持文本字幕";
+        return false;
+    }
+    m_secondarySubtitle = {demuxIdx, streamIdx};
+    emit streamInfoUpdate();
+    return true;
+}
+
+bool MediaController::setOverlayAudioStream(int demuxIdx, int streamIdx) {
+    if (demuxIdx < 0 || streamIdx < 0) { // 关闭
+        closeOverlayAudio();
+        emit streamInfoUpdate();
+        return true;
+    }
+
+    if (!m_opened || demuxIdx >= static_cast<int>(m_demuxs.size()) || m_streams[MediaType::Audio] == StreamSlot{demuxIdx, streamIdx})
+        return false;
+    if (m_overlayAudio == StreamSlot{demuxIdx, streamIdx})
+        return true;
+    closeOverlayAudio();
+
+    // 叠加音轨有自己的读取位置，单独打开一份源文件
+    if (!m_overlayDemux->init(m_demuxs[demuxIdx]->url()) ||
+        !m_overlayDemux->switchAudioStream(streamIdx, m_pktOverlayBuf, m_frmOverlayBuf) ||
+        !m_decodeOverlay->init(m_overlayDemux->getStream(MediaType::Audio), m_pktOverlayBuf, m_frmOverlayBuf, 1)) {
+        closeOverlayAudio();
+        return false;
+    }
+    m_decodeOverlay->start();
+
+    // 主音轨的 PCM 线程停下来之后才能修改混音音轨，设备继续播放已缓冲的数据
+    m_audioPlayer->stop();
+    const bool ok = m_audioPlayer->setOverlay(m_overlayDemux->getStream(MediaType::Audio)->codecpar, m_frmOverlayBuf);
+    m_audioPlayer->start();
+    if (m_paused) {
+        // start 会无条件开始播放，这儿重新设置一下状态
+        m_audioPlayer->togglePaused();
+    }
+    if (!ok) {
+        closeOverlayAudio();
+        return false;
+    }
+
+    m_overlayAudio = {demuxIdx, streamIdx};
+    emit streamInfoUpdate();
+    return true;
+}
+
+void MediaController::closeOverlayAudio() {
+    if (m_audioPlayer->haveOverlay()) {
+        const bool running = m_opened && m_streams[MediaType::Audio].demuxIdx != -1;
+        m_audioPlayer->stop();
+        m_audioPlayer->clearOverlay();
+        if (running) {
+            m_audioPlayer->start();
+            if (m_paused) {
+                m_audioPlayer->togglePaused();
+            }
+        }
+    }
+    m_overlayDemux->uninit();
+    m_decodeOverlay->uninit();
+    clearPktQ(m_pktOverlayBuf);
+    clearFrmQ(m_frmOverlayBuf);
+    m_pktOverlayBuf->addSerial();
+    m_frmOverlayBuf->addSerial();
+    m_overlayAudio = {-1, -1};
+}
+
+double MediaController::overlayVolume() const {
+    return m_overlayVolume;
+}
+
+void MediaController::setOverlayVolume(double newVolume) {
+    newVolume = std::clamp(newVolume, 0.0, 1.0);
+    if (qFuzzyCompare(m_overlayVolume, newVolume)) return;
+    m_overlayVolume = newVolume;
+    m_audioPlayer->setOverlayGain(newVolume);
+    emit overlayVolumeChanged();
+}
+
 bool MediaController::switchAudioStream(int demuxIdx, int streamIdx) {
     if (m_streams[MediaType::Audio] == StreamSlot{demuxIdx, streamIdx}) {
         return true;
     }
+    if (m_overlayAudio == StreamSlot{demuxIdx, streamIdx}) {
+        closeOverlayAudio(); // 同一条音轨不叠加到自己上
+    }
     // 关闭旧的
     if (m_streams[MediaType::Audio].demuxIdx != -1)
         m_demuxs[m_streams[MediaType::Audio].demuxIdx]->closeStream(MediaType::Audio);
     m_decodeAudio->uninit();
-    m_audioPlayer->uninit(); // 音频设备需要重新设置
+    m_audioPlayer->uninit(true); // 设备不重新打开，已缓冲的数据继续播放，新音轨从其末尾接上
 
     clearPktQ(m_pktAudioBuf);
     clearFrmQ(m_frmAudioBuf);
@@ -411,6 +587,116 @@ void MediaController::setAutoLoadExtSub(bool newAutoLoadExtSub) {
     emit autoLoadExtSubChanged();
 }
 
+bool MediaController::preloadAudioTracks() const {
+    return m_preloadAudioTracks;
+}
+
+void MediaController::setPreloadAudioTracks(bool newPreload) {
+    if (m_preloadAudioTracks == newPreload) return;
+    m_preloadAudioTracks = newPreload;
+    for (Demux *demux : m_demuxs) {
+        demux->setPreloadAudioTracks(newPreload);
+    }
+    emit preloadAudioTracksChanged();
+}
+
+int MediaController::clockMaster() const {
+    return static_cast<int>(m_clockMaster);
+}
+
+void MediaController::setClockMaster(int newClockMaster) {
+    if (newClockMaster < static_cast<int>(ClockType::AUDIO) || newClockMaster > static_cast<int>(ClockType::EXTERNAL))
+        return;
+    const ClockType type = static_cast<ClockType>(newClockMaster);
+    if (m_clockMaster == type) return;
+    m_clockMaster = type;
+    if (m_opened) applyClockMaster();
+    emit clockMasterChanged();
+}
+
+double MediaController::speed() const {
+    return m_speed;
+}
+
+void MediaController::setSpeed(double newSpeed) {
+    newSpeed = std::clamp(newSpeed, kMinSpeed, kMaxSpeed);
+    if (qFuzzyCompare(m_speed, newSpeed)) return;
+    m_speed = newSpeed;
+    // 时钟与音频同时切换，视频按时钟的速度调整帧间隔
+    GlobalClock::instance().setSpeed(newSpeed);
+    m_audioPlayer->setSpeed(newSpeed);
+    emit speedChanged();
+}
+
+int MediaController::audioLatencyProfile() const {
+    return static_cast<int>(m_audioLatencyProfile);
+}
+
+void MediaController::setAudioLatencyProfile(int newProfile) {
+    if (newProfile < static_cast<int>(AudioLatencyProfile::PowerSaving) || newProfile > static_cast<int>(AudioLatencyProfile::LowLatency))
+        return;
+    const AudioLatencyProfile profile = static_cast<AudioLatencyProfile>(newProfile);
+    if (m_audioLatencyProfile == profile) return;
+    m_audioLatencyProfile = profile;
+    m_audioPlayer->setLatencyProfile(profile);
+
+    // 播放中按新档位重新打开设备，丢弃已缓冲的数据，之后的帧照常播放
+    const StreamSlot &slot = m_streams[MediaType::Audio];
+    if (m_opened && slot.demuxIdx != -1) {
+        m_audioPlayer->uninit();
+        if (m_audioPlayer->init(m_demuxs[slot.demuxIdx]->getStream(MediaType::Audio)->codecpar, m_frmAudioBuf)) {
+            m_audioPlayer->start();
+            if (m_paused) {
+                m_audioPlayer->togglePaused();
+            }
+        }
+    }
+    emit audioLatencyProfileChanged();
+}
+
+bool MediaController::binauralRendering() const {
+    return m_binauralRendering;
+}
+
+void MediaController::setBinauralRendering(bool newBinaural) {
+    if (m_binauralRendering == newBinaural) return;
+    m_binauralRendering = newBinaural;
+
+    // 播放中重新初始化主音轨的转换，丢弃已缓冲的数据；叠加音轨在 setBinaural 中重建
+    const StreamSlot &slot = m_streams[MediaType::Audio];
+    if (m_opened && slot.demuxIdx != -1) {
+        m_audioPlayer->uninit();
+        m_audioPlayer->setBinaural(newBinaural);
+        if (m_audioPlayer->init(m_demuxs[slot.demuxIdx]->getStream(MediaType::Audio)->codecpar, m_frmAudioBuf)) {
+            m_audioPlayer->start();
+            if (m_paused) {
+                m_audioPlayer->togglePaused();
+            }
+        }
+    } else {
+        m_audioPlayer->setBinaural(newBinaural);
+    }
+    emit binauralRenderingChanged();
+}
+
+void MediaController::applyClockMaster() {
+    const bool haveAudio = DeviceStatus::instance().haveAudio();
+    const bool haveVideo = DeviceStatus::instance().haveVideo();
+    ClockType type = m_clockMaster;
+    if (type == ClockType::AUDIO && !haveAudio) {
+        type = ClockType::VIDEO;
+    } else if (type == ClockType::VIDEO && !haveVideo) {
+        type = ClockType::AUDIO;
+    }
+
+    GlobalClock &clock = GlobalClock::instance();
+    // 外部时钟从当前主时钟的位置开始走，避免切换时画面或声音跳变
+    if (type == ClockType::EXTERNAL && clock.mainClockType() != ClockType::EXTERNAL) {
+        clock.setExternalClk(clock.getMainPts());
+    }
+    clock.setMainClockType(type);
+}
+
 int MediaController::progress() const {
     return m_progress;
 }
@@ -481,6 +767,13 @@ bool MediaController::openStreamByFile(const QUrl &URL, MediaType type) {
         m_pktSubtitleBuf->clear();
         m_streams[MediaType::Subtitle] = {-1, -1};
     }
+    if (m_secondarySubtitle.demuxIdx == index) {
+        (void)ASSRender::instance().setSecondaryTrack({}, -1);
+        m_secondarySubtitle = {-1, -1};
+    }
+    if (m_overlayAudio.demuxIdx == index) {
+        closeOverlayAudio();
+    }
 
     bool initOk = m_demuxs[index]->init(localFile.toUtf8().constData());
     if (initOk && m_demuxs[index]->getStreamsCount()[type] < 1) {
@@ -496,6 +789,7 @@ bool MediaController::openStreamByFile(const QUrl &URL, MediaType type) {
 bool MediaController::seekAudioAndSubtitleDemux(double pts) {
     m_demuxs[kSubDemux]->seekBySec(pts, 0.0);
     m_demuxs[kAudioDemux]->seekBySec(pts, 0.0);
+    m_overlayDemux->seekBySec(pts, 0.0);
     return true;
 }
 
@@ -580,23 +874,29 @@ QVariantList MediaController::getChaptersInfo() const {
 }
 
 int MediaController::getSubtitleIdx() const {
-    if (m_streams[MediaType::Subtitle].demuxIdx == -1)
-        return -1;
-    size_t idx = 0;
-    for (int i = 0; i < m_streams[MediaType::Subtitle].demuxIdx; ++i) {
-        idx += m_demuxs[i]->getStreamsCount()[MediaType::Subtitle];
-    }
-    return static_cast<int>(idx) + m_streams[MediaType::Subtitle].streamIdx;
+    return getFlatStreamIdx(MediaType::Subtitle, m_streams[MediaType::Subtitle]);
 }
 
 int MediaController::getAudioIdx() const {
-    if (m_streams[MediaType::Audio].demuxIdx == -1)
+    return getFlatStreamIdx(MediaType::Audio, m_streams[MediaType::Audio]);
+}
+
+int MediaController::getSecondarySubtitleIdx() const {
+    return getFlatStreamIdx(MediaType::Subtitle, m_secondarySubtitle);
+}
+
+int MediaController::getOverlayAudioIdx() const {
+    return getFlatStreamIdx(MediaType::Audio, m_overlayAudio);
+}
+
+int MediaController::getFlatStreamIdx(MediaType type, const StreamSlot &slot) const {
+    if (slot.demuxIdx == -1)
         return -1;
     size_t idx = 0;
-    for (int i = 0; i < m_streams[MediaType::Audio].demuxIdx; ++i) {
-        idx += m_demuxs[i]->getStreamsCount()[MediaType::Audio];
+    for (int i = 0; i < slot.demuxIdx; ++i) {
+        idx += m_demuxs[i]->getStreamsCount()[type];
     }
-    return static_cast<int>(idx) + m_streams[MediaType::Audio].streamIdx;
+    return static_cast<int>(idx) + slot.streamIdx;
 }
 
 int MediaController::duration() const {
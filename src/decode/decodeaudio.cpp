@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "decode/decodeaudio.h"
+#include "clock/timesource.h"
 #include <QDebug>
 
 bool DecodeAudio::init(AVStream *stream, sharedPktQueue pktBuf, sharedFrmQueue frmBuf, int threadNum) {
@@ -33,7 +34,7 @@ void DecodeAudio::decodingLoop() {
     while (!m_stop.load(std::memory_order_relaxed)) {
         bool ok = getPkt(pktItem, needFlushBuffers);
         if (!ok) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            TimeSource::instance().sleepFor(0.005);
             continue;
         }
 
@@ -50,7 +51,7 @@ void DecodeAudio::decodingLoop() {
         } else if (ret == AVERROR_EOF) {
             av_packet_free(&pktItem.pkt);
             m_isEOF = true;
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            TimeSource::instance().sleepFor(0.01);
             continue;
         } else if (ret == AVERROR(EAGAIN)) {
             ;
@@ -74,11 +75,9 @@ void DecodeAudio::decodingLoop() {
             // 写入缓冲区
             if (ret == 0) {
                 frmItem.pts = (frmItem.frm->pts == AV_NOPTS_VALUE) ? INVALID_DOUBLE : frmItem.frm->pts * av_q2d(m_time_base);
-                while (!m_frmBuf->push(frmItem)) {
-                    if (m_stop.load(std::memory_order_relaxed)) {
-                        goto end;
-                    }
-                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                recordFrameBytes(frmItem.frm);
+                if (!m_frmBuf->waitPush(std::move(frmItem), m_stop)) {
+                    goto end;
                 }
                 frmItem.frm = nullptr;
             } else {
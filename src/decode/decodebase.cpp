@@ -83,6 +83,7 @@ void DecodeBase::uninit() {
     }
     m_initialized = false;
     m_streamIdx = -1;
+    m_lastFrameBytes.store(0, std::memory_order_relaxed);
     m_pktBuf.reset();
     m_frmBuf.reset();
 }
@@ -92,7 +93,10 @@ void DecodeBase::start() {
         return; // 已经在运行了
     }
     m_stop.store(false, std::memory_order_relaxed);
-    m_thread = std::thread([this]() {
+    // 字幕解码不影响音画同步，放到后台等级
+    const bool subtitle = m_codecCtx->codec_type == AVMEDIA_TYPE_SUBTITLE;
+    const char *name = subtitle ? "AZ-sdec" : (m_codecCtx->codec_type == AVMEDIA_TYPE_VIDEO ? "AZ-vdec" : "AZ-adec");
+    m_thread = TaskExecutor::instance().submit(subtitle ? TaskQoS::Background : TaskQoS::Decode, name, [this]() {
         decodingLoop();
     });
 }
@@ -109,6 +113,21 @@ bool DecodeBase::initialized() const {
     return m_initialized;
 }
 
+int64_t DecodeBase::lastFrameBytes() const {
+    return m_lastFrameBytes.load(std::memory_order_relaxed);
+}
+
+void DecodeBase::recordFrameBytes(const AVFrame *frm) {
+    int64_t bytes = 0;
+    for (const AVBufferRef *buf : frm->buf) {
+        if (buf)
+            bytes += static_cast<int64_t>(buf->size);
+    }
+    for (int i = 0; i < frm->nb_extended_buf; ++i)
+        bytes += static_cast<int64_t>(frm->extended_buf[i]->size);
+    m_lastFrameBytes.store(bytes, std::memory_order_relaxed);
+}
+
 bool DecodeBase::getPkt(AVPktItem &pktItem, bool &needFlushBuffers) {
     // *流ID不同直接丢弃，不用清解码器缓存
 
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "decode/decodesubtitle.h"
+#include "clock/timesource.h"
 // #include "renderer/assrender.h"
 #include <QDebug>
 
@@ -47,7 +48,7 @@ void DecodeSubtitle::decodingLoop() {
     while (!m_stop.load(std::memory_order_relaxed)) {
         bool ok = getPkt(pktItem, needFlushBuffers);
         if (!ok) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            TimeSource::instance().sleepFor(0.005);
             continue;
         }
 
@@ -75,11 +76,8 @@ void DecodeSubtitle::decodingLoop() {
                 frmItem.duration = (sub.end_display_time - sub.start_display_time) / 1000.0;
 
                 if (sub.format == 0) { // 图形字幕
-                    while (!m_frmBuf->push(frmItem)) {
-                        if (m_stop.load(std::memory_order_relaxed)) {
-                            goto end;
-                        }
-                        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                    if (!m_frmBuf->waitPush(std::move(frmItem), m_stop)) {
+                        goto end;
                     }
                 } else {
                     handleTextSub(frmItem);
@@ -3,9 +3,15 @@
 
 #include "decode/decodevideo.h"
 #include "clock/globalclock.h"
+#include "clock/timesource.h"
 #include "stats/playbackstats.h"
+#include "stats/tracer.h"
 #include <QDebug>
 
+namespace {
+    constexpr double kSkipNonRefSpeed = 2.0; // 达到该倍速后不再解码非参考帧
+}
+
 bool DecodeVideo::init(AVStream *stream, sharedPktQueue pktBuf, sharedFrmQueue frmBuf, int threadNum) {
     bool initok = DecodeBase::init(stream, pktBuf, frmBuf, threadNum);
     if (!initok) {
@@ -28,7 +34,7 @@ void DecodeVideo::decodingLoop() {
     while (!m_stop.load(std::memory_order_relaxed)) {
         bool ok = getPkt(pktItem, needFlushBuffers);
         if (!ok) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            TimeSource::instance().sleepFor(0.005);
             continue;
         }
 
@@ -38,8 +44,15 @@ void DecodeVideo::decodingLoop() {
             needFlushBuffers = false;
         }
 
+        // 高倍速时大部分帧都会被丢弃，非参考帧(通常是B帧)干脆不解码
+        m_codecCtx->skip_frame = GlobalClock::instance().speed() >= kSkipNonRefSpeed ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+
         startTime = getRelativeSeconds();
-        int ret = avcodec_send_packet(m_codecCtx, pktItem.pkt);
+        int ret = 0;
+        {
+            AZ_TRACE_SCOPE("vdec.send", pktItem.serial, pktItem.pkt && pktItem.pkt->pts != AV_NOPTS_VALUE ? pktItem.pkt->pts * av_q2d(m_time_base) : INVALID_DOUBLE);
+            ret = avcodec_send_packet(m_codecCtx, pktItem.pkt);
+        }
         sumTime = getRelativeSeconds() - startTime;
 
         if (ret == 0) {
@@ -47,7 +60,7 @@ void DecodeVideo::decodingLoop() {
         } else if (ret == AVERROR_EOF) {
             av_packet_free(&pktItem.pkt);
             m_isEOF = true;
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            TimeSource::instance().sleepFor(0.01);
             continue;
         } else if (ret == AVERROR(EAGAIN)) {
             // nothing
@@ -63,7 +76,11 @@ void DecodeVideo::decodingLoop() {
             frmItem.serial = pktItem.serial;
 
             startTime = getRelativeSeconds();
-            ret = avcodec_receive_frame(m_codecCtx, frmItem.frm);
+            {
+                AZ_TRACE_SCOPE_NAMED(traceReceive, "vdec.receive", frmItem.serial, INVALID_DOUBLE);
+                ret = avcodec_receive_frame(m_codecCtx, frmItem.frm);
+                AZ_TRACE_SET_FRAME(traceReceive, frmItem.serial, ret == 0 && frmItem.frm->best_effort_timestamp != AV_NOPTS_VALUE ? frmItem.frm->best_effort_timestamp * av_q2d(m_time_base) : INVALID_DOUBLE);
+            }
             sumTime += getRelativeSeconds() - startTime;
 
             // 完全消耗完解码后的帧
@@ -78,11 +95,9 @@ void DecodeVideo::decodingLoop() {
                 int64_t raw_pts = (frmItem.frm->best_effort_timestamp == AV_NOPTS_VALUE) ? frmItem.frm->pts : frmItem.frm->best_effort_timestamp;
                 frmItem.pts = (raw_pts != AV_NOPTS_VALUE) ? raw_pts * timeBase : INVALID_DOUBLE;
                 frmItem.duration = frmItem.frm->duration * timeBase;
-                while (!m_frmBuf->push(frmItem)) {
-                    if (m_stop.load(std::memory_order_relaxed)) {
-                        goto end;
-                    }
-                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                recordFrameBytes(frmItem.frm);
+                if (!m_frmBuf->waitPush(std::move(frmItem), m_stop)) {
+                    goto end;
                 }
                 frmItem.frm = nullptr;
             } else {
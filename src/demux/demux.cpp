@@ -3,13 +3,20 @@
 
 #include "demux/demux.h"
 #include "clock/globalclock.h"
+#include "clock/timesource.h"
 #include "renderer/assrender.h"
 #include "stats/playbackstats.h"
+#include "stats/tracer.h"
 #include <QDebug>
+#include <algorithm>
 
 namespace {
     static char _infoBuf[512];
 
+    constexpr double kAudioCacheKeepSec = 2.0; // 音频缓存保留到主时钟之前多少秒
+    constexpr size_t kAudioCacheMaxPkts = 4096; // 单个音频流最多缓存的包数
+    constexpr double kSubScanBackSec = 15.0;    // seek 到索引之外时，从目标之前多少秒开始扫描字幕包
+
     QString getStringInfo(AVStream *st) {
         const AVDictionaryEntry *lang = av_dict_get(st->metadata, "language", NULL, 0);
         QString str = lang ? QString("(%1), ").arg(lang->value) : "";
@@ -30,6 +37,17 @@ namespace {
         str += QString(" %1").arg(_infoBuf);
         return str;
     }
+
+    // 后台打开字幕索引上下文时的中断条件
+    struct SubOpenState {
+        const std::atomic<bool> *abort;
+        int64_t deadline; // us
+    };
+
+    int subOpenInterrupt(void *opaque) {
+        const SubOpenState *state = static_cast<const SubOpenState *>(opaque);
+        return state->abort->load(std::memory_order_relaxed) || av_gettime_relative() > state->deadline;
+    }
 }
 
 Demux::Demux(QObject *parent)
@@ -108,6 +126,22 @@ void Demux::uninit() {
 
     m_chaptersInfo.clear();
 
+    m_subFetchAbort.store(true, std::memory_order_relaxed);
+    if (m_subFetchOpen.joinable()) {
+        m_subFetchOpen.join();
+    }
+    m_subFetchReady.store(false, std::memory_order_relaxed);
+    if (m_subFetchCtx) {
+        avformat_close_input(&m_subFetchCtx);
+    }
+    m_subPktIndex.clear();
+    m_subRecoveredIdx = -1;
+    m_subRecoveredPts = AV_NOPTS_VALUE;
+    m_subIndexedSpans.clear();
+    m_readSpanBegin = m_readSpanEnd = INVALID_DOUBLE;
+    clearAudioPktCache();
+    m_audioCacheFlushIdx.store(-1, std::memory_order_relaxed);
+
     m_usedVIdx.store(-1, std::memory_order_relaxed);
     m_usedAIdx.store(-1, std::memory_order_relaxed);
     m_usedSIdx.store(-1, std::memory_order_relaxed);
@@ -127,7 +161,7 @@ void Demux::start() {
         return; // 已经在运行了
     }
     m_stop.store(false, std::memory_order_relaxed);
-    m_thread = std::thread([this]() {
+    m_thread = TaskExecutor::instance().submit(TaskQoS::Background, "AZ-demux", [this]() {
         demuxLoop();
     });
 }
@@ -169,7 +203,20 @@ bool Demux::switchSubtitleStream(int streamIdx, weakPktQueue wpq, weakFrmQueue w
         return true;
     }
 
-    return switchStream(MediaType::Subtitle, streamIdx, wpq, wfq);
+    if (!switchStream(MediaType::Subtitle, streamIdx, wpq, wfq))
+        return false;
+
+    // 图形字幕 seek 后要按索引取回正在显示的包，提前在后台打开取包用的上下文，不阻塞解复用线程
+    const AVCodecDescriptor *desc = avcodec_descriptor_get(m_formatCtx->streams[m_subtitleIdx[streamIdx]]->codecpar->codec_id);
+    if (desc && (desc->props & AV_CODEC_PROP_BITMAP_SUB))
+        openSubFetchCtxAsync();
+    return true;
+}
+
+bool Demux::setSecondarySubtitleStream(int streamIdx) {
+    if (streamIdx >= static_cast<int>(m_subtitleIdx.size())) return false;
+    // 副字幕完全由ASSRender渲染，不需要解复用线程参与
+    return ASSRender::instance().setSecondaryTrack(m_URL, streamIdx < 0 ? -1 : m_subtitleIdx[streamIdx]);
 }
 
 bool Demux::switchAudioStream(int streamIdx, weakPktQueue wpq, weakFrmQueue wfq) {
@@ -177,6 +224,13 @@ bool Demux::switchAudioStream(int streamIdx, weakPktQueue wpq, weakFrmQueue wfq)
     return switchStream(MediaType::Audio, streamIdx, wpq, wfq);
 }
 
+void Demux::setPreloadAudioTracks(bool preload) {
+    m_preloadAudio.store(preload, std::memory_order_relaxed);
+    if (!preload) {
+        clearAudioPktCache();
+    }
+}
+
 void Demux::closeStream(MediaType type) {
     {
         std::lock_guard<std::mutex> mtx(m_mutex);
@@ -301,12 +355,20 @@ void Demux::demuxLoop() {
             if (ret < 0) {
                 qDebug() << "seek出错";
             }
+            closeReadSpan();
+            recoverSubtitleState(m_seekTs);
+            clearAudioPktCache();
             emitRealSeekTs = m_isMainDemux;
             m_needSeek.store(false, std::memory_order_release);
         }
 
         pkt = av_packet_alloc();
-        int ret = av_read_frame(m_formatCtx, pkt);
+        int ret = 0;
+        {
+            AZ_TRACE_SCOPE_NAMED(traceRead, "demux.read", -1, INVALID_DOUBLE);
+            ret = av_read_frame(m_formatCtx, pkt);
+            AZ_TRACE_SET_FRAME(traceRead, -1, ret == 0 && pkt->pts != AV_NOPTS_VALUE ? pkt->pts * av_q2d(m_formatCtx->streams[pkt->stream_index]->time_base) : INVALID_DOUBLE);
+        }
         if (ret < 0) {
             if (ret == AVERROR_EOF && !m_isEOF) { // EOF
                 Q_ASSERT(pkt->data == NULL && pkt->size == 0);
@@ -322,7 +384,8 @@ void Demux::demuxLoop() {
                 qDebug() << "解复用出错";
                 goto end;
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            routeAudioPkt(nullptr); // EOF 后切换音频流也要推送缓存
+            TimeSource::instance().sleepFor(0.01);
             continue;
         } else {
             m_isEOF = false;
@@ -334,17 +397,23 @@ void Demux::demuxLoop() {
             // 提前设置一下时钟，能比较好的避免出现视频pts先更新且落后与音频，导致视频疯狂更新，然后音频再更新，导致视频领先与音频，最后导致视频变卡一会儿
             GlobalClock::instance().setAudioClk(seekedPts);
             GlobalClock::instance().setVideoClk(seekedPts);
+            GlobalClock::instance().setExternalClk(seekedPts);
             emit seeked(seekedPts);
             emitRealSeekTs = false;
         }
 
         // ret == 0
-        if (pkt->stream_index == m_usedAIdx.load(std::memory_order_acquire)) {
-            pushAudioPkt(pkt);
+        indexSubtitlePkt(pkt);
+        if (m_formatCtx->streams[pkt->stream_index]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
+            routeAudioPkt(pkt);
         } else if (pkt->stream_index == m_usedVIdx.load(std::memory_order_acquire)) {
             pushVideoPkt(pkt);
         } else if (pkt->stream_index == m_usedSIdx.load(std::memory_order_acquire)) {
-            pushSubtitlePkt(pkt);
+            if (pkt->stream_index == m_subRecoveredIdx && pkt->pts != AV_NOPTS_VALUE && pkt->pts <= m_subRecoveredPts) {
+                av_packet_free(&pkt); // seek 时已经通过索引取回
+            } else {
+                pushSubtitlePkt(pkt);
+            }
         } else {
             av_packet_free(&pkt);
         }
@@ -378,11 +447,397 @@ void Demux::pushPkt(const weakPktQueue &wq, AVPacket *pkt) {
             av_packet_free(&pkt);
             return;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        TimeSource::instance().sleepFor(0.005);
     }
     av_packet_free(&pkt);
 }
 
+void Demux::routeAudioPkt(AVPacket *pkt) {
+    // 未开启缓存且没有待推送的缓存时直接分发，不加锁
+    if (!m_preloadAudio.load(std::memory_order_relaxed) && m_audioCacheFlushIdx.load(std::memory_order_relaxed) < 0) {
+        if (pkt && pkt->stream_index == m_usedAIdx.load(std::memory_order_acquire)) {
+            pushAudioPkt(pkt);
+        } else if (pkt) {
+            av_packet_free(&pkt);
+        }
+        return;
+    }
+
+    // 缓存、当前流ID和待推送的流ID必须在同一把锁下读取，否则切换瞬间的包可能乱序或重复
+    std::vector<AVPacket *> flushPkts;
+    int usedIdx;
+    bool flushedCurrent = false; // 当前包已经包含在推送的缓存中
+    {
+        std::lock_guard<std::mutex> mtx(m_mutex);
+        usedIdx = m_usedAIdx.load(std::memory_order_relaxed);
+        const bool cached = pkt && cacheAudioPkt(pkt);
+        const int flushIdx = m_audioCacheFlushIdx.exchange(-1, std::memory_order_relaxed);
+        if (flushIdx >= 0 && flushIdx == usedIdx) {
+            collectCachedAudioPkts(flushIdx, flushPkts);
+            flushedCurrent = cached && pkt->stream_index == flushIdx;
+        }
+    }
+
+    for (AVPacket *p : flushPkts) {
+        pushAudioPkt(p);
+    }
+    if (!pkt)
+        return;
+    if (pkt->stream_index == usedIdx && !flushedCurrent) {
+        pushAudioPkt(pkt);
+    } else {
+        av_packet_free(&pkt);
+    }
+}
+
+bool Demux::cacheAudioPkt(const AVPacket *pkt) {
+    if (!m_preloadAudio.load(std::memory_order_relaxed) || pkt->pts == AV_NOPTS_VALUE)
+        return false;
+    AVPacket *ref = av_packet_clone(pkt); // 只增加引用计数，不拷贝数据
+    if (!ref)
+        return false;
+
+    const AVStream *st = m_formatCtx->streams[pkt->stream_index];
+    const double mainPts = GlobalClock::instance().getMainPts();
+    const int64_t minPts = std::isnan(mainPts) ? INT64_MIN : static_cast<int64_t>((mainPts - kAudioCacheKeepSec) / av_q2d(st->time_base));
+
+    auto &cache = m_audioPktCache[pkt->stream_index];
+    cache.push_back(ref);
+    while (!cache.empty() && (cache.size() > kAudioCacheMaxPkts || cache.front()->pts < minPts)) {
+        av_packet_free(&cache.front());
+        cache.pop_front();
+    }
+    return true;
+}
+
+void Demux::collectCachedAudioPkts(int streamIdx, std::vector<AVPacket *> &out) {
+    auto it = m_audioPktCache.find(streamIdx);
+    if (it == m_audioPktCache.end() || it->second.empty())
+        return;
+
+    // 从主时钟所在的包开始解码，更早的已经播放过了
+    const auto &cache = it->second;
+    const double mainPts = GlobalClock::instance().getMainPts();
+    size_t begin = 0;
+    if (!std::isnan(mainPts)) {
+        const int64_t target = static_cast<int64_t>(mainPts / av_q2d(m_formatCtx->streams[streamIdx]->time_base));
+        for (size_t i = cache.size(); i-- > 0;) {
+            if (cache[i]->pts <= target) {
+                begin = i;
+                break;
+            }
+        }
+    }
+
+    out.reserve(cache.size() - begin);
+    for (size_t i = begin; i < cache.size(); ++i) {
+        if (AVPacket *p = av_packet_clone(cache[i]))
+            out.push_back(p);
+    }
+}
+
+bool Demux::audioCacheCovers(int streamIdx, double pts) {
+    if (!m_preloadAudio.load(std::memory_order_relaxed) || std::isnan(pts))
+        return false;
+    std::lock_guard<std::mutex> mtx(m_mutex);
+    auto it = m_audioPktCache.find(streamIdx);
+    if (it == m_audioPktCache.end() || it->second.empty())
+        return false;
+    const double tb = av_q2d(m_formatCtx->streams[streamIdx]->time_base);
+    return it->second.front()->pts * tb <= pts && it->second.back()->pts * tb >= pts;
+}
+
+void Demux::clearAudioPktCache() {
+    std::lock_guard<std::mutex> mtx(m_mutex);
+    for (auto &[idx, cache] : m_audioPktCache) {
+        for (AVPacket *p : cache) {
+            av_packet_free(&p);
+        }
+    }
+    m_audioPktCache.clear();
+}
+
+void Demux::indexSubtitlePkt(const AVPacket *pkt) {
+    if (pkt->pts == AV_NOPTS_VALUE)
+        return;
+    const AVStream *st = m_formatCtx->streams[pkt->stream_index];
+    const double pts = pkt->pts * av_q2d(st->time_base);
+    if (std::isnan(m_readSpanBegin)) {
+        m_readSpanBegin = m_readSpanEnd = pts;
+    } else {
+        m_readSpanEnd = std::max(m_readSpanEnd, pts);
+    }
+
+    if (st->codecpar->codec_type != AVMEDIA_TYPE_SUBTITLE || pkt->size <= 0)
+        return;
+    // 所有字幕流的包本来就会被读出，顺便记录下来，切换字幕流时也能用上
+    m_subPktIndex[pkt->stream_index].add(pkt->pts, pkt->duration, pkt->pos);
+}
+
+void Demux::closeReadSpan() {
+    // 字幕包与音视频包交错存放，两端各留一点余量，只算确定已经读过的部分
+    constexpr double kInterleaveSlackSec = 1.0;
+    if (!std::isnan(m_readSpanBegin)) {
+        addIndexedSpan(m_readSpanBegin + kInterleaveSlackSec, m_readSpanEnd - kInterleaveSlackSec);
+    }
+    m_readSpanBegin = m_readSpanEnd = INVALID_DOUBLE;
+}
+
+void Demux::addIndexedSpan(double begin, double end) {
+    if (!(begin < end))
+        return;
+    // 合并所有与 [begin, end] 相交的时间段
+    auto first = std::lower_bound(m_subIndexedSpans.begin(), m_subIndexedSpans.end(), begin, [](const std::pair<double, double> &span, double v) {
+        return span.second < v;
+    });
+    auto last = first;
+    while (last != m_subIndexedSpans.end() && last->first <= end) {
+        begin = std::min(begin, last->first);
+        end = std::max(end, last->second);
+        ++last;
+    }
+    first = m_subIndexedSpans.erase(first, last);
+    m_subIndexedSpans.insert(first, {begin, end});
+}
+
+double Demux::indexedSpanBegin(double ts) const {
+    auto it = std::lower_bound(m_subIndexedSpans.begin(), m_subIndexedSpans.end(), ts, [](const std::pair<double, double> &span, double v) {
+        return span.second < v;
+    });
+    return (it != m_subIndexedSpans.end() && it->first <= ts) ? it->first : INVALID_DOUBLE;
+}
+
+void Demux::recoverSubtitleState(double ts) {
+    m_subRecoveredIdx = -1;
+    m_subRecoveredPts = AV_NOPTS_VALUE;
+
+    const int streamIdx = m_usedSIdx.load(std::memory_order_acquire);
+    if (streamIdx < 0 || std::isnan(ts))
+        return;
+
+    // 文本字幕由ASSRender整体解析，不受seek影响，只处理图形字幕
+    const AVStream *st = m_formatCtx->streams[streamIdx];
+    const AVCodecDescriptor *desc = avcodec_descriptor_get(st->codecpar->codec_id);
+    if (!desc || !(desc->props & AV_CODEC_PROP_BITMAP_SUB))
+        return;
+
+    // 上下文还在后台打开(或打开失败)时这次 seek 不恢复
+    if (!m_subFetchReady.load(std::memory_order_acquire))
+        return;
+
+    const double timeBase = av_q2d(st->time_base);
+    SubtitlePacketIndex &index = m_subPktIndex[streamIdx];
+    std::vector<AVPacket *> pkts;
+
+    // ts 在读过的时间段内且该时间段里有 ts 之前的包时，索引中的结果是完整的，按索引逐个取回
+    // 否则(通常是向前 seek 到还没播放过的位置)扫描 ts 之前的一段
+    const double spanBegin = indexedSpanBegin(ts);
+    const std::vector<SubtitlePacketIndex::Entry> entries = index.activeAt(static_cast<int64_t>(ts / timeBase));
+    if (!std::isnan(spanBegin) && !entries.empty() && entries.back().pts * timeBase >= spanBegin) {
+        for (const auto &e : entries) {
+            if (AVPacket *pkt = fetchSubtitlePkt(streamIdx, e)) {
+                pkts.push_back(pkt);
+            }
+        }
+    } else if (std::isnan(spanBegin) || ts - spanBegin < kSubScanBackSec) {
+        pkts = scanSubtitlePkts(streamIdx, ts);
+    }
+
+    for (AVPacket *pkt : pkts) {
+        m_subRecoveredIdx = streamIdx;
+        m_subRecoveredPts = std::max(m_subRecoveredPts, pkt->pts);
+        pushSubtitlePkt(pkt);
+    }
+}
+
+void Demux::openSubFetchCtxAsync() {
+    if (m_subFetchReady.load(std::memory_order_acquire) || m_subFetchOpening.load(std::memory_order_acquire))
+        return;
+    if (m_subFetchOpen.joinable())
+        m_subFetchOpen.join(); // 上一次打开失败，任务已经结束
+
+    m_subFetchOpening.store(true, std::memory_order_relaxed);
+    m_subFetchAbort.store(false, std::memory_order_relaxed);
+    m_subFetchOpen = TaskExecutor::instance().submit(TaskQoS::Background, "AZ-subfetch", [this, url = m_URL, nbStreams = m_formatCtx->nb_streams]() {
+        AVFormatContext *ctx = openSubFetchCtx(url, nbStreams);
+        if (ctx) {
+            // 之后由解复用线程取包，中断条件换成解复用线程的
+            ctx->interrupt_callback.callback = &Demux::subFetchInterrupt;
+            ctx->interrupt_callback.opaque = this;
+            m_subFetchCtx = ctx;
+            m_subFetchReady.store(true, std::memory_order_release);
+        }
+        m_subFetchOpening.store(false, std::memory_order_release);
+    });
+}
+
+AVFormatContext *Demux::openSubFetchCtx(const std::string &url, unsigned int nbStreams) {
+    AVFormatContext *ctx = avformat_alloc_context();
+    if (!ctx)
+        return nullptr;
+
+    constexpr int64_t kOpenTimeoutUs = 10000000; // 在后台打开，网络流可以多等一会
+    SubOpenState state{&m_subFetchAbort, av_gettime_relative() + kOpenTimeoutUs};
+    ctx->interrupt_callback.callback = &subOpenInterrupt;
+    ctx->interrupt_callback.opaque = &state;
+
+    char err[AV_ERROR_MAX_STRING_SIZE];
+    int ret = avformat_open_input(&ctx, url.c_str(), nullptr, nullptr); // 失败时会释放ctx
+    if (ret != 0) {
+        av_strerror(ret, err, sizeof(err));
+        qDebug() << "字幕索引上下文打开失败:" << err;
+        return nullptr;
+    }
+    // 部分格式(如TS)需要探测后才能得到全部流，流ID必须和主上下文一致
+    if (ctx->nb_streams != nbStreams) {
+        ret = avformat_find_stream_info(ctx, nullptr);
+    }
+    if (ret < 0 || ctx->nb_streams != nbStreams) {
+        qDebug() << "字幕索引上下文的流与主上下文不一致";
+        avformat_close_input(&ctx);
+        return nullptr;
+    }
+    return ctx;
+}
+
+void Demux::selectSubFetchStream(int streamIdx) {
+    for (unsigned int i = 0; i < m_subFetchCtx->nb_streams; ++i) {
+        m_subFetchCtx->streams[i]->discard = (static_cast<int>(i) == streamIdx) ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+    }
+}
+
+AVPacket *Demux::fetchSubtitlePkt(int streamIdx, const SubtitlePacketIndex::Entry &e) {
+    constexpr int64_t kFetchTimeoutUs = 200000; // 单个包最多花费的时间，避免seek卡顿
+    constexpr int kMaxReadPkts = 32;            // 最多读取的字幕包个数
+
+    selectSubFetchStream(streamIdx);
+
+    AVPacket *pkt = av_packet_alloc();
+    if (!pkt)
+        return nullptr;
+
+    // 优先按字节偏移定位，失败或没读到再按时间定位
+    const bool canByteSeek = e.pos >= 0 && !(m_subFetchCtx->iformat->flags & AVFMT_NO_BYTE_SEEK);
+    for (int attempt = canByteSeek ? 0 : 1; attempt < 2; ++attempt) {
+        m_subFetchDeadline = av_gettime_relative() + kFetchTimeoutUs;
+        int ret;
+        if (attempt == 0) {
+            ret = avformat_seek_file(m_subFetchCtx, -1, e.pos, e.pos, e.pos, AVSEEK_FLAG_BYTE);
+        } else {
+            const AVStream *st = m_subFetchCtx->streams[streamIdx];
+            const int64_t target = av_rescale_q(e.pts, st->time_base, AV_TIME_BASE_Q);
+            ret = avformat_seek_file(m_subFetchCtx, -1, INT64_MIN, target, target, 0);
+        }
+        if (ret < 0)
+            continue;
+
+        for (int n = 0; n < kMaxReadPkts; ++n) {
+            if (av_read_frame(m_subFetchCtx, pkt) < 0)
+                break;
+            // 同一 pts 可能有多个包(PGS 显示集)，位置已知时按位置区分
+            if (pkt->stream_index == streamIdx && pkt->pts == e.pts && (e.pos < 0 || pkt->pos < 0 || pkt->pos == e.pos))
+                return pkt;
+            const bool passed = pkt->stream_index == streamIdx && pkt->pts != AV_NOPTS_VALUE && pkt->pts > e.pts;
+            av_packet_unref(pkt);
+            if (passed)
+                break;
+        }
+    }
+
+    qDebug() << "未能取回字幕包, pts:" << e.pts;
+    av_packet_free(&pkt);
+    return nullptr;
+}
+
+std::vector<AVPacket *> Demux::scanSubtitlePkts(int streamIdx, double ts) {
+    constexpr int64_t kScanTimeoutUs = 300000; // 整个扫描最多花费的时间，超时放弃，避免seek卡顿
+    constexpr int kMaxScanPkts = 1024;         // 最多读取的字幕包个数
+    constexpr size_t kMaxActivePkts = 8;       // 与 SubtitlePacketIndex::activeAt 的默认上限一致
+
+    selectSubFetchStream(streamIdx);
+
+    const AVStream *st = m_subFetchCtx->streams[streamIdx];
+    const int64_t target = static_cast<int64_t>(ts / av_q2d(st->time_base));
+    const double scanFrom = std::max(0.0, ts - kSubScanBackSec);
+    const int64_t from = static_cast<int64_t>(scanFrom * AV_TIME_BASE);
+
+    std::vector<AVPacket *> active; // 与 activeAt 的规则相同：最后一个 pts 的所有包，以及时长已知且覆盖 ts 的包
+    auto freeAll = [](std::vector<AVPacket *> &v) {
+        for (AVPacket *p : v) {
+            av_packet_free(&p);
+        }
+        v.clear();
+    };
+
+    m_subFetchDeadline = av_gettime_relative() + kScanTimeoutUs;
+    if (avformat_seek_file(m_subFetchCtx, -1, INT64_MIN, from, from, 0) < 0) {
+        qDebug() << "字幕扫描seek失败, ts:" << ts;
+        return active;
+    }
+
+    SubtitlePacketIndex &index = m_subPktIndex[streamIdx];
+    bool finished = false; // 读到了 ts 之后的包或文件末尾，扫描范围内的包都已记入索引
+    AVPacket *pkt = av_packet_alloc();
+    for (int n = 0; pkt && n < kMaxScanPkts; ++n) {
+        const int ret = av_read_frame(m_subFetchCtx, pkt);
+        if (ret < 0) {
+            finished = ret == AVERROR_EOF;
+            break;
+        }
+        if (pkt->stream_index != streamIdx || pkt->pts == AV_NOPTS_VALUE || pkt->size <= 0) {
+            av_packet_unref(pkt);
+            continue;
+        }
+        if (pkt->pts > target) {
+            finished = true;
+            break;
+        }
+        index.add(pkt->pts, pkt->duration, pkt->pos);
+
+        // 新的 pts 出现时，之前的包只保留时长已知且覆盖 ts 的
+        if (!active.empty() && active.back()->pts != pkt->pts) {
+            auto keep = std::remove_if(active.begin(), active.end(), [target](AVPacket *p) {
+                if (p->duration > 0 && p->pts + p->duration > target)
+                    return false;
+                av_packet_free(&p);
+                return true;
+            });
+            active.erase(keep, active.end());
+        }
+        if (AVPacket *copy = av_packet_clone(pkt)) {
+            active.push_back(copy);
+        }
+        av_packet_unref(pkt);
+        if (active.size() > kMaxActivePkts) {
+            av_packet_free(&active.front());
+            active.erase(active.begin());
+        }
+    }
+    av_packet_free(&pkt);
+
+    if (!finished) {
+        qDebug() << "字幕扫描未完成, ts:" << ts;
+        freeAll(active);
+        return active;
+    }
+    addIndexedSpan(scanFrom, ts);
+
+    // 最后一个 pts 的包即使时长未知也决定当前画面；时长已知且已结束的不需要
+    auto keep = std::remove_if(active.begin(), active.end(), [target](AVPacket *p) {
+        if (p->duration <= 0 || p->pts + p->duration > target)
+            return false;
+        av_packet_free(&p);
+        return true;
+    });
+    active.erase(keep, active.end());
+    return active;
+}
+
+int Demux::subFetchInterrupt(void *opaque) {
+    const Demux *self = static_cast<const Demux *>(opaque);
+    return self->m_stop.load(std::memory_order_relaxed) || av_gettime_relative() > self->m_subFetchDeadline;
+}
+
 void Demux::fillStreamInfo() {
     // Video
     // MAYBE:
@@ -460,11 +915,21 @@ bool Demux::switchStream(MediaType type, int streamIdx, weakPktQueue wpq, weakFr
 
     Q_ASSERT(streamIdx < static_cast<int>(idxVec->size()));
 
+    // 缓存中有新音频流在主时钟处的包时，直接从缓存开始解码，不需要seek
+    const bool fromCache = type == MediaType::Audio && !m_stop.load(std::memory_order_relaxed) &&
+                           audioCacheCovers((*idxVec)[streamIdx], GlobalClock::instance().getMainPts());
+
     // 更新队列和当前流
     {
         std::lock_guard<std::mutex> mtx(m_mutex);
         *pktBuf = wpq, *frmBuf = wfq;
         usedIdx->store((*idxVec)[streamIdx], std::memory_order_release);
+        if (fromCache)
+            m_audioCacheFlushIdx.store((*idxVec)[streamIdx], std::memory_order_relaxed);
+    }
+    if (fromCache) {
+        qDebug() << "从缓存切换音频流:" << (*idxVec)[streamIdx];
+        return true;
     }
 
     int ret = 0;
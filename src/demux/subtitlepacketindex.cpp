@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "demux/subtitlepacketindex.h"
+#include <algorithm>
+#include <iterator>
+
+void SubtitlePacketIndex::clear() {
+    m_entries.clear();
+}
+
+void SubtitlePacketIndex::add(int64_t pts, int64_t duration, int64_t pos) {
+    const Entry entry{pts, duration, pos};
+    // 顺序播放时总是追加到末尾，只有 seek 回之前未播放过的位置才需要插入
+    if (m_entries.empty() || less(m_entries.back(), entry)) {
+        m_entries.push_back(entry);
+        return;
+    }
+
+    auto it = std::lower_bound(m_entries.begin(), m_entries.end(), entry, &SubtitlePacketIndex::less);
+    if (it != m_entries.end() && it->pts == pts && it->pos == pos) {
+        return; // 已经记录过
+    }
+    m_entries.insert(it, entry);
+}
+
+std::vector<SubtitlePacketIndex::Entry> SubtitlePacketIndex::activeAt(int64_t ts, size_t maxCount) const {
+    std::vector<Entry> result;
+    // 第一个 pts > ts 的包
+    auto it = std::upper_bound(m_entries.begin(), m_entries.end(), ts, [](int64_t v, const Entry &e) {
+        return v < e.pts;
+    });
+    if (it == m_entries.begin() || maxCount == 0) {
+        return result;
+    }
+
+    // ts 之前最后一个 pts 的包：时长未知时由它决定当前画面(可能是清屏包，解码后为空字幕)
+    // PGS 的显示集(PCS/WDS/PDS/ODS/END)各是一个包且 pts 相同，必须全部取回
+    --it;
+    const int64_t lastPts = it->pts;
+    while (true) {
+        if (it->duration <= 0 || it->pts + it->duration > ts) {
+            result.push_back(*it);
+        }
+        if (it == m_entries.begin() || std::prev(it)->pts != lastPts)
+            break;
+        --it;
+    }
+
+    // 更早的包只在时长已知且仍覆盖 ts 时才需要(DVB 等可能同时显示多个区域)，只向前查找有限个
+    constexpr size_t kMaxLookback = 64;
+    for (size_t n = 0; it != m_entries.begin() && n < kMaxLookback && result.size() < maxCount; ++n) {
+        --it;
+        if (it->duration > 0 && it->pts + it->duration > ts) {
+            result.push_back(*it);
+        }
+    }
+
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+size_t SubtitlePacketIndex::size() const {
+    return m_entries.size();
+}
+
+bool SubtitlePacketIndex::empty() const {
+    return m_entries.empty();
+}
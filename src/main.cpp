@@ -24,8 +24,10 @@ public:
 #endif
 
 #include "controller/mediacontroller.h"
+#include "renderer/assrender.h"
 #include "renderer/videorenderer.h"
 #include "stats/playbackstats.h"
+#include "stats/tracer.h"
 #include "utils/filehelper.h"
 #include "utils/powermanager.h"
 
@@ -45,6 +47,13 @@ int main(int argc, char *argv[]) {
     app.setApplicationName("AZPlayer");
     QQuickStyle::setStyle("Basic");
 
+    // 设置了 AZPLAYER_TRACE_JSON 时从启动开始追踪，每次关闭文件时写出
+    if (qEnvironmentVariableIsSet("AZPLAYER_TRACE_JSON")) {
+        Tracer::instance().setEnabled(true);
+    }
+
+    ASSRender::instance().warmUp(); // 后台预热字体，避免打开第一个字幕时卡顿
+
     MediaController mc;
     QObject::connect(&mc, &MediaController::pausedChanged, &app, [&mc]() {
         bool shouldKeepAwake = !mc.paused();
@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "renderer/asseventstore.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+void ASSEventStore::clear() {
+    m_arena.clear();
+    m_events.clear();
+    m_maxEnd.clear();
+    m_finalized = true;
+}
+
+void ASSEventStore::shrinkToFit() {
+    m_arena.shrink_to_fit();
+    m_events.shrink_to_fit();
+    m_maxEnd.shrink_to_fit();
+}
+
+bool ASSEventStore::add(const char *data, size_t size, int64_t start, int64_t duration) {
+    if (!data || size == 0 || duration < 0)
+        return false;
+    // 偏移使用 uint32_t 存储，单个轨道的文本不会超过 4GB
+    if (m_arena.size() + size + 1 > std::numeric_limits<uint32_t>::max())
+        return false;
+
+    Event e;
+    e.start = start;
+    e.duration = duration;
+    e.offset = static_cast<uint32_t>(m_arena.size());
+    e.size = static_cast<uint32_t>(size);
+
+    m_arena.insert(m_arena.end(), data, data + size);
+    m_arena.push_back('\0'); // 便于调试时直接当作C字符串查看
+    m_events.push_back(e);
+    m_finalized = false;
+    return true;
+}
+
+void ASSEventStore::finalize() {
+    if (m_finalized)
+        return;
+
+    // 解码顺序基本就是时间顺序，stable_sort 在接近有序时开销很小，并保留同一时刻事件的原始顺序
+    std::stable_sort(m_events.begin(), m_events.end(), [](const Event &a, const Event &b) {
+        return a.start < b.start;
+    });
+
+    m_maxEnd.resize(m_events.size());
+    int64_t maxEnd = std::numeric_limits<int64_t>::min();
+    for (size_t i = 0; i < m_events.size(); ++i) {
+        maxEnd = std::max(maxEnd, m_events[i].start + m_events[i].duration);
+        m_maxEnd[i] = maxEnd;
+    }
+    m_finalized = true;
+}
+
+bool ASSEventStore::finalized() const {
+    return m_finalized;
+}
+
+size_t ASSEventStore::countOverlapping(int64_t begin, int64_t end) const {
+    size_t count = 0;
+    forEachOverlapping(begin, end, [&count](const Event &, const char *) { ++count; });
+    return count;
+}
+
+const char *ASSEventStore::text(const Event &e) const {
+    return m_arena.data() + e.offset;
+}
+
+size_t ASSEventStore::size() const {
+    return m_events.size();
+}
+
+bool ASSEventStore::empty() const {
+    return m_events.empty();
+}
+
+size_t ASSEventStore::textBytes() const {
+    return m_arena.size();
+}
+
+size_t ASSEventStore::memoryUsage() const {
+    return m_arena.capacity() * sizeof(char) + m_events.capacity() * sizeof(Event) + m_maxEnd.capacity() * sizeof(int64_t);
+}
+
+size_t ASSEventStore::firstCandidate(int64_t begin) const {
+    // m_maxEnd 单调不减，二分找到第一个结束时间可能晚于 begin 的位置
+    auto it = std::upper_bound(m_maxEnd.begin(), m_maxEnd.end(), begin);
+    return static_cast<size_t>(it - m_maxEnd.begin());
+}
@@ -2,15 +2,51 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "renderer/assrender.h"
 #include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace {
-    bool isAssFile(const std::string &s) {
-        return QString::fromStdString(s).endsWith(".ass", Qt::CaseInsensitive);
+    // 提交给 libass 的事件窗口，相对当前 pts
+    constexpr int64_t kWindowBehindMs = 5'000;
+    constexpr int64_t kWindowAheadMs = 60'000;
+
+    // 估算一条事件在 libass 中的内存占用: ASS_Event 本体 + 解析后复制的字符串
+    size_t estimateTrackBytes(size_t events, size_t textBytes) {
+        return events * sizeof(ASS_Event) + textBytes;
+    }
+
+    // FNV-1a 64位，用于字体附件去重
+    uint64_t fnv1a64(const uint8_t *data, size_t size) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= data[i];
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    bool isFontAttachment(const AVStream *st) {
+        const AVCodecParameters *par = st->codecpar;
+        if (par->codec_type != AVMEDIA_TYPE_ATTACHMENT || !par->extradata || par->extradata_size <= 0)
+            return false;
+        if (par->codec_id == AV_CODEC_ID_TTF || par->codec_id == AV_CODEC_ID_OTF)
+            return true;
+        // MKV 中字体附件的 mimetype 并不统一，如 application/x-truetype-font、font/otf、application/vnd.ms-opentype
+        const AVDictionaryEntry *mime = av_dict_get(st->metadata, "mimetype", nullptr, 0);
+        return mime && (strstr(mime->value, "font") || strstr(mime->value, "truetype") || strstr(mime->value, "opentype"));
     }
 }
 
 ASSRender::ASSRender(QObject *parent)
-    : QObject{parent} {}
+    : QObject{parent} {
+    // 库与渲染器在整个程序生命周期内只创建一次，切换字幕/文件时只重建轨道
+    m_assLibrary = ass_library_init();
+    if (m_assLibrary)
+        ass_set_extract_fonts(m_assLibrary, 1); // 开启从 ASS 字幕文件中提取内嵌字体的功能
+    else
+        qDebug() << "ASS库初始化失败";
+}
 
 ASSRender &ASSRender::instance() {
     static ASSRender assr;
@@ -18,131 +54,175 @@ ASSRender &ASSRender::instance() {
 }
 
 ASSRender::~ASSRender() {
+    if (m_warmUpThread.joinable())
+        m_warmUpThread.join();
     uninit();
+    ass_renderer_done(m_secondaryRenderer);
+    m_secondaryRenderer = nullptr;
+    ass_renderer_done(m_assRenderer);
+    m_assRenderer = nullptr;
+    ass_library_done(m_assLibrary);
+    m_assLibrary = nullptr;
 }
 
-bool ASSRender::init(const std::string &subFile) { // 通过字幕文件加载
-    uninit();
+void ASSRender::warmUp() {
+    if (m_warmUpStarted.exchange(true, std::memory_order_acq_rel))
+        return;
 
-    m_assLibrary = ass_library_init();
-    if (!m_assLibrary)
-        return false;
+    // 字体提供者(fontconfig/DirectWrite)第一次扫描字体可能需要数秒，放到后台线程中完成
+    m_warmUpThread = TaskExecutor::instance().submit(TaskQoS::Background, "AZ-font-scan", [this]() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_assLibrary)
+            return;
+        m_assRenderer = ass_renderer_init(m_assLibrary);
+        if (!m_assRenderer) {
+            qDebug() << "ASS字幕渲染器创建失败";
+            return;
+        }
+        ass_set_fonts(m_assRenderer, NULL, "sans-serif", ASS_FONTPROVIDER_AUTODETECT, NULL, 1);
 
-    ass_set_extract_fonts(m_assLibrary, 1); // 开启从 ASS 字幕文件中提取内嵌字体的功能
+        // 副字幕渲染器，字体数据库已经更新过，不需要再次扫描
+        m_secondaryRenderer = ass_renderer_init(m_assLibrary);
+        if (m_secondaryRenderer) {
+            ass_set_fonts(m_secondaryRenderer, NULL, "sans-serif", ASS_FONTPROVIDER_AUTODETECT, NULL, 0);
+            ass_set_line_position(m_secondaryRenderer, 100.0); // 未指定位置的字幕显示在顶部，避免与主字幕重叠
+        } else {
+            qDebug() << "ASS副字幕渲染器创建失败";
+        }
+        m_fontsReady.store(true, std::memory_order_release);
+    });
+}
 
-    if (isAssFile(subFile)) {
-        m_track = ass_read_file(m_assLibrary, subFile.c_str(), NULL);
-        if (!m_track)
-            return false;
-        m_initialized.store(true, std::memory_order_relaxed);
-        return true;
-    }
+bool ASSRender::fontsReady() const {
+    return m_fontsReady.load(std::memory_order_acquire);
+}
 
-    // 不是ASS字幕，自动选择一条最佳字幕流
+bool ASSRender::init(const std::string &subFile) { // 通过字幕文件加载
+    // 外挂 .ass/.srt 等字幕文件同样由 libavformat 读取，事件进入事件存储，按窗口提交给 libass
     return init(subFile, -1);
 }
 
 bool ASSRender::init(const std::string &mediaFile, int subStreamIdx) {
-    uninit();
-
-    // init ass
-    m_assLibrary = ass_library_init();
-    if (!m_assLibrary)
-        return false;
+    deactivate();
 
-    ass_set_extract_fonts(m_assLibrary, 1); // 开启从 ASS 字幕文件中提取内嵌字体的功能
-
-    m_track = ass_new_track(m_assLibrary);
-    if (!m_track)
+    if (!m_assLibrary || !parseFile(mediaFile))
         return false;
 
-    // open file
-    AVFormatContext *fmt = nullptr;
-    int ret = avformat_open_input(&fmt, mediaFile.c_str(), nullptr, nullptr);
-    if (ret < 0)
-        goto fail;
-
-    ret = avformat_find_stream_info(fmt, nullptr);
-    if (ret < 0 || subStreamIdx >= static_cast<int>(fmt->nb_streams))
-        goto fail;
-
-    if (subStreamIdx < 0) { // auto
-        subStreamIdx = av_find_best_stream(fmt, AVMEDIA_TYPE_SUBTITLE, -1, -1, nullptr, 0);
-        if (subStreamIdx < 0)
-            goto fail;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Track *t = findTrack(mediaFile, subStreamIdx);
+    if (!t)
+        return false; // 位图字幕或无效的流
+    if (t == m_secondary) { // 同一条轨道不同时作为主副字幕
+        m_secondary = nullptr;
     }
-    if (!initFromDemux(fmt, subStreamIdx))
-        goto fail;
-
-    avformat_close_input(&fmt);
+    m_active = t;
     m_initialized.store(true, std::memory_order_relaxed);
     return true;
-fail:
-    avformat_close_input(&fmt);
-    return false;
+}
+
+void ASSRender::deactivate() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_initialized.store(false, std::memory_order_relaxed);
+    m_active = nullptr;
 }
 
 void ASSRender::uninit() {
+    std::lock_guard<std::mutex> lock(m_mutex);
     m_initialized.store(false, std::memory_order_relaxed);
-    ass_free_track(m_track);
-    m_track = nullptr;
-    ass_renderer_done(m_assRenderer);
-    m_assRenderer = nullptr;
-    ass_library_done(m_assLibrary);
-    m_assLibrary = nullptr;
+    m_active = nullptr;
+    m_secondary = nullptr;
+    m_tracks.clear();
+    m_parsedFiles.clear();
+    m_memoryBytes.store(0, std::memory_order_relaxed);
 }
 
 bool ASSRender::initialized() const {
     return m_initialized.load(std::memory_order_relaxed);
 }
 
+bool ASSRender::setSecondaryTrack(const std::string &mediaFile, int subStreamIdx) {
+    if (subStreamIdx < 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_secondary = nullptr;
+        return true;
+    }
+
+    if (!m_assLibrary || !parseFile(mediaFile))
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Track *t = findTrack(mediaFile, subStreamIdx);
+    if (!t || t == m_active)
+        return false;
+    m_secondary = t;
+    return true;
+}
+
 bool ASSRender::addEvent(const char *data, int size, double startTime, double duration) {
     if (!m_initialized.load(std::memory_order_relaxed))
         return false;
 
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_active)
+        return false;
+
     const long long st = startTime * 1000;
     const long long dur = duration * 1000;
-    ass_process_chunk(m_track, data, size, st, dur);
+    if (!m_active->store.add(data, size, st, dur))
+        return false;
+    m_active->windowBegin = m_active->windowEnd = 0; // 下次渲染时重建窗口
     return true;
 }
 
-const ASS_Image *ASSRender::getASSImage(size_t &size, const QSize &videoSize, double pts) {
-    if (!m_initialized.load(std::memory_order_relaxed)) {
-        size = 0;
-        return nullptr;
-    }
+ASSRender::Frame ASSRender::getASSImage(const QSize &videoSize, double pts) {
+    Frame frame;
+    if (!m_initialized.load(std::memory_order_relaxed))
+        return frame;
 
-    if (!m_assRenderer) { // 初始化渲染器
-        m_assRenderer = ass_renderer_init(m_assLibrary);
-        if (!m_assRenderer) {
-            qDebug() << "ASS字幕渲染器创建失败";
-            size = 0;
-            return nullptr;
+    warmUp(); // 正常情况下程序启动时已经调用过
+    if (!m_fontsReady.load(std::memory_order_acquire))
+        return frame; // 字体还在扫描，暂不显示字幕，避免阻塞视频线程
+
+    // 其他线程正在切换轨道或添加字体时跳过这一帧，保留上一帧的字幕
+    std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        frame.unchanged = true;
+        return frame;
+    }
+    if (!m_active || std::isnan(pts))
+        return frame;
+
+    if (videoSize != m_frameSize) { // 渲染器是长期存在的，视频尺寸变化时需要重新设置
+        m_frameSize = videoSize;
+        for (ASS_Renderer *renderer : {m_assRenderer, m_secondaryRenderer}) {
+            if (!renderer)
+                continue;
+            ass_set_storage_size(renderer, videoSize.width(), videoSize.height());
+            ass_set_frame_size(renderer, videoSize.width(), videoSize.height());
         }
-        // TODO: size不一致是否要重新初始化(在正确调用init与uninit的情况下应该不会出现不一致的问题)
-        ass_set_storage_size(m_assRenderer, videoSize.width(), videoSize.height());
-        ass_set_frame_size(m_assRenderer, videoSize.width(), videoSize.height());
-        ass_set_fonts(m_assRenderer, NULL, "sans-serif", ASS_FONTPROVIDER_AUTODETECT, NULL, 1);
+        updateCacheLimits(m_assRenderer, *m_active, videoSize);
+        if (m_secondary)
+            updateCacheLimits(m_secondaryRenderer, *m_secondary, videoSize);
     }
 
-    const ASS_Image *img = ass_render_frame(m_assRenderer, m_track, (int)(pts * 1000), NULL);
-    const ASS_Image *ptr = img;
+    const long long now = static_cast<long long>(pts * 1000);
+    frame.primary = renderTrack(m_assRenderer, *m_active, now);
+    if (m_secondary && m_secondaryRenderer)
+        frame.secondary = renderTrack(m_secondaryRenderer, *m_secondary, now);
 
     m_dirtyRectManager.init();
-    while (ptr) {
-        m_dirtyRectManager.addRect(QRect(ptr->dst_x, ptr->dst_y, ptr->w, ptr->h));
-        ptr = ptr->next;
-    }
+    addDirtyRects(frame.primary);
+    addDirtyRects(frame.secondary);
 
-    size = m_dirtyRectManager.size();
-    return img;
+    frame.size = m_dirtyRectManager.size();
+    return frame;
 }
 
-void ASSRender::renderFrame(std::vector<std::vector<uint8_t>> &dataArr, std::vector<QRect> &rects, const ASS_Image *assImg) {
+void ASSRender::renderFrame(std::vector<std::vector<uint8_t>> &dataArr, std::vector<QRect> &rects, const Frame &frame) {
     if (!m_initialized.load(std::memory_order_relaxed))
         return;
 
-    if (m_dirtyRectManager.size() <= 0 || assImg == nullptr) {
+    if (frame.size == 0 || m_dirtyRectManager.size() <= 0 || (frame.primary == nullptr && frame.secondary == nullptr)) {
         return;
     }
 
@@ -156,9 +236,11 @@ void ASSRender::renderFrame(std::vector<std::vector<uint8_t>> &dataArr, std::vec
         dataArr[i].assign(rect.width() * rect.height() * 4, 0);
     }
 
-    while (assImg) {
-        blendSingleOnly(dataArr, assImg);
-        assImg = assImg->next;
+    for (const ASS_Image *img : {frame.primary, frame.secondary}) {
+        while (img) {
+            blendSingleOnly(m_dirtyRectManager, dataArr, img);
+            img = img->next;
+        }
     }
 
     for (auto &buffer : dataArr) {
@@ -166,48 +248,92 @@ void ASSRender::renderFrame(std::vector<std::vector<uint8_t>> &dataArr, std::vec
     }
 }
 
-bool ASSRender::initFromDemux(AVFormatContext *fmt, int subStreamIdx) {
-    int ret;
-    AVStream *st = fmt->streams[subStreamIdx];
-    const AVCodecDescriptor *dec_desc = nullptr;
-    AVCodecContext *dec_ctx = nullptr;
-    AVPacket pkt;
-
-    const AVCodec *dec = avcodec_find_decoder(st->codecpar->codec_id);
-    if (!dec)
-        goto fail;
+size_t ASSRender::memoryUsage() const {
+    return m_memoryBytes.load(std::memory_order_relaxed);
+}
 
-    dec_desc = avcodec_descriptor_get(st->codecpar->codec_id);
-    if (dec_desc && !(dec_desc->props & AV_CODEC_PROP_TEXT_SUB))
-        goto fail;
+bool ASSRender::parseFile(const std::string &mediaFile) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_parsedFiles.count(mediaFile))
+            return true; // 已解析，直接使用
+    }
 
-    dec_ctx = avcodec_alloc_context3(dec);
-    if (!dec_ctx)
-        goto fail;
+    struct Decoder {
+        AVCodecContext *ctx{nullptr};
+        std::unique_ptr<Track> track;
+    };
+    std::map<int, Decoder> decoders; // 流ID -> 解码器
+    int bestIdx = -1;
+    AVPacket *pkt = nullptr;
+    size_t events = 0, textBytes = 0;
 
-    ret = avcodec_parameters_to_context(dec_ctx, st->codecpar);
+    // open file
+    AVFormatContext *fmt = nullptr;
+    int ret = avformat_open_input(&fmt, mediaFile.c_str(), nullptr, nullptr);
     if (ret < 0)
         goto fail;
 
-    dec_ctx->pkt_timebase = st->time_base;
-    ret = avcodec_open2(dec_ctx, nullptr, nullptr);
+    ret = avformat_find_stream_info(fmt, nullptr);
     if (ret < 0)
         goto fail;
 
-    if (dec_ctx->subtitle_header) {
-        ass_process_codec_private(m_track,
-                                  reinterpret_cast<const char *>(dec_ctx->subtitle_header),
-                                  dec_ctx->subtitle_header_size);
-    }
-    // MAYBE: else goto fail?
+    bestIdx = av_find_best_stream(fmt, AVMEDIA_TYPE_SUBTITLE, -1, -1, nullptr, 0);
+    addFontAttachments(fmt);
+
+    // 为每一条文本字幕流准备解码器与轨道，其余的流直接丢弃
+    for (unsigned int i = 0; i < fmt->nb_streams; ++i) {
+        AVStream *st = fmt->streams[i];
+        st->discard = AVDISCARD_ALL;
+        if (st->codecpar->codec_type != AVMEDIA_TYPE_SUBTITLE)
+            continue;
+
+        const AVCodecDescriptor *desc = avcodec_descriptor_get(st->codecpar->codec_id);
+        const AVCodec *dec = avcodec_find_decoder(st->codecpar->codec_id);
+        if (!dec || (desc && !(desc->props & AV_CODEC_PROP_TEXT_SUB)))
+            continue;
+
+        AVCodecContext *ctx = avcodec_alloc_context3(dec);
+        if (!ctx)
+            continue;
+        if (avcodec_parameters_to_context(ctx, st->codecpar) < 0) {
+            avcodec_free_context(&ctx);
+            continue;
+        }
+        ctx->pkt_timebase = st->time_base;
+        if (avcodec_open2(ctx, nullptr, nullptr) < 0) {
+            avcodec_free_context(&ctx);
+            continue;
+        }
 
-    // decode
-    while (av_read_frame(fmt, &pkt) >= 0) {
-        int got_subtitle;
-        AVSubtitle sub{};
+        auto track = std::make_unique<Track>();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex); // 头部中可能含有需要加入库中的内嵌字体
+            track->track = ass_new_track(m_assLibrary);
+            if (track->track && ctx->subtitle_header) {
+                ass_process_codec_private(track->track,
+                                          reinterpret_cast<const char *>(ctx->subtitle_header),
+                                          ctx->subtitle_header_size);
+            }
+        }
+        if (!track->track) {
+            avcodec_free_context(&ctx);
+            continue;
+        }
+        st->discard = AVDISCARD_DEFAULT;
+        decoders[static_cast<int>(i)] = Decoder{ctx, std::move(track)};
+    }
 
-        if (pkt.stream_index == subStreamIdx) {
-            ret = avcodec_decode_subtitle2(dec_ctx, &sub, &got_subtitle, &pkt);
+    // decode，所有文本字幕流只读取一遍文件
+    pkt = av_packet_alloc();
+    if (!pkt)
+        goto fail;
+    while (!decoders.empty() && av_read_frame(fmt, pkt) >= 0) {
+        auto it = decoders.find(pkt->stream_index);
+        if (it != decoders.end()) {
+            int got_subtitle = 0;
+            AVSubtitle sub{};
+            ret = avcodec_decode_subtitle2(it->second.ctx, &sub, &got_subtitle, pkt);
             if (ret < 0) {
                 char errbuf[AV_ERROR_MAX_STRING_SIZE]{};
                 av_strerror(ret, errbuf, sizeof(errbuf));
@@ -218,22 +344,134 @@ bool ASSRender::initFromDemux(AVFormatContext *fmt, int subStreamIdx) {
                     char *ass_line = sub.rects[i]->ass;
                     if (!ass_line)
                         break;
-                    ass_process_chunk(m_track, ass_line, static_cast<int>(strlen(ass_line)),
-                                      start_time, sub.end_display_time);
+                    if (!it->second.track->store.add(ass_line, strlen(ass_line), start_time, sub.end_display_time))
+                        qDebug() << "ASS事件存储失败(ignored)";
                 }
             }
+            avsubtitle_free(&sub);
+        }
+        av_packet_unref(pkt);
+    }
+    av_packet_free(&pkt);
+
+    // 事件只保存在存储中，第一次渲染时再按窗口提交给 libass
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto &[idx, decoder] : decoders) {
+            Track &t = *decoder.track;
+            t.store.finalize();
+            t.store.shrinkToFit();
+            events += t.store.size();
+            textBytes += t.store.textBytes();
+            avcodec_free_context(&decoder.ctx);
+            m_tracks[{mediaFile, idx}] = std::move(decoder.track);
         }
-        av_packet_unref(&pkt);
-        avsubtitle_free(&sub);
+        m_parsedFiles[mediaFile] = bestIdx;
+        updateMemoryUsage();
     }
+    qDebug() << "解析文本字幕流:" << decoders.size() << "条, ASS事件数:" << events
+             << "全部提交给libass约:" << estimateTrackBytes(events, textBytes) / 1024 << "KB"
+             << "事件存储:" << m_memoryBytes.load(std::memory_order_relaxed) / 1024 << "KB";
 
-    avcodec_free_context(&dec_ctx);
+    avformat_close_input(&fmt);
     return true;
 fail:
-    avcodec_free_context(&dec_ctx);
+    for (auto &[idx, decoder] : decoders)
+        avcodec_free_context(&decoder.ctx);
+    av_packet_free(&pkt);
+    avformat_close_input(&fmt);
     return false;
 }
 
+ASSRender::Track *ASSRender::findTrack(const std::string &mediaFile, int subStreamIdx) {
+    if (subStreamIdx < 0) { // auto
+        auto file = m_parsedFiles.find(mediaFile);
+        if (file == m_parsedFiles.end())
+            return nullptr;
+        subStreamIdx = file->second;
+    }
+    auto it = m_tracks.find({mediaFile, subStreamIdx});
+    return it == m_tracks.end() ? nullptr : it->second.get();
+}
+
+void ASSRender::addFontAttachments(AVFormatContext *fmt) {
+    int added = 0;
+    for (unsigned int i = 0; i < fmt->nb_streams; ++i) {
+        const AVStream *st = fmt->streams[i];
+        if (!isFontAttachment(st))
+            continue;
+
+        const uint8_t *data = st->codecpar->extradata;
+        const int size = st->codecpar->extradata_size;
+        // 按内容去重，同一字体(同一文件的再次打开、同一系列的其他集)只加入库中一次；字节数一起比较，降低哈希碰撞误判
+        const std::pair<uint64_t, size_t> key{fnv1a64(data, static_cast<size_t>(size)), static_cast<size_t>(size)};
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_fontKeys.insert(key).second)
+            continue;
+        const AVDictionaryEntry *name = av_dict_get(st->metadata, "filename", nullptr, 0);
+        ass_add_font(m_assLibrary, name ? name->value : "attachment", reinterpret_cast<const char *>(data), size);
+        ++added;
+    }
+    if (added > 0)
+        qDebug() << "加载字体附件:" << added << "个, 缓存字体总数:" << m_fontKeys.size();
+}
+
+const ASS_Image *ASSRender::renderTrack(ASS_Renderer *renderer, Track &t, long long now) {
+    if (now < t.windowBegin || now >= t.windowEnd) {
+        refillWindow(t, now);
+        updateCacheLimits(renderer, t, m_frameSize);
+        updateMemoryUsage();
+    }
+    return ass_render_frame(renderer, t.track, now, NULL);
+}
+
+void ASSRender::refillWindow(Track &t, int64_t now) {
+    t.store.finalize();
+
+    // 丢弃窗口外的事件，重新提交新窗口内的事件
+    ass_flush_events(t.track);
+    t.windowBegin = now - kWindowBehindMs;
+    t.windowEnd = now + kWindowAheadMs;
+    t.windowEvents = 0;
+
+    size_t textBytes = 0;
+    t.store.forEachOverlapping(t.windowBegin, t.windowEnd, [&](const ASSEventStore::Event &e, const char *text) {
+        ass_process_chunk(t.track, text, static_cast<int>(e.size), e.start, e.duration);
+        textBytes += e.size;
+        ++t.windowEvents;
+    });
+    t.trackBytes = estimateTrackBytes(t.windowEvents, textBytes);
+}
+
+void ASSRender::updateCacheLimits(ASS_Renderer *renderer, const Track &t, const QSize &videoSize) {
+    if (!renderer)
+        return;
+
+    // 位图缓存约为 6 帧完整 RGBA 画面，限制在 [16, 128]MB
+    const size_t frameBytes = static_cast<size_t>(std::max(videoSize.width(), 0)) * std::max(videoSize.height(), 0) * 4;
+    const int bitmapMB = static_cast<int>(std::clamp<size_t>((frameBytes * 6) >> 20, 16, 128));
+
+    // 字形缓存按同时存在的事件数估算，限制在 [1000, 10000]
+    const int glyphMax = static_cast<int>(std::clamp<size_t>(t.windowEvents * 50, 1000, 10000));
+
+    ass_set_cache_limits(renderer, glyphMax, bitmapMB);
+}
+
+void ASSRender::updateMemoryUsage() {
+    size_t bytes = 0;
+    for (const auto &[key, t] : m_tracks)
+        bytes += t->store.memoryUsage() + t->trackBytes;
+    m_memoryBytes.store(bytes, std::memory_order_relaxed);
+}
+
+void ASSRender::addDirtyRects(const ASS_Image *img) {
+    while (img) {
+        m_dirtyRectManager.addRect(QRect(img->dst_x, img->dst_y, img->w, img->h));
+        img = img->next;
+    }
+}
+
 // from https://github.com/libass/libass/blob/master/test/test.c
 
 void ASSRender::unpremultiplyAlpha(std::vector<uint8_t> &buffer) {
@@ -256,9 +494,9 @@ void ASSRender::unpremultiplyAlpha(std::vector<uint8_t> &buffer) {
     }
 }
 
-void ASSRender::blendSingleOnly(std::vector<std::vector<uint8_t>> &dataArr, const ASS_Image *img) {
+void ASSRender::blendSingleOnly(const DirtyRectManager &dirtyRects, std::vector<std::vector<uint8_t>> &dataArr, const ASS_Image *img) {
     const QRect rect(img->dst_x, img->dst_y, img->w, img->h);
-    const int rect_idx = m_dirtyRectManager.findFirstIntersect(rect);
+    const int rect_idx = dirtyRects.findFirstIntersect(rect);
     if (rect_idx < 0)
         return;
     const unsigned char r = img->color >> 24;
@@ -266,7 +504,7 @@ void ASSRender::blendSingleOnly(std::vector<std::vector<uint8_t>> &dataArr, cons
     const unsigned char b = (img->color >> 8) & 0xFF;
     const unsigned char a = 255 - (img->color & 0xFF);
 
-    const QRect &targetRect = m_dirtyRectManager[rect_idx];
+    const QRect &targetRect = dirtyRects[rect_idx];
     Q_ASSERT(targetRect.contains(rect, false)); // img 位于targetRect内，包括边缘
 
     // 计算局部偏移
@@ -4,28 +4,47 @@
 #include "renderer/audioplayer.h"
 #include "3rd/miniaudio/miniaudio.h"
 #include "clock/globalclock.h"
+#include "clock/timesource.h"
+#include "stats/outputsink.h"
 #include "stats/playbackstats.h"
 #include <QDebug>
+#include <algorithm>
+#include <climits>
+#include <cmath>
 
 namespace {
 
-    // 根据数量获取 miniaudio 与之对应的 FFmpeg 布局
-    static void get_default_ffmpeg_layout(int nb_channels, AVChannelLayout *layout) {
-        int count = (nb_channels > 8) ? 8 : nb_channels;
-        // clang-format off
-        switch (count) {
-        case 1: *layout = AV_CHANNEL_LAYOUT_MONO;         break;
-        case 2: *layout = AV_CHANNEL_LAYOUT_STEREO;       break;
-        case 3: *layout = AV_CHANNEL_LAYOUT_SURROUND;     break;
-        case 4: *layout = AV_CHANNEL_LAYOUT_4POINT0;      break;
-        case 5: *layout = AV_CHANNEL_LAYOUT_5POINT0_BACK; break;
-        case 6: *layout = AV_CHANNEL_LAYOUT_5POINT1;      break;
-        case 7: *layout = AV_CHANNEL_LAYOUT_6POINT1;      break;
-        case 8: *layout = AV_CHANNEL_LAYOUT_7POINT1;      break;
-        default: *layout = AV_CHANNEL_LAYOUT_STEREO;      break;
-        }
-        // clang-format on
-    }
+    // 切换音轨时新流数据与已缓冲数据的最大重叠(秒)，超过则认为发生了seek，不再拼接
+    constexpr double kMaxSpliceOverlap = 0.5;
+
+    // 漂移校正参数，与 ffplay 相同
+    constexpr double kNoSyncThreshold = 10.0;                             // 差值超过该值不校正(秒)
+    constexpr int kDriftAvgNb = 20;                                       // 差值平均的帧数
+    const double kDriftAvgCoef = std::exp(std::log(0.01) / kDriftAvgNb);  // 指数加权系数
+    constexpr int kSampleCorrectionPercentMax = 10;                       // 单帧最多增减的采样比例
+
+    constexpr int kStretchChunkFrames = 4096; // 变速时每次转换的最大帧数
+    constexpr int kOverlayChunkFrames = 4096; // 叠加音轨每次转换的最大帧数
+    constexpr uint64_t kMinMarkerFrames = 64; // 估算 pts 标记环容量的最短帧(采样数)，Vorbis 短块 128，倍速后变速输出再减半
+    constexpr double kMinus3dB = 0.70710678118654752; // 下混时中置/环绕声道的系数
+
+    // 各延迟档位的设备周期和 PCM buffer 水位，欠载时水位每次提高初始值的一半，直到容量上限
+    struct LatencyProfileParams {
+        uint32_t periodMs;              // 设备周期(ms)
+        uint32_t periods;               // 设备周期个数
+        uint32_t fillMs;                // PCM buffer 初始水位(ms)
+        uint32_t capacityMs;            // PCM buffer 容量(ms)，水位上限
+        ma_performance_profile profile; // WASAPI 等后端据此选择独占/共享周期
+    };
+
+    // clang-format off
+    constexpr LatencyProfileParams kLatencyProfiles[] = {
+        // periodMs  periods  fillMs  capacityMs  profile
+        {  25,       3,       200,    800,        ma_performance_profile_conservative }, // PowerSaving
+        {  10,       3,       100,    400,        ma_performance_profile_low_latency  }, // Balanced
+        {  5,        2,       40,     200,        ma_performance_profile_low_latency  }, // LowLatency
+    };
+    // clang-format on
 
     static ma_channel ffmpeg_channel_to_ma(enum AVChannel channel) {
         // clang-format off
@@ -58,65 +77,48 @@ namespace {
         // clang-format on
     }
 
-    // 根据 oldPar 设置 deviceConfig 的通道参数，并设置 swrPar 的通道参数，返回是否重采样
-    static bool initChannelConfig(const AudioPar &oldPar, ma_device_config &deviceConfig, ma_channel *channelMap, AudioPar &swrPar, int &initIsOk) {
-        deviceConfig.playback.channels = oldPar.ch_layout.nb_channels;
-        initIsOk = av_channel_layout_copy(&swrPar.ch_layout, &oldPar.ch_layout);
-        if (initIsOk != 0) {
-            return false;
+    static AVChannel ma_channel_to_ffmpeg(ma_channel channel) {
+        if (channel == MA_CHANNEL_MONO)
+            return AV_CHAN_FRONT_CENTER;
+        for (int c = AV_CHAN_FRONT_LEFT; c <= AV_CHAN_TOP_BACK_RIGHT; ++c) {
+            if (ffmpeg_channel_to_ma(static_cast<AVChannel>(c)) == channel)
+                return static_cast<AVChannel>(c);
         }
+        return AV_CHAN_NONE;
+    }
 
-        // 声道顺序未知，直接用 miniaudio 的默认顺序
-        if (oldPar.ch_layout.order == AV_CHANNEL_ORDER_UNSPEC) {
-            return false;
+    // 根据设备的声道映射生成 FFmpeg 布局，无法识别的声道按默认布局处理
+    static void layout_from_ma_channel_map(const ma_channel *channelMap, int channels, AVChannelLayout *layout) {
+        uint64_t mask = 0;
+        bool mapped = true;
+        for (int i = 0; i < channels; ++i) {
+            const AVChannel c = ma_channel_to_ffmpeg(channelMap[i]);
+            if (c == AV_CHAN_NONE || (mask >> c) & 1) {
+                mapped = false;
+                break;
+            }
+            mask |= 1ULL << c;
         }
 
-        if (oldPar.ch_layout.order == AV_CHANNEL_ORDER_NATIVE) {
-            bool mappingFailed = false;
-
-            for (int i = 0; i < oldPar.ch_layout.nb_channels; ++i) {
-                AVChannel ffmpegChan = av_channel_layout_channel_from_index(&oldPar.ch_layout, i);
-                ma_channel maChan = ffmpeg_channel_to_ma(ffmpegChan);
-
-                if (maChan == MA_CHANNEL_NONE) {
-                    mappingFailed = true;
-                    break; // 只要有一个不支持，就重采样
+        if (mapped) {
+            // 设备声道顺序与 FFmpeg 原生顺序一致时用 mask 表示，否则逐个声道指定
+            if (av_channel_layout_from_mask(layout, mask) == 0) {
+                bool sameOrder = true;
+                for (int i = 0; i < channels; ++i) {
+                    sameOrder &= av_channel_layout_channel_from_index(layout, i) == ma_channel_to_ffmpeg(channelMap[i]);
                 }
-                channelMap[i] = maChan;
-            }
-
-            if (!mappingFailed) {
-                deviceConfig.playback.pChannelMap = channelMap;
-                return false;
+                if (sameOrder)
+                    return;
+                av_channel_layout_uninit(layout);
             }
-
-            // 重采样
-            av_channel_layout_uninit(&swrPar.ch_layout);
-            get_default_ffmpeg_layout(oldPar.ch_layout.nb_channels, &swrPar.ch_layout);
-
-            for (int i = 0; i < swrPar.ch_layout.nb_channels; ++i) {
-                AVChannel ffmpegChan = av_channel_layout_channel_from_index(&oldPar.ch_layout, i);
-                channelMap[i] = ffmpeg_channel_to_ma(ffmpegChan);
-                Q_ASSERT(channelMap[i] != MA_CHANNEL_NONE);
+            if (av_channel_layout_custom_init(layout, channels) == 0) {
+                for (int i = 0; i < channels; ++i) {
+                    layout->u.map[i].id = ma_channel_to_ffmpeg(channelMap[i]);
+                }
+                return;
             }
-            deviceConfig.playback.channels = swrPar.ch_layout.nb_channels;
-            deviceConfig.playback.pChannelMap = channelMap;
-
-            return true;
-        }
-
-        // HACK: 暂时不支持Ambisonic，先用声道数代替
-        if (oldPar.ch_layout.order == AV_CHANNEL_ORDER_AMBISONIC) {
-            return false;
         }
-
-        // HACK: 暂时不支持自定义，先用声道数代替
-        if (oldPar.ch_layout.order == AV_CHANNEL_ORDER_CUSTOM) {
-            return false;
-        }
-
-        // 未知
-        return false;
+        av_channel_layout_default(layout, channels);
     }
 
     // 向上舍入到最近的2^n
@@ -144,10 +146,92 @@ AudioPlayer::AudioPlayer(QObject *parent)
 
 AudioPlayer::~AudioPlayer() {
     uninit();
+    clearOverlay();
     Q_ASSERT(m_audioDevice != nullptr);
+    closeDevice();
     delete m_audioDevice;
 }
 
+bool AudioPlayer::openDevice() {
+    Q_ASSERT(!m_deviceOpened);
+
+    const LatencyProfileParams &params = kLatencyProfiles[static_cast<int>(m_latencyProfile)];
+
+    // 声道数和采样率为0表示使用设备的原生参数，之后所有流都转换成该格式，切换流时不再重新协商设备
+    ma_device_config deviceConfig = ma_device_config_init(ma_device_type_playback);
+    deviceConfig.playback.format = ma_format_f32;
+    deviceConfig.playback.channels = 0;
+    deviceConfig.sampleRate = 0;
+    deviceConfig.periodSizeInMilliseconds = params.periodMs;
+    deviceConfig.periods = params.periods;
+    deviceConfig.performanceProfile = params.profile;
+    deviceConfig.dataCallback = miniaudio_data_callback;
+    deviceConfig.pUserData = this;
+
+    if (ma_device_init(NULL, &deviceConfig, m_audioDevice) != MA_SUCCESS) {
+        qDebug() << "无法打开音频设备";
+        return false;
+    }
+
+    m_devicePar.reset();
+    m_devicePar.sampleFormat = AV_SAMPLE_FMT_FLT;
+    m_devicePar.sampleRate = static_cast<int>(m_audioDevice->sampleRate);
+    layout_from_ma_channel_map(m_audioDevice->playback.channelMap, static_cast<int>(m_audioDevice->playback.channels), &m_devicePar.ch_layout);
+    OutputSink::instance().setAudioFormat(m_devicePar.ch_layout.nb_channels, m_devicePar.sampleRate);
+
+    Q_ASSERT(m_pcmBuffer == nullptr);
+    m_pcmFrameSize = m_devicePar.ch_layout.nb_channels * av_get_bytes_per_sample(m_devicePar.sampleFormat);
+    const uint64_t bytesPerMs = (uint64_t)m_devicePar.sampleRate * m_pcmFrameSize / 1000;
+    // 标记环按缓冲区装满最短帧时的帧数分配，连续的标记还会被合并
+    const uint64_t pcmCapacity = roundUpPow2(bytesPerMs * params.capacityMs);
+    m_pcmBuffer = new SPSCBuffer(pcmCapacity, pcmCapacity / (static_cast<uint64_t>(m_pcmFrameSize) * kMinMarkerFrames) + 1);
+    m_targetFill.store(std::min<uint64_t>(bytesPerMs * params.fillMs, m_pcmBuffer->capacity()), std::memory_order_relaxed);
+    m_fillStep = bytesPerMs * params.fillMs / 2;
+    m_fillWait = std::chrono::microseconds(params.periodMs * 500);
+    m_deviceProfile = m_latencyProfile;
+    qDebug() << "audio device:" << m_audioDevice->playback.name << m_devicePar.sampleRate << "Hz" << m_devicePar.ch_layout.nb_channels << "ch"
+             << "profile:" << static_cast<int>(m_deviceProfile) << "pcmBuffer capacity:" << m_pcmBuffer->capacity()
+             << "markers:" << m_pcmBuffer->markerCapacity()
+             << "fill:" << m_targetFill.load(std::memory_order_relaxed);
+
+    // 设备缓冲区中已排队的周期决定了回调写入的数据多久之后才会被听到
+    {
+        const ma_uint32 periods = m_audioDevice->playback.internalPeriods;
+        const ma_uint32 latencyFrames = m_audioDevice->playback.internalPeriodSizeInFrames * (periods > 1 ? periods - 1 : 1);
+        const ma_uint32 internalRate = m_audioDevice->playback.internalSampleRate;
+        m_deviceLatency = internalRate > 0 ? static_cast<double>(latencyFrames) / internalRate : 0.0;
+        qDebug() << "audio device latency(ms):" << m_deviceLatency * 1000;
+    }
+
+    if (!m_stretcher.init(m_devicePar.ch_layout.nb_channels, m_devicePar.sampleRate)) {
+        qDebug() << "无法初始化变速处理";
+        return false;
+    }
+    m_stretchChunk.resize(static_cast<size_t>(kStretchChunkFrames) * m_devicePar.ch_layout.nb_channels);
+
+    // 设备声道数超过混音器上限时只能播放主音轨
+    if (!m_mixer.init(m_devicePar.ch_layout.nb_channels, m_devicePar.sampleRate)) {
+        qDebug() << "设备声道数过多，不支持叠加音轨";
+    } else if (m_overlayFrmBuf && !setupOverlayTrack()) {
+        qDebug() << "无法重新配置叠加音轨";
+    }
+
+    setVolume(m_volume);
+    m_deviceOpened = true;
+    return true;
+}
+
+void AudioPlayer::closeDevice() {
+    if (!m_deviceOpened) {
+        return;
+    }
+    ma_device_uninit(m_audioDevice);
+    delete m_pcmBuffer;
+    m_pcmBuffer = nullptr;
+    m_writtenEndPts = INVALID_DOUBLE;
+    m_deviceOpened = false;
+}
+
 bool AudioPlayer::init(const AVCodecParameters *codecParams, sharedFrmQueue frmBuf) { // TODO ： initial_padding trailing_padding是否要做处理
     if (m_initialized) {
         uninit();
@@ -160,130 +244,75 @@ bool AudioPlayer::init(const AVCodecParameters *codecParams, sharedFrmQueue frmB
         return false;
     }
 
-    // 设备配置
-    ma_device_config deviceConfig = ma_device_config_init(ma_device_type_playback);
-    ma_channel channelMap[MA_MAX_CHANNELS];
-
-    // 同步音频数据
-    m_oldPar.reset(), m_swrPar.reset();
-    m_oldPar.sampleFormat = m_swrPar.sampleFormat = static_cast<AVSampleFormat>(codecParams->format);
-    m_oldPar.sampleRate = m_swrPar.sampleRate = codecParams->sample_rate;
-    int ret = av_channel_layout_copy(&m_oldPar.ch_layout, &codecParams->ch_layout);
-    if (ret != 0) {
+    // 延迟档位改变后重新打开设备，无缝切换音轨时保持旧设备
+    if (m_deviceOpened && m_deviceProfile != m_latencyProfile && !m_splicing) {
+        closeDevice();
+    }
+    if (!m_deviceOpened && !openDevice()) {
         return false;
     }
 
-    bool isResample = false; // 是否重采样
-
-    // 调整采样率
-    deviceConfig.sampleRate = m_oldPar.sampleRate;
-
-    // 调整采样格式
-    // NOTE : miniaudio只支持packet格式，这儿planar格式需要重采样
-    switch (m_oldPar.sampleFormat) { // clang-format off
-    case AV_SAMPLE_FMT_NONE: qDebug() << "无效音频采样格式"; return false;
-    case AV_SAMPLE_FMT_U8:   deviceConfig.playback.format = ma_format_u8;  break;
-    case AV_SAMPLE_FMT_S16:  deviceConfig.playback.format = ma_format_s16; break;
-    case AV_SAMPLE_FMT_S32:  deviceConfig.playback.format = ma_format_s32; break;
-    case AV_SAMPLE_FMT_FLT:  deviceConfig.playback.format = ma_format_f32; break;
-    case AV_SAMPLE_FMT_DBL:  deviceConfig.playback.format = ma_format_f32; isResample = true; m_swrPar.sampleFormat = AV_SAMPLE_FMT_FLT; break;
-    case AV_SAMPLE_FMT_U8P:  deviceConfig.playback.format = ma_format_u8;  isResample = true; m_swrPar.sampleFormat = AV_SAMPLE_FMT_U8;  break;
-    case AV_SAMPLE_FMT_S16P: deviceConfig.playback.format = ma_format_s16; isResample = true; m_swrPar.sampleFormat = AV_SAMPLE_FMT_S16; break;
-    case AV_SAMPLE_FMT_S32P: deviceConfig.playback.format = ma_format_s32; isResample = true; m_swrPar.sampleFormat = AV_SAMPLE_FMT_S32; break;
-    case AV_SAMPLE_FMT_FLTP: deviceConfig.playback.format = ma_format_f32; isResample = true; m_swrPar.sampleFormat = AV_SAMPLE_FMT_FLT; break;
-    case AV_SAMPLE_FMT_DBLP: deviceConfig.playback.format = ma_format_f32; isResample = true; m_swrPar.sampleFormat = AV_SAMPLE_FMT_FLT; break;
-    case AV_SAMPLE_FMT_S64:  deviceConfig.playback.format = ma_format_s32; isResample = true; m_swrPar.sampleFormat = AV_SAMPLE_FMT_S32; break;
-    case AV_SAMPLE_FMT_S64P: deviceConfig.playback.format = ma_format_s32; isResample = true; m_swrPar.sampleFormat = AV_SAMPLE_FMT_S32; break;
-    default:break;
-    } // clang-format on
-
-    // 调整通道布局
-    int ChannelConfigInitIsOK;
-    isResample |= initChannelConfig(m_oldPar, deviceConfig, channelMap, m_swrPar, ChannelConfigInitIsOK);
-    if (ChannelConfigInitIsOK != 0) {
+    m_oldPar.reset();
+    m_oldPar.sampleFormat = static_cast<AVSampleFormat>(codecParams->format);
+    m_oldPar.sampleRate = codecParams->sample_rate;
+    if (m_oldPar.sampleFormat == AV_SAMPLE_FMT_NONE) {
+        qDebug() << "无效音频采样格式";
         return false;
     }
-
-    Q_ASSERT(m_pcmBuffer == nullptr);
-    m_pcmFrameSize = m_swrPar.ch_layout.nb_channels * av_get_bytes_per_sample(m_swrPar.sampleFormat);
-    const uint64_t pcmBufferSize = (uint64_t)m_swrPar.sampleRate * m_pcmFrameSize * 100 / 1000; // 100ms容量
-    m_pcmBuffer = new SPSCBuffer(roundUpPow2(pcmBufferSize));
-    qDebug() << "pcmBuffer capacity:" << m_pcmBuffer->capacity();
-
-    deviceConfig.dataCallback = miniaudio_data_callback;
-    deviceConfig.pUserData = this;
-
-    if (ma_device_init(NULL, &deviceConfig, m_audioDevice) != MA_SUCCESS) {
-        printf("Failed to open playback device.\n");
+    if (av_channel_layout_copy(&m_oldPar.ch_layout, &codecParams->ch_layout) != 0) {
         return false;
     }
-    setVolume(m_volume);
 
-    // 配置重采样上下文
-    if (isResample) {
-        swr_alloc_set_opts2(&m_swrContext,
-                            &m_swrPar.ch_layout,   // 输出声道布局
-                            m_swrPar.sampleFormat, // 输出格式
-                            m_swrPar.sampleRate,   // 输出采样率
-                            &m_oldPar.ch_layout,   // 输入声道布局
-                            m_oldPar.sampleFormat, // 输入格式
-                            m_oldPar.sampleRate,   // 输入采样率
-                            0, nullptr);
-
-        if (!m_swrContext || swr_init(m_swrContext) < 0) {
-            qDebug() << "采样上下文初始化失败";
-            return false;
-        }
-
-        // 初始化缓冲区
-        m_swrBuffer = static_cast<uint8_t **>(av_malloc(sizeof(uint8_t *)));
-        m_swrBufferSize = 1024;
-        *m_swrBuffer = static_cast<uint8_t *>(av_malloc(m_swrBufferSize));
+    // 配置格式转换：参数与设备一致时只做交织/拷贝，其余交给 swresample(必要时先经过空间音频渲染)
+    if (!m_converter.init(m_oldPar, m_devicePar, m_binaural)) {
+        return false;
     }
+    qDebug() << "audio convert mode:" << static_cast<int>(m_converter.mode());
 
     m_frmItem = {};
-    m_pcmDataSize = 0;
-    m_pcmDataPtr = nullptr;
-    m_pcmDataIndex = 0;
+    resetDriftCorrection();
 
     m_forceRefresh = false;
     m_initialized = true;
-    m_serial = 0;
+    m_serial = m_frmBuf->serial();
+    if (!m_splicing) {
+        m_switchBegin = std::chrono::steady_clock::now();
+        m_underrunCount.store(0, std::memory_order_relaxed);
+    }
+    m_switchPending = true;
 
     return true;
 }
 
-void AudioPlayer::uninit() {
+void AudioPlayer::uninit(bool keepBuffered) {
     stop();
 
-    Q_ASSERT(m_audioDevice != nullptr);
-    ma_device_uninit(m_audioDevice);
-
     m_oldPar.reset();
-    m_swrPar.reset();
-
     m_initialized = false;
+    m_converter.uninit();
+    m_frmBuf.reset();
+    m_switchPending = false;
+    m_underrunArmed.store(false, std::memory_order_relaxed);
 
-    if (m_swrContext) {
-        swr_free(&m_swrContext);
-        m_swrContext = nullptr;
-    }
-
-    if (m_swrBuffer) {
-        if (*m_swrBuffer) {
-            av_free(*m_swrBuffer);
-        }
-        av_free(m_swrBuffer);
-        m_swrBuffer = nullptr;
+    if (!m_deviceOpened) {
+        return;
     }
 
-    if (m_pcmBuffer) {
-        delete m_pcmBuffer;
-        m_pcmBuffer = nullptr;
+    if (keepBuffered && !std::isnan(m_writtenEndPts)) {
+        // 设备继续播放已缓冲的数据，下一个流从 m_writtenEndPts 处接上
+        m_splicing = true;
+        m_switchBegin = std::chrono::steady_clock::now();
+        return;
     }
 
-    m_swrBufferSize = 0;
-    m_frmBuf.reset();
+    // 只停止设备，不重新打开
+    ma_device_stop(m_audioDevice);
+    m_pcmBuffer->unsafeClear(); // 回调已经停止
+    m_stretcher.reset();
+    m_mixer.clearTrack(m_overlayTrack);
+    m_stretchAnchorPts = INVALID_DOUBLE;
+    m_writtenEndPts = INVALID_DOUBLE;
+    m_splicing = false;
 }
 
 void AudioPlayer::start() {
@@ -299,9 +328,9 @@ void AudioPlayer::start() {
     // 启动PCM线程
     m_stop.store(false, std::memory_order_relaxed);
     m_paused.store(false, std::memory_order_relaxed);
-    m_thread = std::thread([this] { playerLoop(); });
+    m_thread = TaskExecutor::instance().submit(TaskQoS::RealtimeAudio, "AZ-audio-pcm", [this] { playerLoop(); });
 
-    // 启动音频设备
+    // 启动音频设备(切换音轨时设备一直在运行)
     ma_device_state state = ma_device_get_state(m_audioDevice);
     Q_ASSERT(state != ma_device_state_uninitialized);
     if (state != ma_device_state_started && state != ma_device_state_starting) {
@@ -320,11 +349,8 @@ void AudioPlayer::stop() {
         return; // 已经退出
     }
 
-    // 关闭设备
+    // 关闭PCM线程，设备由 uninit 决定是否停止
     m_stop.store(true, std::memory_order_relaxed);
-    ma_device_uninit(m_audioDevice);
-
-    // 关闭PCM线程
     m_thread.join(); // 阻塞直到 playerLoop 退出
 
     DeviceStatus::instance().setAudioInitialized(false);
@@ -352,6 +378,165 @@ void AudioPlayer::setVolume(double newVolume) {
     m_volume = newVolume;
 }
 
+bool AudioPlayer::setOverlay(const AVCodecParameters *codecParams, sharedFrmQueue frmBuf) {
+    Q_ASSERT(!m_thread.joinable());
+    clearOverlay();
+
+    if (!m_deviceOpened || !codecParams || codecParams->ch_layout.nb_channels == 0 || !frmBuf) {
+        qDebug() << "无效的叠加音轨参数或音频设备未打开";
+        return false;
+    }
+
+    m_overlayPar.sampleFormat = static_cast<AVSampleFormat>(codecParams->format);
+    m_overlayPar.sampleRate = codecParams->sample_rate;
+    if (m_overlayPar.sampleFormat == AV_SAMPLE_FMT_NONE || av_channel_layout_copy(&m_overlayPar.ch_layout, &codecParams->ch_layout) != 0) {
+        clearOverlay();
+        return false;
+    }
+    m_overlayFrmBuf = frmBuf;
+    m_overlaySerial = frmBuf->serial();
+
+    if (!setupOverlayTrack()) {
+        clearOverlay();
+        return false;
+    }
+    return true;
+}
+
+void AudioPlayer::clearOverlay() {
+    Q_ASSERT(!m_thread.joinable());
+    av_frame_free(&m_overlayItem.frm);
+    m_overlayItem = {};
+    m_mixer.removeTrack(m_overlayTrack);
+    m_overlayTrack = -1;
+    m_overlayConverter.uninit();
+    m_overlayPar.reset();
+    m_overlayFrmBuf.reset();
+}
+
+bool AudioPlayer::haveOverlay() const {
+    return m_overlayFrmBuf != nullptr;
+}
+
+void AudioPlayer::setOverlayGain(double gain) {
+    m_overlayGain.store(static_cast<float>(gain), std::memory_order_relaxed);
+}
+
+bool AudioPlayer::setupOverlayTrack() {
+    m_mixer.removeTrack(m_overlayTrack);
+    m_overlayTrack = -1;
+
+    // 混音器能处理的声道数以内保持原声道，由混音矩阵下混；否则由转换器直接转换到设备布局
+    AudioPar out;
+    out.sampleFormat = AV_SAMPLE_FMT_FLT;
+    out.sampleRate = m_devicePar.sampleRate;
+    const bool toDevice = m_overlayPar.ch_layout.nb_channels > AudioMixer::kMaxChannels ||
+                          AudioConverter::rendersSpatially(m_overlayPar.ch_layout, m_devicePar.ch_layout, m_binaural);
+    const AVChannelLayout &layout = toDevice ? m_devicePar.ch_layout : m_overlayPar.ch_layout;
+    if (av_channel_layout_copy(&out.ch_layout, &layout) != 0 || !m_overlayConverter.init(m_overlayPar, out, m_binaural)) {
+        return false;
+    }
+
+    const int channels = out.ch_layout.nb_channels;
+    m_overlayTrack = m_mixer.addTrack(channels);
+    if (m_overlayTrack < 0) {
+        return false;
+    }
+
+    // 布局不同时用 swresample 的系数生成下混矩阵，这样也考虑了设备实际的声道顺序
+    if (av_channel_layout_compare(&out.ch_layout, &m_devicePar.ch_layout) != 0) {
+        const int outChannels = m_devicePar.ch_layout.nb_channels;
+        std::vector<double> matrix(static_cast<size_t>(outChannels) * channels);
+        if (swr_build_matrix2(&out.ch_layout, &m_devicePar.ch_layout, kMinus3dB, kMinus3dB, 0.0, 1.0, 0.0,
+                              matrix.data(), channels, AV_MATRIX_ENCODING_NONE, nullptr) == 0) {
+            const std::vector<float> coeffs(matrix.begin(), matrix.end());
+            m_mixer.setMatrix(m_overlayTrack, coeffs.data());
+        }
+    }
+
+    m_overlayChunk.resize(static_cast<size_t>(kOverlayChunkFrames) * channels);
+    qDebug() << "overlay audio:" << m_overlayPar.sampleRate << "Hz" << m_overlayPar.ch_layout.nb_channels << "ch"
+             << "convert mode:" << static_cast<int>(m_overlayConverter.mode());
+    return true;
+}
+
+void AudioPlayer::mixOverlay(float *dst, int64_t frames, double pts) {
+    // 先解码叠加音轨，直到其数据覆盖本段的末尾
+    const double endPts = std::isnan(pts) ? pts : pts + static_cast<double>(frames) / m_devicePar.sampleRate;
+    while (m_overlayTrack >= 0) {
+        const double bufferedEnd = m_mixer.bufferedEnd(m_overlayTrack);
+        if (!std::isnan(bufferedEnd) && (std::isnan(endPts) || bufferedEnd >= endPts))
+            break;
+        if (!getOverlayFrm(m_overlayItem))
+            break; // 叠加音轨暂时没有数据，只混入已有的部分
+
+        double overlayPts = m_overlayItem.pts;
+        if (!std::isnan(overlayPts)) {
+            overlayPts -= m_overlayConverter.delay();
+        }
+        m_overlayConverter.setInput(m_overlayItem.frm);
+        while (true) {
+            const int64_t produced = m_overlayConverter.produce(reinterpret_cast<uint8_t *>(m_overlayChunk.data()), kOverlayChunkFrames);
+            if (produced < 0) {
+                qDebug() << "叠加音轨格式转换失败";
+                break;
+            }
+            m_mixer.push(m_overlayTrack, m_overlayChunk.data(), static_cast<int>(produced), overlayPts);
+            overlayPts = INVALID_DOUBLE; // 之后的数据紧接着上一批
+            if (produced < kOverlayChunkFrames)
+                break;
+        }
+        av_frame_free(&m_overlayItem.frm);
+    }
+
+    m_mixer.mix(dst, static_cast<int>(frames), pts);
+}
+
+bool AudioPlayer::getOverlayFrm(AVFrmItem &item) {
+    Q_ASSERT(item.frm == nullptr);
+    while (m_overlayFrmBuf->pop(item)) {
+        if (item.serial == m_overlayFrmBuf->serial()) {
+            // 叠加音轨seek过，之前缓存的数据作废
+            if (item.serial != m_overlaySerial) {
+                m_overlaySerial = item.serial;
+                m_overlayConverter.reset();
+                m_mixer.clearTrack(m_overlayTrack);
+            }
+            return true;
+        }
+        av_frame_free(&item.frm);
+    }
+    return false;
+}
+
+AudioLatencyProfile AudioPlayer::latencyProfile() const {
+    return m_latencyProfile;
+}
+
+void AudioPlayer::setLatencyProfile(AudioLatencyProfile profile) {
+    m_latencyProfile = profile;
+}
+
+bool AudioPlayer::binaural() const {
+    return m_binaural;
+}
+
+void AudioPlayer::setBinaural(bool enabled) {
+    m_binaural = enabled;
+    // 叠加音轨的转换在设备打开时就已配置，需要立即按新设置重建
+    if (m_deviceOpened && m_overlayFrmBuf && !setupOverlayTrack()) {
+        qDebug() << "无法重新配置叠加音轨";
+    }
+}
+
+double AudioPlayer::speed() const {
+    return m_speed.load(std::memory_order_relaxed);
+}
+
+void AudioPlayer::setSpeed(double newSpeed) {
+    m_speed.store(newSpeed, std::memory_order_relaxed);
+}
+
 bool AudioPlayer::getFrm(AVFrmItem &item) {
     Q_ASSERT(item.frm == nullptr);
     // 直到找到序号一致的帧或队列为空
@@ -378,23 +563,29 @@ void AudioPlayer::playerLoop() {
     while (!m_stop.load(std::memory_order_relaxed)) {
         bool ok = updatePcmFromFrameQueue();
         if (!ok) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            m_underrunArmed.store(false, std::memory_order_relaxed); // 上游没有数据，此时读空不是缓冲不足
+            TimeSource::instance().sleepFor(0.005);
             continue;
         }
 
         if (m_serial != m_frmBuf->serial()) {
             m_serial = m_frmBuf->serial();
-            m_pcmBuffer->requestClearOldData();
-            if (m_swrContext) {
-                swr_init(m_swrContext);
-            }
+            m_underrunArmed.store(false, std::memory_order_relaxed);
+            if (!m_splicing) // 切换音轨时的seek不清空旧数据，由 writePCM 接上
+                m_pcmBuffer->requestClearOldData();
+            m_converter.reset();
+            m_stretcher.reset();
+            m_stretchAnchorPts = INVALID_DOUBLE;
+            resetDriftCorrection();
             m_forceRefresh = true;
         }
 
         // 写入帧到PCMBuffer中
         writePCM();
 
-        if (m_forceRefresh && GlobalClock::instance().mainClockType() == ClockType::AUDIO)
+        // 外部时钟为主时钟时，有音频就由音频报告seek完成
+        const ClockType mainClock = GlobalClock::instance().mainClockType();
+        if (m_forceRefresh && (mainClock == ClockType::AUDIO || mainClock == ClockType::EXTERNAL))
             emit seeked();
 
         if (m_forceRefresh || !DeviceStatus::instance().haveVideo())
@@ -407,92 +598,277 @@ void AudioPlayer::playerLoop() {
 }
 
 void AudioPlayer::writePCM() {
-    m_bufferedEndPts = m_frmItem.pts;
-    const double bytesPerSec = m_swrPar.sampleRate * m_pcmFrameSize;
     GlobalClock::instance().syncExternalClk(ClockType::AUDIO);
 
-    while (m_pcmDataIndex < m_pcmDataSize) {
-        const uint64_t len = m_pcmDataSize - m_pcmDataIndex;
-        const uint64_t written = m_pcmBuffer->write(m_pcmDataPtr + m_pcmDataIndex, len);
-        m_bufferedEndPts += written / bytesPerSec;
-        m_pcmDataIndex += written;
-        if (written != len) {
-            if (m_stop.load(std::memory_order_relaxed))
-                return;
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    double pts = m_frmItem.pts;
+    int skipSamples = 0;
+    if (m_splicing && !std::isnan(pts) && !std::isnan(m_writtenEndPts)) {
+        const double frameEnd = pts + static_cast<double>(m_frmItem.frm->nb_samples) / m_oldPar.sampleRate;
+        if (pts < m_writtenEndPts - kMaxSpliceOverlap) {
+            // 重叠过多说明期间发生了seek，旧数据作废
+            m_pcmBuffer->requestClearOldData();
+            m_splicing = false;
+        } else if (frameEnd <= m_writtenEndPts) {
+            return; // 已被旧流的数据覆盖
+        } else {
+            // 去掉与旧数据重叠的部分，从旧数据的末尾接上
+            if (pts < m_writtenEndPts) {
+                skipSamples = static_cast<int>(std::lround((m_writtenEndPts - pts) * m_oldPar.sampleRate));
+                pts = m_writtenEndPts;
+            }
+            m_splicing = false;
         }
     }
 
-    PlaybackStats::instance().audioPTS = GlobalClock::instance().audioPts();
+    // 重采样器内部缓存的采样先于本帧输出，输出数据的起点要提前
+    if (!std::isnan(pts)) {
+        pts -= m_converter.delay();
+    }
+
+    syncToMainClock(m_frmItem.frm->nb_samples);
+
+    m_converter.setInput(m_frmItem.frm, skipSamples);
+
+    if (m_overlayTrack >= 0) {
+        m_mixer.setGain(m_overlayTrack, m_overlayGain.load(std::memory_order_relaxed));
+    }
+
+    // 进出变速时 m_stretcher 中残留的数据与新数据不连续
+    const bool stretch = m_speed.load(std::memory_order_relaxed) != 1.0;
+    if (stretch != m_stretching) {
+        m_stretcher.reset();
+        m_stretchAnchorPts = INVALID_DOUBLE;
+        m_stretching = stretch;
+    }
+    const int64_t totalFrames = stretch ? writeStretched(pts) : writeConverted(pts);
+    if (totalFrames < 0) {
+        return;
+    }
+
+    if (!std::isnan(pts)) {
+        m_writtenEndPts = pts + static_cast<double>(totalFrames) / m_devicePar.sampleRate;
+    }
+
+    // 打开或切换后新流第一次写入设备缓冲的耗时
+    if (m_switchPending) {
+        m_switchPending = false;
+        PlaybackStats::instance().audioSwitchLatency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_switchBegin).count();
+    }
+
+    m_underrunArmed.store(true, std::memory_order_relaxed);
+
+    PlaybackStats &stats = PlaybackStats::instance();
+    stats.audioPTS = GlobalClock::instance().audioPts();
+    stats.audioUnderrunCount = m_underrunCount.load(std::memory_order_relaxed);
+    stats.audioBufferMs = m_targetFill.load(std::memory_order_relaxed) * 1000.0 / (static_cast<double>(m_pcmFrameSize) * m_devicePar.sampleRate);
     return;
 }
 
-bool AudioPlayer::updatePcmFromFrameQueue() {
-    av_frame_free(&m_frmItem.frm);
-    m_pcmDataSize = 0;
-    m_pcmDataPtr = nullptr;
-    m_pcmDataIndex = 0;
+uint64_t AudioPlayer::writableFrames() const {
+    const uint64_t target = m_targetFill.load(std::memory_order_relaxed);
+    const uint64_t filled = m_pcmBuffer->readAvailable();
+    return target > filled ? (target - filled) / m_pcmFrameSize : 0;
+}
 
-    if (getFrm(m_frmItem) == false) {
-        return false;
+void AudioPlayer::pushPtsMarker(double pts) {
+    // 与回调中 readPts 外推使用相同的速率
+    const double bytesPerSec = static_cast<double>(m_pcmFrameSize) * m_devicePar.sampleRate / m_speed.load(std::memory_order_relaxed);
+    if (!m_pcmBuffer->pushPtsMarker(pts, bytesPerSec))
+        qDebug() << "pts 标记环已满，丢弃标记:" << pts;
+}
+
+int64_t AudioPlayer::writeConverted(double pts) {
+    // 每帧数据前打上时间戳，回调据此得到精确到采样的音频时钟
+    pushPtsMarker(pts);
+
+    // 转换的输出直接写进环形缓冲区，不再经过中间缓冲；叠加音轨趁数据还在缓存中时立即混入
+    bool drained = false; // 本帧数据是否已全部写入
+    int64_t totalFrames = 0;
+    const bool mixing = m_mixer.active();
+    int64_t mixedFrames = 0; // 已混音的帧数，用于推算每批数据的pts
+    auto produce = [&](uint8_t *dst, uint64_t frames) -> int64_t {
+        const int64_t produced = m_converter.produce(dst, frames);
+        if (produced >= 0 && static_cast<uint64_t>(produced) < frames) {
+            drained = true;
+        }
+        if (produced > 0 && mixing) {
+            const double chunkPts = std::isnan(pts) ? pts : pts + static_cast<double>(mixedFrames) / m_devicePar.sampleRate;
+            mixOverlay(reinterpret_cast<float *>(dst), produced, chunkPts);
+            mixedFrames += produced;
+        }
+        return produced;
+    };
+
+    while (!drained) {
+        const uint64_t writable = writableFrames();
+        if (writable > 0) {
+            const int64_t written = m_pcmBuffer->writeFrames(m_pcmFrameSize, writable, produce);
+            if (written < 0) {
+                qDebug() << "音频格式转换失败";
+                return -1;
+            }
+            totalFrames += written;
+        }
+        if (!drained) { // 达到水位
+            if (m_stop.load(std::memory_order_relaxed))
+                return -1;
+            std::this_thread::sleep_for(m_fillWait);
+        }
     }
-    AVFrame *frm = m_frmItem.frm;
+    return totalFrames;
+}
 
-    if (m_swrContext) {
-        int nb_samples;
+int64_t AudioPlayer::writeStretched(double pts) {
+    m_stretcher.setSpeed(m_speed.load(std::memory_order_relaxed));
+    if (!std::isnan(pts)) {
+        m_stretchAnchorPos = m_stretcher.inputFrames();
+        m_stretchAnchorPts = pts;
+    }
 
-        // 估算需要的输出样本数（带上延迟）
-        const int out_nb_samples = av_rescale_rnd(
-            swr_get_delay(m_swrContext, m_oldPar.sampleRate) + frm->nb_samples,
-            m_swrPar.sampleRate,
-            m_oldPar.sampleRate,
-            AV_ROUND_UP);
+    // 本帧全部转换、混音后送入 m_stretcher
+    const int chunkFrames = static_cast<int>(m_stretchChunk.size()) / m_stretcher.channels();
+    const bool mixing = m_mixer.active();
+    int64_t totalFrames = 0;
+    while (true) {
+        const int64_t produced = m_converter.produce(reinterpret_cast<uint8_t *>(m_stretchChunk.data()), chunkFrames);
+        if (produced < 0) {
+            qDebug() << "音频格式转换失败";
+            return -1;
+        }
+        if (produced > 0 && mixing) {
+            const double chunkPts = std::isnan(pts) ? pts : pts + static_cast<double>(totalFrames) / m_devicePar.sampleRate;
+            mixOverlay(m_stretchChunk.data(), produced, chunkPts);
+        }
+        m_stretcher.push(m_stretchChunk.data(), static_cast<int>(produced));
+        totalFrames += produced;
+        if (produced < chunkFrames)
+            break;
+    }
 
-        // 确保输出缓冲区足够大（单位：字节）
-        const int out_channels = m_swrPar.ch_layout.nb_channels;                         // 通道数
-        const int out_bytes_per_sample = av_get_bytes_per_sample(m_swrPar.sampleFormat); // 单个通道的单个采样大小
-        const int out_buf_size = out_nb_samples * out_channels * out_bytes_per_sample;
+    if (m_stretcher.available() == 0) {
+        return totalFrames; // 输入还不够一段
+    }
 
-        if (out_buf_size > m_swrBufferSize) { // swrbuf大小不够，重新分配
-            *m_swrBuffer = (uint8_t *)av_realloc(*m_swrBuffer, out_buf_size);
-            m_swrBufferSize = out_buf_size;
+    // 输出的第一个采样在输入中的位置换算成pts
+    double outPts = INVALID_DOUBLE;
+    if (!std::isnan(m_stretchAnchorPts)) {
+        outPts = m_stretchAnchorPts + (m_stretcher.outputPosition() - m_stretchAnchorPos) / m_devicePar.sampleRate;
+    }
+    pushPtsMarker(outPts);
+
+    auto produce = [&](uint8_t *dst, uint64_t frames) -> int64_t {
+        return m_stretcher.pull(reinterpret_cast<float *>(dst), static_cast<int>(std::min<uint64_t>(frames, INT_MAX)));
+    };
+    while (m_stretcher.available() > 0) {
+        const uint64_t writable = writableFrames();
+        if (writable > 0) {
+            (void)m_pcmBuffer->writeFrames(m_pcmFrameSize, writable, produce);
+        }
+        if (m_stretcher.available() > 0) { // 达到水位
+            if (m_stop.load(std::memory_order_relaxed))
+                return -1;
+            std::this_thread::sleep_for(m_fillWait);
         }
+    }
+    return totalFrames;
+}
 
-        // 执行重采样
-        nb_samples = swr_convert(
-            m_swrContext,
-            m_swrBuffer, out_nb_samples,                 // 输出
-            (const uint8_t **)frm->data, frm->nb_samples // 输入
-        );
+void AudioPlayer::syncToMainClock(int nbSamples) {
+    const GlobalClock &clock = GlobalClock::instance();
+    if (clock.mainClockType() == ClockType::AUDIO) {
+        resetDriftCorrection();
+        return;
+    }
+
+    // 与 ffplay 的 synchronize_audio 相同：差值取指数加权平均，超过阈值后在本帧内增减采样
+    const double diff = clock.audioPts() - clock.getMainPts();
+    if (std::isnan(diff) || std::abs(diff) >= kNoSyncThreshold) {
+        resetDriftCorrection(); // 差太多说明刚seek或者时钟无效，重新开始统计
+        return;
+    }
 
-        if (nb_samples < 0) {
-            qDebug() << "重采样执行失败";
-            return false;
+    m_driftCum = diff + kDriftAvgCoef * m_driftCum;
+    if (m_driftAvgCount < kDriftAvgNb) {
+        ++m_driftAvgCount;
+        return;
+    }
+
+    PlaybackStats &stats = PlaybackStats::instance();
+    const double avgDiff = m_driftCum * (1.0 - kDriftAvgCoef);
+    stats.audioDrift = avgDiff * 1000;
+
+    // 阈值取设备缓冲的时长，更小的误差本身就测不准
+    const double threshold = std::max(0.01, m_deviceLatency);
+    if (std::abs(avgDiff) < threshold) {
+        if (m_compensating) {
+            (void)m_converter.setCompensation(0, 0);
+            m_compensating = false;
         }
+        return;
+    }
+
+    // 音频超前时多输出一些采样，落后时少输出一些
+    const int minSamples = nbSamples * (100 - kSampleCorrectionPercentMax) / 100;
+    const int maxSamples = nbSamples * (100 + kSampleCorrectionPercentMax) / 100;
+    const int wanted = std::clamp(nbSamples + static_cast<int>(diff * m_oldPar.sampleRate), minSamples, maxSamples);
+    if (wanted == nbSamples)
+        return;
+
+    const int64_t outRate = m_devicePar.sampleRate, inRate = m_oldPar.sampleRate;
+    const int delta = static_cast<int>((wanted - nbSamples) * outRate / inRate);
+    const int distance = static_cast<int>(wanted * outRate / inRate);
+    if (!m_converter.setCompensation(delta, distance)) {
+        qDebug() << "音频漂移补偿失败";
+        return;
+    }
+    m_compensating = true;
+    ++stats.audioCompensationCount;
+    stats.audioCompensatedSamples += delta;
+}
+
+void AudioPlayer::resetDriftCorrection() {
+    m_driftCum = 0.0;
+    m_driftAvgCount = 0;
+    if (m_compensating) {
+        (void)m_converter.setCompensation(0, 0);
+        m_compensating = false;
+    }
+}
 
-        m_pcmDataSize = nb_samples * out_channels * out_bytes_per_sample;
-        m_pcmDataPtr = *m_swrBuffer;
-    } else { // 无需重采样
-        assert(!av_sample_fmt_is_planar(m_oldPar.sampleFormat));
-        assert(m_oldPar.sampleFormat == static_cast<AVSampleFormat>(frm->format));
-        m_pcmDataSize = frm->nb_samples * m_pcmFrameSize;
-        m_pcmDataPtr = frm->data[0];
+bool AudioPlayer::updatePcmFromFrameQueue() {
+    av_frame_free(&m_frmItem.frm);
+
+    if (getFrm(m_frmItem) == false) {
+        return false;
     }
 
+    assert(m_oldPar.sampleFormat == static_cast<AVSampleFormat>(m_frmItem.frm->format));
+
     return true;
 }
 
 void AudioPlayer::miniaudio_data_callback(ma_device *pDevice, void *pOutput, const void * /*pInput*/, ma_uint32 frameCount) {
     AudioPlayer *const audioPlayer = static_cast<AudioPlayer *>(pDevice->pUserData);
     SPSCBuffer *const buffer = audioPlayer->m_pcmBuffer;
-    const double nextPtr = audioPlayer->m_bufferedEndPts;
+
+    // 设备线程由 miniaudio/系统创建，第一次回调时命名，资源统计里才能和其他线程区分
+    thread_local bool named = false;
+    if (!named) {
+        TaskExecutor::setThreadName("AZ-audio-dev");
+        named = true;
+    }
 
     const uint32_t bytesPerSample = ma_get_bytes_per_sample(pDevice->playback.format);
     const uint32_t frameSize = pDevice->playback.channels * bytesPerSample;
 
-    const double bytesPerSec = frameSize * pDevice->sampleRate;
-    const double offsetPts = buffer->readAvailable() / bytesPerSec; // 未播的时间
-    GlobalClock::instance().setAudioClk(nextPtr - offsetPts);
+    // 本次读出的第一个采样的pts，再扣除设备缓冲区中尚未播放的部分，就是此刻正在播放的pts
+    // 变速时每秒输出对应 speed 秒的媒体时间
+    const double speed = audioPlayer->m_speed.load(std::memory_order_relaxed);
+    const double bytesPerSec = frameSize * pDevice->sampleRate / speed;
+    const double headPts = buffer->readPts(bytesPerSec);
+    if (!std::isnan(headPts)) {
+        GlobalClock::instance().setAudioClk(headPts - audioPlayer->m_deviceLatency * speed);
+    }
 
     uint8_t *const pDst = static_cast<uint8_t *>(pOutput);
     int writeCnt = 0;                          // 已经写入的大小(字节)
@@ -503,7 +879,18 @@ void AudioPlayer::miniaudio_data_callback(ma_device *pDevice, void *pOutput, con
         bytesNeeded -= len;
         writeCnt += len;
 
-        if (len == 0)
-            return; // 无数据
+        if (len == 0) {
+            // PCM线程仍在持续供给数据时读空，说明水位不足以覆盖线程调度的抖动，提高水位
+            if (audioPlayer->m_underrunArmed.exchange(false, std::memory_order_relaxed)) {
+                audioPlayer->m_underrunCount.fetch_add(1, std::memory_order_relaxed);
+                const uint64_t target = audioPlayer->m_targetFill.load(std::memory_order_relaxed) + audioPlayer->m_fillStep;
+                audioPlayer->m_targetFill.store(std::min(target, buffer->capacity()), std::memory_order_relaxed);
+            }
+            break; // 无数据，剩余部分由 miniaudio 预先填充的静音补齐
+        }
+    }
+
+    if (OutputSink::enabled()) {
+        OutputSink::instance().writeAudio(static_cast<const float *>(pOutput), frameCount, static_cast<int>(pDevice->playback.channels));
     }
 }
@@ -0,0 +1,110 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "renderer/framepacer.h"
+#include "clock/globalclock.h"
+#include "stats/playbackstats.h"
+#include <algorithm>
+#include <cmath>
+
+void FramePacer::reset() {
+    m_last = {kInvalid, kInvalid};
+    m_renderTime = kInvalid;
+}
+
+FramePacer::Plan FramePacer::schedule(const Frame &frame, double diff, double speed, double maxFrameDuration, bool restart, double now) {
+    // 上一帧持续时间，倍速播放时媒体时间流逝得更快，换算为现实时间
+    double delay = frameDuration(m_last, frame, maxFrameDuration) / speed;
+    m_last = frame;
+
+    // //[0.004 - 1/fps -  0.01]与主时钟差距保证在范围外需要同步 //NOTE： ffplay用的[0.04-0.1]
+    Sync sync = Sync::ON_TIME;
+    const double syncThreshold = std::max(0.004, std::min(0.01, delay));
+    if (!std::isnan(diff) && std::abs(diff) < maxFrameDuration) {
+        if (diff <= -syncThreshold) { // 落后太多，尝试直接播放
+            sync = Sync::LATE;
+            delay = std::max(0.0, delay + diff);
+        } else if (diff >= syncThreshold) { // 领先太多
+            sync = Sync::EARLY;
+            delay = delay + (delay > 0.1 ? diff : delay);
+        }
+    }
+
+    if (std::isnan(m_renderTime) || restart) {
+        m_renderTime = now;
+    } else {
+        m_renderTime += delay;
+    }
+
+    double dt = m_renderTime - now;
+    if (dt > kMaxWait) {
+        dt = kMaxWait;
+        m_renderTime = now + dt;
+    }
+    return {std::max(dt, 0.0), sync};
+}
+
+bool FramePacer::shouldPresent(const Frame *next, double speed, double maxFrameDuration, double now) const {
+    return !next || now <= m_renderTime + frameDuration(m_last, *next, maxFrameDuration) / speed;
+}
+
+void FramePacer::resume(double now) {
+    m_renderTime = now;
+}
+
+double FramePacer::renderTime() const {
+    return m_renderTime;
+}
+
+double FramePacer::frameDuration(const Frame &last, const Frame &now, double maxFrameDuration) {
+    double duration = now.pts - last.pts;
+    if (std::isnan(duration) || duration <= 0 || duration > maxFrameDuration)
+        duration = std::isnan(last.duration) ? 0.0 : last.duration;
+    return duration;
+}
+
+bool FramePacer::presentFrame(const Frame &frame, bool restart, Hooks &hooks) {
+    GlobalClock &clock = GlobalClock::instance();
+    PlaybackStats &stats = PlaybackStats::instance();
+    // 倍速播放时媒体时间流逝得更快，以下延迟/差值均换算为现实时间
+    const double speed = clock.speed();
+    const double maxFrameDuration = clock.maxFrameDuration();
+
+    // 同步主时钟
+    const double diff = (clock.videoPts() - clock.getMainPts()) / speed;
+    const Plan plan = schedule(frame, diff, speed, maxFrameDuration, restart, hooks.now());
+    if (plan.sync == Sync::LATE)
+        stats.lateFrameCount++;
+    else if (plan.sync == Sync::EARLY)
+        stats.earlyFrameCount++;
+
+    if (plan.wait > 0)
+        hooks.sleepFor(plan.wait);
+
+    Frame next{kInvalid, kInvalid};
+    const bool haveNext = hooks.peekNext(next);
+    const double nowTime = hooks.now();
+    const bool presented = shouldPresent(haveNext ? &next : nullptr, speed, maxFrameDuration, nowTime);
+    if (presented) {
+        if (!restart) { // seek 后的第一帧没有计划时刻
+            stats.recordPresentJitter(nowTime - m_renderTime);
+        }
+        stats.recordQueueDepth(hooks.queueDepth());
+        hooks.present();
+    } else {
+        stats.droppedFrameCount++;
+        hooks.drop();
+    }
+
+    // 更新视频时钟
+    clock.setVideoClk(frame.pts);
+    clock.syncExternalClk(ClockType::VIDEO);
+
+    stats.videoPTS = frame.pts;
+    const double avDiff = clock.getMainPts() - clock.videoPts();
+    stats.avPtsDiff = avDiff;
+    if (!restart) { // seek 后的第一帧不计入误差分布
+        stats.recordAvSyncError(avDiff);
+    }
+    return presented;
+}
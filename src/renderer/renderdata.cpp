@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "renderer/renderdata.h"
+#include "utils/palette.h"
 
 #include <QDateTime>
 
@@ -242,12 +243,21 @@ void VideoRenderData::updateGLParaArr(PixFormat fmt) {
     }
 }
 
+int64_t VideoRenderData::memoryBytes() const {
+    int64_t bytes = 0;
+    for (const auto &plane : dst16)
+        bytes += static_cast<int64_t>(plane.capacity() * sizeof(uint16_t));
+    if (frmItem.frm) {
+        for (const AVBufferRef *buf : frmItem.frm->buf) {
+            if (buf)
+                bytes += static_cast<int64_t>(buf->size);
+        }
+    }
+    return bytes;
+}
+
 //======SubRenderData===========//
 void SubRenderData::reset() {
-    if (subSwsCtx) { // MABEY: 需要free吗
-        sws_freeContext(subSwsCtx);
-        subSwsCtx = nullptr;
-    }
     avsubtitle_free(&frmItem.sub);
     subtitleType = SUBTITLE_NONE;
     frmItem.pts = INVALID_DOUBLE;
@@ -280,6 +290,7 @@ void SubRenderData::updateBitmapImage(AVFrmItem *newItem, int videoWidth, int vi
 
     subtitleType = SUBTITLE_BITMAP;
 
+    PaletteLUT lut;
     for (unsigned i = 0; i < sub.num_rects; ++i) {
         AVSubtitleRect *subRect = sub.rects[i];
         subtitleType = subRect->type;
@@ -297,25 +308,19 @@ void SubRenderData::updateBitmapImage(AVFrmItem *newItem, int videoWidth, int vi
         linesizeArr[i] = subRect->w;
         dataArr[i].resize(subRect->h * subRect->w * 4);
 
-        subSwsCtx = sws_getCachedContext(subSwsCtx,
-                                         subRect->w, subRect->h, AV_PIX_FMT_PAL8,
-                                         subRect->w, subRect->h, AV_PIX_FMT_RGBA,
-                                         0, NULL, NULL, NULL);
-
-        const int dstStride[1] = {linesizeArr[i] * 4};
-        uint8_t *const dst[1] = {dataArr[i].data()};
-        sws_scale(subSwsCtx, (const uint8_t *const *)subRect->data, subRect->linesize, 0, subRect->h, dst, dstStride);
+        // PAL8 直接查表展开为 RGBA，每个矩形的调色板只转换一次
+        buildPaletteLUT(lut, reinterpret_cast<const uint32_t *>(subRect->data[1]), subRect->nb_colors);
+        expandPal8ToRGBA(subRect->data[0], subRect->linesize[0], lut,
+                         dataArr[i].data(), linesizeArr[i] * 4, subRect->w, subRect->h);
     }
 }
 
-void SubRenderData::updateASSImage(double pts, int videoWidth, int videoHeight) {
+void SubRenderData::updateASSImage(const ASSRender::Frame &frame) {
     subtitleType = SUBTITLE_ASS;
-    size_t rectsSize; // ASS每帧的rects数量
-    const ASS_Image *assImg = ASSRender::instance().getASSImage(rectsSize, QSize{videoWidth, videoHeight}, pts);
-    prepareBuffers(rectsSize);
+    prepareBuffers(frame.size);
 
-    ASSRender::instance().renderFrame(dataArr, rects, assImg);
-    for (size_t i = 0; i < rectsSize; ++i) {
+    ASSRender::instance().renderFrame(dataArr, rects, frame);
+    for (size_t i = 0; i < frame.size; ++i) {
         linesizeArr[i] = rects[i].width(); // 在OpenGL中linesizeArr是像素个数
     }
 
@@ -331,3 +336,10 @@ void SubRenderData::prepareBuffers(size_t newSize) {
         dataArr.resize(size);
     }
 }
+
+int64_t SubRenderData::memoryBytes() const {
+    int64_t bytes = 0;
+    for (const auto &data : dataArr)
+        bytes += static_cast<int64_t>(data.capacity());
+    return bytes;
+}
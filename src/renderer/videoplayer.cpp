@@ -3,7 +3,10 @@
 
 #include "renderer/videoplayer.h"
 #include "clock/globalclock.h"
+#include "clock/timesource.h"
+#include "stats/outputsink.h"
 #include "stats/playbackstats.h"
+#include "stats/tracer.h"
 #include <QDateTime>
 #include <QDebug>
 
@@ -31,10 +34,9 @@ bool VideoPlayer::init(sharedFrmQueue frmBuf, sharedFrmQueue subFrmBuf) {
         b2.reset();
         return true;
     });
-    m_lastVideoFrameInterval = qMakePair(INVALID_DOUBLE, INVALID_DOUBLE);
+    m_pacer.reset();
     m_needClearSubtitle = false;
     m_subtitleEndDisplayTime = 1e9;
-    m_renderTime = INVALID_DOUBLE;
     m_serial = 0;
     m_width = 0;
     m_height = 0;
@@ -65,7 +67,7 @@ void VideoPlayer::start() {
     }
     m_stop.store(false, std::memory_order_relaxed);
     m_paused.store(false, std::memory_order_relaxed);
-    m_thread = std::thread([this]() {
+    m_thread = TaskExecutor::instance().submit(TaskQoS::Display, "AZ-video", [this]() {
         playerLoop();
     });
 }
@@ -84,7 +86,7 @@ void VideoPlayer::togglePaused() {
     }
     bool paused = m_paused.load(std::memory_order_relaxed);
     if (paused) {
-        m_renderTime = getRelativeSeconds();
+        m_pacer.resume(getRelativeSeconds());
     }
     m_paused.store(!paused, std::memory_order_release);
 }
@@ -96,7 +98,7 @@ void VideoPlayer::clearSubtitle() {
 void VideoPlayer::playerLoop() {
     // 确保音视频设备都完成了基本初始化
     while (!DeviceStatus::instance().initialized() && !m_stop.load(std::memory_order_relaxed)) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        TimeSource::instance().sleepFor(0.005);
     }
 
     AVFrmItem frmItem;
@@ -104,7 +106,7 @@ void VideoPlayer::playerLoop() {
         // 处理视频seek/切流
         int ok = getVideoFrm(frmItem);
         if (!ok) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            TimeSource::instance().sleepFor(0.005);
             continue;
         }
 
@@ -114,7 +116,7 @@ void VideoPlayer::playerLoop() {
         }
 
         if (!m_forceRefresh && m_paused.load(std::memory_order_relaxed)) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            TimeSource::instance().sleepFor(0.005);
             continue;
         }
 
@@ -123,7 +125,9 @@ void VideoPlayer::playerLoop() {
             write(frmItem);
         }
 
-        if (m_forceRefresh && GlobalClock::instance().mainClockType() == ClockType::VIDEO) {
+        // 外部时钟为主时钟且没有音频时，由视频报告seek完成
+        const ClockType mainClock = GlobalClock::instance().mainClockType();
+        if (m_forceRefresh && (mainClock == ClockType::VIDEO || (mainClock == ClockType::EXTERNAL && !DeviceStatus::instance().haveAudio()))) {
             emit seeked();
         }
         m_forceRefresh = false;
@@ -137,94 +141,80 @@ void VideoPlayer::write(AVFrmItem &videoFrmitem) {
     m_width = videoFrmitem.frm->width;
     m_height = videoFrmitem.frm->height;
 
-    const FrameInterval nowVideoFrameInterval = qMakePair(videoFrmitem.pts, videoFrmitem.duration);
-    // 上一帧持续时间
-    double delay = getDuration(m_lastVideoFrameInterval, nowVideoFrameInterval);
+    const FramePacer::Frame frame{videoFrmitem.pts, videoFrmitem.duration};
 
     // 处理字幕seek/切流
-    AVFrmItem subFrmItem;
-    while (m_subFrmBuf->peekFirst(subFrmItem) && subFrmItem.serial != m_subFrmBuf->serial()) {
-        (void)m_subFrmBuf->pop(subFrmItem); // 能 peekFirst，说明一定能 pop 成功
-        avsubtitle_free(&subFrmItem.sub);
+    for (AVFrmItem *sub = m_subFrmBuf->front(); sub && sub->serial != m_subFrmBuf->serial(); sub = m_subFrmBuf->front()) {
+        avsubtitle_free(&sub->sub);
+        m_subFrmBuf->popFront();
         m_forceRefresh = true;
     }
 
     // ==============在渲染之前准备好数据==============
     // clang-format off
     double startTime = getRelativeSeconds();
-    (void)m_videoRenderData.write([&](VideoRenderData &renData, [[maybe_unused]] int idx) -> bool {
-        m_lastVideoFrameInterval = nowVideoFrameInterval;
+    const VideoRenderData *written = nullptr; // release 之前写线程仍可读取
+    (void)m_videoRenderData.write([&](VideoRenderData &renData, int idx) -> bool {
+        AZ_TRACE_SCOPE("vplay.prep", videoFrmitem.serial, videoFrmitem.pts);
         renData.updateFormat(videoFrmitem);
+        written = &renData;
+        m_videoBufBytes[idx] = renData.memoryBytes();
         return true;
     }, false);
     PlaybackStats::instance().updateVideoPrepTime((getRelativeSeconds() - startTime) * 1000);
     // clang-format on
 
     startTime = getRelativeSeconds();
-    if (ASSRender::instance().initialized()) {
-        handleASSSubtitle(videoFrmitem.pts);
-    } else {
-        // 位图字幕
-        handleBitmapSubtitle();
-    }
+    {
+        AZ_TRACE_SCOPE("vplay.subtitle", videoFrmitem.serial, videoFrmitem.pts);
+        if (ASSRender::instance().initialized()) {
+            handleASSSubtitle(videoFrmitem.pts);
+        } else {
+            // 位图字幕
+            handleBitmapSubtitle();
+        }
 
-    if (m_needClearSubtitle || m_forceRefresh) {
-        handleEmptySubtitle();
-        m_needClearSubtitle = false;
+        if (m_needClearSubtitle || m_forceRefresh) {
+            handleEmptySubtitle();
+            m_needClearSubtitle = false;
+        }
     }
     PlaybackStats::instance().updateSubPrepTime((getRelativeSeconds() - startTime) * 1000);
+    PlaybackStats::instance().renderBufferBytes = m_videoBufBytes[0] + m_videoBufBytes[1] + m_subBufBytes[0] + m_subBufBytes[1];
     // ==============渲染数据准备完毕==============
 
-    // 同步主时钟
-    const double maxFrameDuration = GlobalClock::instance().maxFrameDuration();
-    const double diff = GlobalClock::instance().videoPts() - GlobalClock::instance().getMainPts();
-    // //[0.004 - 1/fps -  0.01]与主时钟差距保证在范围外需要同步 //NOTE： ffplay用的[0.04-0.1]
-    const double syncThreshold = std::max(0.004, std::min(0.01, delay));
-    if (!std::isnan(diff) && std::abs(diff) < maxFrameDuration) {
-        if (diff <= -syncThreshold) { // 落后太多，尝试直接播放
-            PlaybackStats::instance().lateFrameCount++;
-            delay = std::max(0.0, delay + diff);
-        } else if (diff >= syncThreshold) { // 领先太多
-            PlaybackStats::instance().earlyFrameCount++;
-            delay = delay + (delay > 0.1 ? diff : delay);
+    // 送显，与 azplayer-syncsim 共用同一流程
+    struct Hooks : FramePacer::Hooks {
+        VideoPlayer &player;
+        const AVFrmItem &item;
+        const VideoRenderData *written;
+
+        Hooks(VideoPlayer &p, const AVFrmItem &i, const VideoRenderData *w) : player(p), item(i), written(w) {}
+        double now() override { return getRelativeSeconds(); }
+        void sleepFor(double seconds) override {
+            AZ_TRACE_SCOPE("vplay.wait", item.serial, item.pts);
+            TimeSource::instance().sleepFor(seconds);
         }
-    }
-
-    if (std::isnan(m_renderTime) || m_forceRefresh) {
-        m_renderTime = getRelativeSeconds();
-    } else {
-        m_renderTime += delay;
-    }
-
-    double nowTime = getRelativeSeconds();
-    double dt = m_renderTime - nowTime;
-
-    if (dt > 0) {
-        if (dt > 0.1) {
-            dt = 0.1;
-            m_renderTime = nowTime + dt;
+        bool peekNext(FramePacer::Frame &next) override {
+            const AVFrmItem *nextItem = player.m_frmBuf->front();
+            if (!nextItem)
+                return false;
+            next = {nextItem->pts, nextItem->duration};
+            return true;
         }
-        std::this_thread::sleep_for(std::chrono::duration<double>(dt));
-    }
-
-    AVFrmItem tmpItem;
-    bool peekOk = m_frmBuf->peekFirst(tmpItem);
-
-    nowTime = getRelativeSeconds();
-    if (!peekOk || nowTime <= m_renderTime + getDuration(nowVideoFrameInterval, qMakePair(tmpItem.pts, tmpItem.duration))) {
-        m_videoRenderData.release();
-        m_subRenderData.release();
-        emit renderDataReady(&m_videoRenderData, &m_subRenderData);
-    } else {
-        PlaybackStats::instance().droppedFrameCount++;
-    }
-
-    // 更新视频时钟
-    GlobalClock::instance().setVideoClk(videoFrmitem.pts);
-    GlobalClock::instance().syncExternalClk(ClockType::VIDEO);
-
-    PlaybackStats::instance().videoPTS = videoFrmitem.pts;
-    PlaybackStats::instance().avPtsDiff = GlobalClock::instance().getMainPts() - GlobalClock::instance().videoPts();
+        size_t queueDepth() override { return player.m_frmBuf->size(); }
+        void present() override {
+            if (OutputSink::enabled()) {
+                OutputSink::instance().writeVideo(*written);
+            }
+            player.m_videoRenderData.release();
+            player.m_subRenderData.release();
+            AZ_TRACE_INSTANT("vplay.present", item.serial, item.pts);
+            emit player.renderDataReady(&player.m_videoRenderData, &player.m_subRenderData);
+        }
+        void drop() override { AZ_TRACE_INSTANT("vplay.drop", item.serial, item.pts); }
+    } hooks(*this, videoFrmitem, written);
+    m_pacer.presentFrame(frame, m_forceRefresh, hooks);
 }
 
 bool VideoPlayer::getVideoFrm(AVFrmItem &item) {
@@ -253,21 +243,18 @@ bool VideoPlayer::getVideoFrm(AVFrmItem &item) {
     return false;
 }
 
-double VideoPlayer::getDuration(const FrameInterval &last, const FrameInterval &now) {
-    const double maxFrameDuration = GlobalClock::instance().maxFrameDuration();
-    double duration = now.first - last.first;
-    if (std::isnan(duration) || duration <= 0 || duration > maxFrameDuration)
-        duration = std::isnan(last.second) ? 0.0 : last.second;
-    return duration;
-}
-
 // clang-format off
 void VideoPlayer::handleASSSubtitle(double pts)
 {
-    (void)m_subRenderData.write([&](SubRenderData &renData, int) -> bool {
-        renData.updateASSImage(pts, m_width, m_height);
+    const ASSRender::Frame frame = ASSRender::instance().getASSImage(QSize{m_width, m_height}, pts);
+    if (frame.unchanged)
+        return; // 不写入双缓冲，渲染端继续显示已上传的字幕
+
+    (void)m_subRenderData.write([&](SubRenderData &renData, int idx) -> bool {
+        renData.updateASSImage(frame);
         renData.frmItem.width  = m_width;
         renData.frmItem.height = m_height;
+        m_subBufBytes[idx] = renData.memoryBytes();
         return true;
     }, false);
 }
@@ -276,18 +263,20 @@ void VideoPlayer::handleBitmapSubtitle()
 {
     AVFrmItem subFrmItem;
     const double videoPts = GlobalClock::instance().videoPts();
-    if (m_subFrmBuf->peekFirst(subFrmItem) && videoPts >= subFrmItem.pts) {
+    const AVFrmItem *nextSub = m_subFrmBuf->front();
+    if (nextSub && videoPts >= nextSub->pts) {
         // 有新字幕
-        (void)m_subFrmBuf->pop(subFrmItem); // 能 peekFirst，说明一定能 pop 成功
+        (void)m_subFrmBuf->pop(subFrmItem); // front 不为空，一定能 pop 成功
 
         if (subFrmItem.serial != m_subFrmBuf->serial()) {
             m_forceRefresh = true;
             return;
         }
 
-        (void)m_subRenderData.write([&](SubRenderData &renData, [[maybe_unused]] int idx) -> bool {
+        (void)m_subRenderData.write([&](SubRenderData &renData, int idx) -> bool {
             renData.updateBitmapImage(&subFrmItem, m_width, m_height);
             m_subtitleEndDisplayTime = subFrmItem.pts + subFrmItem.duration;
+            m_subBufBytes[idx] = renData.memoryBytes();
             return true;
         }, false);
     } else if (videoPts >= m_subtitleEndDisplayTime) {
@@ -298,9 +287,10 @@ void VideoPlayer::handleBitmapSubtitle()
 
 void VideoPlayer::handleEmptySubtitle()
 {
-    (void)m_subRenderData.write([&](SubRenderData &renData, int) -> bool {
+    (void)m_subRenderData.write([&](SubRenderData &renData, int idx) -> bool {
         renData.updateBitmapImage(nullptr, m_width, m_height);
         m_subtitleEndDisplayTime = 1e9;
+        m_subBufBytes[idx] = renData.memoryBytes();
         return true;
     }, false);
 }
@@ -3,9 +3,12 @@
 
 #include "renderer/videorenderer.h"
 #include "clock/globalclock.h"
+#include "stats/outputsink.h"
 #include "stats/playbackstats.h"
+#include "stats/tracer.h"
 #include "utils/utils.h"
 #include <QOpenGLFramebufferObjectFormat>
+#include <algorithm>
 namespace {
     // 为了避免 非 POD 静态对象 导致的初始化顺序问题
     std::vector<uint8_t> &texFill() {
@@ -19,6 +22,7 @@ namespace {
 }
 
 VideoRenderer::VideoRenderer() {
+    AZ_TRACE_THREAD_NAME("qt-render"); // 在渲染线程上创建
     initializeOpenGLFunctions();
     static const QString vSrcPath = QStringLiteral(":/shaderSource/shader.vert");
     static const QString fSrcPath = QStringLiteral(":/shaderSource/shader.frag");
@@ -141,6 +145,7 @@ void VideoRenderer::initVideoTex(VideoRenderData *renderData) {
         }
     }
     m_needInitVideoTex = false;
+    updateTextureStats();
 }
 
 void VideoRenderer::initSubtitleTex(SubRenderData *subRenderData) {
@@ -156,22 +161,28 @@ void VideoRenderer::initSubtitleTex(SubRenderData *subRenderData) {
             m_subtitleSize = m_frameSize;
         }
 
-        // 字幕纹理
-        initTex(m_subTex, m_subtitleSize, {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE}, nullptr);
+        // 字幕纹理，新纹理的内容未定义，只在创建时整体清零一次，之后只清理脏矩形
+        {
+            std::vector<uint8_t> zero(static_cast<size_t>(m_subtitleSize.width()) * m_subtitleSize.height() * 4, 0);
+            glActiveTexture(GL_TEXTURE0 + 4);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            initTex(m_subTex, m_subtitleSize, {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE}, zero.data());
+        }
+        lastSubTexRect().clear();
 
         loc = m_program.uniformLocation("haveSubTex"); // 主要用于标记有字幕纹理(即使当前播放的视频没有字幕)
         m_program.setUniformValue(loc, true);
 
-        // 清空
-        clearSubtitleTex();
-
         m_needInitSubtitleTex = false;
         m_program.release();
+        updateTextureStats();
     }
 }
 
 QOpenGLFramebufferObject *VideoRenderer::createFramebufferObject(const QSize &size) {
     m_FBOSize = size;
+    updateTextureStats();
 
     QOpenGLFramebufferObjectFormat format;
     format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
@@ -187,6 +198,7 @@ void VideoRenderer::render() {
         return;
     }
 
+    AZ_TRACE_SCOPE_NAMED(traceRender, "render", -1, INVALID_DOUBLE);
     GLint prevAlign = 0;
     GLint prevRowLen = 0;
     glGetIntegerv(GL_UNPACK_ALIGNMENT, &prevAlign);
@@ -194,6 +206,7 @@ void VideoRenderer::render() {
 
     if (m_subData) {
         (void)m_subData->read([&](SubRenderData &renData, int) -> bool {
+            AZ_TRACE_SCOPE("render.subtitle", renData.frmItem.serial, renData.frmItem.pts);
             // 初始化字幕纹理
             if (renData.subtitleType != SUBTITLE_NONE && (renData.frmItem.width != m_subtitleSize.width() || renData.frmItem.height != m_subtitleSize.height())) {
                 m_needInitSubtitleTex = true;
@@ -209,7 +222,9 @@ void VideoRenderer::render() {
     }
 
     // read 可能失败，此时复用纹理
-    (void)m_vidData->read([&](VideoRenderData &renData, int) -> bool {
+    double framePts = INVALID_DOUBLE;
+    double frameDuration = INVALID_DOUBLE;
+    const bool newFrame = m_vidData->read([&](VideoRenderData &renData, int) -> bool {
         AVFrame *frm = renData.frmItem.frm;
         if (frm == nullptr)
             return false;
@@ -224,18 +239,23 @@ void VideoRenderer::render() {
         for (int i = 0; i < 4; ++i) {
             dataArr[i] = renData.dataArr[i];
         }
-        // 上传视频纹理
-        if (!updateTex(renData.pixFormat)) {
-            return false;
+        // 上传视频纹理(CPU 侧耗时，包括驱动拷贝)
+        AZ_TRACE_SET_FRAME(traceRender, renData.frmItem.serial, renData.frmItem.pts);
+        const double uploadStart = getRelativeSeconds();
+        {
+            AZ_TRACE_SCOPE("render.upload", renData.frmItem.serial, renData.frmItem.pts);
+            if (!updateTex(renData.pixFormat)) {
+                return false;
+            }
         }
+        PlaybackStats::instance().updateUploadTime((getRelativeSeconds() - uploadStart) * 1000);
 
         // 更新播放信息
-        if (frm->format != PlaybackStats::instance().videoFormat) {
-            PlaybackStats::instance().videoPixFormat = QString(av_get_pix_fmt_name((AVPixelFormat)frm->format));
-            PlaybackStats::instance().videoFormat = frm->format;
-        }
+        PlaybackStats::instance().videoFormat = frm->format;
 
         renData.renderedTime = getRelativeSeconds(); // NOTE: 当前并未使用该变量
+        framePts = renData.frmItem.pts;
+        frameDuration = renData.frmItem.duration;
         return true;
     });
 
@@ -268,9 +288,54 @@ void VideoRenderer::render() {
     // 绘制结束
     PlaybackStats::instance().FBOSize = m_FBOSize;
     PlaybackStats::instance().frameRendered();
+
+    if (newFrame && OutputSink::fboEnabled()) {
+        captureFrame(framePts, frameDuration);
+    }
+}
+
+void VideoRenderer::captureFrame(double pts, double duration) {
+    const int width = m_FBOSize.width();
+    const int height = m_FBOSize.height();
+    if (width <= 0 || height <= 0)
+        return;
+
+    GLint drawFBO = 0;
+    GLint readFBO = 0;
+    GLint packAlign = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFBO);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFBO);
+    glGetIntegerv(GL_PACK_ALIGNMENT, &packAlign);
+
+    // 多重采样的 FBO 不能直接读，先解析到单采样的 FBO
+    if (!m_captureFBO || m_captureFBO->size() != m_FBOSize) {
+        m_captureFBO = std::make_unique<QOpenGLFramebufferObject>(m_FBOSize);
+        updateTextureStats();
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, drawFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_captureFBO->handle());
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    m_capturePixels.resize(static_cast<size_t>(width) * height * 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_captureFBO->handle());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, m_capturePixels.data());
+
+    glPixelStorei(GL_PACK_ALIGNMENT, packAlign);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, readFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFBO);
+
+    // OpenGL 的行序自下而上，翻转为自上而下
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    for (int y = 0; y < height / 2; ++y) {
+        std::swap_ranges(m_capturePixels.begin() + y * rowBytes, m_capturePixels.begin() + (y + 1) * rowBytes,
+                         m_capturePixels.begin() + (height - 1 - y) * rowBytes);
+    }
+    OutputSink::instance().writeFBO(m_capturePixels.data(), width, height, pts, duration);
 }
 
 void VideoRenderer::synchronize(QQuickFramebufferObject *item) {
+    AZ_TRACE_SCOPE("render.sync", -1, INVALID_DOUBLE);
     VideoWindow *videoWindow = static_cast<VideoWindow *>(item);
     m_vidData = videoWindow->m_vidData;
     m_subData = videoWindow->m_subData;
@@ -288,6 +353,11 @@ void VideoRenderer::synchronize(QQuickFramebufferObject *item) {
     m_forceClearSubtitle = &videoWindow->m_forceClearSubtitle;
 }
 
+void VideoRenderer::setRenderData(VideoDoubleBuf *vidData, SubtitleDoubleBuf *subData) {
+    m_vidData = vidData;
+    m_subData = subData;
+}
+
 bool VideoRenderer::updateTex(VideoRenderData::PixFormat fmt) {
     if (fmt == VideoRenderData::NONE)
         return false;
@@ -335,38 +405,16 @@ bool VideoRenderer::updateSubTex(SubRenderData &renData) {
     glBindTexture(GL_TEXTURE_2D, m_subTex);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-    // 清理旧数据
+    // 清理纹理上的旧字幕(只清理上一次写入的矩形，被新字幕完全覆盖的跳过)
     if (renData.size == 0) {
-        clearSubtitleTex();
+        clearSubTexRects(nullptr, 0);
         renData.uploaded = true;
         return true;
     }
-
-    if (renData.subtitleType != lastSubType) {
-        clearSubtitleTex();
-        lastSubType = renData.subtitleType;
-    }
-
-    // 清理纹理上的旧字幕
-    for (size_t i = 0; i < lastSubTexRect().size(); ++i) {
-        const QRect &rect = lastSubTexRect()[i];
-        int x = std::clamp(rect.x(), 0, m_frameSize.width());
-        int y = std::clamp(rect.y(), 0, m_frameSize.height());
-        int w = std::clamp(rect.width(), 0, m_frameSize.width() - x);
-        int h = std::clamp(rect.height(), 0, m_frameSize.height() - y);
-
-        if (w == 0 || h == 0)
-            continue;
-
-        if ((int)texFill().size() < h * w * 4) {
-            texFill().assign(h * w * 4, 0);
-        }
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, w);
-        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, texFill().data());
-    }
+    clearSubTexRects(renData.rects.data(), renData.size);
 
     // 保存当前字幕区域
-    lastSubTexRect() = renData.rects;
+    lastSubTexRect().assign(renData.rects.begin(), renData.rects.begin() + renData.size);
 
     // 绘制新字幕
     for (size_t i = 0; i < renData.size; ++i) {
@@ -390,6 +438,37 @@ bool VideoRenderer::updateSubTex(SubRenderData &renData) {
     return true;
 }
 
+void VideoRenderer::updateTextureStats() {
+    // 纹理按驱动报告的尺寸与各分量位数计算(不含驱动内部的对齐填充)
+    auto texBytes = [this](GLuint tex) -> int64_t {
+        if (tex == 0)
+            return 0;
+        glBindTexture(GL_TEXTURE_2D, tex);
+        GLint width = 0, height = 0, bits = 0;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+        for (GLenum pname : {GL_TEXTURE_RED_SIZE, GL_TEXTURE_GREEN_SIZE, GL_TEXTURE_BLUE_SIZE, GL_TEXTURE_ALPHA_SIZE}) {
+            GLint size = 0;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, pname, &size);
+            bits += size;
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return static_cast<int64_t>(width) * height * ((bits + 7) / 8);
+    };
+
+    int64_t bytes = texBytes(m_subTex);
+    for (GLuint tex : m_texArr)
+        bytes += texBytes(tex);
+
+    // FBO：4x MSAA 的 RGBA8 + 深度模板(各 4 字节/采样)，Qt 另有一个解析用的单采样 RGBA8 纹理
+    const int64_t pixels = static_cast<int64_t>(m_FBOSize.width()) * m_FBOSize.height();
+    bytes += pixels * (4 + 4) * 4 + pixels * 4;
+    if (m_captureFBO)
+        bytes += static_cast<int64_t>(m_captureFBO->width()) * m_captureFBO->height() * 4;
+
+    PlaybackStats::instance().textureBytes = bytes;
+}
+
 void VideoRenderer::initTex(GLuint &tex, const QSize &size, const std::array<unsigned int, 3> &para, uint8_t *fill) {
     if (tex != 0)
         glDeleteTextures(1, &tex);
@@ -476,13 +555,33 @@ void VideoRenderer::clearSubtitleTex() {
     glBindTexture(GL_TEXTURE_2D, m_subTex);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-    // 清空字幕，和矩形列表
-    int fillLen = m_subtitleSize.height() * m_subtitleSize.width() * 4;
-    if ((int)texFill().size() < fillLen) {
-        texFill().assign(fillLen, 0);
+    // 纹理上只有 lastSubTexRect 中的区域可能非零
+    clearSubTexRects(nullptr, 0);
+}
+
+void VideoRenderer::clearSubTexRects(const QRect *keepRects, size_t keepCount) {
+    const QRect texRect(0, 0, m_subtitleSize.width(), m_subtitleSize.height());
+    for (const QRect &oldRect : lastSubTexRect()) {
+        const QRect rect = oldRect.intersected(texRect);
+        if (rect.isEmpty())
+            continue;
+
+        // 新字幕会完整覆盖该区域，无需清理(位图字幕通常位置不变)
+        bool covered = false;
+        for (size_t i = 0; i < keepCount && !covered; ++i) {
+            covered = keepRects[i].contains(rect);
+        }
+        if (covered)
+            continue;
+
+        const int w = rect.width();
+        const int h = rect.height();
+        if ((int)texFill().size() < h * w * 4) {
+            texFill().assign(h * w * 4, 0);
+        }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, w);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x(), rect.y(), w, h, GL_RGBA, GL_UNSIGNED_BYTE, texFill().data());
     }
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, m_subtitleSize.width());
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_subtitleSize.width(), m_subtitleSize.height(), GL_RGBA, GL_UNSIGNED_BYTE, texFill().data());
     lastSubTexRect().clear();
 }
 
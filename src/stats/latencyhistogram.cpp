@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "stats/latencyhistogram.h"
+#include <algorithm>
+#include <cmath>
+
+void LatencyHistogram::reset() {
+    for (std::atomic<uint64_t> &bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::loadCounts(Counts &counts) const {
+    // 读的过程中写线程可能还在记录，总数以实际读到的桶为准，保证百分位自洽
+    uint64_t total = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    return total;
+}
+
+double LatencyHistogram::valueAtRank(const Counts &counts, uint64_t rank, uint64_t max) {
+    uint64_t acc = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        acc += counts[i];
+        if (acc > rank) {
+            // 取桶的中点，不超过已知的最大值
+            const double mid = static_cast<double>(bucketLower(i)) + (bucketWidth(i) - 1) * 0.5;
+            return std::min(mid, static_cast<double>(max));
+        }
+    }
+    return static_cast<double>(max);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Counts counts;
+    Snapshot snap;
+    snap.count = loadCounts(counts);
+    snap.max = m_max.load(std::memory_order_relaxed);
+    if (snap.count == 0)
+        return snap;
+
+    snap.mean = static_cast<double>(m_sum.load(std::memory_order_relaxed)) / snap.count;
+    auto rankOf = [&](double p) {
+        return static_cast<uint64_t>(std::ceil(p * snap.count)) - 1;
+    };
+    snap.p50 = valueAtRank(counts, rankOf(0.50), snap.max);
+    snap.p95 = valueAtRank(counts, rankOf(0.95), snap.max);
+    snap.p99 = valueAtRank(counts, rankOf(0.99), snap.max);
+    return snap;
+}
+
+double LatencyHistogram::percentile(double p) const {
+    Counts counts;
+    const uint64_t total = loadCounts(counts);
+    if (total == 0)
+        return 0.0;
+    const double rank = std::ceil(std::clamp(p, 0.0, 1.0) * total);
+    return valueAtRank(counts, rank > 0 ? static_cast<uint64_t>(rank) - 1 : 0, m_max.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,591 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "stats/outputsink.h"
+#include "renderer/renderdata.h"
+#include "utils/spscbuffer.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+namespace {
+    constexpr uint64_t kAudioRingBytes = uint64_t{1} << 23; // 8MB，48kHz 8 声道约 5 秒
+    constexpr size_t kAudioScratchBytes = 64 * 1024;
+    constexpr auto kAudioPollInterval = std::chrono::milliseconds(10);
+
+    // clang-format off
+    struct ListName {
+        const char *kind;
+        const char *file;
+    };
+    constexpr ListName kLists[] = {
+        {"video", "video.xxh64"},
+        {"fbo",   "fbo.xxh64"},
+        {"audio", "audio.xxh64"},
+    };
+    // clang-format on
+
+    // 渲染器上传的一个平面
+    struct Plane {
+        const uint8_t *data = nullptr;
+        int rowBytes = 0; // 每行有效字节数
+        int rows = 0;
+        int stride = 0;   // 每行实际字节数(含填充)
+    };
+
+    struct PlaneList {
+        std::array<Plane, 4> planes{};
+        int count = 0;
+    };
+
+    int planeCount(VideoRenderData::PixFormat fmt) {
+        switch (fmt) {
+        case VideoRenderData::RGB_PACKED:
+        case VideoRenderData::RGBA_PACKED:
+        case VideoRenderData::Y:
+            return 1;
+        case VideoRenderData::YA:
+            return 2;
+        case VideoRenderData::RGB_PLANAR:
+        case VideoRenderData::YUV:
+            return 3;
+        case VideoRenderData::RGBA_PLANAR:
+        case VideoRenderData::YUVA:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    // 与 VideoRenderer::updateTex 读取的范围一致：每个平面 componentSizeArr 大小，行距 linesizeArr
+    PlaneList describePlanes(const VideoRenderData &data) {
+        PlaneList list;
+        const bool packed = data.pixFormat == VideoRenderData::RGB_PACKED || data.pixFormat == VideoRenderData::RGBA_PACKED;
+        const int packedBytes = packed ? av_get_padded_bits_per_pixel(av_pix_fmt_desc_get((AVPixelFormat)data.frmItem.frm->format)) / 8 : 0;
+        const int count = planeCount(data.pixFormat);
+        for (int i = 0; i < count; ++i) {
+            if (!data.dataArr[i])
+                break;
+            const int elemBytes = packed ? packedBytes : (data.componentBitSize[i] > 8 ? 2 : 1);
+            Plane &p = list.planes[i];
+            p.data = data.dataArr[i];
+            p.rowBytes = data.componentSizeArr[i].width() * elemBytes;
+            p.rows = data.componentSizeArr[i].height();
+            p.stride = data.linesizeArr[i] * elemBytes;
+            list.count = i + 1;
+        }
+        return list;
+    }
+
+    // 能用 y4m 表示时的色度标签与要写出的平面数，tag 为空表示不支持
+    struct Y4MLayout {
+        const char *tag = nullptr;
+        int planes = 0;
+    };
+
+    Y4MLayout y4mLayout(const VideoRenderData &data) {
+        auto depth = [&data](int i) { return data.componentBitSize[i] > 8 ? 16 : 8; };
+        if (data.pixFormat == VideoRenderData::Y)
+            return {depth(0) == 16 ? "mono16" : "mono", 1};
+        if (data.pixFormat != VideoRenderData::YUV && data.pixFormat != VideoRenderData::YUVA)
+            return {};
+        if (depth(1) != depth(0) || depth(2) != depth(0) || data.componentSizeArr[1] != data.componentSizeArr[2])
+            return {};
+
+        const bool p16 = depth(0) == 16;
+        const QSize luma = data.componentSizeArr[0];
+        const QSize chroma = data.componentSizeArr[1];
+        const bool fullW = chroma.width() == luma.width();
+        const bool halfW = chroma.width() == (luma.width() + 1) / 2;
+        const bool fullH = chroma.height() == luma.height();
+        const bool halfH = chroma.height() == (luma.height() + 1) / 2;
+        if (fullW && fullH) {
+            // y4m 只有 8bit 4:4:4 带透明通道，其余情况丢弃透明通道
+            if (data.pixFormat == VideoRenderData::YUVA && !p16 && depth(3) == 8)
+                return {"444alpha", 4};
+            return {p16 ? "444p16" : "444", 3};
+        }
+        if (halfW && fullH)
+            return {p16 ? "422p16" : "422", 3};
+        if (halfW && halfH)
+            return {p16 ? "420p16" : "420jpeg", 3};
+        return {};
+    }
+
+    // 44 字节的 WAV 头，32bit IEEE float
+    QByteArray wavHeader(int channels, int sampleRate, uint64_t dataBytes) {
+        const uint32_t dataSize = static_cast<uint32_t>(std::min<uint64_t>(dataBytes, UINT32_MAX - 36));
+        QByteArray header;
+        header.reserve(44);
+        auto u16 = [&header](uint32_t v) {
+            header.append(static_cast<char>(v & 0xFF));
+            header.append(static_cast<char>((v >> 8) & 0xFF));
+        };
+        auto u32 = [&](uint32_t v) {
+            u16(v & 0xFFFF);
+            u16(v >> 16);
+        };
+        header.append("RIFF", 4);
+        u32(36 + dataSize);
+        header.append("WAVEfmt ", 8);
+        u32(16);
+        u16(3); // WAVE_FORMAT_IEEE_FLOAT
+        u16(static_cast<uint32_t>(channels));
+        u32(static_cast<uint32_t>(sampleRate));
+        u32(static_cast<uint32_t>(sampleRate * channels * 4));
+        u16(static_cast<uint32_t>(channels * 4));
+        u16(32);
+        header.append("data", 4);
+        u32(dataSize);
+        return header;
+    }
+
+    QList<QByteArray> readLines(const QString &path) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return {};
+        QList<QByteArray> lines = file.readAll().split('\n');
+        if (!lines.isEmpty() && lines.back().isEmpty())
+            lines.removeLast();
+        return lines;
+    }
+}
+
+OutputSink::OutputSink() = default;
+
+OutputSink::~OutputSink() {
+    end();
+}
+
+OutputSink &OutputSink::instance() {
+    static OutputSink instance;
+    return instance;
+}
+
+bool OutputSink::begin(const QString &dir, const Options &opt) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    endLocked();
+
+    if (!QDir().mkpath(dir)) {
+        qDebug() << "无法创建输出记录目录:" << dir;
+        return false;
+    }
+    m_dir = QDir(dir);
+    m_opt = opt;
+    m_videoY4M.segment = 0;
+    m_fboY4M.segment = 0;
+    if (!m_audioRing) {
+        m_audioRing = std::make_unique<SPSCBuffer>(kAudioRingBytes);
+        m_audioScratch.resize(kAudioScratchBytes);
+    }
+
+    bool ok = openList(m_videoList, "video") && (!opt.fbo || openList(m_fboList, "fbo"));
+    {
+        std::lock_guard<std::mutex> audioLock(m_audioMutex);
+        ok = ok && openList(m_audioList, "audio");
+        if (ok) {
+            m_audioRing->unsafeClear(); // 未开启时回调不会写入
+            while (m_audioDrops.front()) {
+                m_audioDrops.popFront();
+            }
+            m_pendingDrop = {};
+            m_audioWritten = 0;
+            m_audioRead = 0;
+            m_audioDroppedTotal = 0;
+            m_wavSegment = 0;
+            m_audioActive = true;
+            openAudioSegment();
+        }
+    }
+    if (!ok) {
+        closeList(m_videoList);
+        closeList(m_fboList);
+        std::lock_guard<std::mutex> audioLock(m_audioMutex);
+        closeList(m_audioList);
+        return false;
+    }
+
+    m_audioStop.store(false, std::memory_order_relaxed);
+    m_audioThread = TaskExecutor::instance().submit(TaskQoS::Background, "AZ-outputsink", [this]() {
+        while (!m_audioStop.load(std::memory_order_acquire)) {
+            {
+                std::lock_guard<std::mutex> audioLock(m_audioMutex);
+                drainAudioRing();
+            }
+            std::this_thread::sleep_for(kAudioPollInterval);
+        }
+    });
+
+    s_fbo.store(opt.fbo);
+    s_enabled.store(true);
+    qDebug() << "输出记录:" << dir << "dump:" << opt.dump << "fbo:" << opt.fbo;
+    return true;
+}
+
+void OutputSink::end() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    endLocked();
+}
+
+void OutputSink::endLocked() {
+    if (!s_enabled.load())
+        return;
+    s_enabled.store(false);
+    s_fbo.store(false);
+
+    // 等已经进入 writeAudio 的回调写完
+    while (m_audioInFlight.load() != 0) {
+        std::this_thread::yield();
+    }
+    m_audioStop.store(true, std::memory_order_release);
+    if (m_audioThread.joinable())
+        m_audioThread.join();
+
+    {
+        std::lock_guard<std::mutex> audioLock(m_audioMutex);
+        drainAudioRing();
+        // 回调都已退出，最后一次丢弃可能还在 m_pendingDrop 中
+        if (m_pendingDrop.bytes > 0) {
+            writeDropMarker(m_pendingDrop.bytes);
+            m_pendingDrop = {};
+        }
+        closeAudioSegment();
+        if (m_audioDroppedTotal > 0)
+            qDebug() << "输出记录: 环形缓冲区满，丢弃了" << m_audioDroppedTotal << "字节音频";
+        m_audioActive = false;
+        qDebug() << "输出记录结束: 视频" << m_videoList.count << "帧, FBO" << m_fboList.count << "帧, 音频" << m_audioList.count << "秒";
+        closeList(m_audioList);
+    }
+    closeList(m_videoList);
+    closeList(m_fboList);
+    closeY4M(m_videoY4M);
+    closeY4M(m_fboY4M);
+}
+
+bool OutputSink::openList(HashList &list, const char *kind) {
+    list.file.setFileName(m_dir.filePath(QStringLiteral("%1.xxh64").arg(QLatin1String(kind))));
+    list.count = 0;
+    if (!list.file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "无法写入哈希列表:" << list.file.fileName();
+        return false;
+    }
+    list.file.write(QByteArray("# azplayer output sink v1 ") + kind + '\n');
+    return true;
+}
+
+void OutputSink::closeList(HashList &list) {
+    if (list.file.isOpen())
+        list.file.close();
+}
+
+bool OutputSink::beginY4MFrame(Y4MFile &y4m, const char *baseName, const QByteArray &key, double duration) {
+    if (!y4m.file.isOpen() || y4m.key != key) {
+        closeY4M(y4m);
+        y4m.key = key;
+        const QString name = y4m.segment == 0 ? QStringLiteral("%1.y4m").arg(QLatin1String(baseName))
+                                              : QStringLiteral("%1.%2.y4m").arg(QLatin1String(baseName)).arg(y4m.segment);
+        y4m.file.setFileName(m_dir.filePath(name));
+        if (!y4m.file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qDebug() << "无法写入:" << y4m.file.fileName();
+            m_opt.dump = false;
+            return false;
+        }
+        // y4m 只有一个固定帧率，用本段第一帧的时长
+        const AVRational rate = duration > 0.0 && std::isfinite(duration) ? av_d2q(1.0 / duration, 1 << 20) : AVRational{25, 1};
+        char header[256];
+        const int n = std::snprintf(header, sizeof(header), "YUV4MPEG2 %s F%d:%d Ip A1:1\n", key.constData(), rate.num, rate.den);
+        y4m.file.write(header, n);
+    }
+    y4m.file.write("FRAME\n", 6);
+    return true;
+}
+
+void OutputSink::closeY4M(Y4MFile &y4m) {
+    if (y4m.file.isOpen()) {
+        y4m.file.close();
+        ++y4m.segment;
+    }
+    y4m.key.clear();
+}
+
+void OutputSink::writeVideo(const VideoRenderData &data) {
+    const AVFrame *frm = data.frmItem.frm;
+    if (!frm || data.pixFormat == VideoRenderData::NONE)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!enabled())
+        return;
+
+    const PlaneList planes = describePlanes(data);
+    XXHash64 hash;
+    for (int i = 0; i < planes.count; ++i) {
+        const Plane &p = planes.planes[i];
+        for (int y = 0; y < p.rows; ++y)
+            hash.update(p.data + static_cast<ptrdiff_t>(y) * p.stride, static_cast<size_t>(p.rowBytes));
+    }
+
+    const char *fmtName = av_get_pix_fmt_name((AVPixelFormat)frm->format);
+    char line[160];
+    const int n = std::snprintf(line, sizeof(line), "%lld %.6f %dx%d %s %016llx\n", static_cast<long long>(m_videoList.count),
+                                data.frmItem.pts, frm->width, frm->height, fmtName ? fmtName : "unknown",
+                                static_cast<unsigned long long>(hash.digest()));
+    m_videoList.file.write(line, n);
+    ++m_videoList.count;
+
+    if (!m_opt.dump)
+        return;
+    const Y4MLayout layout = y4mLayout(data);
+    if (!layout.tag) {
+        // RGB 与 YA 没有对应的 y4m 格式，只记录哈希
+        if (m_videoY4M.key != "unsupported") {
+            qDebug() << "输出记录: y4m 不支持的像素格式" << (fmtName ? fmtName : "unknown") << "，只记录哈希";
+            closeY4M(m_videoY4M);
+            m_videoY4M.key = "unsupported";
+        }
+        return;
+    }
+    char key[128];
+    (void)std::snprintf(key, sizeof(key), "W%d H%d C%s XCOLORRANGE=%s", data.componentSizeArr[0].width(), data.componentSizeArr[0].height(),
+                        layout.tag, frm->color_range == AVCOL_RANGE_JPEG ? "FULL" : "LIMITED");
+    if (!beginY4MFrame(m_videoY4M, "video", QByteArray(key), data.frmItem.duration))
+        return;
+    for (int i = 0; i < layout.planes && i < planes.count; ++i) {
+        const Plane &p = planes.planes[i];
+        for (int y = 0; y < p.rows; ++y)
+            m_videoY4M.file.write(reinterpret_cast<const char *>(p.data) + static_cast<ptrdiff_t>(y) * p.stride, p.rowBytes);
+    }
+}
+
+void OutputSink::writeFBO(const uint8_t *rgba, int width, int height, double pts, double duration) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!enabled() || !m_opt.fbo)
+        return;
+
+    const size_t pixels = static_cast<size_t>(width) * height;
+    const uint64_t hash = XXHash64::hash(rgba, pixels * 4);
+    char line[128];
+    const int n = std::snprintf(line, sizeof(line), "%lld %.6f %dx%d %016llx\n", static_cast<long long>(m_fboList.count), pts, width, height,
+                                static_cast<unsigned long long>(hash));
+    m_fboList.file.write(line, n);
+    ++m_fboList.count;
+
+    if (!m_opt.dump)
+        return;
+    // 转为全范围 BT.601 YUV444 写入 y4m，只用于查看，哈希基于原始 RGBA
+    m_fboPlanes.resize(pixels * 3);
+    uint8_t *dstY = m_fboPlanes.data();
+    uint8_t *dstU = dstY + pixels;
+    uint8_t *dstV = dstU + pixels;
+    for (size_t i = 0; i < pixels; ++i) {
+        const int r = rgba[i * 4 + 0];
+        const int g = rgba[i * 4 + 1];
+        const int b = rgba[i * 4 + 2];
+        dstY[i] = static_cast<uint8_t>((77 * r + 150 * g + 29 * b + 128) >> 8);
+        dstU[i] = static_cast<uint8_t>(std::min(255, (-43 * r - 85 * g + 128 * b + 32896) >> 8));
+        dstV[i] = static_cast<uint8_t>(std::min(255, (128 * r - 107 * g - 21 * b + 32896) >> 8));
+    }
+    char key[96];
+    (void)std::snprintf(key, sizeof(key), "W%d H%d C444 XCOLORRANGE=FULL", width, height);
+    if (beginY4MFrame(m_fboY4M, "fbo", QByteArray(key), duration))
+        m_fboY4M.file.write(reinterpret_cast<const char *>(m_fboPlanes.data()), static_cast<qint64>(m_fboPlanes.size()));
+}
+
+void OutputSink::setAudioFormat(int channels, int sampleRate) {
+    std::lock_guard<std::mutex> audioLock(m_audioMutex);
+    if (channels == m_channels && sampleRate == m_sampleRate)
+        return;
+    if (m_audioActive) {
+        // 旧设备的数据按旧格式写完
+        drainAudioRing();
+        closeAudioSegment();
+    }
+    m_channels = channels;
+    m_sampleRate = sampleRate;
+    if (m_audioActive)
+        openAudioSegment();
+}
+
+void OutputSink::writeAudio(const float *pcm, uint32_t frames, int channels) {
+    if (!enabled())
+        return;
+    // 与 endLocked 配对：先登记再确认仍在记录，end 在关闭后等待登记数归零
+    m_audioInFlight.fetch_add(1);
+    if (s_enabled.load()) {
+        const uint64_t len = static_cast<uint64_t>(frames) * channels * sizeof(float);
+        // 放不下时整块丢弃，只写入一部分会让之后的数据错开声道；只有本线程写入，检查后一定能写完
+        if (m_audioRing->writeAvailable() >= len) {
+            // 丢弃之后又写入了数据，它的位置不会再变，交给写线程；队列满时留到下一次
+            if (m_pendingDrop.bytes > 0 && m_audioDrops.push(AudioDrop{m_pendingDrop}))
+                m_pendingDrop = {};
+            (void)m_audioRing->write(reinterpret_cast<const uint8_t *>(pcm), len);
+            m_audioWritten += len;
+        } else if (m_pendingDrop.bytes == 0) {
+            m_pendingDrop = {m_audioWritten, len};
+        } else {
+            // 与上一次丢弃之间没有写入时位置相同；否则说明丢弃队列已满，只能合并到上一次的位置
+            m_pendingDrop.bytes += len;
+        }
+    }
+    m_audioInFlight.fetch_sub(1);
+}
+
+void OutputSink::writeAudioSync(const float *pcm, uint32_t frames, int channels) {
+    if (!enabled())
+        return;
+    std::lock_guard<std::mutex> audioLock(m_audioMutex);
+    if (m_audioActive)
+        consumeAudio(reinterpret_cast<const uint8_t *>(pcm), static_cast<uint64_t>(frames) * channels * sizeof(float));
+}
+
+void OutputSink::drainAudioRing() {
+    if (!m_audioRing)
+        return;
+    while (true) {
+        // 先取可读长度再看丢弃队列：回调先把丢弃入队再写入之后的数据，这部分数据可读时对应的丢弃一定可见
+        uint64_t want = std::min<uint64_t>(m_audioScratch.size(), m_audioRing->readAvailable());
+        // 只读到丢弃发生的位置，在列表中对应的地方插入说明
+        if (const AudioDrop *drop = m_audioDrops.front()) {
+            if (drop->offset <= m_audioRead) {
+                writeDropMarker(drop->bytes);
+                m_audioDrops.popFront();
+                continue;
+            }
+            want = std::min(want, drop->offset - m_audioRead);
+        }
+        if (want == 0)
+            break;
+        const uint64_t len = m_audioRing->read(m_audioScratch.data(), want);
+        if (len == 0)
+            break;
+        m_audioRead += len;
+        consumeAudio(m_audioScratch.data(), len);
+    }
+}
+
+void OutputSink::writeDropMarker(uint64_t dropped) {
+    m_audioDroppedTotal += dropped;
+    // 丢过数据的列表一定与 golden 不同，compare 会停在这一行
+    const uint64_t frame = m_channels > 0 ? m_audioFrames + m_chunkBytes / (static_cast<uint64_t>(m_channels) * sizeof(float)) : 0;
+    char line[128];
+    const int n = std::snprintf(line, sizeof(line), "# dropped %llu bytes after frame %llu\n", static_cast<unsigned long long>(dropped),
+                                static_cast<unsigned long long>(frame));
+    m_audioList.file.write(line, n);
+}
+
+void OutputSink::consumeAudio(const uint8_t *data, uint64_t len) {
+    if (m_channels <= 0 || m_sampleRate <= 0)
+        return;
+    if (m_wav.isOpen()) {
+        m_wav.write(reinterpret_cast<const char *>(data), static_cast<qint64>(len));
+        m_wavBytes += len;
+    }
+    // 每秒一个哈希，与设备每次回调的帧数无关
+    const uint64_t chunkBytes = static_cast<uint64_t>(m_sampleRate) * m_channels * sizeof(float);
+    while (len > 0) {
+        const uint64_t n = std::min(len, chunkBytes - m_chunkBytes);
+        m_audioHash.update(data, n);
+        m_chunkBytes += n;
+        data += n;
+        len -= n;
+        if (m_chunkBytes == chunkBytes)
+            finishAudioChunk();
+    }
+}
+
+void OutputSink::finishAudioChunk() {
+    if (m_chunkBytes == 0)
+        return;
+    const uint64_t frames = m_chunkBytes / (static_cast<uint64_t>(m_channels) * sizeof(float));
+    char line[128];
+    const int n = std::snprintf(line, sizeof(line), "%lld %llu %llu %016llx\n", static_cast<long long>(m_audioList.count),
+                                static_cast<unsigned long long>(m_audioFrames), static_cast<unsigned long long>(frames),
+                                static_cast<unsigned long long>(m_audioHash.digest()));
+    m_audioList.file.write(line, n);
+    ++m_audioList.count;
+    m_audioFrames += frames;
+    m_audioHash.reset();
+    m_chunkBytes = 0;
+}
+
+void OutputSink::openAudioSegment() {
+    m_audioHash.reset();
+    m_chunkBytes = 0;
+    m_audioFrames = 0;
+    if (m_channels <= 0 || m_sampleRate <= 0)
+        return;
+
+    char line[96];
+    const int n = std::snprintf(line, sizeof(line), "# audio f32le %dch %dHz\n", m_channels, m_sampleRate);
+    m_audioList.file.write(line, n);
+
+    if (!m_opt.dump)
+        return;
+    const QString name = m_wavSegment == 0 ? QStringLiteral("audio.wav") : QStringLiteral("audio.%1.wav").arg(m_wavSegment);
+    m_wav.setFileName(m_dir.filePath(name));
+    if (!m_wav.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "无法写入:" << m_wav.fileName();
+        return;
+    }
+    m_wav.write(wavHeader(m_channels, m_sampleRate, 0)); // 长度在关闭时补上
+    m_wavBytes = 0;
+}
+
+void OutputSink::closeAudioSegment() {
+    finishAudioChunk();
+    if (!m_wav.isOpen())
+        return;
+    if (m_wav.seek(0))
+        m_wav.write(wavHeader(m_channels, m_sampleRate, m_wavBytes));
+    m_wav.close();
+    ++m_wavSegment;
+}
+
+QJsonObject OutputSink::compare(const QString &goldenDir, const QString &dir) {
+    QJsonObject result;
+    bool ok = true;
+    for (const ListName &list : kLists) {
+        const QString goldenPath = QDir(goldenDir).filePath(QLatin1String(list.file));
+        if (!QFileInfo::exists(goldenPath))
+            continue;
+        const QList<QByteArray> expected = readLines(goldenPath);
+        const QList<QByteArray> actual = readLines(QDir(dir).filePath(QLatin1String(list.file)));
+
+        qsizetype mismatch = -1;
+        const qsizetype common = std::min(expected.size(), actual.size());
+        for (qsizetype i = 0; i < common; ++i) {
+            if (expected[i] != actual[i]) {
+                mismatch = i;
+                break;
+            }
+        }
+        if (mismatch < 0 && expected.size() != actual.size())
+            mismatch = common;
+
+        QJsonObject item;
+        item["ok"] = mismatch < 0;
+        item["lines"] = static_cast<qint64>(actual.size());
+        item["goldenLines"] = static_cast<qint64>(expected.size());
+        if (mismatch >= 0) {
+            ok = false;
+            const QByteArray exp = mismatch < expected.size() ? expected[mismatch] : QByteArray();
+            const QByteArray act = mismatch < actual.size() ? actual[mismatch] : QByteArray();
+            // 记录行的第一个字段是序号(视频/FBO 为帧，音频为秒)
+            const QByteArray &record = !exp.isEmpty() && !exp.startsWith('#') ? exp : act;
+            bool isRecord = false;
+            const qint64 frame = record.left(record.indexOf(' ')).toLongLong(&isRecord);
+            item["line"] = static_cast<qint64>(mismatch + 1);
+            item["frame"] = isRecord ? frame : -1;
+            item["expected"] = QString::fromLatin1(exp);
+            item["actual"] = QString::fromLatin1(act);
+        }
+        result[QLatin1String(list.kind)] = item;
+    }
+    result["ok"] = ok;
+    return result;
+}
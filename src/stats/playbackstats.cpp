@@ -2,19 +2,48 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "stats/playbackstats.h"
+#include "stats/resourcemonitor.h"
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <algorithm>
+#include <cmath>
+
+AZ_EXTERN_C_BEGIN
+#include <libavutil/pixdesc.h>
+AZ_EXTERN_C_END
+
+namespace {
+    struct StageInfo {
+        const char *name;
+        const char *unit;
+        double ticksPerUnit; // 直方图记录的是整数，ms 按 us 精度记录
+    };
 
-PlaybackStats::PlaybackStats(QObject *parent)
-    : QObject{parent} { reset(); }
+    // clang-format off
+    const EnumIndexArray<StageInfo, PlaybackStats::Stage> kStageInfo = {
+        {"videoDecode",   "ms",     1000.0},
+        {"videoPrep",     "ms",     1000.0},
+        {"subPrep",       "ms",     1000.0},
+        {"upload",        "ms",     1000.0},
+        {"presentJitter", "ms",     1000.0},
+        {"avError",       "ms",     1000.0},
+        {"queueDepth",    "frames", 1.0},
+    };
+    // clang-format on
 
-double PlaybackStats::calculateAverage(std::deque<double> &deq, double newValue) {
-    deq.push_back(newValue);
-    if (deq.size() > m_maxSamples) {
-        deq.pop_front();
+    constexpr double kAvgAlpha = 0.2; // 平均耗时的平滑因子
+    constexpr size_t kMaxThreadGroups = 8; // 统计浮层最多显示的线程组数
+
+    QString megabytes(int64_t bytes) {
+        return QString::number(static_cast<double>(bytes) / (1024 * 1024), 'f', 1) + "MB";
     }
-    double sum = std::accumulate(deq.begin(), deq.end(), 0.0);
-    return sum / deq.size();
 }
 
+PlaybackStats::PlaybackStats(QObject *parent)
+    : QObject{parent} { reset(); }
+
 PlaybackStats &PlaybackStats::instance() {
     static PlaybackStats instance;
     return instance;
@@ -30,6 +59,11 @@ void PlaybackStats::reset() {
     videoFrameCount = 0;
     subtitleFrameCount = 0;
 
+    // ==== 内存 ====
+    // 纹理、双缓冲与 libass 的内存在文件之间保留，不清空
+    packetQueueBytes = 0;
+    frameQueueBytes = 0;
+
     // ==== 视频/字幕尺寸 ====
     videoSize = QSize{};
     subtitleSize = QSize{};
@@ -37,7 +71,6 @@ void PlaybackStats::reset() {
 
     // ==== 像素格式 ====
     videoFormat = -1;
-    videoPixFormat = "";
 
     // ==== FPS ====
     videoFps = 0.0;
@@ -45,15 +78,15 @@ void PlaybackStats::reset() {
     m_frameCounter = 0;
     m_lastFpsTime = std::chrono::steady_clock::now();
 
-    // ==== 视频解码耗时统计 ms ====
+    // ==== 耗时统计 ms ====
     videoDecodeTime = 0.0;
     avgVideoDecodeTime = 0.0;
-    // ==== 视频数据准备耗时 ms====
     videoPrepTime = 0.0;
     avgVideoPrepTime = 0.0;
-    // ==== 字幕数据准备耗时 ms====
     subPrepTime = 0.0;
     avgSubPrepTime = 0.0;
+    uploadTime = 0.0;
+    avgUploadTime = 0.0;
 
     // ==== 帧状态 ====
     lateFrameCount = 0;
@@ -64,6 +97,28 @@ void PlaybackStats::reset() {
     videoPTS = INVALID_DOUBLE;
     audioPTS = INVALID_DOUBLE;
     avPtsDiff = INVALID_DOUBLE;
+    audioSwitchLatency = INVALID_DOUBLE;
+    audioDrift = INVALID_DOUBLE;
+    audioCompensationCount = 0;
+    audioCompensatedSamples = 0;
+    audioUnderrunCount = 0;
+    audioBufferMs = INVALID_DOUBLE;
+
+    for (LatencyHistogram &hist : m_histograms) {
+        hist.reset();
+    }
+}
+
+void PlaybackStats::updateAverage(StatValue<double> &avg, double value) {
+    const double old = avg;
+    avg = old == 0.0 ? value : old + kAvgAlpha * (value - old);
+}
+
+void PlaybackStats::record(Stage stage, double value) {
+    if (std::isnan(value))
+        return;
+    const double ticks = std::max(0.0, value) * kStageInfo[stage].ticksPerUnit;
+    m_histograms[stage].record(static_cast<uint64_t>(std::min(ticks + 0.5, static_cast<double>(LatencyHistogram::kMaxValue))));
 }
 
 void PlaybackStats::frameRendered() {
@@ -88,17 +143,120 @@ void PlaybackStats::frameRendered() {
 
 void PlaybackStats::updateVideoDecodeTime(double ms) {
     videoDecodeTime = ms;
-    avgVideoDecodeTime = calculateAverage(m_vDecSamples, ms);
+    updateAverage(avgVideoDecodeTime, ms);
+    record(Stage::VideoDecode, ms);
 }
 
 void PlaybackStats::updateVideoPrepTime(double ms) {
     videoPrepTime = ms;
-    avgVideoPrepTime = calculateAverage(m_vPrepSamples, ms);
+    updateAverage(avgVideoPrepTime, ms);
+    record(Stage::VideoPrep, ms);
 }
 
 void PlaybackStats::updateSubPrepTime(double ms) {
     subPrepTime = ms;
-    avgSubPrepTime = calculateAverage(m_sPrepSamples, ms);
+    updateAverage(avgSubPrepTime, ms);
+    record(Stage::SubPrep, ms);
+}
+
+void PlaybackStats::updateUploadTime(double ms) {
+    uploadTime = ms;
+    updateAverage(avgUploadTime, ms);
+    record(Stage::Upload, ms);
+}
+
+void PlaybackStats::recordPresentJitter(double sec) {
+    record(Stage::PresentJitter, std::abs(sec) * 1000.0);
+}
+
+void PlaybackStats::recordQueueDepth(size_t frames) {
+    record(Stage::QueueDepth, static_cast<double>(frames));
+}
+
+void PlaybackStats::recordAvSyncError(double sec) {
+    record(Stage::AvError, std::abs(sec) * 1000.0);
+}
+
+double PlaybackStats::avSyncErrorPercentile(double p) const {
+    const LatencyHistogram &hist = m_histograms[Stage::AvError];
+    if (hist.snapshot().count == 0)
+        return INVALID_DOUBLE;
+    return hist.percentile(p) / kStageInfo[Stage::AvError].ticksPerUnit;
+}
+
+LatencyHistogram::Snapshot PlaybackStats::snapshot(Stage stage) const {
+    return m_histograms[stage].snapshot();
+}
+
+QJsonObject PlaybackStats::toJson() const {
+    QJsonObject counters;
+    counters["lateFrames"] = static_cast<int>(lateFrameCount);
+    counters["earlyFrames"] = static_cast<int>(earlyFrameCount);
+    counters["droppedFrames"] = static_cast<int>(droppedFrameCount);
+    counters["audioUnderruns"] = static_cast<int>(audioUnderrunCount);
+    counters["audioCompensations"] = static_cast<int>(audioCompensationCount);
+    counters["audioCompensatedSamples"] = static_cast<qint64>(audioCompensatedSamples);
+    counters["videoFps"] = static_cast<double>(videoFps);
+    counters["outputFps"] = static_cast<double>(outputFps);
+
+    QJsonObject stages;
+    for (size_t i = 0; i < kStageInfo.size(); ++i) {
+        const StageInfo &info = kStageInfo[i];
+        const LatencyHistogram::Snapshot snap = m_histograms[i].snapshot();
+        QJsonObject obj;
+        obj["unit"] = info.unit;
+        obj["count"] = static_cast<qint64>(snap.count);
+        obj["mean"] = snap.mean / info.ticksPerUnit;
+        obj["p50"] = snap.p50 / info.ticksPerUnit;
+        obj["p95"] = snap.p95 / info.ticksPerUnit;
+        obj["p99"] = snap.p99 / info.ticksPerUnit;
+        obj["max"] = static_cast<double>(snap.max) / info.ticksPerUnit;
+        stages[info.name] = obj;
+    }
+
+    QJsonObject memory;
+    memory["packetQueues"] = static_cast<qint64>(packetQueueBytes);
+    memory["frameQueues"] = static_cast<qint64>(frameQueueBytes);
+    memory["renderBuffers"] = static_cast<qint64>(renderBufferBytes);
+    memory["libass"] = static_cast<qint64>(libassBytes);
+    memory["textures"] = static_cast<qint64>(textureBytes);
+
+    QJsonObject root;
+    root["build"] = QStringLiteral(__DATE__ " " __TIME__);
+    root["qt"] = qVersion();
+    root["counters"] = counters;
+    root["stages"] = stages;
+    root["memory"] = memory;
+
+    // 只有采样过(显示过统计)才有线程 CPU
+    const ResourceMonitor::Snapshot res = ResourceMonitor::instance().snapshot();
+    if (res.valid) {
+        QJsonArray threads;
+        for (const ResourceMonitor::ThreadGroup &group : res.groups) {
+            QJsonObject obj;
+            obj["name"] = QString::fromStdString(group.name);
+            obj["threads"] = group.threads;
+            obj["cpu"] = group.cpu;
+            obj["peak"] = group.peak;
+            threads.append(obj);
+        }
+        QJsonObject resources;
+        resources["processCpu"] = res.processCpu;
+        resources["rss"] = static_cast<qint64>(res.rssBytes);
+        resources["threads"] = threads;
+        root["resources"] = resources;
+    }
+    return root;
+}
+
+bool PlaybackStats::dumpJson(const QString &path) const {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "无法写入播放统计:" << path;
+        return false;
+    }
+    file.write(QJsonDocument(toJson()).toJson(QJsonDocument::Indented));
+    return true;
 }
 
 QString PlaybackStats::getPlaybackStatsStringHTML() const {
@@ -109,6 +267,9 @@ QString PlaybackStats::getPlaybackStatsStringHTML() const {
         return QString("<b><span style='color:%1;'>%2:</span></b> <span style='color:%3;'>%4</span> ")
             .arg(labelColor, label, valColor, value);
     };
+    auto sizeText = [](const QSize &size) {
+        return QString("%1x%2").arg(size.width()).arg(size.height());
+    };
 
     // ==== 队列长度 (Packets) ====
     str += item("Pkt队列: A", QString::number(audioPacketCount), "white", "green");
@@ -123,35 +284,40 @@ QString PlaybackStats::getPlaybackStatsStringHTML() const {
     str += "<br>";
 
     // ==== 尺寸 (Size) ====
-    str += item("尺寸: Video", QString("%1x%2").arg(videoSize.width()).arg(videoSize.height()), "white", "cyan");
-    str += item("Subtitle", QString("%1x%2").arg(subtitleSize.width()).arg(subtitleSize.height()), "white", "magenta");
-    str += item("Frame Buffer", QString("%1x%2").arg(FBOSize.width()).arg(FBOSize.height()), "white", "gray");
+    str += item("尺寸: Video", sizeText(videoSize.load()), "white", "cyan");
+    str += item("Subtitle", sizeText(subtitleSize.load()), "white", "magenta");
+    str += item("Frame Buffer", sizeText(FBOSize.load()), "white", "gray");
     str += "<br>";
 
     // ==== 4. 像素格式 & 视频解码耗时 ====
-    str += item("像素格式", videoPixFormat, "white", "yellow");
+    const char *pixFmtName = av_get_pix_fmt_name(static_cast<AVPixelFormat>(static_cast<int>(videoFormat)));
+    str += item("像素格式", pixFmtName ? pixFmtName : "", "white", "yellow");
 
     // 性能统计：解码与准备 ms
     const int vdec = static_cast<int>(avgVideoDecodeTime);
     const int vprep = static_cast<int>(avgVideoPrepTime);
     const int sprep = static_cast<int>(avgSubPrepTime);
+    const int upload = static_cast<int>(avgUploadTime);
 
     str += item("视频解码", QString::number(vdec) + "ms", "white", (vdec > 30 ? "red" : "#55FF55"));
     str += item("视频准备", QString::number(vprep) + "ms", "white", (vprep > 30 ? "red" : "#55FF55"));
     str += item("字幕准备", QString::number(sprep) + "ms", "white", (sprep > 5 ? "red" : "#55FF55"));
+    str += item("纹理上传", QString::number(upload) + "ms", "white", (upload > 10 ? "red" : "#55FF55"));
     str += "<br>";
 
     // ==== FPS 逻辑处理 ====
+    const double srcFps = videoFps;
+    const double curFps = outputFps;
     QString outputFpsColor = "green";
-    if (videoFps > 0) {
-        double ratio = outputFps / videoFps;
+    if (srcFps > 0) {
+        double ratio = curFps / srcFps;
         if (ratio < 0.5)
             outputFpsColor = "red";
         else if (ratio < 0.7)
             outputFpsColor = "yellow";
     }
-    str += item("源FPS", QString::number(videoFps, 'f', 3), "white", "cyan");
-    str += item("当前FPS", QString::number(outputFps, 'f', 3), "white", outputFpsColor);
+    str += item("源FPS", QString::number(srcFps, 'f', 3), "white", "cyan");
+    str += item("当前FPS", QString::number(curFps, 'f', 3), "white", outputFpsColor);
     str += "<br>";
 
     // ==== 帧状态 (Frames Status) ====
@@ -161,16 +327,105 @@ QString PlaybackStats::getPlaybackStatsStringHTML() const {
     str += "<br>";
 
     // ==== PTS & 同步 (PTS) ====
+    const double avDiff = avPtsDiff;
     QString avDiffColor = "green";
-    if (qAbs(avPtsDiff) * 1000 > 10)
+    if (qAbs(avDiff) * 1000 > 10)
         avDiffColor = "red";
-    else if (qAbs(avPtsDiff) * 1000 > 5)
+    else if (qAbs(avDiff) * 1000 > 5)
         avDiffColor = "yellow";
 
     str += item("VideoPTS", QString::number(videoPTS, 'f', 3), "white", "cyan");
     str += item("AudioPTS", QString::number(audioPTS, 'f', 3), "white", "magenta");
-    str += item("AVDiff", QString::number(avPtsDiff, 'f', 3), "white", avDiffColor);
+    str += item("AVDiff", QString::number(avDiff, 'f', 3), "white", avDiffColor);
+    str += "<br>";
+
+    // ==== 同步误差与送显抖动分布 ====
+    auto stageItems = [&](const QString &label, Stage stage, double warnMs) {
+        const LatencyHistogram::Snapshot snap = m_histograms[stage].snapshot();
+        if (snap.count == 0)
+            return;
+        const double scale = kStageInfo[stage].ticksPerUnit;
+        const double p95 = snap.p95 / scale;
+        str += item(label + " P50", QString::number(snap.p50 / scale, 'f', 1) + "ms", "white", "cyan");
+        str += item("P95", QString::number(p95, 'f', 1) + "ms", "white", (p95 > warnMs ? "red" : "#55FF55"));
+        str += item("P99", QString::number(snap.p99 / scale, 'f', 1) + "ms", "white", "cyan");
+        str += item("Max", QString::number(snap.max / scale, 'f', 1) + "ms", "white", "cyan");
+        str += "<br>";
+    };
+    stageItems("同步误差", Stage::AvError, 20);
+    stageItems("送显抖动", Stage::PresentJitter, 4);
+
+    // ==== 音频跟随主时钟 ====
+    const double drift = audioDrift;
+    if (!std::isnan(drift)) {
+        str += item("音频漂移", QString::number(drift, 'f', 1) + "ms", "white", (qAbs(drift) > 40 ? "red" : "#55FF55"));
+        str += item("补偿", QString::number(audioCompensationCount), "white", "cyan");
+        str += item("采样", QString::number(audioCompensatedSamples), "white", "cyan");
+        str += "<br>";
+    }
+
+    // ==== 音频流切换耗时 ====
+    const double switchLatency = audioSwitchLatency;
+    if (!std::isnan(switchLatency)) {
+        str += item("音轨切换", QString::number(switchLatency, 'f', 1) + "ms", "white", (switchLatency > 100 ? "yellow" : "#55FF55"));
+        str += "<br>";
+    }
+
+    // ==== 音频缓冲水位与欠载 ====
+    const double bufferMs = audioBufferMs;
+    const int underruns = audioUnderrunCount;
+    if (!std::isnan(bufferMs)) {
+        str += item("音频缓冲", QString::number(bufferMs, 'f', 0) + "ms", "white", "cyan");
+        str += item("欠载", QString::number(underruns), "white", (underruns > 0 ? "yellow" : "#55FF55"));
+        str += "<br>";
+    }
+
+    // ==== 线程 CPU(100% 为一个核心) ====
+    const ResourceMonitor::Snapshot res = ResourceMonitor::instance().snapshot();
+    auto percent = [](double cpu) {
+        return QString::number(cpu, 'f', cpu < 10 ? 1 : 0) + "%";
+    };
+    if (res.valid) {
+        str += item("CPU", percent(res.processCpu), "white", "cyan");
+        str += "<br>";
+        // 颜色按组内单个线程的最高占用，接近 100% 说明该阶段占满了一个核心
+        const size_t count = std::min(res.groups.size(), kMaxThreadGroups);
+        for (size_t i = 0; i < count; ++i) {
+            const ResourceMonitor::ThreadGroup &group = res.groups[i];
+            const QString label = QString::fromStdString(group.name).toHtmlEscaped() +
+                                  (group.threads > 1 ? QString("×%1").arg(group.threads) : QString());
+            const QString color = group.peak > 90 ? "red" : (group.peak > 60 ? "yellow" : "#55FF55");
+            str += item(label, percent(group.cpu), "white", color);
+            if (i % 3 == 2 || i + 1 == count)
+                str += "<br>";
+        }
+    }
+
+    // ==== 内存 ====
+    // 纹理在显存中(软件渲染除外)，不计入常驻内存的拆分
+    const int64_t pktBytes = packetQueueBytes;
+    const int64_t frmBytes = frameQueueBytes;
+    const int64_t renderBytes = renderBufferBytes;
+    const int64_t assBytes = libassBytes;
+    if (res.rssBytes >= 0) {
+        str += item("RSS", megabytes(res.rssBytes), "white", "cyan");
+        str += item("其他", megabytes(std::max<int64_t>(0, res.rssBytes - pktBytes - frmBytes - renderBytes - assBytes)), "white", "gray");
+        str += "<br>";
+    }
+    str += item("Pkt队列", megabytes(pktBytes), "white", "cyan");
+    str += item("Frm队列", megabytes(frmBytes), "white", "cyan");
+    str += item("渲染缓冲", megabytes(renderBytes), "white", "cyan");
+    str += "<br>";
+    str += item("libass", megabytes(assBytes), "white", "magenta");
+    str += item("纹理(显存)", megabytes(textureBytes), "white", "gray");
     str += "<br>";
 
     return str;
 }
+
+void PlaybackStats::setResourceSampling(bool enabled) {
+    if (enabled)
+        ResourceMonitor::instance().start();
+    else
+        ResourceMonitor::instance().stop();
+}
@@ -0,0 +1,243 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "stats/resourcemonitor.h"
+#include <QString>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(Q_OS_LINUX)
+#include <dirent.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+#endif
+
+namespace {
+#if defined(Q_OS_LINUX)
+    // 读取一个 /proc 文件的开头部分，返回读到的字节数
+    size_t readProcFile(const char *path, char *buf, size_t size) {
+        std::FILE *file = std::fopen(path, "r");
+        if (!file)
+            return 0;
+        const size_t len = std::fread(buf, 1, size - 1, file);
+        std::fclose(file);
+        buf[len] = '\0';
+        return len;
+    }
+
+    /**
+     * 解析 /proc/self/task/<tid>/stat：tid (comm) state ppid ...
+     * comm 中可能含空格和括号，以最后一个 ')' 为界；utime/stime 为第 14/15 个字段，单位是时钟滴答
+     */
+    bool parseTaskStat(const char *path, std::string &name, double &cpuSeconds) {
+        static const double ticksPerSecond = static_cast<double>(sysconf(_SC_CLK_TCK));
+        char buf[1024];
+        if (readProcFile(path, buf, sizeof(buf)) == 0)
+            return false;
+        const char *open = std::strchr(buf, '(');
+        const char *close = std::strrchr(buf, ')');
+        if (!open || !close || close < open)
+            return false;
+
+        unsigned long long utime = 0, stime = 0;
+        if (std::sscanf(close + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2)
+            return false;
+        name.assign(open + 1, close);
+        cpuSeconds = static_cast<double>(utime + stime) / ticksPerSecond;
+        return true;
+    }
+#elif defined(Q_OS_WIN)
+    // FILETIME 为 100ns 单位
+    double fileTimeSeconds(const FILETIME &ft) {
+        return static_cast<double>(static_cast<uint64_t>(ft.dwHighDateTime) << 32 | ft.dwLowDateTime) * 1e-7;
+    }
+#endif
+}
+
+ResourceMonitor::ResourceMonitor() {
+    (void)TaskExecutor::instance(); // 先构造执行器，保证它晚于本对象析构
+}
+
+ResourceMonitor::~ResourceMonitor() {
+    stop();
+}
+
+ResourceMonitor &ResourceMonitor::instance() {
+    static ResourceMonitor instance;
+    return instance;
+}
+
+void ResourceMonitor::start(std::chrono::milliseconds interval) {
+    if (m_thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_stopMutex);
+        m_stop = false;
+    }
+    m_thread = TaskExecutor::instance().submit(TaskQoS::Background, "AZ-resmon", [this, interval]() {
+        samplingLoop(interval);
+    });
+}
+
+void ResourceMonitor::stop() {
+    if (!m_thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_stopMutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+}
+
+ResourceMonitor::Snapshot ResourceMonitor::snapshot() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_snapshot;
+}
+
+void ResourceMonitor::samplingLoop(std::chrono::milliseconds interval) {
+    // 每次启动重新建立基准，停止期间的 CPU 时间不计入
+    m_lastThreads.clear();
+    m_hasLast = false;
+
+    std::unique_lock<std::mutex> lock(m_stopMutex);
+    while (!m_stop) {
+        lock.unlock();
+        sample();
+        lock.lock();
+        m_cv.wait_for(lock, interval, [this]() { return m_stop; });
+    }
+}
+
+void ResourceMonitor::sample() {
+    std::unordered_map<uint64_t, ThreadSample> threads;
+    const bool ok = readThreads(threads);
+    const Clock::time_point now = Clock::now();
+
+    Snapshot snap;
+    snap.supported = ok;
+    snap.rssBytes = readRss();
+    if (ok && m_hasLast) {
+        const double wall = std::chrono::duration<double>(now - m_lastTime).count();
+        std::unordered_map<std::string, size_t> groupIdx; // 组名 -> snap.groups 下标
+        for (const auto &[tid, t] : threads) {
+            // 新出现的线程只记录基准，下一次采样才计入
+            const auto last = m_lastThreads.find(tid);
+            double cpu = 0;
+            if (last != m_lastThreads.end() && wall > 0)
+                cpu = std::max(0.0, t.cpuSeconds - last->second.cpuSeconds) / wall * 100;
+
+            const std::string name = groupName(t.name);
+            const auto [it, inserted] = groupIdx.try_emplace(name, snap.groups.size());
+            if (inserted)
+                snap.groups.push_back({name});
+            ThreadGroup &group = snap.groups[it->second];
+            ++group.threads;
+            group.cpu += cpu;
+            group.peak = std::max(group.peak, cpu);
+            snap.processCpu += cpu;
+        }
+        std::sort(snap.groups.begin(), snap.groups.end(), [](const ThreadGroup &a, const ThreadGroup &b) {
+            return a.cpu != b.cpu ? a.cpu > b.cpu : a.name < b.name;
+        });
+        snap.valid = true;
+    }
+
+    m_lastThreads = std::move(threads);
+    m_lastTime = now;
+    m_hasLast = ok;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_snapshot = std::move(snap);
+}
+
+bool ResourceMonitor::readThreads(std::unordered_map<uint64_t, ThreadSample> &threads) {
+#if defined(Q_OS_LINUX)
+    DIR *dir = opendir("/proc/self/task");
+    if (!dir)
+        return false;
+    char path[64];
+    while (const dirent *entry = readdir(dir)) {
+        if (!std::isdigit(static_cast<unsigned char>(entry->d_name[0])))
+            continue; // . 与 ..
+        std::snprintf(path, sizeof(path), "/proc/self/task/%s/stat", entry->d_name);
+        ThreadSample t;
+        if (parseTaskStat(path, t.name, t.cpuSeconds)) // 线程可能刚好退出
+            threads.emplace(std::strtoull(entry->d_name, nullptr, 10), std::move(t));
+    }
+    closedir(dir);
+    return true;
+#elif defined(Q_OS_WIN)
+    // 快照包含系统中所有线程，只取本进程的
+    HANDLE snap = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snap == INVALID_HANDLE_VALUE)
+        return false;
+    const DWORD pid = GetCurrentProcessId();
+    THREADENTRY32 entry{};
+    entry.dwSize = sizeof(entry);
+    for (BOOL more = Thread32First(snap, &entry); more; more = Thread32Next(snap, &entry)) {
+        if (entry.th32OwnerProcessID != pid)
+            continue;
+        HANDLE thread = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, entry.th32ThreadID);
+        if (!thread)
+            continue;
+        FILETIME creation, exit, kernel, user;
+        if (GetThreadTimes(thread, &creation, &exit, &kernel, &user)) {
+            ThreadSample t;
+            t.cpuSeconds = fileTimeSeconds(kernel) + fileTimeSeconds(user);
+            PWSTR desc = nullptr;
+            if (SUCCEEDED(GetThreadDescription(thread, &desc)) && desc) {
+                t.name = QString::fromWCharArray(desc).toStdString();
+                LocalFree(desc);
+            }
+            if (t.name.empty())
+                t.name = "unnamed";
+            threads.emplace(entry.th32ThreadID, std::move(t));
+        }
+        CloseHandle(thread);
+    }
+    CloseHandle(snap);
+    return true;
+#else
+    (void)threads;
+    return false;
+#endif
+}
+
+int64_t ResourceMonitor::readRss() {
+#if defined(Q_OS_LINUX)
+    char buf[4096];
+    if (readProcFile("/proc/self/status", buf, sizeof(buf)) == 0)
+        return -1;
+    const char *line = std::strstr(buf, "VmRSS:");
+    long long kb = 0;
+    if (!line || std::sscanf(line, "VmRSS: %lld", &kb) != 1)
+        return -1;
+    return static_cast<int64_t>(kb) * 1024;
+#elif defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return -1;
+    return static_cast<int64_t>(counters.WorkingSetSize);
+#else
+    return -1;
+#endif
+}
+
+std::string ResourceMonitor::groupName(const std::string &threadName) {
+    // "av:hevc:df3" -> "av:hevc:df"，"Thread (pooled)" 等不带编号的保持不变
+    size_t end = threadName.size();
+    while (end > 0 && std::isdigit(static_cast<unsigned char>(threadName[end - 1])))
+        --end;
+    if (end == threadName.size())
+        return threadName;
+    while (end > 0 && (threadName[end - 1] == '-' || threadName[end - 1] == '_' || threadName[end - 1] == '#'))
+        --end;
+    return end == 0 ? threadName : threadName.substr(0, end);
+}
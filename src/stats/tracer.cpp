@@ -0,0 +1,148 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "stats/tracer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+    int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 名字都来自代码中的字符串常量，这里只是防止意外的引号/反斜杠破坏 JSON
+    void writeString(std::ostream &out, const char *str) {
+        out << '"';
+        for (const char *p = str; *p; ++p) {
+            const unsigned char c = static_cast<unsigned char>(*p);
+            if (c == '"' || c == '\\')
+                out << '\\' << *p;
+            else if (c >= 0x20)
+                out << *p;
+        }
+        out << '"';
+    }
+
+    thread_local const char *t_threadName = nullptr;
+}
+
+Tracer::Tracer()
+    : m_epoch(nowNs()) {}
+
+Tracer &Tracer::instance() {
+    static Tracer ins;
+    return ins;
+}
+
+void Tracer::setEnabled(bool enabled) {
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Tracer::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const std::unique_ptr<ThreadBuffer> &buf : m_buffers) {
+        buf->clearIndex.store(buf->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+void Tracer::setThreadName(const char *name) {
+    t_threadName = name;
+    if (t_buffer)
+        t_buffer->name.store(name, std::memory_order_relaxed);
+}
+
+Tracer::ThreadBuffer *Tracer::threadBuffer() {
+    if (!t_buffer) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffers.push_back(std::make_unique<ThreadBuffer>(static_cast<int>(m_buffers.size()) + 1));
+        t_buffer = m_buffers.back().get();
+        t_buffer->name.store(t_threadName, std::memory_order_relaxed);
+    }
+    return t_buffer;
+}
+
+void Tracer::record(char phase, const char *name, int serial, double pts) {
+    ThreadBuffer *buf = threadBuffer();
+    const uint64_t head = buf->head.load(std::memory_order_relaxed);
+    buf->events[head & (kEventsPerThread - 1)] = {nowNs() - m_epoch, name, pts, serial, phase};
+    buf->head.store(head + 1, std::memory_order_release);
+}
+
+bool Tracer::exportChromeTrace(std::ostream &out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&]() {
+        if (!first)
+            out << ",\n";
+        first = false;
+    };
+
+    char num[64];
+    std::vector<Event> events;
+    for (const std::unique_ptr<ThreadBuffer> &buf : m_buffers) {
+        // 先读写入位置再拷贝，拷贝完再读一次，期间可能已被覆盖的最旧事件丢弃
+        const uint64_t head = buf->head.load(std::memory_order_acquire);
+        uint64_t begin = std::max(buf->clearIndex.load(std::memory_order_relaxed), head > kEventsPerThread ? head - kEventsPerThread : 0);
+        events.clear();
+        for (uint64_t i = begin; i < head; ++i) {
+            events.push_back(buf->events[i & (kEventsPerThread - 1)]);
+        }
+        const uint64_t headAfter = buf->head.load(std::memory_order_acquire);
+        const uint64_t overwritten = headAfter > kEventsPerThread ? headAfter - kEventsPerThread : 0;
+        const size_t skip = overwritten > begin ? static_cast<size_t>(std::min<uint64_t>(overwritten - begin, events.size())) : 0;
+
+        const char *threadName = buf->name.load(std::memory_order_relaxed);
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buf->tid << ",\"args\":{\"name\":";
+        if (threadName) {
+            writeString(out, threadName);
+        } else {
+            std::snprintf(num, sizeof(num), "\"thread-%d\"", buf->tid);
+            out << num;
+        }
+        out << "}}";
+
+        // 环形缓冲区覆盖后开头可能是没有 B 的 E，跳过
+        int depth = 0;
+        for (size_t i = skip; i < events.size(); ++i) {
+            const Event &ev = events[i];
+            if (ev.phase == 'E') {
+                if (depth == 0)
+                    continue;
+                --depth;
+            } else if (ev.phase == 'B') {
+                ++depth;
+            }
+
+            separator();
+            out << "{\"name\":";
+            writeString(out, ev.name);
+            std::snprintf(num, sizeof(num), "%.3f", static_cast<double>(ev.ts) / 1000.0);
+            out << ",\"ph\":\"" << ev.phase << "\",\"ts\":" << num << ",\"pid\":1,\"tid\":" << buf->tid;
+            if (ev.phase == 'i')
+                out << ",\"s\":\"t\"";
+            out << ",\"args\":{\"serial\":" << ev.serial << ",\"pts\":";
+            if (std::isnan(ev.pts)) {
+                out << "null";
+            } else {
+                std::snprintf(num, sizeof(num), "%.6f", ev.pts);
+                out << num;
+            }
+            out << "}}";
+        }
+    }
+    out << "]}\n";
+    return static_cast<bool>(out);
+}
+
+bool Tracer::exportChromeTrace(const std::string &path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+    return exportChromeTrace(out);
+}
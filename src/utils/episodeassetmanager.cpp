@@ -45,12 +45,17 @@ struct FileInfo {
     }
 };
 
-/**
- * 提取集数
- * @param filenames 文件名数组
- * @return 与各个文件名对应的集数, -1表示无法提取集数
- */
-[[nodiscard]] std::vector<int> extractEpisodes(const std::vector<QString>& filenames) {
+} // namespace
+
+EpisodeAssetManager::EpisodeAssetManager(QObject* parent)
+    : QObject{parent} {}
+
+EpisodeAssetManager& EpisodeAssetManager::instance() {
+    static EpisodeAssetManager instance;
+    return instance;
+}
+
+std::vector<int> EpisodeAssetManager::extractEpisodes(const std::vector<QString>& filenames) {
     const size_t n = filenames.size();
     std::vector<FileInfo> files(n);
     std::vector<int> answer(n, -1), unique_nums;
@@ -104,15 +109,6 @@ struct FileInfo {
 
     return answer;
 }
-} // namespace
-
-EpisodeAssetManager::EpisodeAssetManager(QObject* parent)
-    : QObject{parent} {}
-
-EpisodeAssetManager& EpisodeAssetManager::instance() {
-    static EpisodeAssetManager instance;
-    return instance;
-}
 
 QUrl EpisodeAssetManager::resolveSubtitleURL(const QUrl& videoFileURL) {
     const QString localFile = videoFileURL.toLocalFile();
@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "utils/palette.h"
+#include "compat/compat.h"
+#include <cstring>
+
+#ifdef AZ_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace {
+    /**
+     * 展开一行
+     * 开启 AZPLAYER_ENABLE_AVX2 时用 gather 一次查 8 个索引，否则为标量查表：
+     * SSE2/SSSE3 没有 gather，pshufb 只能查 16 项，256 项的查表逐项读取已经是最快的写法
+     */
+    void expandRow(const uint8_t *src, const uint32_t *lut, uint32_t *dst, int width) {
+        int x = 0;
+#ifdef AZ_HAVE_AVX2
+        // 一次查 8 个索引
+        for (; x + 8 <= width; x += 8) {
+            const __m128i idx8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + x));
+            const __m256i idx = _mm256_cvtepu8_epi32(idx8);
+            const __m256i px = _mm256_i32gather_epi32(reinterpret_cast<const int *>(lut), idx, 4);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), px);
+        }
+#endif
+        for (; x + 4 <= width; x += 4) {
+            dst[x + 0] = lut[src[x + 0]];
+            dst[x + 1] = lut[src[x + 1]];
+            dst[x + 2] = lut[src[x + 2]];
+            dst[x + 3] = lut[src[x + 3]];
+        }
+        for (; x < width; ++x) {
+            dst[x] = lut[src[x]];
+        }
+    }
+}
+
+void buildPaletteLUT(PaletteLUT &lut, const uint32_t *palette, int nbColors) {
+    lut.fill(0);
+    if (!palette)
+        return;
+    if (nbColors > 256)
+        nbColors = 256;
+    for (int i = 0; i < nbColors; ++i) {
+        const uint32_t argb = palette[i];
+        const uint8_t px[4] = {
+            static_cast<uint8_t>(argb >> 16), // R
+            static_cast<uint8_t>(argb >> 8),  // G
+            static_cast<uint8_t>(argb),       // B
+            static_cast<uint8_t>(argb >> 24), // A
+        };
+        std::memcpy(&lut[i], px, sizeof(px)); // 与字节序无关
+    }
+}
+
+void expandPal8ToRGBA(const uint8_t *src, int srcStride, const PaletteLUT &lut,
+                      uint8_t *dst, int dstStride, int width, int height) {
+    for (int y = 0; y < height; ++y) {
+        // dst 每行都是 4 字节对齐的(宽度 * 4)，可以直接按 uint32_t 写入
+        expandRow(src + static_cast<size_t>(y) * srcStride, lut.data(),
+                  reinterpret_cast<uint32_t *>(dst + static_cast<size_t>(y) * dstStride), width);
+    }
+}
@@ -4,33 +4,61 @@
 #include "utils/spscbuffer.h"
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstring>
+#include <limits>
+
+namespace {
+    uint64_t roundUpPow2(uint64_t v) {
+        uint64_t n = 1;
+        while (n < v)
+            n <<= 1;
+        return n;
+    }
+}
 
-SPSCBuffer::SPSCBuffer(uint64_t capacity) : m_capacity(capacity), m_mask(capacity - 1),
-                                            m_buffer(std::make_unique<uint8_t[]>(capacity)) {
+SPSCBuffer::SPSCBuffer(uint64_t capacity, uint64_t markerCapacity)
+    : m_capacity(capacity), m_mask(capacity - 1), m_markerMask(roundUpPow2(markerCapacity) - 1),
+      m_buffer(std::make_unique<uint8_t[]>(capacity)), m_markers(std::make_unique<PtsMarker[]>(m_markerMask + 1)) {
     assert((capacity & (capacity - 1)) == 0 && capacity > 0);
 }
 
 uint64_t SPSCBuffer::write(const uint8_t *input, uint64_t len) {
     if (!input || len == 0)
         return 0;
+    const WriteSpan span = reserveWrite(len);
+    if (span.size() == 0)
+        return 0;
+
+    std::memcpy(span.first, input, span.firstLen);
+    if (span.secondLen > 0) {
+        std::memcpy(span.second, input + span.firstLen, span.secondLen);
+    }
+
+    commitWrite(span.size());
+    return span.size();
+}
+
+SPSCBuffer::WriteSpan SPSCBuffer::reserveWrite(uint64_t maxLen) {
     const uint64_t head = m_head.load(std::memory_order_acquire);
     const uint64_t tail = m_tail.load(std::memory_order_relaxed);
 
     const uint64_t avail = m_capacity - (tail - head);
-    const uint64_t write_len = std::min(len, avail);
-    if (write_len == 0)
-        return 0;
+    const uint64_t len = std::min(maxLen, avail);
+    if (len == 0)
+        return {};
 
     const uint64_t pos = tail & m_mask;
-    const uint64_t first_chunk = std::min(write_len, m_capacity - pos);
-    std::memcpy(m_buffer.get() + pos, input, first_chunk);
-    if (write_len > first_chunk) {
-        std::memcpy(m_buffer.get(), input + first_chunk, write_len - first_chunk);
-    }
+    const uint64_t first_chunk = std::min(len, m_capacity - pos);
+    return {m_buffer.get() + pos, first_chunk, m_buffer.get(), len - first_chunk};
+}
 
-    m_tail.store(tail + write_len, std::memory_order_release);
-    return write_len;
+void SPSCBuffer::commitWrite(uint64_t len) {
+    if (len == 0)
+        return;
+    const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    assert(len <= m_capacity - (tail - m_head.load(std::memory_order_acquire)));
+    m_tail.store(tail + len, std::memory_order_release);
 }
 
 void SPSCBuffer::requestClearOldData() {
@@ -38,12 +66,8 @@ void SPSCBuffer::requestClearOldData() {
     m_needClear.store(1, std::memory_order_release);
 }
 
-uint64_t SPSCBuffer::read(uint8_t *output, uint64_t len) {
-    if (!output || len == 0)
-        return 0;
-    const uint64_t tail = m_tail.load(std::memory_order_acquire);
+uint64_t SPSCBuffer::applyPendingClear(uint64_t tail) {
     uint64_t head = m_head.load(std::memory_order_relaxed);
-
     if (m_needClear.load(std::memory_order_acquire)) {
         const uint64_t v_tail = m_virtualTail.load(std::memory_order_relaxed);
         // 只有当 v_tail 在 head 之后且在 tail 之前（或等于）时才跳转
@@ -53,6 +77,60 @@ uint64_t SPSCBuffer::read(uint8_t *output, uint64_t len) {
         }
         m_needClear.store(0, std::memory_order_release);
     }
+    return head;
+}
+
+bool SPSCBuffer::pushPtsMarker(double pts, double bytesPerSec) {
+    if (std::isnan(pts))
+        return true;
+    const uint64_t markerHead = m_markerHead.load(std::memory_order_acquire);
+    const uint64_t markerTail = m_markerTail.load(std::memory_order_relaxed);
+    const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+
+    // 与上一个标记连续时由它外推即可；上一个标记只有生产者会修改，消费者已越过它也不影响外推结果
+    if (markerTail != markerHead && bytesPerSec > 0.0) {
+        const PtsMarker &last = m_markers[(markerTail - 1) & m_markerMask];
+        const double predicted = last.pts + static_cast<double>(tail - last.offset) / bytesPerSec;
+        if (std::abs(predicted - pts) < kMarkerMergeTolerance)
+            return true;
+    }
+    if (markerTail - markerHead > m_markerMask)
+        return false;
+
+    m_markers[markerTail & m_markerMask] = {tail, pts};
+    m_markerTail.store(markerTail + 1, std::memory_order_release);
+    return true;
+}
+
+double SPSCBuffer::readPts(double bytesPerSec) {
+    const uint64_t markerTail = m_markerTail.load(std::memory_order_acquire);
+    uint64_t markerHead = m_markerHead.load(std::memory_order_relaxed);
+    if (markerHead == markerTail || bytesPerSec <= 0.0)
+        return std::numeric_limits<double>::quiet_NaN();
+
+    // 丢弃已经完全读过的标记，保留偏移 <= head 的最后一个
+    // 先处理清理请求，requestClearOldData 跳过的数据对应的标记也会在这里被跳过
+    const uint64_t head = applyPendingClear(m_tail.load(std::memory_order_acquire));
+    while (markerTail - markerHead > 1) {
+        const PtsMarker &next = m_markers[(markerHead + 1) & m_markerMask];
+        if (static_cast<int64_t>(next.offset - head) > 0)
+            break;
+        ++markerHead;
+    }
+    m_markerHead.store(markerHead, std::memory_order_release);
+
+    const PtsMarker &m = m_markers[markerHead & m_markerMask];
+    const int64_t delta = static_cast<int64_t>(head - m.offset);
+    if (delta < 0) // 标记对应的数据还没读到
+        return std::numeric_limits<double>::quiet_NaN();
+    return m.pts + delta / bytesPerSec;
+}
+
+uint64_t SPSCBuffer::read(uint8_t *output, uint64_t len) {
+    if (!output || len == 0)
+        return 0;
+    const uint64_t tail = m_tail.load(std::memory_order_acquire);
+    const uint64_t head = applyPendingClear(tail);
 
     const uint64_t avail = tail - head;
     const uint64_t read_len = std::min(len, avail);
@@ -73,6 +151,8 @@ uint64_t SPSCBuffer::read(uint8_t *output, uint64_t len) {
 void SPSCBuffer::unsafeClear() {
     m_head.store(0, std::memory_order_relaxed);
     m_tail.store(0, std::memory_order_relaxed);
+    m_markerHead.store(0, std::memory_order_relaxed);
+    m_markerTail.store(0, std::memory_order_relaxed);
 }
 
 uint64_t SPSCBuffer::readAvailable() const {
@@ -86,3 +166,7 @@ uint64_t SPSCBuffer::writeAvailable() const {
 uint64_t SPSCBuffer::capacity() const {
     return m_capacity;
 }
+
+uint64_t SPSCBuffer::markerCapacity() const {
+    return m_markerMask + 1;
+}
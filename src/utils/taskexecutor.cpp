@@ -0,0 +1,254 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "utils/taskexecutor.h"
+#include "stats/tracer.h"
+#include <QDebug>
+#include <QString>
+#include <string>
+#include <utility>
+
+#if defined(Q_OS_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(Q_OS_MACOS)
+#include <pthread.h>
+#include <pthread/qos.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+namespace {
+    constexpr const char *kIdleThreadName = "AZ-idle";
+
+#if defined(Q_OS_LINUX)
+    constexpr int kRealtimeAudioPriority = 5; // SCHED_FIFO 优先级，只需高于普通线程，远低于音频服务自身的线程
+    constexpr size_t kMaxThreadName = 15;     // 不含结尾的 '\0'
+
+    // 设置当前线程的 nice 值，负值需要 CAP_SYS_NICE 或 RLIMIT_NICE
+    bool setNice(int nice) {
+        return setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), nice) == 0;
+    }
+#endif
+
+    const char *qosName(TaskQoS qos) {
+        switch (qos) {
+        case TaskQoS::RealtimeAudio: return "RealtimeAudio";
+        case TaskQoS::Display: return "Display";
+        case TaskQoS::Decode: return "Decode";
+        default: return "Background";
+        }
+    }
+}
+
+bool TaskHandle::joinable() const {
+    return m_state != nullptr;
+}
+
+void TaskHandle::join() {
+    if (!m_state)
+        return;
+    {
+        std::unique_lock<std::mutex> lock(m_state->mutex);
+        m_state->cv.wait(lock, [this] { return m_state->done; });
+    }
+    m_state.reset();
+}
+
+TaskExecutor &TaskExecutor::instance() {
+    static TaskExecutor ins;
+    return ins;
+}
+
+TaskExecutor::~TaskExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+        for (auto &worker : m_workers) {
+            worker->cv.notify_one();
+        }
+    }
+    // 正在运行的任务由各自的持有者负责让其退出，这里等待它们结束
+    for (auto &worker : m_workers) {
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
+}
+
+TaskHandle TaskExecutor::submit(TaskQoS qos, const char *name, std::function<void()> task) {
+    TaskHandle handle;
+    handle.m_state = std::make_shared<TaskHandle::State>();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Worker *worker = nullptr;
+    for (auto &w : m_workers) {
+        if (w->qos == qos && !w->busy) {
+            worker = w.get();
+            break;
+        }
+    }
+    if (!worker) {
+        m_workers.push_back(std::make_unique<Worker>());
+        worker = m_workers.back().get();
+        worker->qos = qos;
+        worker->affinityDirty = m_affinity[qos] != 0;
+        worker->thread = std::thread([this, worker] { workerLoop(worker); });
+        qDebug() << "TaskExecutor: 新建工作线程" << qosName(qos) << "共" << m_workers.size() << "个";
+    }
+
+    worker->busy = true;
+    worker->task = std::move(task);
+    worker->name = name;
+    worker->state = handle.m_state;
+    worker->cv.notify_one();
+    return handle;
+}
+
+void TaskExecutor::setAffinityHint(TaskQoS qos, uint64_t cpuMask) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_affinity[qos] == cpuMask)
+        return;
+    m_affinity[qos] = cpuMask;
+    for (auto &worker : m_workers) {
+        if (worker->qos == qos)
+            worker->affinityDirty = true;
+    }
+}
+
+int TaskExecutor::workerCount(TaskQoS qos) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int count = 0;
+    for (const auto &worker : m_workers) {
+        count += worker->qos == qos ? 1 : 0;
+    }
+    return count;
+}
+
+void TaskExecutor::workerLoop(Worker *worker) {
+    applyQoS(worker->qos);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        worker->cv.wait(lock, [&] { return m_exit || worker->task; });
+        if (!worker->task)
+            return; // 退出
+
+        std::function<void()> task = std::move(worker->task);
+        worker->task = nullptr;
+        std::shared_ptr<TaskHandle::State> state = std::move(worker->state);
+        const char *name = worker->name;
+        const bool affinityDirty = std::exchange(worker->affinityDirty, false);
+        const uint64_t cpuMask = m_affinity[worker->qos];
+        lock.unlock();
+
+        setThreadName(name);
+        AZ_TRACE_THREAD_NAME(name);
+        if (affinityDirty)
+            applyAffinity(cpuMask);
+        task();
+        setThreadName(kIdleThreadName); // 空闲线程不计入上一个任务的 CPU 统计
+
+        {
+            std::lock_guard<std::mutex> stateLock(state->mutex);
+            state->done = true;
+        }
+        state->cv.notify_all();
+
+        lock.lock();
+        worker->busy = false;
+    }
+}
+
+void TaskExecutor::applyQoS(TaskQoS qos) {
+#if defined(Q_OS_LINUX)
+    bool ok = true;
+    switch (qos) {
+    case TaskQoS::RealtimeAudio: {
+        sched_param param{};
+        param.sched_priority = kRealtimeAudioPriority;
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0)
+            return;
+        // 没有 RLIMIT_RTPRIO 时退回提高 nice 值
+        ok = setNice(-10);
+        break;
+    }
+    case TaskQoS::Display:
+        ok = setNice(-5);
+        break;
+    case TaskQoS::Decode:
+        break;
+    case TaskQoS::Background: {
+        sched_param param{};
+        (void)pthread_setschedparam(pthread_self(), SCHED_BATCH, &param);
+        ok = setNice(5);
+        break;
+    }
+    default:
+        break;
+    }
+    if (!ok)
+        qDebug() << "TaskExecutor: 无权限调整线程优先级，" << qosName(qos) << "使用默认优先级";
+#elif defined(Q_OS_MACOS)
+    qos_class_t cls = QOS_CLASS_DEFAULT;
+    switch (qos) {
+    case TaskQoS::RealtimeAudio:
+    case TaskQoS::Display: cls = QOS_CLASS_USER_INTERACTIVE; break;
+    case TaskQoS::Decode: cls = QOS_CLASS_USER_INITIATED; break;
+    default: cls = QOS_CLASS_UTILITY; break;
+    }
+    if (pthread_set_qos_class_self_np(cls, 0) != 0)
+        qDebug() << "TaskExecutor: 无法设置线程 QoS" << qosName(qos);
+#elif defined(Q_OS_WIN)
+    int priority = THREAD_PRIORITY_NORMAL;
+    switch (qos) {
+    case TaskQoS::RealtimeAudio: priority = THREAD_PRIORITY_HIGHEST; break;
+    case TaskQoS::Display: priority = THREAD_PRIORITY_ABOVE_NORMAL; break;
+    case TaskQoS::Decode: priority = THREAD_PRIORITY_NORMAL; break;
+    default: priority = THREAD_PRIORITY_BELOW_NORMAL; break;
+    }
+    if (!SetThreadPriority(GetCurrentThread(), priority))
+        qDebug() << "TaskExecutor: 无法设置线程优先级" << qosName(qos);
+#else
+    Q_UNUSED(qos);
+#endif
+}
+
+void TaskExecutor::applyAffinity(uint64_t cpuMask) {
+#if defined(Q_OS_LINUX)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    const unsigned cpus = std::thread::hardware_concurrency();
+    for (unsigned i = 0; i < 64 && i < CPU_SETSIZE; ++i) {
+        // 0 表示不限制
+        if (cpuMask == 0 ? i < cpus : ((cpuMask >> i) & 1) != 0)
+            CPU_SET(i, &set);
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        qDebug() << "TaskExecutor: 无法设置 CPU 亲和性" << cpuMask;
+#elif defined(Q_OS_WIN)
+    DWORD_PTR processMask = 0, systemMask = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+        return;
+    const DWORD_PTR mask = cpuMask == 0 ? processMask : (static_cast<DWORD_PTR>(cpuMask) & processMask);
+    if (mask == 0 || !SetThreadAffinityMask(GetCurrentThread(), mask))
+        qDebug() << "TaskExecutor: 无法设置 CPU 亲和性" << cpuMask;
+#else
+    Q_UNUSED(cpuMask); // macOS 不支持绑定核心
+#endif
+}
+
+void TaskExecutor::setThreadName(const char *name) {
+    if (!name)
+        return;
+#if defined(Q_OS_LINUX)
+    const std::string truncated = std::string(name).substr(0, kMaxThreadName);
+    (void)pthread_setname_np(pthread_self(), truncated.c_str());
+#elif defined(Q_OS_MACOS)
+    (void)pthread_setname_np(name);
+#elif defined(Q_OS_WIN)
+    (void)SetThreadDescription(GetCurrentThread(), reinterpret_cast<const wchar_t *>(QString::fromUtf8(name).utf16()));
+#endif
+}
@@ -0,0 +1,126 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "utils/xxhash64.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+    constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+    inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    // 按小端读取，与参考实现在所有平台上结果一致
+    inline uint64_t read64(const uint8_t *p) {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; --i)
+            v = (v << 8) | p[i];
+        return v;
+    }
+    inline uint32_t read32(const uint8_t *p) {
+        return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+               static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+    }
+
+    inline uint64_t accumulate(uint64_t acc, uint64_t input) {
+        acc += input * kPrime2;
+        acc = rotl(acc, 31);
+        return acc * kPrime1;
+    }
+    inline uint64_t mergeRound(uint64_t acc, uint64_t val) {
+        acc ^= accumulate(0, val);
+        return acc * kPrime1 + kPrime4;
+    }
+
+    // 处理一个 32 字节的 stripe
+    inline void stripe(uint64_t acc[4], const uint8_t *p) {
+        acc[0] = accumulate(acc[0], read64(p));
+        acc[1] = accumulate(acc[1], read64(p + 8));
+        acc[2] = accumulate(acc[2], read64(p + 16));
+        acc[3] = accumulate(acc[3], read64(p + 24));
+    }
+}
+
+void XXHash64::reset(uint64_t seed) {
+    m_seed = seed;
+    m_acc[0] = seed + kPrime1 + kPrime2;
+    m_acc[1] = seed + kPrime2;
+    m_acc[2] = seed;
+    m_acc[3] = seed - kPrime1;
+    m_totalLen = 0;
+    m_bufLen = 0;
+}
+
+void XXHash64::update(const void *data, size_t len) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    m_totalLen += len;
+
+    // 先补满上次剩下的 stripe
+    if (m_bufLen > 0) {
+        const size_t fill = std::min<size_t>(32 - m_bufLen, len);
+        std::memcpy(m_buf + m_bufLen, p, fill);
+        m_bufLen += static_cast<uint32_t>(fill);
+        p += fill;
+        len -= fill;
+        if (m_bufLen < 32)
+            return;
+        stripe(m_acc, m_buf);
+        m_bufLen = 0;
+    }
+
+    for (; len >= 32; p += 32, len -= 32)
+        stripe(m_acc, p);
+
+    if (len > 0) {
+        std::memcpy(m_buf, p, len);
+        m_bufLen = static_cast<uint32_t>(len);
+    }
+}
+
+uint64_t XXHash64::digest() const {
+    uint64_t h;
+    if (m_totalLen >= 32) {
+        h = rotl(m_acc[0], 1) + rotl(m_acc[1], 7) + rotl(m_acc[2], 12) + rotl(m_acc[3], 18);
+        for (int i = 0; i < 4; ++i)
+            h = mergeRound(h, m_acc[i]);
+    } else {
+        h = m_seed + kPrime5;
+    }
+    h += m_totalLen;
+
+    // 剩余不足 32 字节的部分
+    const uint8_t *p = m_buf;
+    uint32_t len = m_bufLen;
+    for (; len >= 8; p += 8, len -= 8) {
+        h ^= accumulate(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+    }
+    if (len >= 4) {
+        h ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+        len -= 4;
+    }
+    for (; len > 0; ++p, --len) {
+        h ^= *p * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+    }
+
+    // avalanche
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t XXHash64::hash(const void *data, size_t len, uint64_t seed) {
+    XXHash64 state(seed);
+    state.update(data, len);
+    return state.digest();
+}
@@ -0,0 +1,576 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// 无界面的整条流水线基准测试：Demux -> 解码 -> 视频渲染数据准备 -> 字幕准备 (-> 可选的离屏纹理上传)
+// 不做音画同步，不睡眠也不丢帧，解码出多少帧就处理多少帧；音频只做格式转换，不经过设备
+// 每个文件输出一个 JSON 对象，包含帧率和各阶段耗时分布，供 CI 做性能回归对比
+//
+// 用法: azplayer-bench [--gl] [--no-audio] [--seconds N] [--json 输出文件] [--manifest 清单]
+//                      [--hash 目录 [--dump] [--golden 目录]] 文件...
+// --manifest 读取 azplayer-mediagen 生成的 manifest.json，测试其中列出的全部文件，结果中带上用例名
+// --hash 用 OutputSink 把每个文件送显的帧与转换后的 PCM 逐帧哈希到 <目录>/<用例名或文件名>/(加 --gl 时还有读回的画面)，
+//        --dump 同时写出 y4m/wav，--golden 与之前记录的目录逐行对比，不一致时返回非零
+
+#include "audio/audioconverter.h"
+#include "clock/globalclock.h"
+#include "decode/decodeaudio.h"
+#include "decode/decodesubtitle.h"
+#include "decode/decodevideo.h"
+#include "demux/demux.h"
+#include "renderer/assrender.h"
+#include "renderer/renderdata.h"
+#include "renderer/videorenderer.h"
+#include "stats/latencyhistogram.h"
+#include "stats/outputsink.h"
+#include "stats/playbackstats.h"
+#include "types/ptrs.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QSurfaceFormat>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr int kOutSampleRate = 48000;
+    constexpr int kAudioChunkFrames = 4096;
+    constexpr double kIdleTimeout = 0.5; // 读到 EOF 且所有队列空了这么久，认为解码器已经排空(秒)
+    const QSize kFBOSize{1920, 1080};
+
+    struct Options {
+        QStringList files;
+        bool gl = false;       // 离屏 OpenGL 上传与绘制
+        bool audio = true;     // 解码并转换音频
+        double seconds = 0.0;  // 每个文件最多处理的媒体时长(秒)，0 为不限
+        QString jsonPath;      // 为空时写到标准输出
+        QString manifestPath;  // azplayer-mediagen 的 manifest.json
+        QString hashDir;       // 输出记录目录，为空时不记录
+        QString goldenDir;     // 对比用的 golden 记录目录
+        bool dump = false;     // 同时写出 y4m/wav
+        QHash<QString, QString> caseNames; // 文件 -> 清单中的用例名
+    };
+
+    void printUsage() {
+        std::fprintf(stderr,
+                     "usage: azplayer-bench [--gl] [--no-audio] [--seconds N] [--json FILE] [--manifest FILE]\n"
+                     "                      [--hash DIR [--dump] [--golden DIR]] [FILE...]\n"
+                     "  --gl          upload and draw every frame with an offscreen OpenGL 3.3 context\n"
+                     "  --no-audio    skip audio decoding\n"
+                     "  --seconds N   stop after N seconds of media per file\n"
+                     "  --json FILE   write results to FILE instead of stdout\n"
+                     "  --manifest F  also run every file listed in an azplayer-mediagen manifest.json\n"
+                     "  --hash DIR    write per-frame XXH64 lists of presented frames and PCM to DIR/<case>/\n"
+                     "  --dump        with --hash, also write video.y4m / fbo.y4m / audio.wav\n"
+                     "  --golden DIR  with --hash, compare the lists against DIR/<case>/ and fail on mismatch\n");
+    }
+
+    bool parseArgs(const QStringList &args, Options &opt) {
+        for (int i = 1; i < args.size(); ++i) {
+            const QString &arg = args[i];
+            if (arg == "--gl") {
+                opt.gl = true;
+            } else if (arg == "--no-audio") {
+                opt.audio = false;
+            } else if (arg == "--seconds" && i + 1 < args.size()) {
+                bool ok = false;
+                opt.seconds = args[++i].toDouble(&ok);
+                if (!ok || opt.seconds < 0.0)
+                    return false;
+            } else if (arg == "--json" && i + 1 < args.size()) {
+                opt.jsonPath = args[++i];
+            } else if (arg == "--manifest" && i + 1 < args.size()) {
+                opt.manifestPath = args[++i];
+            } else if (arg == "--hash" && i + 1 < args.size()) {
+                opt.hashDir = args[++i];
+            } else if (arg == "--golden" && i + 1 < args.size()) {
+                opt.goldenDir = args[++i];
+            } else if (arg == "--dump") {
+                opt.dump = true;
+            } else if (arg.startsWith("--")) {
+                return false;
+            } else {
+                opt.files << arg;
+            }
+        }
+        if (opt.hashDir.isEmpty() && (opt.dump || !opt.goldenDir.isEmpty()))
+            return false;
+        return !opt.files.isEmpty() || !opt.manifestPath.isEmpty();
+    }
+
+    // 把清单中的文件(相对清单所在目录)追加到 opt.files
+    bool loadManifest(Options &opt) {
+        QFile file(opt.manifestPath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qDebug() << "无法打开清单:" << opt.manifestPath;
+            return false;
+        }
+        const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+        if (!doc.isObject() || !doc.object()["files"].isArray()) {
+            qDebug() << "清单格式错误:" << opt.manifestPath;
+            return false;
+        }
+        const QDir dir = QFileInfo(opt.manifestPath).absoluteDir();
+        const QJsonArray files = doc.object()["files"].toArray();
+        for (const QJsonValue &value : files) {
+            const QJsonObject entry = value.toObject();
+            const QString path = dir.filePath(entry["file"].toString());
+            opt.files << path;
+            opt.caseNames.insert(path, entry["name"].toString());
+        }
+        return true;
+    }
+
+    void clearPktQ(const sharedPktQueue &pktq) {
+        AVPktItem tmp;
+        while (pktq->pop(tmp)) {
+            av_packet_free(&tmp.pkt);
+        }
+    }
+    void clearFrmQ(const sharedFrmQueue &frmq) {
+        AVFrmItem tmp;
+        while (frmq->pop(tmp)) {
+            av_frame_free(&tmp.frm);
+            avsubtitle_free(&tmp.sub);
+        }
+    }
+
+    // 离屏 OpenGL 环境，VideoRenderer 直接渲染到 FBO
+    class OffscreenGL {
+    public:
+        [[nodiscard]] bool init() {
+            QSurfaceFormat format;
+            format.setVersion(3, 3);
+            format.setProfile(QSurfaceFormat::CoreProfile);
+            m_surface.setFormat(format);
+            m_surface.create();
+            m_context.setFormat(format);
+            if (!m_surface.isValid() || !m_context.create() || !m_context.makeCurrent(&m_surface)) {
+                qDebug() << "无法创建 OpenGL 3.3 离屏上下文";
+                return false;
+            }
+            m_renderer = std::make_unique<VideoRenderer>();
+            m_fbo.reset(m_renderer->createFramebufferObject(kFBOSize));
+            return m_fbo->bind();
+        }
+
+        ~OffscreenGL() {
+            if (m_context.makeCurrent(&m_surface)) {
+                m_renderer.reset();
+                m_fbo.reset();
+                m_context.doneCurrent();
+            }
+        }
+
+        void setRenderData(VideoDoubleBuf *vidData, SubtitleDoubleBuf *subData) {
+            m_renderer->setRenderData(vidData, subData);
+        }
+
+        // 渲染一帧并等待 GPU 完成，避免命令堆积到后面的帧
+        void render() {
+            m_renderer->render();
+            m_context.functions()->glFinish();
+        }
+
+    private:
+        QOffscreenSurface m_surface;
+        QOpenGLContext m_context;
+        std::unique_ptr<VideoRenderer> m_renderer;
+        std::unique_ptr<QOpenGLFramebufferObject> m_fbo;
+    };
+
+    // 单个文件的解复用/解码流水线，队列容量与 MediaController 一致
+    class Pipeline {
+    public:
+        ~Pipeline() { close(); }
+
+        [[nodiscard]] bool open(const QString &file, bool withAudio) {
+            if (!m_demux.init(file.toUtf8().constData(), true))
+                return false;
+
+            bool ok = true;
+            if (m_demux.haveStream(MediaType::Video)) {
+                m_haveVideo = true;
+                ok &= m_demux.switchVideoStream(0, m_pktVideoBuf, m_frmVideoBuf);
+                const int cores = std::thread::hardware_concurrency();
+                ok &= m_decodeVideo.init(m_demux.getStream(MediaType::Video), m_pktVideoBuf, m_frmVideoBuf, cores >= 6 ? 6 : 0);
+            }
+            if (withAudio && m_demux.haveStream(MediaType::Audio)) {
+                m_haveAudio = true;
+                ok &= m_demux.switchAudioStream(0, m_pktAudioBuf, m_frmAudioBuf);
+                ok &= m_decodeAudio.init(m_demux.getStream(MediaType::Audio), m_pktAudioBuf, m_frmAudioBuf, 1);
+                ok &= initAudioConverter(m_demux.getStream(MediaType::Audio)->codecpar);
+            }
+            if (m_haveVideo && m_demux.haveStream(MediaType::Subtitle)) {
+                bool isAssSub = false;
+                ok &= m_demux.switchSubtitleStream(0, m_pktSubtitleBuf, m_frmSubtitleBuf, isAssSub);
+                if (!isAssSub)
+                    ok &= m_decodeSubtitle.init(m_demux.getStream(MediaType::Subtitle), m_pktSubtitleBuf, m_frmSubtitleBuf, 1);
+            }
+            if (!ok || (!m_haveVideo && !m_haveAudio))
+                return false;
+
+            GlobalClock::instance().reset();
+
+            m_demux.start();
+            m_decodeVideo.start();
+            m_decodeAudio.start();
+            m_decodeSubtitle.start();
+            return true;
+        }
+
+        void close() {
+            m_demux.uninit();
+            m_decodeVideo.uninit();
+            m_decodeAudio.uninit();
+            m_decodeSubtitle.uninit();
+            m_converter.uninit();
+            clearPktQ(m_pktVideoBuf);
+            clearPktQ(m_pktAudioBuf);
+            clearPktQ(m_pktSubtitleBuf);
+            clearFrmQ(m_frmVideoBuf);
+            clearFrmQ(m_frmAudioBuf);
+            clearFrmQ(m_frmSubtitleBuf);
+            ASSRender::instance().uninit();
+        }
+
+        // 解复用到了结尾且所有队列为空(解码器可能仍在排空最后几帧，由调用者再等一段时间)
+        [[nodiscard]] bool drained() const {
+            return m_demux.isEOF() &&
+                   m_pktVideoBuf->size() == 0 && m_frmVideoBuf->size() == 0 &&
+                   m_pktAudioBuf->size() == 0 && m_frmAudioBuf->size() == 0;
+        }
+
+        [[nodiscard]] bool haveVideo() const { return m_haveVideo; }
+        [[nodiscard]] bool haveAudio() const { return m_haveAudio; }
+
+        // 取出一帧当前序号的视频
+        [[nodiscard]] bool popVideo(AVFrmItem &item) {
+            while (m_frmVideoBuf->pop(item)) {
+                if (item.serial == m_frmVideoBuf->serial())
+                    return true;
+                av_frame_free(&item.frm);
+            }
+            return false;
+        }
+
+        /**
+         * 把已解码的音频全部转换为 48kHz 立体声 f32
+         * @return 本次转换的帧数(输出采样率)，< 0 表示出错
+         */
+        [[nodiscard]] int64_t drainAudio(double &lastPts) {
+            int64_t total = 0;
+            AVFrmItem item;
+            while (m_frmAudioBuf->pop(item)) {
+                if (item.frm && item.serial == m_frmAudioBuf->serial()) {
+                    m_converter.setInput(item.frm);
+                    int64_t produced = 0;
+                    do {
+                        produced = m_converter.produce(reinterpret_cast<uint8_t *>(m_audioChunk.data()), kAudioChunkFrames);
+                        if (produced < 0) {
+                            av_frame_free(&item.frm);
+                            return -1;
+                        }
+                        if (produced > 0)
+                            OutputSink::instance().writeAudioSync(m_audioChunk.data(), static_cast<uint32_t>(produced), 2);
+                        total += produced;
+                    } while (produced == kAudioChunkFrames);
+                    lastPts = item.pts;
+                }
+                av_frame_free(&item.frm);
+            }
+            return total;
+        }
+
+        // 与 VideoPlayer 相同的字幕准备，以视频帧 pts 代替视频时钟
+        void prepareSubtitle(SubtitleDoubleBuf &subData, double pts, int width, int height) {
+            if (ASSRender::instance().initialized()) {
+                (void)subData.write([&](SubRenderData &renData, int) -> bool {
+                    renData.updateASSImage(pts, width, height);
+                    renData.frmItem.width = width;
+                    renData.frmItem.height = height;
+                    return true;
+                }, false);
+                return;
+            }
+
+            const AVFrmItem *nextSub = m_frmSubtitleBuf->front();
+            if (nextSub && pts >= nextSub->pts) {
+                AVFrmItem subFrmItem;
+                (void)m_frmSubtitleBuf->pop(subFrmItem);
+                if (subFrmItem.serial != m_frmSubtitleBuf->serial()) {
+                    avsubtitle_free(&subFrmItem.sub);
+                    return;
+                }
+                (void)subData.write([&](SubRenderData &renData, int) -> bool {
+                    renData.updateBitmapImage(&subFrmItem, width, height);
+                    m_subtitleEndTime = subFrmItem.pts + subFrmItem.duration;
+                    return true;
+                }, false);
+            } else if (pts >= m_subtitleEndTime) {
+                (void)subData.write([&](SubRenderData &renData, int) -> bool {
+                    renData.updateBitmapImage(nullptr, width, height);
+                    m_subtitleEndTime = 1e9;
+                    return true;
+                }, false);
+            }
+        }
+
+    private:
+        [[nodiscard]] bool initAudioConverter(const AVCodecParameters *codecParams) {
+            AudioPar in;
+            in.sampleFormat = static_cast<AVSampleFormat>(codecParams->format);
+            in.sampleRate = codecParams->sample_rate;
+            if (av_channel_layout_copy(&in.ch_layout, &codecParams->ch_layout) != 0)
+                return false;
+            AudioPar out;
+            out.sampleFormat = AV_SAMPLE_FMT_FLT;
+            out.sampleRate = kOutSampleRate;
+            av_channel_layout_default(&out.ch_layout, 2);
+            m_audioChunk.resize(static_cast<size_t>(kAudioChunkFrames) * 2);
+            return m_converter.init(in, out);
+        }
+
+        sharedPktQueue m_pktAudioBuf = std::make_shared<AVPktQueue>(2);
+        sharedFrmQueue m_frmAudioBuf = std::make_shared<SPSCRing<AVFrmItem>>(50);
+        sharedPktQueue m_pktVideoBuf = std::make_shared<AVPktQueue>(10);
+        sharedFrmQueue m_frmVideoBuf = std::make_shared<SPSCRing<AVFrmItem>>(3);
+        sharedPktQueue m_pktSubtitleBuf = std::make_shared<AVPktQueue>(2);
+        sharedFrmQueue m_frmSubtitleBuf = std::make_shared<SPSCRing<AVFrmItem>>(16);
+
+        Demux m_demux;
+        DecodeVideo m_decodeVideo;
+        DecodeAudio m_decodeAudio;
+        DecodeSubtitle m_decodeSubtitle;
+        AudioConverter m_converter;
+        std::vector<float> m_audioChunk;
+        double m_subtitleEndTime = 1e9;
+        bool m_haveVideo = false;
+        bool m_haveAudio = false;
+    };
+
+    QJsonObject histogramToJson(const LatencyHistogram &hist, double ticksPerMs) {
+        const LatencyHistogram::Snapshot snap = hist.snapshot();
+        QJsonObject obj;
+        obj["unit"] = "ms";
+        obj["count"] = static_cast<qint64>(snap.count);
+        obj["mean"] = snap.mean / ticksPerMs;
+        obj["p50"] = snap.p50 / ticksPerMs;
+        obj["p95"] = snap.p95 / ticksPerMs;
+        obj["p99"] = snap.p99 / ticksPerMs;
+        obj["max"] = static_cast<double>(snap.max) / ticksPerMs;
+        return obj;
+    }
+
+    QJsonObject runFile(const QString &file, const Options &opt, OffscreenGL *gl) {
+        QJsonObject result;
+        result["file"] = file;
+
+        PlaybackStats::instance().reset();
+        auto pipeline = std::make_unique<Pipeline>();
+        if (!pipeline->open(file, opt.audio)) {
+            result["ok"] = false;
+            result["error"] = "open failed";
+            return result;
+        }
+
+        // 与播放器相同，记录送显的帧(以及加 --gl 时读回的画面)和输出的 PCM
+        const QString caseName = opt.caseNames.value(file, QFileInfo(file).completeBaseName());
+        if (!opt.hashDir.isEmpty()) {
+            OutputSink::instance().setAudioFormat(2, kOutSampleRate);
+            OutputSink::Options sinkOpt;
+            sinkOpt.dump = opt.dump;
+            sinkOpt.fbo = gl != nullptr;
+            if (!OutputSink::instance().begin(QDir(opt.hashDir).filePath(caseName), sinkOpt)) {
+                result["ok"] = false;
+                result["error"] = "output sink failed";
+                return result;
+            }
+        }
+
+        VideoDoubleBuf videoData;
+        SubtitleDoubleBuf subData;
+        if (gl)
+            gl->setRenderData(&videoData, &subData);
+
+        static LatencyHistogram frameHist; // 每帧总耗时(准备 + 字幕 + 上传绘制)，us
+        frameHist.reset();
+
+        int64_t videoFrames = 0;
+        int64_t audioFrames = 0;
+        double firstPts = INVALID_DOUBLE;
+        double lastVideoPts = INVALID_DOUBLE;
+        double lastAudioPts = INVALID_DOUBLE;
+        bool ok = true;
+
+        const double startTime = getRelativeSeconds();
+        double lastWorkTime = startTime;
+        double idleSince = INVALID_DOUBLE;
+        auto reachedLimit = [&](double pts) {
+            if (std::isnan(firstPts) && !std::isnan(pts))
+                firstPts = pts;
+            return opt.seconds > 0.0 && !std::isnan(pts) && pts - firstPts >= opt.seconds;
+        };
+
+        while (true) {
+            bool didWork = false;
+
+            AVFrmItem item;
+            if (pipeline->haveVideo() && pipeline->popVideo(item)) {
+                didWork = true;
+                const double frameStart = getRelativeSeconds();
+                const int width = item.frm->width;
+                const int height = item.frm->height;
+                const double pts = item.pts;
+
+                // clang-format off
+                double t = getRelativeSeconds();
+                const VideoRenderData *written = nullptr;
+                (void)videoData.write([&](VideoRenderData &renData, int) -> bool {
+                    renData.updateFormat(item);
+                    written = &renData;
+                    return true;
+                }, false);
+                PlaybackStats::instance().updateVideoPrepTime((getRelativeSeconds() - t) * 1000);
+                // clang-format on
+
+                t = getRelativeSeconds();
+                pipeline->prepareSubtitle(subData, pts, width, height);
+                PlaybackStats::instance().updateSubPrepTime((getRelativeSeconds() - t) * 1000);
+
+                if (OutputSink::enabled())
+                    OutputSink::instance().writeVideo(*written);
+                videoData.release();
+                subData.release();
+                if (gl)
+                    gl->render();
+
+                frameHist.record(static_cast<uint64_t>((getRelativeSeconds() - frameStart) * 1e6));
+                ++videoFrames;
+                lastVideoPts = pts;
+                if (reachedLimit(pts))
+                    break;
+            }
+
+            if (pipeline->haveAudio()) {
+                const int64_t produced = pipeline->drainAudio(lastAudioPts);
+                if (produced < 0) {
+                    ok = false;
+                    break;
+                }
+                if (produced > 0) {
+                    didWork = true;
+                    audioFrames += produced;
+                    if (!pipeline->haveVideo() && reachedLimit(lastAudioPts))
+                        break;
+                }
+            }
+
+            const double now = getRelativeSeconds();
+            if (didWork) {
+                lastWorkTime = now;
+                idleSince = INVALID_DOUBLE;
+                continue;
+            }
+            if (pipeline->drained()) {
+                if (std::isnan(idleSince))
+                    idleSince = now;
+                else if (now - idleSince >= kIdleTimeout)
+                    break;
+            } else {
+                idleSince = INVALID_DOUBLE;
+            }
+            std::this_thread::yield(); // 等待解码，不计入任何阶段
+        }
+        const double wallSeconds = lastWorkTime - startTime;
+        pipeline.reset(); // 先停止解码线程再读统计
+        OutputSink::instance().end();
+
+        const double lastPts = !std::isnan(lastVideoPts) ? lastVideoPts : lastAudioPts;
+        const double mediaSeconds = std::isnan(firstPts) || std::isnan(lastPts) ? 0.0 : lastPts - firstPts;
+        result["ok"] = ok;
+        result["gl"] = gl != nullptr;
+        result["wallSeconds"] = wallSeconds;
+        result["videoFrames"] = static_cast<qint64>(videoFrames);
+        result["fps"] = wallSeconds > 0.0 ? videoFrames / wallSeconds : 0.0;
+        result["audioSeconds"] = static_cast<double>(audioFrames) / kOutSampleRate;
+        result["mediaSeconds"] = mediaSeconds;
+        result["realtimeFactor"] = wallSeconds > 0.0 ? mediaSeconds / wallSeconds : 0.0;
+        result["frameTime"] = histogramToJson(frameHist, 1000.0);
+        result["stats"] = PlaybackStats::instance().toJson();
+        if (!opt.hashDir.isEmpty()) {
+            const QString outDir = QDir(opt.hashDir).filePath(caseName);
+            result["output"] = outDir;
+            if (!opt.goldenDir.isEmpty())
+                result["golden"] = OutputSink::compare(QDir(opt.goldenDir).filePath(caseName), outDir);
+        }
+        return result;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    // CI 上没有显示器，默认使用 offscreen 平台
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+
+    Options opt;
+    if (!parseArgs(app.arguments(), opt)) {
+        printUsage();
+        return 2;
+    }
+    if (!opt.manifestPath.isEmpty() && !loadManifest(opt))
+        return 1;
+
+    std::unique_ptr<OffscreenGL> gl;
+    if (opt.gl) {
+        gl = std::make_unique<OffscreenGL>();
+        if (!gl->init())
+            return 1;
+    }
+    int exitCode = 0;
+    QJsonArray results;
+    for (const QString &file : opt.files) {
+        if (!QFileInfo::exists(file)) {
+            qDebug() << "无效路径:" << file;
+            exitCode = 1;
+            continue;
+        }
+        QJsonObject result = runFile(file, opt, gl.get());
+        if (opt.caseNames.contains(file))
+            result["case"] = opt.caseNames.value(file);
+        if (!result["ok"].toBool())
+            exitCode = 1;
+        if (result.contains("golden") && !result["golden"].toObject()["ok"].toBool()) {
+            qDebug() << "与 golden 不一致:" << file;
+            exitCode = 1;
+        }
+        results.append(result);
+    }
+
+    QJsonObject root;
+    root["tool"] = "azplayer-bench";
+    root["results"] = results;
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    if (opt.jsonPath.isEmpty()) {
+        std::fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+    } else {
+        QFile out(opt.jsonPath);
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate) || out.write(json) != json.size()) {
+            qDebug() << "无法写入结果:" << opt.jsonPath;
+            return 1;
+        }
+    }
+    return exitCode;
+}
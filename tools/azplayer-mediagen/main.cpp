@@ -0,0 +1,803 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// 合成测试媒体生成器：用 lavfi 源 + libavcodec/libavformat 在本地生成一组可复现的性能测试素材，不需要下载任何文件
+// 覆盖 NV12/P010/yuv444p12/gbrp/PAL8 像素格式、4K/8K 高码率 HEVC/AV1、10 万条事件的 ASS、PGS 图形字幕、
+// 7.1 与三阶 Ambisonics 音频、严重交错不良的 MKV 等容易出性能问题的路径
+// 输出目录中的 manifest.json 记录每个文件的参数，azplayer-bench --manifest 可以直接读取
+//
+// 可复现：容器与编码器都使用 bitexact，编码线程数固定，随机内容只来自固定种子的 std::mt19937；
+// 同一个 FFmpeg 构建(同样的编码器版本)生成的文件逐字节相同
+//
+// 用法: azplayer-mediagen [--out 目录] [--only 名字,...] [--scale 倍数] [--list]
+
+#include "compat/compat.h"
+#include "subtitlegen.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+AZ_EXTERN_C_BEGIN
+#include <libavcodec/avcodec.h>
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersink.h>
+#include <libavformat/avformat.h>
+#include <libavutil/avutil.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
+AZ_EXTERN_C_END
+
+namespace {
+    constexpr int kEncoderThreads = 8;     // x264/x265 等的输出与线程数有关，固定下来才能在不同机器上得到相同的文件
+    constexpr double kBurstSeconds = 5.0;  // 交错不良的文件中音频每攒够这么长才写一次
+    constexpr int kPgsWidth = 1200;
+    constexpr int kPgsHeight = 120;
+
+    enum class Subtitles {
+        None,
+        AssEmbedded, // MKV 内嵌 ASS 轨道
+        PgsEmbedded, // MKV 内嵌 PGS 轨道
+        Sidecar,     // 同名的 .ass 与 .srt 外挂字幕
+    };
+
+    struct VideoSpec {
+        std::string filters;  // 接在 testsrc2 之后的滤镜，为空表示直接输出
+        std::string pixFmt;   // 为空表示没有视频
+        int width = 0;
+        int height = 0;
+        int fps = 0;
+        std::string encoders; // 逗号分隔，按顺序尝试第一个能打开的
+        std::string options;  // 编码器选项 key=value;key=value，不认识的选项会被忽略
+        int64_t bitrate = 0;
+    };
+
+    struct AudioSpec {
+        std::string source;        // lavfi 音频源，为空表示没有音频
+        std::string sampleFmt;
+        std::string encoderLayout; // 编码器使用的声道布局，为空时沿用源的布局
+        std::string encoders;
+        int64_t bitrate = 0;
+    };
+
+    struct Case {
+        std::string name;
+        std::string description;
+        std::string muxer;     // libavformat 的格式名
+        std::string extension;
+        double seconds = 0.0;
+        VideoSpec video;
+        AudioSpec audio;
+        Subtitles subtitles = Subtitles::None;
+        int subtitleEvents = 0;
+        bool badInterleave = false;
+    };
+
+    std::string stereoSource() {
+        return "aevalsrc=exprs=0.2*sin(2*PI*440*t)|0.2*sin(2*PI*554.37*t):channel_layout=stereo:sample_rate=48000";
+    }
+
+    // 7.1：每个声道一个不同频率的正弦
+    std::string surroundSource() {
+        std::string exprs;
+        for (int c = 0; c < 8; ++c) {
+            exprs += (c ? "|" : "") + std::string("0.15*sin(2*PI*") + std::to_string(220 + 110 * c) + "*t)";
+        }
+        return "aevalsrc=exprs=" + exprs + ":channel_layout=7.1:sample_rate=48000";
+    }
+
+    // 三阶 Ambisonics(ACN/SN3D)：一个水平面上每 8 秒绕听者一圈的 440Hz 点声源
+    std::string ambisonicSource() {
+        struct Term {
+            double gain;
+            const char *func; // 方位角 phi 的函数，nullptr 为常数
+            int multiple;     // func(multiple * phi)
+        };
+        // 仰角为 0 时各分量的 SN3D 球谐函数值，为 0 的分量也保留，声道数固定为 16
+        // clang-format off
+        const Term terms[16] = {
+            {1.0, nullptr, 0},                                             // W
+            {1.0, "sin", 1}, {0.0, nullptr, 0}, {1.0, "cos", 1},           // 一阶
+            {0.8660254, "sin", 2}, {0.0, nullptr, 0}, {-0.5, nullptr, 0},  // 二阶
+            {0.0, nullptr, 0}, {0.8660254, "cos", 2},
+            {0.7905694, "sin", 3}, {0.0, nullptr, 0}, {-0.6123724, "sin", 1}, // 三阶
+            {0.0, nullptr, 0}, {-0.6123724, "cos", 1}, {0.0, nullptr, 0}, {0.7905694, "cos", 3},
+        };
+        // clang-format on
+        std::string exprs;
+        char buf[96];
+        for (int c = 0; c < 16; ++c) {
+            const Term &t = terms[c];
+            if (t.gain == 0.0)
+                std::snprintf(buf, sizeof(buf), "0");
+            else if (!t.func)
+                std::snprintf(buf, sizeof(buf), "%.7f*0.25*sin(2*PI*440*t)", t.gain);
+            else
+                std::snprintf(buf, sizeof(buf), "%.7f*%s(%d*2*PI*t/8)*0.25*sin(2*PI*440*t)", t.gain, t.func, t.multiple);
+            exprs += (c ? "|" : "") + std::string(buf);
+        }
+        // 不指定布局时 aevalsrc 按表达式个数确定声道数，编码时再标记为 ambisonic 3
+        return "aevalsrc=exprs=" + exprs + ":sample_rate=48000";
+    }
+
+    std::vector<Case> makeCases() {
+        const std::string h264 = "libx264,mpeg4";
+        const std::string h264Opts = "preset=veryfast;crf=23";
+        const AudioSpec aacStereo{stereoSource(), "fltp", "", "aac", 192000};
+        const AudioSpec noAudio{};
+        const std::string palette = "split[a][b];[a]palettegen=stats_mode=single[p];[b][p]paletteuse=new=1";
+        const std::string noise = "noise=alls=24:allf=t+u"; // 时域噪声让码率接近上限
+
+        std::vector<Case> cases;
+        // clang-format off
+        cases.push_back({"pixfmt_nv12", "1080p NV12 rawvideo (semi-planar split path)", "nut", "nut", 2.0,
+                         {"", "nv12", 1920, 1080, 24, "rawvideo", "", 0}, noAudio});
+        cases.push_back({"pixfmt_p010", "1080p P010LE rawvideo (10-bit semi-planar split + shift path)", "nut", "nut", 2.0,
+                         {"", "p010le", 1920, 1080, 24, "rawvideo", "", 0}, noAudio});
+        cases.push_back({"pixfmt_yuv444p12", "1080p yuv444p12 HEVC (FFV1 when x265 lacks 12-bit)", "matroska", "mkv", 5.0,
+                         {"", "yuv444p12le", 1920, 1080, 24, "libx265,ffv1", "preset=ultrafast;x265-params=log-level=error", 0}, aacStereo});
+        cases.push_back({"pixfmt_gbrp", "1080p planar RGB (gbrp) FFV1", "matroska", "mkv", 5.0,
+                         {"", "gbrp", 1920, 1080, 24, "ffv1,libx264rgb", "preset=ultrafast", 0}, aacStereo});
+        cases.push_back({"pixfmt_pal8", "720p PAL8 PNG with a per-frame palette", "mov", "mov", 5.0,
+                         {palette, "pal8", 1280, 720, 24, "png", "", 0}, noAudio});
+        cases.push_back({"hevc_4k60_80m", "2160p60 10-bit HEVC at 80 Mbit/s", "matroska", "mkv", 10.0,
+                         {noise, "yuv420p10le", 3840, 2160, 60, "libx265", "preset=ultrafast;x265-params=log-level=error", 80'000'000}, aacStereo});
+        cases.push_back({"av1_4k30_40m", "2160p30 10-bit AV1 at 40 Mbit/s", "matroska", "mkv", 5.0,
+                         {noise, "yuv420p10le", 3840, 2160, 30, "libsvtav1,libaom-av1,librav1e", "preset=12;cpu-used=8;speed=10", 40'000'000}, aacStereo});
+        cases.push_back({"hevc_8k30_120m", "4320p30 HEVC at 120 Mbit/s", "matroska", "mkv", 3.0,
+                         {noise, "yuv420p", 7680, 4320, 30, "libx265", "preset=ultrafast;x265-params=log-level=error", 120'000'000}, aacStereo});
+        cases.push_back({"ass_100k", "24 min 360p with an embedded ASS track of 100k overlapping events", "matroska", "mkv", 1440.0,
+                         {"", "yuv420p", 640, 360, 24, h264, "preset=ultrafast;crf=28", 0}, aacStereo, Subtitles::AssEmbedded, 100'000});
+        cases.push_back({"pgs_1080p", "1080p with an embedded PGS track (one bitmap every 2 s)", "matroska", "mkv", 60.0,
+                         {"", "yuv420p", 1920, 1080, 24, h264, h264Opts, 0}, aacStereo, Subtitles::PgsEmbedded, 0});
+        cases.push_back({"text_sidecar", "720p with sidecar .ass and .srt of 600 events", "matroska", "mkv", 60.0,
+                         {"", "yuv420p", 1280, 720, 24, h264, h264Opts, 0}, aacStereo, Subtitles::Sidecar, 600});
+        cases.push_back({"audio_7_1", "7.1 FLAC 48 kHz", "matroska", "mkv", 60.0,
+                         {"", "yuv420p", 640, 360, 24, h264, h264Opts, 0}, {surroundSource(), "s16", "", "flac", 0}});
+        cases.push_back({"audio_hoa3", "third-order ambisonics (16 ch ACN/SN3D) PCM, rotating source", "matroska", "mkv", 60.0,
+                         {"", "yuv420p", 640, 360, 24, h264, h264Opts, 0}, {ambisonicSource(), "s32", "ambisonic 3", "pcm_s24le", 0}});
+        cases.push_back({"bad_interleave", "1080p MKV whose audio arrives in 5 s bursts behind the video", "matroska", "mkv", 60.0,
+                         {"", "yuv420p", 1920, 1080, 30, h264, h264Opts, 0}, aacStereo, Subtitles::None, 0, true});
+        // clang-format on
+        return cases;
+    }
+
+    QString averr(int err) {
+        char buf[AV_ERROR_MAX_STRING_SIZE] = {};
+        av_strerror(err, buf, sizeof(buf));
+        return QString::fromUtf8(buf);
+    }
+
+    std::vector<std::string> splitList(const std::string &list) {
+        std::vector<std::string> items;
+        size_t begin = 0;
+        while (begin <= list.size()) {
+            const size_t end = std::min(list.find(',', begin), list.size());
+            if (end > begin)
+                items.push_back(list.substr(begin, end - begin));
+            begin = end + 1;
+        }
+        return items;
+    }
+
+    // 输出文件，正常情况交给 libavformat 交错，交错不良时音频攒够 kBurstSeconds 才写
+    class Output {
+    public:
+        ~Output() {
+            for (AVPacket *pkt : m_heldAudio) {
+                av_packet_free(&pkt);
+            }
+            if (m_ctx && !(m_ctx->oformat->flags & AVFMT_NOFILE))
+                avio_closep(&m_ctx->pb);
+            avformat_free_context(m_ctx);
+        }
+
+        bool open(const QString &path, const std::string &muxer, bool badInterleave, QString &error) {
+            const QByteArray utf8 = path.toUtf8();
+            int ret = avformat_alloc_output_context2(&m_ctx, nullptr, muxer.c_str(), utf8.constData());
+            if (ret < 0) {
+                error = "muxer " + QString::fromStdString(muxer) + ": " + averr(ret);
+                return false;
+            }
+            m_ctx->flags |= AVFMT_FLAG_BITEXACT; // 不写入版本号、时间与随机 UID
+            m_path = utf8;
+            m_badInterleave = badInterleave;
+            return true;
+        }
+
+        [[nodiscard]] AVFormatContext *context() const { return m_ctx; }
+
+        bool writeHeader(QString &error) {
+            int ret = 0;
+            if (!(m_ctx->oformat->flags & AVFMT_NOFILE)) {
+                ret = avio_open(&m_ctx->pb, m_path.constData(), AVIO_FLAG_WRITE);
+                if (ret < 0) {
+                    error = "open: " + averr(ret);
+                    return false;
+                }
+            }
+            ret = avformat_write_header(m_ctx, nullptr);
+            if (ret < 0) {
+                error = "write header: " + averr(ret);
+                return false;
+            }
+            return true;
+        }
+
+        // 写出并释放 pkt 的数据
+        bool write(AVPacket *pkt, bool audio) {
+            if (!m_badInterleave)
+                return av_interleaved_write_frame(m_ctx, pkt) >= 0;
+
+            const AVStream *st = m_ctx->streams[pkt->stream_index];
+            if (audio) {
+                m_heldAudio.push_back(av_packet_clone(pkt));
+                av_packet_unref(pkt);
+                return m_heldAudio.back() != nullptr;
+            }
+            const double t = pkt->dts * av_q2d(st->time_base);
+            const int ret = av_write_frame(m_ctx, pkt);
+            av_packet_unref(pkt);
+            if (t >= m_nextBurst) {
+                m_nextBurst += kBurstSeconds;
+                return ret >= 0 && flushAudio();
+            }
+            return ret >= 0;
+        }
+
+        bool finish(QString &error) {
+            if (!flushAudio()) {
+                error = "write audio";
+                return false;
+            }
+            if (m_badInterleave)
+                (void)av_write_frame(m_ctx, nullptr);
+            else
+                (void)av_interleaved_write_frame(m_ctx, nullptr);
+            const int ret = av_write_trailer(m_ctx);
+            if (ret < 0) {
+                error = "write trailer: " + averr(ret);
+                return false;
+            }
+            if (!(m_ctx->oformat->flags & AVFMT_NOFILE))
+                avio_closep(&m_ctx->pb);
+            return true;
+        }
+
+    private:
+        bool flushAudio() {
+            bool ok = true;
+            for (AVPacket *pkt : m_heldAudio) {
+                ok &= av_write_frame(m_ctx, pkt) >= 0;
+                av_packet_free(&pkt);
+            }
+            m_heldAudio.clear();
+            return ok;
+        }
+
+        AVFormatContext *m_ctx = nullptr;
+        QByteArray m_path;
+        bool m_badInterleave = false;
+        double m_nextBurst = kBurstSeconds;
+        std::deque<AVPacket *> m_heldAudio;
+    };
+
+    // lavfi 源 -> 编码器 -> Output 的一路音频或视频
+    class EncodedStream {
+    public:
+        ~EncodedStream() {
+            avfilter_graph_free(&m_graph);
+            avcodec_free_context(&m_enc);
+            av_frame_free(&m_frame);
+            av_packet_free(&m_pkt);
+        }
+
+        /**
+         * 建立滤镜图并打开编码器，成功后在 out 中添加一路流
+         * @param missing 没有可用的编码器时置为 true(该用例应跳过而不是失败)
+         */
+        bool open(Output &out, const std::string &graph, bool audio, const std::string &encoders, const std::string &options,
+                  int64_t bitrate, const std::string &encoderLayout, QString &error, bool &missing) {
+            m_audio = audio;
+            if (!buildGraph(graph, error))
+                return false;
+
+            for (const std::string &name : splitList(encoders)) {
+                const AVCodec *codec = avcodec_find_encoder_by_name(name.c_str());
+                if (!codec)
+                    continue;
+                if (openEncoder(codec, options, bitrate, encoderLayout, out.context()->oformat->flags))
+                    break;
+                avcodec_free_context(&m_enc);
+            }
+            if (!m_enc) {
+                error = "no usable encoder among " + QString::fromStdString(encoders);
+                missing = true;
+                return false;
+            }
+            if (m_audio && m_enc->frame_size > 0 && !(m_enc->codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE))
+                av_buffersink_set_frame_size(m_sink, m_enc->frame_size);
+
+            m_stream = avformat_new_stream(out.context(), nullptr);
+            m_frame = av_frame_alloc();
+            m_pkt = av_packet_alloc();
+            if (!m_stream || !m_frame || !m_pkt || avcodec_parameters_from_context(m_stream->codecpar, m_enc) < 0) {
+                error = "allocation failed";
+                return false;
+            }
+            m_stream->time_base = m_enc->time_base;
+            return true;
+        }
+
+        [[nodiscard]] bool done() const { return m_done; }
+        // 下一帧的时间(秒)，用于决定先推进哪一路
+        [[nodiscard]] double nextTime() const { return m_next; }
+        [[nodiscard]] const AVCodecContext *encoder() const { return m_enc; }
+
+        // 编码一帧(到达 endTime 后冲刷编码器)并写出得到的数据包
+        bool step(Output &out, double endTime, QString &error) {
+            if (!m_flushing) {
+                av_frame_unref(m_frame);
+                const int ret = av_buffersink_get_frame(m_sink, m_frame);
+                const AVRational tb = av_buffersink_get_time_base(m_sink);
+                if (ret < 0 || m_frame->pts * av_q2d(tb) >= endTime) {
+                    m_flushing = true;
+                    (void)avcodec_send_frame(m_enc, nullptr);
+                } else {
+                    if (m_audio) {
+                        m_next = (m_frame->pts + m_frame->nb_samples) * av_q2d(tb);
+                        if (av_channel_layout_compare(&m_frame->ch_layout, &m_enc->ch_layout) != 0) {
+                            av_channel_layout_uninit(&m_frame->ch_layout);
+                            (void)av_channel_layout_copy(&m_frame->ch_layout, &m_enc->ch_layout);
+                        }
+                    } else {
+                        m_next = (m_frame->pts + 1) * av_q2d(tb);
+                        m_frame->pict_type = AV_PICTURE_TYPE_NONE;
+                    }
+                    const int sent = avcodec_send_frame(m_enc, m_frame);
+                    if (sent < 0) {
+                        error = "encode: " + averr(sent);
+                        return false;
+                    }
+                }
+            }
+
+            while (true) {
+                const int ret = avcodec_receive_packet(m_enc, m_pkt);
+                if (ret == AVERROR(EAGAIN))
+                    return true;
+                if (ret == AVERROR_EOF) {
+                    m_done = true;
+                    return true;
+                }
+                if (ret < 0) {
+                    error = "encode: " + averr(ret);
+                    return false;
+                }
+                m_pkt->stream_index = m_stream->index;
+                av_packet_rescale_ts(m_pkt, m_enc->time_base, m_stream->time_base);
+                if (!out.write(m_pkt, m_audio)) {
+                    error = "write packet failed";
+                    return false;
+                }
+            }
+        }
+
+    private:
+        bool buildGraph(const std::string &desc, QString &error) {
+            m_graph = avfilter_graph_alloc();
+            const AVFilter *sinkFilter = avfilter_get_by_name(m_audio ? "abuffersink" : "buffersink");
+            if (!m_graph || !sinkFilter || avfilter_graph_create_filter(&m_sink, sinkFilter, "out", nullptr, nullptr, m_graph) < 0) {
+                error = "lavfi: cannot create sink";
+                return false;
+            }
+            AVFilterInOut *inputs = avfilter_inout_alloc();
+            AVFilterInOut *outputs = nullptr; // 全部是源滤镜，没有外部输入
+            if (!inputs) {
+                error = "allocation failed";
+                return false;
+            }
+            inputs->name = av_strdup("out");
+            inputs->filter_ctx = m_sink;
+            inputs->pad_idx = 0;
+            inputs->next = nullptr;
+
+            int ret = avfilter_graph_parse_ptr(m_graph, desc.c_str(), &inputs, &outputs, nullptr);
+            avfilter_inout_free(&inputs);
+            avfilter_inout_free(&outputs);
+            if (ret >= 0)
+                ret = avfilter_graph_config(m_graph, nullptr);
+            if (ret < 0) {
+                error = "lavfi \"" + QString::fromStdString(desc) + "\": " + averr(ret);
+                return false;
+            }
+            return true;
+        }
+
+        bool openEncoder(const AVCodec *codec, const std::string &options, int64_t bitrate, const std::string &encoderLayout, int muxerFlags) {
+            m_enc = avcodec_alloc_context3(codec);
+            if (!m_enc)
+                return false;
+            const AVRational tb = av_buffersink_get_time_base(m_sink);
+            m_enc->time_base = tb;
+            if (m_audio) {
+                m_enc->sample_fmt = static_cast<AVSampleFormat>(av_buffersink_get_format(m_sink));
+                m_enc->sample_rate = av_buffersink_get_sample_rate(m_sink);
+                if (encoderLayout.empty()) {
+                    if (av_buffersink_get_ch_layout(m_sink, &m_enc->ch_layout) < 0)
+                        return false;
+                } else if (av_channel_layout_from_string(&m_enc->ch_layout, encoderLayout.c_str()) < 0) {
+                    return false;
+                }
+            } else {
+                m_enc->pix_fmt = static_cast<AVPixelFormat>(av_buffersink_get_format(m_sink));
+                m_enc->width = av_buffersink_get_w(m_sink);
+                m_enc->height = av_buffersink_get_h(m_sink);
+                m_enc->sample_aspect_ratio = av_buffersink_get_sample_aspect_ratio(m_sink);
+                m_enc->framerate = av_buffersink_get_frame_rate(m_sink);
+                const int fps = m_enc->framerate.den > 0 ? m_enc->framerate.num / m_enc->framerate.den : 0;
+                m_enc->gop_size = 2 * std::max(fps, 1);
+            }
+            m_enc->bit_rate = bitrate;
+            if (bitrate > 0) {
+                m_enc->rc_max_rate = bitrate;
+                m_enc->rc_buffer_size = static_cast<int>(std::min<int64_t>(bitrate, INT32_MAX));
+            }
+            m_enc->thread_count = kEncoderThreads;
+            m_enc->flags |= AV_CODEC_FLAG_BITEXACT;
+            if (muxerFlags & AVFMT_GLOBALHEADER)
+                m_enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+            AVDictionary *opts = nullptr;
+            if (!options.empty())
+                (void)av_dict_parse_string(&opts, options.c_str(), "=", ";", 0);
+            const int ret = avcodec_open2(m_enc, codec, &opts);
+            av_dict_free(&opts);
+            return ret >= 0;
+        }
+
+        bool m_audio = false;
+        AVFilterGraph *m_graph = nullptr;
+        AVFilterContext *m_sink = nullptr;
+        AVCodecContext *m_enc = nullptr;
+        AVStream *m_stream = nullptr;
+        AVFrame *m_frame = nullptr;
+        AVPacket *m_pkt = nullptr;
+        bool m_flushing = false;
+        bool m_done = false;
+        double m_next = 0.0;
+    };
+
+    // 预先生成好的字幕数据包(时间基 1/1000)
+    struct SubtitleStream {
+        struct Packet {
+            int64_t pts;
+            int64_t duration;
+            std::vector<uint8_t> data;
+        };
+
+        AVStream *stream = nullptr;
+        std::vector<Packet> packets;
+        size_t next = 0;
+
+        [[nodiscard]] bool done() const { return next >= packets.size(); }
+        [[nodiscard]] double nextTime() const { return packets[next].pts / 1000.0; }
+
+        bool step(Output &out) {
+            const Packet &p = packets[next++];
+            AVPacket *pkt = av_packet_alloc();
+            if (!pkt || av_new_packet(pkt, static_cast<int>(p.data.size())) < 0) {
+                av_packet_free(&pkt);
+                return false;
+            }
+            std::copy(p.data.begin(), p.data.end(), pkt->data);
+            pkt->pts = pkt->dts = av_rescale_q(p.pts, {1, 1000}, stream->time_base);
+            pkt->duration = av_rescale_q(p.duration, {1, 1000}, stream->time_base);
+            pkt->stream_index = stream->index;
+            pkt->flags |= AV_PKT_FLAG_KEY;
+            const bool ok = out.write(pkt, false);
+            av_packet_free(&pkt);
+            return ok;
+        }
+    };
+
+    bool addSubtitleStream(Output &out, AVCodecID codecId, const std::string &extradata, SubtitleStream &sub) {
+        sub.stream = avformat_new_stream(out.context(), nullptr);
+        if (!sub.stream)
+            return false;
+        sub.stream->codecpar->codec_type = AVMEDIA_TYPE_SUBTITLE;
+        sub.stream->codecpar->codec_id = codecId;
+        sub.stream->time_base = {1, 1000};
+        if (!extradata.empty()) {
+            sub.stream->codecpar->extradata = static_cast<uint8_t *>(av_mallocz(extradata.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+            if (!sub.stream->codecpar->extradata)
+                return false;
+            std::copy(extradata.begin(), extradata.end(), sub.stream->codecpar->extradata);
+            sub.stream->codecpar->extradata_size = static_cast<int>(extradata.size());
+        }
+        return true;
+    }
+
+    // 用例名的 FNV-1a，作为字幕内容的种子(qHash 的结果随 Qt 版本变化)
+    uint32_t nameSeed(const std::string &name) {
+        uint32_t h = 2166136261u;
+        for (unsigned char ch : name) {
+            h = (h ^ ch) * 16777619u;
+        }
+        return h;
+    }
+
+    std::string videoGraph(const VideoSpec &v) {
+        std::string graph = "testsrc2=size=" + std::to_string(v.width) + "x" + std::to_string(v.height) + ":rate=" + std::to_string(v.fps);
+        if (!v.filters.empty())
+            graph += "," + v.filters;
+        return graph + ",format=pix_fmts=" + v.pixFmt + "[out]";
+    }
+
+    std::string audioGraph(const AudioSpec &a) {
+        return a.source + ",aformat=sample_fmts=" + a.sampleFmt + ":sample_rates=48000[out]";
+    }
+
+    enum class Result {
+        Generated,
+        Skipped, // 缺少编码器
+        Failed,
+    };
+
+    Result generate(const Case &c, const QDir &outDir, double scale, QJsonObject &entry, QString &error) {
+        const double seconds = c.seconds * scale;
+        const int64_t durationMs = static_cast<int64_t>(std::llround(seconds * 1000.0));
+        const QString fileName = QString::fromStdString(c.name + "." + c.extension);
+        const QString path = outDir.filePath(fileName);
+
+        Output out;
+        if (!out.open(path, c.muxer, c.badInterleave, error))
+            return Result::Failed;
+
+        bool missing = false;
+        std::unique_ptr<EncodedStream> video, audio;
+        if (!c.video.pixFmt.empty()) {
+            video = std::make_unique<EncodedStream>();
+            if (!video->open(out, videoGraph(c.video), false, c.video.encoders, c.video.options, c.video.bitrate, "", error, missing))
+                return missing ? Result::Skipped : Result::Failed;
+        }
+        if (!c.audio.source.empty()) {
+            audio = std::make_unique<EncodedStream>();
+            if (!audio->open(out, audioGraph(c.audio), true, c.audio.encoders, "", c.audio.bitrate, c.audio.encoderLayout, error, missing))
+                return missing ? Result::Skipped : Result::Failed;
+        }
+
+        // 字幕
+        std::unique_ptr<SubtitleStream> sub;
+        QJsonObject subJson;
+        const uint32_t seed = nameSeed(c.name);
+        if (c.subtitles == Subtitles::AssEmbedded) {
+            sub = std::make_unique<SubtitleStream>();
+            if (!addSubtitleStream(out, AV_CODEC_ID_ASS, subtitlegen::assHeader(), *sub)) {
+                error = "allocation failed";
+                return Result::Failed;
+            }
+            const std::vector<subtitlegen::Event> events = subtitlegen::makeEvents(c.subtitleEvents, durationMs, seed);
+            int readOrder = 0;
+            for (const subtitlegen::Event &e : events) {
+                const std::string text = subtitlegen::assPacket(e, readOrder++);
+                sub->packets.push_back({e.startMs, e.endMs - e.startMs, std::vector<uint8_t>(text.begin(), text.end())});
+            }
+            subJson = {{"format", "ass"}, {"embedded", true}, {"events", c.subtitleEvents}};
+        } else if (c.subtitles == Subtitles::PgsEmbedded) {
+            sub = std::make_unique<SubtitleStream>();
+            if (!addSubtitleStream(out, AV_CODEC_ID_HDMV_PGS_SUBTITLE, "", *sub)) {
+                error = "allocation failed";
+                return Result::Failed;
+            }
+            int composition = 0, events = 0;
+            for (int64_t t = 500; t + 1500 <= durationMs; t += 2000, ++events) {
+                sub->packets.push_back({t, 1500, subtitlegen::pgsShow(c.video.width, c.video.height, kPgsWidth, kPgsHeight, composition++, seed + events)});
+                sub->packets.push_back({t + 1500, 0, subtitlegen::pgsClear(c.video.width, c.video.height, kPgsWidth, kPgsHeight, composition++)});
+            }
+            subJson = {{"format", "pgs"}, {"embedded", true}, {"events", events}};
+        } else if (c.subtitles == Subtitles::Sidecar) {
+            const std::vector<subtitlegen::Event> events = subtitlegen::makeEvents(c.subtitleEvents, durationMs, seed);
+            const QString assFile = QString::fromStdString(c.name + ".ass");
+            const QString srtFile = QString::fromStdString(c.name + ".srt");
+            if (!subtitlegen::writeAss(QFile::encodeName(outDir.filePath(assFile)).toStdString(), events) ||
+                !subtitlegen::writeSrt(QFile::encodeName(outDir.filePath(srtFile)).toStdString(), events)) {
+                error = "cannot write sidecar subtitles";
+                return Result::Failed;
+            }
+            subJson = {{"format", "ass+srt"}, {"embedded", false}, {"events", c.subtitleEvents}, {"files", QJsonArray{assFile, srtFile}}};
+        }
+
+        if (!out.writeHeader(error))
+            return Result::Failed;
+
+        // 每次推进时间最早的一路，让 libavformat 的交错缓冲保持很小
+        while (true) {
+            enum { None, Video, Audio, Sub } pick = None;
+            double t = INFINITY;
+            if (video && !video->done() && video->nextTime() < t) {
+                pick = Video;
+                t = video->nextTime();
+            }
+            if (audio && !audio->done() && audio->nextTime() < t) {
+                pick = Audio;
+                t = audio->nextTime();
+            }
+            if (sub && !sub->done() && sub->nextTime() < t) {
+                pick = Sub;
+                t = sub->nextTime();
+            }
+            if (pick == None)
+                break;
+            bool ok = true;
+            if (pick == Video)
+                ok = video->step(out, seconds, error);
+            else if (pick == Audio)
+                ok = audio->step(out, seconds, error);
+            else if (!(ok = sub->step(out)))
+                error = "write subtitle failed";
+            if (!ok)
+                return Result::Failed;
+        }
+        if (!out.finish(error))
+            return Result::Failed;
+
+        entry["name"] = QString::fromStdString(c.name);
+        entry["description"] = QString::fromStdString(c.description);
+        entry["file"] = fileName;
+        entry["container"] = QString::fromStdString(c.muxer);
+        entry["durationSeconds"] = seconds;
+        entry["bytes"] = static_cast<double>(QFileInfo(path).size());
+        entry["interleave"] = c.badInterleave ? "audio in 5 s bursts" : "normal";
+        if (video) {
+            const AVCodecContext *enc = video->encoder();
+            entry["video"] = QJsonObject{
+                {"encoder", enc->codec->name},
+                {"codec", avcodec_get_name(enc->codec_id)},
+                {"pixFmt", av_get_pix_fmt_name(enc->pix_fmt)},
+                {"width", enc->width},
+                {"height", enc->height},
+                {"fps", c.video.fps},
+                {"bitrate", static_cast<double>(c.video.bitrate)},
+            };
+        }
+        if (audio) {
+            const AVCodecContext *enc = audio->encoder();
+            char layout[128] = {};
+            av_channel_layout_describe(&enc->ch_layout, layout, sizeof(layout));
+            entry["audio"] = QJsonObject{
+                {"encoder", enc->codec->name},
+                {"sampleRate", enc->sample_rate},
+                {"channels", enc->ch_layout.nb_channels},
+                {"layout", layout},
+            };
+        }
+        if (!subJson.isEmpty())
+            entry["subtitles"] = subJson;
+        return Result::Generated;
+    }
+
+    struct Options {
+        QString outDir = "azplayer-media";
+        QStringList only;
+        double scale = 1.0;
+        bool list = false;
+    };
+
+    void printUsage() {
+        std::fprintf(stderr,
+                     "usage: azplayer-mediagen [--out DIR] [--only NAME,...] [--scale F] [--list]\n"
+                     "  --out DIR      output directory (default: azplayer-media)\n"
+                     "  --only NAMES   generate only the listed cases\n"
+                     "  --scale F      multiply every duration by F (e.g. 0.1 for a quick corpus)\n"
+                     "  --list         list the cases and exit\n");
+    }
+
+    bool parseArgs(const QStringList &args, Options &opt) {
+        for (int i = 1; i < args.size(); ++i) {
+            const QString &arg = args[i];
+            if (arg == "--out" && i + 1 < args.size()) {
+                opt.outDir = args[++i];
+            } else if (arg == "--only" && i + 1 < args.size()) {
+                opt.only = args[++i].split(',', Qt::SkipEmptyParts);
+            } else if (arg == "--scale" && i + 1 < args.size()) {
+                bool ok = false;
+                opt.scale = args[++i].toDouble(&ok);
+                if (!ok || opt.scale <= 0.0)
+                    return false;
+            } else if (arg == "--list") {
+                opt.list = true;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    Options opt;
+    if (!parseArgs(app.arguments(), opt)) {
+        printUsage();
+        return 2;
+    }
+
+    const std::vector<Case> cases = makeCases();
+    if (opt.list) {
+        for (const Case &c : cases) {
+            std::printf("%-18s %7.1fs  %s\n", c.name.c_str(), c.seconds * opt.scale, c.description.c_str());
+        }
+        return 0;
+    }
+    for (const QString &name : opt.only) {
+        if (std::none_of(cases.begin(), cases.end(), [&](const Case &c) { return name == QString::fromStdString(c.name); })) {
+            qDebug() << "未知的用例:" << name;
+            return 2;
+        }
+    }
+
+    QDir outDir(opt.outDir);
+    if (!outDir.mkpath(".")) {
+        qDebug() << "无法创建输出目录:" << opt.outDir;
+        return 1;
+    }
+
+    av_log_set_level(AV_LOG_ERROR);
+    QJsonArray files, skipped;
+    bool allOk = true;
+    for (const Case &c : cases) {
+        const QString name = QString::fromStdString(c.name);
+        if (!opt.only.isEmpty() && !opt.only.contains(name))
+            continue;
+        std::fprintf(stderr, "%-18s ...", c.name.c_str());
+        std::fflush(stderr);
+
+        QJsonObject entry;
+        QString error;
+        switch (generate(c, outDir, opt.scale, entry, error)) {
+        case Result::Generated:
+            files.append(entry);
+            std::fprintf(stderr, " ok (%.1f MiB)\n", entry["bytes"].toDouble() / (1 << 20));
+            break;
+        case Result::Skipped:
+            skipped.append(QJsonObject{{"name", name}, {"reason", error}});
+            std::fprintf(stderr, " skipped: %s\n", qUtf8Printable(error));
+            break;
+        case Result::Failed:
+            skipped.append(QJsonObject{{"name", name}, {"reason", error}});
+            std::fprintf(stderr, " FAILED: %s\n", qUtf8Printable(error));
+            allOk = false;
+            break;
+        }
+    }
+
+    const QJsonObject manifest{
+        {"tool", "azplayer-mediagen"},
+        {"version", 1},
+        {"ffmpeg", av_version_info()},
+        {"scale", opt.scale},
+        {"files", files},
+        {"skipped", skipped},
+    };
+    QFile file(outDir.filePath("manifest.json"));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "无法写入清单:" << file.fileName();
+        return 1;
+    }
+    file.write(QJsonDocument(manifest).toJson(QJsonDocument::Indented));
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,353 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "subtitlegen.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+namespace subtitlegen {
+    namespace {
+        constexpr int kPlayResX = 1920;
+        constexpr int kPlayResY = 1080;
+
+        // clang-format off
+        const char *const kWords[] = {
+            "the", "night", "train", "never", "stops", "here", "but", "we", "keep", "waiting",
+            "for", "someone", "who", "remembers", "our", "names", "again", "tomorrow", "maybe",
+            "字幕", "测试", "今天的", "天气", "真不错", "我们", "一起", "回家吧", "約束", "したよね", "ありがとう",
+        };
+        // clang-format on
+        constexpr size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+        uint32_t pick(std::mt19937 &rng, uint32_t n) {
+            return rng() % n;
+        }
+
+        std::string sentence(std::mt19937 &rng, int words) {
+            std::string s;
+            for (int i = 0; i < words; ++i) {
+                if (i > 0)
+                    s += ' ';
+                s += kWords[pick(rng, kWordCount)];
+            }
+            return s;
+        }
+
+        // 同一个表达式里不要调用两次 pick：参数的求值顺序未指定，不同编译器会得到不同的内容
+
+        // ASS 时间 h:mm:ss.cc
+        std::string assTime(int64_t ms) {
+            char buf[32];
+            const int64_t cs = ms / 10;
+            std::snprintf(buf, sizeof(buf), "%d:%02d:%02d.%02d", static_cast<int>(cs / 360000), static_cast<int>(cs / 6000 % 60),
+                          static_cast<int>(cs / 100 % 60), static_cast<int>(cs % 100));
+            return buf;
+        }
+
+        // SRT 时间 hh:mm:ss,mmm
+        std::string srtTime(int64_t ms) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%02d:%02d:%02d,%03d", static_cast<int>(ms / 3600000), static_cast<int>(ms / 60000 % 60),
+                          static_cast<int>(ms / 1000 % 60), static_cast<int>(ms % 1000));
+            return buf;
+        }
+
+        std::string typesetText(std::mt19937 &rng, int64_t durationMs) {
+            const int x = static_cast<int>(pick(rng, kPlayResX));
+            const int y = static_cast<int>(pick(rng, kPlayResY));
+            char tags[160];
+            switch (pick(rng, 4)) {
+            case 0:
+                std::snprintf(tags, sizeof(tags), "{\\pos(%d,%d)\\fad(200,200)}", x, y);
+                break;
+            case 1: {
+                const int x2 = static_cast<int>(pick(rng, kPlayResX));
+                const int y2 = static_cast<int>(pick(rng, kPlayResY));
+                std::snprintf(tags, sizeof(tags), "{\\move(%d,%d,%d,%d)\\blur2}", x, y, x2, y2);
+                break;
+            }
+            case 2:
+                std::snprintf(tags, sizeof(tags), "{\\an5\\pos(%d,%d)\\t(0,%d,\\frz360\\fscx150)}", x, y, static_cast<int>(durationMs));
+                break;
+            default: {
+                // 卡拉 OK：逐词 \k
+                std::string s = "{\\an8\\pos(960,80)}";
+                const int words = 3 + static_cast<int>(pick(rng, 6));
+                for (int i = 0; i < words; ++i) {
+                    const uint32_t k = 10 + pick(rng, 40);
+                    s += "{\\k" + std::to_string(k) + "}" + kWords[pick(rng, kWordCount)] + " ";
+                }
+                return s;
+            }
+            }
+            return tags + sentence(rng, 1 + static_cast<int>(pick(rng, 3)));
+        }
+
+        void put16(std::vector<uint8_t> &out, int v) {
+            out.push_back(static_cast<uint8_t>(v >> 8));
+            out.push_back(static_cast<uint8_t>(v));
+        }
+
+        void segment(std::vector<uint8_t> &out, uint8_t type, const std::vector<uint8_t> &payload) {
+            out.push_back(type);
+            put16(out, static_cast<int>(payload.size()));
+            out.insert(out.end(), payload.begin(), payload.end());
+        }
+
+        // PGS 段类型
+        constexpr uint8_t kPDS = 0x14;
+        constexpr uint8_t kODS = 0x15;
+        constexpr uint8_t kPCS = 0x16;
+        constexpr uint8_t kWDS = 0x17;
+        constexpr uint8_t kEND = 0x80;
+
+        std::vector<uint8_t> pcs(int videoWidth, int videoHeight, int compositionNumber, bool show, int x, int y) {
+            std::vector<uint8_t> p;
+            put16(p, videoWidth);
+            put16(p, videoHeight);
+            p.push_back(0x10);                 // 帧率(解码器忽略)
+            put16(p, compositionNumber);
+            p.push_back(show ? 0x80 : 0x00);   // 显示时为 epoch start，每个显示集都可以单独解码(方便 seek)
+            p.push_back(0x00);                 // palette update flag
+            p.push_back(0x00);                 // palette id
+            p.push_back(show ? 1 : 0);         // 对象个数
+            if (show) {
+                put16(p, 0);                   // object id
+                p.push_back(0);                // window id
+                p.push_back(0);                // 不裁剪
+                put16(p, x);
+                put16(p, y);
+            }
+            return p;
+        }
+
+        std::vector<uint8_t> wds(int x, int y, int w, int h) {
+            std::vector<uint8_t> p;
+            p.push_back(1); // 窗口个数
+            p.push_back(0); // window id
+            put16(p, x);
+            put16(p, y);
+            put16(p, w);
+            put16(p, h);
+            return p;
+        }
+
+        // 游程编码一行
+        void rleLine(std::vector<uint8_t> &out, const uint8_t *line, int w) {
+            for (int x = 0; x < w;) {
+                const uint8_t c = line[x];
+                int len = 1;
+                while (x + len < w && line[x + len] == c && len < 16383) {
+                    ++len;
+                }
+                if (c == 0) {
+                    out.push_back(0);
+                    if (len < 64) {
+                        out.push_back(static_cast<uint8_t>(len));
+                    } else {
+                        out.push_back(static_cast<uint8_t>(0x40 | (len >> 8)));
+                        out.push_back(static_cast<uint8_t>(len));
+                    }
+                } else if (len < 3) {
+                    out.insert(out.end(), len, c);
+                } else {
+                    out.push_back(0);
+                    if (len < 64) {
+                        out.push_back(static_cast<uint8_t>(0x80 | len));
+                    } else {
+                        out.push_back(static_cast<uint8_t>(0xC0 | (len >> 8)));
+                        out.push_back(static_cast<uint8_t>(len));
+                    }
+                    out.push_back(c);
+                }
+                x += len;
+            }
+            out.push_back(0); // 行结束
+            out.push_back(0);
+        }
+    }
+
+    std::vector<Event> makeEvents(size_t count, int64_t durationMs, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::vector<Event> events(count);
+        const uint32_t span = static_cast<uint32_t>(std::max<int64_t>(durationMs, 1));
+        for (Event &e : events) {
+            e.startMs = pick(rng, span);
+            e.endMs = e.startMs + 800 + pick(rng, 4200);
+            if (pick(rng, 5) != 0) {
+                e.style = pick(rng, 4) == 0 ? "Alt" : "Default";
+                e.text = sentence(rng, 3 + static_cast<int>(pick(rng, 6)));
+                if (pick(rng, 3) == 0)
+                    e.text += "\\N" + sentence(rng, 2 + static_cast<int>(pick(rng, 5)));
+            } else {
+                e.layer = 1 + static_cast<int>(pick(rng, 3));
+                e.style = "Sign";
+                e.text = typesetText(rng, e.endMs - e.startMs);
+            }
+        }
+        std::stable_sort(events.begin(), events.end(), [](const Event &a, const Event &b) { return a.startMs < b.startMs; });
+        return events;
+    }
+
+    std::string assHeader() {
+        return "[Script Info]\n"
+               "; Generated by azplayer-mediagen\n"
+               "ScriptType: v4.00+\n"
+               "PlayResX: " + std::to_string(kPlayResX) + "\n"
+               "PlayResY: " + std::to_string(kPlayResY) + "\n"
+               "WrapStyle: 0\n"
+               "ScaledBorderAndShadow: yes\n"
+               "YCbCr Matrix: TV.709\n"
+               "\n"
+               "[V4+ Styles]\n"
+               "Format: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, BackColour, Bold, Italic, Underline, "
+               "StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, Outline, Shadow, Alignment, MarginL, MarginR, MarginV, Encoding\n"
+               "Style: Default,Arial,64,&H00FFFFFF,&H000000FF,&H00000000,&H80000000,0,0,0,0,100,100,0,0,1,3,2,2,40,40,50,1\n"
+               "Style: Alt,Arial,56,&H0000FFFF,&H000000FF,&H00202020,&H80000000,0,1,0,0,100,100,0,0,1,3,2,8,40,40,50,1\n"
+               "Style: Sign,Arial,48,&H00F0E0D0,&H000000FF,&H00402010,&H00000000,1,0,0,0,100,100,2,0,1,2,0,5,10,10,10,1\n"
+               "\n"
+               "[Events]\n"
+               "Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\n";
+    }
+
+    std::string assPacket(const Event &event, int readOrder) {
+        return std::to_string(readOrder) + "," + std::to_string(event.layer) + "," + event.style + ",,0,0,0,," + event.text;
+    }
+
+    std::string plainText(const std::string &assText) {
+        std::string out;
+        for (size_t i = 0; i < assText.size(); ++i) {
+            const char c = assText[i];
+            if (c == '{') {
+                const size_t close = assText.find('}', i);
+                if (close == std::string::npos)
+                    break;
+                i = close;
+            } else if (c == '\\' && i + 1 < assText.size() && (assText[i + 1] == 'N' || assText[i + 1] == 'n')) {
+                out += '\n';
+                ++i;
+            } else if (c == '\\' && i + 1 < assText.size() && assText[i + 1] == 'h') {
+                out += ' ';
+                ++i;
+            } else {
+                out += c;
+            }
+        }
+        return out;
+    }
+
+    bool writeAss(const std::string &path, const std::vector<Event> &events) {
+        std::ofstream out(path, std::ios::binary);
+        if (!out)
+            return false;
+        out << assHeader();
+        for (const Event &e : events) {
+            out << "Dialogue: " << e.layer << ',' << assTime(e.startMs) << ',' << assTime(e.endMs) << ',' << e.style << ",,0,0,0,," << e.text << '\n';
+        }
+        return static_cast<bool>(out);
+    }
+
+    bool writeSrt(const std::string &path, const std::vector<Event> &events) {
+        std::ofstream out(path, std::ios::binary);
+        if (!out)
+            return false;
+        int index = 1;
+        for (const Event &e : events) {
+            out << index++ << '\n'
+                << srtTime(e.startMs) << " --> " << srtTime(e.endMs) << '\n'
+                << plainText(e.text) << "\n\n";
+        }
+        return static_cast<bool>(out);
+    }
+
+    std::vector<uint8_t> pgsShow(int videoWidth, int videoHeight, int w, int h, int compositionNumber, uint32_t seed) {
+        const int x = (videoWidth - w) / 2;
+        const int y = videoHeight - h - videoHeight / 20;
+
+        // 调色板索引：0 透明，1 白色填充，2 黑色描边，3 半透明阴影
+        std::vector<uint8_t> bitmap(static_cast<size_t>(w) * h, 0);
+        std::mt19937 rng(seed);
+        constexpr int kCell = 56, kGap = 8, kBorder = 3, kShadow = 4;
+        for (int gx = kGap; gx + kCell - kGap + kShadow <= w; gx += kCell) {
+            const int gw = kCell - kGap;
+            const int gh = h / 2 + static_cast<int>(rng() % static_cast<uint32_t>(h / 2 - kShadow));
+            const int gy = h - kShadow - gh;
+            for (int yy = gy; yy < gy + gh + kShadow; ++yy) {
+                for (int xx = gx; xx < gx + gw + kShadow; ++xx) {
+                    const bool inGlyph = xx < gx + gw && yy < gy + gh;
+                    uint8_t &px = bitmap[static_cast<size_t>(yy) * w + xx];
+                    if (inGlyph) {
+                        const bool border = xx < gx + kBorder || xx >= gx + gw - kBorder || yy < gy + kBorder || yy >= gy + gh - kBorder;
+                        px = border ? 2 : 1;
+                    } else if (xx >= gx + kShadow && yy >= gy + kShadow) {
+                        px = 3;
+                    }
+                }
+            }
+        }
+
+        std::vector<uint8_t> rle;
+        for (int yy = 0; yy < h; ++yy) {
+            rleLine(rle, &bitmap[static_cast<size_t>(yy) * w], w);
+        }
+
+        std::vector<uint8_t> out;
+        segment(out, kPCS, pcs(videoWidth, videoHeight, compositionNumber, true, x, y));
+        segment(out, kWDS, wds(x, y, w, h));
+
+        std::vector<uint8_t> pds{0x00, 0x00}; // palette id, version
+        // clang-format off
+        const uint8_t palette[][5] = {
+            // id, Y, Cr, Cb, A
+            {1, 235, 128, 128, 255},
+            {2, 16, 128, 128, 255},
+            {3, 64, 128, 128, 128},
+        };
+        // clang-format on
+        for (const auto &entry : palette) {
+            pds.insert(pds.end(), entry, entry + 5);
+        }
+        segment(out, kPDS, pds);
+
+        // 对象数据超过一个段的长度上限时拆成多个 ODS(首段 0x80，末段 0x40)
+        constexpr size_t kMaxSegment = 0xFFFF;
+        const size_t dataLen = rle.size() + 4; // 含宽高
+        size_t offset = 0;
+        bool first = true;
+        do {
+            std::vector<uint8_t> ods;
+            put16(ods, 0);  // object id
+            ods.push_back(0); // version
+            const size_t header = first ? 11 : 4;
+            const size_t chunk = std::min(rle.size() - offset, kMaxSegment - header);
+            const bool last = offset + chunk == rle.size();
+            ods.push_back(static_cast<uint8_t>((first ? 0x80 : 0) | (last ? 0x40 : 0)));
+            if (first) {
+                ods.push_back(static_cast<uint8_t>(dataLen >> 16));
+                put16(ods, static_cast<int>(dataLen & 0xFFFF));
+                put16(ods, w);
+                put16(ods, h);
+            }
+            ods.insert(ods.end(), rle.begin() + static_cast<std::ptrdiff_t>(offset), rle.begin() + static_cast<std::ptrdiff_t>(offset + chunk));
+            segment(out, kODS, ods);
+            offset += chunk;
+            first = false;
+        } while (offset < rle.size());
+
+        segment(out, kEND, {});
+        return out;
+    }
+
+    std::vector<uint8_t> pgsClear(int videoWidth, int videoHeight, int w, int h, int compositionNumber) {
+        const int x = (videoWidth - w) / 2;
+        const int y = videoHeight - h - videoHeight / 20;
+        std::vector<uint8_t> out;
+        segment(out, kPCS, pcs(videoWidth, videoHeight, compositionNumber, false, 0, 0));
+        segment(out, kWDS, wds(x, y, w, h));
+        segment(out, kEND, {});
+        return out;
+    }
+}
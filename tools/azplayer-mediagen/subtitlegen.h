@@ -0,0 +1,54 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SUBTITLEGEN_H
+#define SUBTITLEGEN_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * 合成字幕：文本事件(ASS/SRT)与 PGS 图形字幕
+ * 只依赖标准库，随机数直接取 std::mt19937 的输出(标准规定了其序列)，同一参数在任何平台上生成的内容都相同
+ */
+namespace subtitlegen {
+    struct Event {
+        int64_t startMs = 0;
+        int64_t endMs = 0;
+        int layer = 0;
+        std::string style; // ASS 样式名
+        std::string text;  // ASS 文本，带覆盖标签
+    };
+
+    /**
+     * 在 [0, durationMs) 内生成 count 个事件，按开始时间排序
+     * 大部分是底部的对白，其余是带 \pos \move \fad \t \k 等标签的特效字幕，事件之间大量重叠
+     */
+    [[nodiscard]] std::vector<Event> makeEvents(size_t count, int64_t durationMs, uint32_t seed);
+
+    // 完整的 ASS 脚本头([Script Info]、[V4+ Styles] 与 [Events] 的 Format 行)，也用作 Matroska 中 ASS 轨道的 extradata
+    // 脚本坐标固定为 1920x1080，libass 按视频大小缩放
+    [[nodiscard]] std::string assHeader();
+
+    // Matroska 中 ASS 数据包的内容：ReadOrder,Layer,Style,Name,MarginL,MarginR,MarginV,Effect,Text
+    [[nodiscard]] std::string assPacket(const Event &event, int readOrder);
+
+    // 去掉覆盖标签后的纯文本(SRT 用)
+    [[nodiscard]] std::string plainText(const std::string &assText);
+
+    bool writeAss(const std::string &path, const std::vector<Event> &events);
+    bool writeSrt(const std::string &path, const std::vector<Event> &events);
+
+    /**
+     * 一个 PGS 显示集(PCS + WDS + PDS + ODS + END)，即 Matroska 中 S_HDMV/PGS 的一个数据包
+     * 在画面底部显示一个 w x h 的字幕块(描边、填充与半透明阴影组成的“字形”条纹)
+     * @param compositionNumber 每个显示集递增
+     */
+    [[nodiscard]] std::vector<uint8_t> pgsShow(int videoWidth, int videoHeight, int w, int h, int compositionNumber, uint32_t seed);
+
+    // 清除画面的 PGS 显示集(PCS 不带对象 + WDS + END)
+    [[nodiscard]] std::vector<uint8_t> pgsClear(int videoWidth, int videoHeight, int w, int h, int compositionNumber);
+}
+
+#endif // SUBTITLEGEN_H
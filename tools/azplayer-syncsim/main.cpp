@@ -0,0 +1,370 @@
+// SPDX-FileCopyrightText: 2025-2026 Xuefei Ai
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// 音画同步模拟器：在虚拟时间上单线程重放视频播放线程的送显逻辑(FramePacer + GlobalClock)，
+// 用模型代替解码线程与音频设备回调，几秒内跑完两小时的片子，输出与 azplayer-bench 相同格式的统计
+// 同样的参数得到完全相同的落后/领先/丢帧计数，可直接用于回归测试
+//
+// 模型：
+// - 解码线程：逐帧耗时 decode ± jitter，每 spike-every 帧额外 spike；帧队列满时等待播放线程取走
+// - 视频播放线程：队列空时以 5ms 为步长轮询，取到帧后花 prep 准备数据，之后的送显流程与 VideoPlayer::write 是同一份代码(FramePacer::presentFrame)
+// - 音频设备：每 period 回调一次，按 headPts - latency 更新音频时钟；drift-ppm 为设备时钟相对系统时钟的偏差
+// - 每次睡眠额外多睡 oversleep(系统定时器精度)
+//
+// 用法: azplayer-syncsim [选项]，--help 查看
+
+#include "clock/globalclock.h"
+#include "clock/timesource.h"
+#include "renderer/framepacer.h"
+#include "stats/playbackstats.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr double kPollInterval = 0.005; // VideoPlayer 队列为空时的轮询间隔(秒)
+
+    struct Options {
+        double duration = 7200.0;
+        double fps = 24000.0 / 1001.0;
+        double speed = 1.0;
+        ClockType master = ClockType::AUDIO;
+        double audioPeriodMs = 10.0;
+        double audioLatencyMs = 40.0;
+        double driftPpm = 0.0;
+        double decodeMs = 4.0;
+        double decodeJitterMs = 2.0;
+        int spikeEvery = 0;
+        double spikeMs = 80.0;
+        double prepMs = 2.0;
+        double oversleepMs = 0.0;
+        int queue = 16;
+        double maxFrameDuration = 10.0;
+        uint32_t seed = 1;
+        QString jsonPath; // 为空时写到标准输出
+    };
+
+    void printUsage() {
+        std::fprintf(stderr,
+                     "usage: azplayer-syncsim [options]\n"
+                     "  --duration S          media duration in seconds (default 7200)\n"
+                     "  --fps F               video frame rate (default 23.976)\n"
+                     "  --speed X             playback speed (default 1)\n"
+                     "  --master audio|video|external  master clock (default audio)\n"
+                     "  --audio-period-ms P   audio device callback period (default 10)\n"
+                     "  --audio-latency-ms L  audio device latency (default 40)\n"
+                     "  --drift-ppm D         audio device clock drift against the system clock (default 0)\n"
+                     "  --decode-ms M         mean video decode time per frame (default 4)\n"
+                     "  --decode-jitter-ms J  uniform decode time jitter (default 2)\n"
+                     "  --spike-every N       add a decode spike every N frames (default 0, off)\n"
+                     "  --spike-ms S          decode spike length (default 80)\n"
+                     "  --prep-ms P           render data preparation time per frame (default 2)\n"
+                     "  --oversleep-ms O      extra time added to every sleep (default 0)\n"
+                     "  --queue N             video frame queue capacity (default 16)\n"
+                     "  --seed N              random seed (default 1)\n"
+                     "  --json FILE           write results to FILE instead of stdout\n");
+    }
+
+    bool parseArgs(const QStringList &args, Options &opt) {
+        // clang-format off
+        struct NumberOption {
+            const char *name;
+            double *value;
+            double min;
+        };
+        const NumberOption numbers[] = {
+            {"--duration",         &opt.duration,       1e-3},
+            {"--fps",              &opt.fps,            1e-3},
+            {"--speed",            &opt.speed,          1e-3},
+            {"--audio-period-ms",  &opt.audioPeriodMs,  0.1},
+            {"--audio-latency-ms", &opt.audioLatencyMs, 0.0},
+            {"--drift-ppm",        &opt.driftPpm,       -1e5},
+            {"--decode-ms",        &opt.decodeMs,       0.0},
+            {"--decode-jitter-ms", &opt.decodeJitterMs, 0.0},
+            {"--spike-ms",         &opt.spikeMs,        0.0},
+            {"--prep-ms",          &opt.prepMs,         0.0},
+            {"--oversleep-ms",     &opt.oversleepMs,    0.0},
+        };
+        // clang-format on
+        for (int i = 1; i < args.size(); ++i) {
+            const QString &arg = args[i];
+            if (i + 1 >= args.size())
+                return false;
+            const QString value = args[++i];
+            bool ok = true;
+            bool matched = false;
+            for (const NumberOption &number : numbers) {
+                if (arg == number.name) {
+                    *number.value = value.toDouble(&ok);
+                    ok = ok && *number.value >= number.min;
+                    matched = true;
+                    break;
+                }
+            }
+            if (matched) {
+                // 已处理
+            } else if (arg == "--master") {
+                if (value == "audio")
+                    opt.master = ClockType::AUDIO;
+                else if (value == "video")
+                    opt.master = ClockType::VIDEO;
+                else if (value == "external")
+                    opt.master = ClockType::EXTERNAL;
+                else
+                    ok = false;
+            } else if (arg == "--spike-every") {
+                opt.spikeEvery = value.toInt(&ok);
+                ok = ok && opt.spikeEvery >= 0;
+            } else if (arg == "--queue") {
+                opt.queue = value.toInt(&ok);
+                ok = ok && opt.queue >= 1;
+            } else if (arg == "--seed") {
+                opt.seed = value.toUInt(&ok);
+            } else if (arg == "--json") {
+                opt.jsonPath = value;
+            } else {
+                return false;
+            }
+            if (!ok)
+                return false;
+        }
+        return true;
+    }
+
+    // 音频设备：按固定周期回调，在回调时刻更新音频时钟
+    class AudioDeviceModel {
+    public:
+        explicit AudioDeviceModel(const Options &opt)
+            : m_period(opt.audioPeriodMs / 1000.0), m_latency(opt.audioLatencyMs / 1000.0),
+              m_rate(1.0 + opt.driftPpm * 1e-6), m_speed(opt.speed), m_enabled(opt.master != ClockType::VIDEO) {}
+
+        // 把时间推进到 time，途中按时间顺序触发设备回调
+        void advanceTo(double time) {
+            TimeSource &ts = TimeSource::instance();
+            while (m_enabled && nextCallback() <= time) {
+                ts.advanceTo(nextCallback());
+                // 本次读出的第一个采样的 pts，设备按自己的时钟消耗采样
+                const double headPts = m_callbacks * m_period * m_speed;
+                GlobalClock::instance().setAudioClk(headPts - m_latency * m_speed);
+                ++m_callbacks;
+            }
+            ts.advanceTo(time);
+        }
+
+    private:
+        [[nodiscard]] double nextCallback() const { return m_callbacks * m_period / m_rate; }
+
+        double m_period;
+        double m_latency;
+        double m_rate; // 设备时钟相对系统时钟的速率
+        double m_speed;
+        bool m_enabled;
+        int64_t m_callbacks = 0;
+    };
+
+    // 解码线程：第 i 帧在 max(第 i-1 帧就绪, 第 i-queue 帧被取走) 之后再解码 cost(i)
+    class DecoderModel {
+    public:
+        DecoderModel(const Options &opt, int64_t frames)
+            : m_decode(opt.decodeMs / 1000.0), m_jitter(opt.decodeJitterMs / 1000.0), m_spikeEvery(opt.spikeEvery),
+              m_spike(opt.spikeMs / 1000.0), m_queue(opt.queue), m_frames(frames), m_rng(opt.seed) {
+            m_ready.reserve(static_cast<size_t>(frames));
+            m_pop.reserve(static_cast<size_t>(frames));
+        }
+
+        // 第 index 帧进入帧队列的时刻；需要的第 index-queue 帧必须已经被取走
+        double readyTime(int64_t index) {
+            while (static_cast<int64_t>(m_ready.size()) <= index) {
+                const int64_t i = static_cast<int64_t>(m_ready.size());
+                double start = m_ready.empty() ? 0.0 : m_ready.back();
+                if (i >= m_queue)
+                    start = std::max(start, m_pop[static_cast<size_t>(i - m_queue)]);
+                m_ready.push_back(start + cost(i));
+            }
+            return m_ready[static_cast<size_t>(index)];
+        }
+
+        // 播放线程在 time 取走了下一帧
+        void pop(double time) { m_pop.push_back(time); }
+
+        // time 时刻帧队列中的帧数
+        [[nodiscard]] size_t queued(double time) {
+            size_t count = 0;
+            for (int64_t i = static_cast<int64_t>(m_pop.size()); i < m_frames && count < static_cast<size_t>(m_queue) && readyTime(i) <= time; ++i) {
+                ++count;
+            }
+            return count;
+        }
+
+    private:
+        double cost(int64_t index) {
+            // 直接用 mt19937 的输出(标准规定了序列)，保证各平台结果一致
+            const double u = static_cast<double>(m_rng()) / 4294967295.0;
+            double c = m_decode + m_jitter * (2.0 * u - 1.0);
+            if (m_spikeEvery > 0 && index % m_spikeEvery == m_spikeEvery - 1)
+                c += m_spike;
+            c = std::max(c, 0.0);
+            PlaybackStats::instance().updateVideoDecodeTime(c * 1000.0);
+            return c;
+        }
+
+        double m_decode;
+        double m_jitter;
+        int m_spikeEvery;
+        double m_spike;
+        int64_t m_queue;
+        int64_t m_frames;
+        std::mt19937 m_rng;
+        std::vector<double> m_ready; // 每帧进入帧队列的时刻
+        std::vector<double> m_pop;   // 每帧被播放线程取走的时刻
+    };
+
+    const char *clockName(ClockType type) {
+        switch (type) {
+        case ClockType::AUDIO:
+            return "audio";
+        case ClockType::VIDEO:
+            return "video";
+        case ClockType::EXTERNAL:
+            return "external";
+        default:
+            return "none";
+        }
+    }
+
+    // 模拟器中的视频播放线程：虚拟时间只能由本线程推进，睡眠改为推进时间并触发期间的音频回调
+    class PlayerModel : public FramePacer::Hooks {
+    public:
+        PlayerModel(const Options &opt, int64_t frames, AudioDeviceModel &audio, DecoderModel &decoder)
+            : m_ts(TimeSource::instance()), m_audio(audio), m_decoder(decoder), m_frames(frames),
+              m_frameDuration(1.0 / opt.fps), m_oversleep(opt.oversleepMs / 1000.0) {}
+
+        // 正在送显第 index 帧
+        void setIndex(int64_t index) { m_index = index; }
+        [[nodiscard]] int64_t presented() const { return m_presented; }
+        [[nodiscard]] double frameDuration() const { return m_frameDuration; }
+
+        double now() override { return m_ts.now(); }
+        void sleepFor(double seconds) override { m_audio.advanceTo(m_ts.now() + seconds + m_oversleep); }
+        bool peekNext(FramePacer::Frame &next) override {
+            if (m_index + 1 >= m_frames || m_decoder.readyTime(m_index + 1) > m_ts.now())
+                return false;
+            next = {(m_index + 1) * m_frameDuration, m_frameDuration};
+            return true;
+        }
+        size_t queueDepth() override { return m_decoder.queued(m_ts.now()); }
+        void present() override { ++m_presented; }
+        void drop() override {}
+
+    private:
+        TimeSource &m_ts;
+        AudioDeviceModel &m_audio;
+        DecoderModel &m_decoder;
+        int64_t m_frames;
+        double m_frameDuration;
+        double m_oversleep;
+        int64_t m_index = 0;
+        int64_t m_presented = 0;
+    };
+
+    // 与 VideoPlayer::playerLoop 相同的取帧轮询，送显直接调用 VideoPlayer::write 使用的 FramePacer::presentFrame
+    // 不模拟 seek/切流与字幕，返回送显的帧数
+    int64_t simulate(const Options &opt, int64_t frames) {
+        TimeSource &ts = TimeSource::instance();
+        AudioDeviceModel audio(opt);
+        DecoderModel decoder(opt, frames);
+        PlayerModel player(opt, frames, audio, decoder);
+        FramePacer pacer;
+
+        const double frameDuration = player.frameDuration();
+        const double prep = opt.prepMs / 1000.0;
+        for (int64_t i = 0; i < frames; ++i) {
+            // 队列为空时轮询
+            const double ready = decoder.readyTime(i);
+            while (ts.now() < ready) {
+                player.sleepFor(kPollInterval);
+            }
+            decoder.pop(ts.now());
+
+            // 准备渲染数据
+            audio.advanceTo(ts.now() + prep);
+            PlaybackStats::instance().updateVideoPrepTime(opt.prepMs);
+
+            player.setIndex(i);
+            pacer.presentFrame({i * frameDuration, frameDuration}, i == 0, player); // 第一帧相当于 seek 后的第一帧
+        }
+        return player.presented();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    Options opt;
+    if (!parseArgs(app.arguments(), opt)) {
+        printUsage();
+        return 2;
+    }
+
+    const int64_t frames = static_cast<int64_t>(std::llround(opt.duration * opt.fps));
+    TimeSource::instance().setVirtual(0.0);
+    GlobalClock &clock = GlobalClock::instance();
+    clock.setSpeed(opt.speed);
+    clock.reset();
+    clock.setMaxFrameDuration(opt.maxFrameDuration);
+    clock.setMainClockType(opt.master);
+    if (opt.master == ClockType::EXTERNAL)
+        clock.setExternalClk(0.0); // 与 Demux seek 完成时相同
+    PlaybackStats::instance().reset();
+
+    QElapsedTimer timer;
+    timer.start();
+    const int64_t presented = simulate(opt, frames);
+    const double wallSeconds = timer.nsecsElapsed() / 1e9;
+    const double simulatedSeconds = TimeSource::instance().now();
+    TimeSource::instance().setReal();
+
+    QJsonObject params;
+    params["duration"] = opt.duration;
+    params["fps"] = opt.fps;
+    params["speed"] = opt.speed;
+    params["master"] = clockName(opt.master);
+    params["audioPeriodMs"] = opt.audioPeriodMs;
+    params["audioLatencyMs"] = opt.audioLatencyMs;
+    params["driftPpm"] = opt.driftPpm;
+    params["decodeMs"] = opt.decodeMs;
+    params["decodeJitterMs"] = opt.decodeJitterMs;
+    params["spikeEvery"] = opt.spikeEvery;
+    params["spikeMs"] = opt.spikeMs;
+    params["prepMs"] = opt.prepMs;
+    params["oversleepMs"] = opt.oversleepMs;
+    params["queue"] = opt.queue;
+    params["seed"] = static_cast<qint64>(opt.seed);
+
+    QJsonObject root;
+    root["tool"] = "azplayer-syncsim";
+    root["params"] = params;
+    root["frames"] = static_cast<qint64>(frames);
+    root["presented"] = static_cast<qint64>(presented);
+    root["simulatedSeconds"] = simulatedSeconds;
+    root["wallSeconds"] = wallSeconds;
+    root["stats"] = PlaybackStats::instance().toJson();
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    if (opt.jsonPath.isEmpty()) {
+        std::fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+    } else {
+        QFile out(opt.jsonPath);
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate) || out.write(json) != json.size()) {
+            qDebug() << "无法写入结果:" << opt.jsonPath;
+            return 1;
+        }
+    }
+    return 0;
+}